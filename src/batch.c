@@ -0,0 +1,413 @@
+#include <SDL3/SDL.h>
+
+#include "batch.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fingerprint.h"
+#include "offline.h"
+#include "recording.h"
+#include "source.h"
+
+// Longest line accepted in a file list, and longest generated output path.
+#define BATCH_LINE_MAX 1024
+#define BATCH_PATH_MAX 1280
+
+// Mean square of a full-scale sine, the 0 dB reference for file levels.
+#define BATCH_REFERENCE 0.5
+
+/*
+    BatchResult: Summary of one listed file, written by the worker that
+    analysed it and read by the main thread once all workers have joined.
+*/
+typedef struct {
+    bool ok;
+    int sample_rate;
+    int channels;
+    unsigned long long frames;
+    double seconds;            // Audio covered by the analysed frames.
+    float level_db;            // Mean frame level, dB re a full-scale sine.
+    float peak_hz;             // Strongest bin of the long-term spectrum.
+    char recording[BATCH_PATH_MAX];
+    FingerprintHash* hashes;   // --fingerprint: landmarks of the file, in frame order.
+    size_t hash_count;
+} BatchResult;
+
+/*
+    BatchQueue: The file list, shared by all workers. Files are claimed one
+    at a time through an atomic counter, so long and short files balance
+    across the pool without a lock.
+*/
+typedef struct {
+    const CliOptions* options;
+    char** paths;
+    int count;
+    BatchResult* results;
+    SDL_AtomicInt next;        // Next unclaimed list entry.
+    SDL_AtomicInt finished;    // Files done, for progress.
+} BatchQueue;
+
+/*
+    BatchWorker: One pool thread with its own plan and buffers.
+*/
+typedef struct {
+    BatchQueue* queue;
+    OfflineStft stft;
+    double* power_sum;         // Long-term spectrum of the current file.
+    FingerprintHash* hashes;   // One frame's landmarks, FP_MAX_HASHES.
+    SDL_Thread* thread;
+} BatchWorker;
+
+/*
+    batch_read_list: Loads the file list, skipping blank lines and lines
+    starting with '#'. Returns the number of paths, or -1 on failure.
+*/
+int batch_read_list(const char* path, char*** out) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    char line[BATCH_LINE_MAX];
+    char** paths = NULL;
+    int count = 0;
+    int capacity = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        size_t len = strcspn(line, "\r\n");
+        line[len] = '\0';
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char** grown = realloc(paths, sizeof(char*) * capacity);
+            ok = (grown != NULL);
+            paths = grown ? grown : paths;
+        }
+        char* copy = ok ? malloc(len + 1) : NULL;
+        if (copy) {
+            memcpy(copy, line, len + 1);
+            paths[count++] = copy;
+        }
+        ok = (copy != NULL);
+    }
+    fclose(file);
+    if (!ok) {
+        for (int i = 0; i < count; i++) {
+            free(paths[i]);
+        }
+        free(paths);
+        return -1;
+    }
+    *out = paths;
+    return count;
+}
+
+/*
+    batch_recording_path: Output path for list entry index. The entry number
+    keeps files with the same name from different folders apart.
+*/
+static void batch_recording_path(char* out, const char* dir, int index, const char* path) {
+    const char* name = path;
+    for (const char* p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    int stem = (int)strcspn(name, ".");
+    snprintf(out, BATCH_PATH_MAX, "%s/%06d-%.*s.avspec", dir, index, stem, name);
+}
+
+/*
+    batch_keep_hashes: Appends one frame's landmarks to a file's list.
+*/
+static bool batch_keep_hashes(BatchResult* result, size_t* capacity, const FingerprintHash* hashes, int count) {
+    if (result->hash_count + count > *capacity) {
+        size_t grown_capacity = *capacity ? *capacity * 2 : 4096;
+        while (grown_capacity < result->hash_count + count) {
+            grown_capacity *= 2;
+        }
+        FingerprintHash* grown = realloc(result->hashes, sizeof(FingerprintHash) * grown_capacity);
+        if (!grown) {
+            return false;
+        }
+        result->hashes = grown;
+        *capacity = grown_capacity;
+    }
+    memcpy(result->hashes + result->hash_count, hashes, sizeof(FingerprintHash) * count);
+    result->hash_count += count;
+    return true;
+}
+
+/*
+    batch_analyse: Runs one file through the worker's STFT, writing its
+    recording when an output directory was given and collecting its
+    landmarks when a fingerprint index is being built.
+*/
+static void batch_analyse(BatchWorker* worker, int index) {
+    BatchQueue* queue = worker->queue;
+    const CliOptions* options = queue->options;
+    BatchResult* result = &queue->results[index];
+    OfflineStft* stft = &worker->stft;
+
+    AudioSource src;
+    if (!source_open(&src, SOURCE_FILE, queue->paths[index], 0, 0, 0, 0)) {
+        return;
+    }
+    result->sample_rate = src.sample_rate;
+    result->channels = src.channels;
+
+    Recording rec = {0};
+    if (options->record_path) {
+        batch_recording_path(result->recording, options->record_path, index, queue->paths[index]);
+        if (!recording_open(&rec, result->recording, src.sample_rate, stft->fft_size, stft->hop,
+                            stft->bins, options->record_format)) {
+            result->recording[0] = '\0';
+            source_close(&src);
+            return;
+        }
+    }
+
+    FingerprintExtractor fp = {0};
+    size_t hash_capacity = 0;
+    bool fingerprint_ok = true;
+    if (options->fingerprint_path) {
+        fingerprint_ok = fingerprint_init(&fp, stft->bins, (float)src.sample_rate / stft->fft_size,
+                                          (float)stft->hop / src.sample_rate);
+    }
+
+    memset(worker->power_sum, 0, sizeof(double) * stft->bins);
+    offline_stft_reset(stft);
+    int count;
+    while (fingerprint_ok && (count = offline_stft_next(stft, &src)) > 0) {
+        for (int i = 0; i < count; i++) {
+            const float* power = stft->power + (size_t)i * stft->bins;
+            const float* row_db = stft->row_db + (size_t)i * stft->bins;
+            for (int k = 0; k < stft->bins; k++) {
+                worker->power_sum[k] += power[k];
+            }
+            if (rec.file) {
+                recording_write(&rec, row_db);
+            }
+            if (fp.mask && fingerprint_ok) {
+                int n = fingerprint_push(&fp, row_db, worker->hashes);
+                fingerprint_ok = batch_keep_hashes(result, &hash_capacity, worker->hashes, n);
+            }
+        }
+        result->frames += count;
+    }
+    fingerprint_free(&fp);
+    recording_close(&rec);
+    source_close(&src);
+    if (!fingerprint_ok) {
+        return;
+    }
+
+    if (result->frames) {
+        // One-sided bin power to mean square, as the RTA scales it.
+        const double scale = 2.0 / (stft->fft_size * stft->window_power);
+        double total = 0;
+        int peak = 1;
+        for (int k = 1; k < stft->bins; k++) {
+            total += worker->power_sum[k];
+            if (worker->power_sum[k] > worker->power_sum[peak]) {
+                peak = k;
+            }
+        }
+        double mean_square = total * scale / result->frames;
+        result->level_db = (float)(10.0 * log10(mean_square / BATCH_REFERENCE + 1e-12));
+        result->peak_hz = (float)peak * src.sample_rate / stft->fft_size;
+        result->seconds = (double)(result->frames * stft->hop + stft->fft_size - stft->hop) / src.sample_rate;
+    }
+    result->ok = true;
+}
+
+/*
+    batch_worker: Pool thread body; claims files until the list is exhausted.
+*/
+static int batch_worker(void* data) {
+    BatchWorker* worker = (BatchWorker*)data;
+    BatchQueue* queue = worker->queue;
+    for (;;) {
+        int index = SDL_AddAtomicInt(&queue->next, 1);
+        if (index >= queue->count) {
+            break;
+        }
+        batch_analyse(worker, index);
+        int done = SDL_AddAtomicInt(&queue->finished, 1) + 1;
+        fprintf(stderr, "[%d/%d] %s%s\n", done, queue->count, queue->paths[index],
+                queue->results[index].ok ? "" : ": failed");
+    }
+    return 0;
+}
+
+/*
+    batch_write_index: Writes one CSV line per listed file, in list order.
+*/
+static bool batch_write_index(const BatchQueue* queue, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "path,status,sample_rate,channels,seconds,frames,level_db,peak_hz,recording\n");
+    for (int i = 0; i < queue->count; i++) {
+        const BatchResult* r = &queue->results[i];
+        fprintf(file, "\"%s\",%s,%d,%d,%.3f,%llu,%.2f,%.1f,\"%s\"\n", queue->paths[i],
+                r->ok ? "ok" : "failed", r->sample_rate, r->channels, r->seconds, r->frames,
+                r->level_db, r->peak_hz, r->recording);
+    }
+    fclose(file);
+    return true;
+}
+
+/*
+    batch_write_fingerprints: Inserts every analysed file's landmarks into
+    one index, in list order, and writes it. Files at another sample rate
+    than the first would hash other frame distances and are left out.
+*/
+static bool batch_write_fingerprints(BatchQueue* queue, const char* path, int fft_size, int hop) {
+    int sample_rate = 0;
+    for (int i = 0; i < queue->count && !sample_rate; i++) {
+        sample_rate = queue->results[i].ok ? queue->results[i].sample_rate : 0;
+    }
+    FingerprintBuilder builder;
+    if (!sample_rate || !fingerprint_builder_init(&builder, sample_rate, fft_size, hop)) {
+        return false;
+    }
+    bool ok = true;
+    for (int i = 0; ok && i < queue->count; i++) {
+        BatchResult* r = &queue->results[i];
+        if (!r->ok) {
+            continue;
+        }
+        if (r->sample_rate != sample_rate) {
+            fprintf(stderr, "%s: %d Hz, not indexed (the index is %d Hz).\n",
+                    queue->paths[i], r->sample_rate, sample_rate);
+            continue;
+        }
+        int track = fingerprint_builder_add_track(&builder, queue->paths[i], r->seconds);
+        ok = track >= 0 && fingerprint_builder_add(&builder, track, r->hashes, r->hash_count);
+    }
+    uint64_t bytes = 0;
+    ok = ok && fingerprint_builder_write(&builder, path, &bytes);
+    if (ok) {
+        const double hours = builder.seconds / 3600.0;
+        fprintf(stderr, "Fingerprints: %llu landmarks from %d tracks (%.2f h) in %.1f MiB: "
+                "%.0f landmarks/s of audio, %.1f MiB per hour of reference\n",
+                (unsigned long long)builder.entries, builder.track_count, hours, bytes / 1048576.0,
+                builder.seconds > 0 ? builder.entries / builder.seconds : 0.0,
+                hours > 0 ? bytes / 1048576.0 / hours : 0.0);
+    }
+    fingerprint_builder_free(&builder);
+    return ok;
+}
+
+/*
+    batch_run: --batch entry point. Plans one STFT per worker up front (the
+    FFTW planner is not thread-safe), then lets the pool drain the list.
+    Reports aggregate throughput in audio-hours per wall-clock minute.
+*/
+int batch_run(const CliOptions* options) {
+    BatchQueue queue = {0};
+    queue.options = options;
+    queue.count = batch_read_list(options->batch_path, &queue.paths);
+    if (queue.count < 0) {
+        fprintf(stderr, "Failed to read the file list %s.\n", options->batch_path);
+        return EXIT_FAILURE;
+    }
+    if (queue.count == 0) {
+        fprintf(stderr, "The file list %s is empty.\n", options->batch_path);
+        free(queue.paths);
+        return EXIT_FAILURE;
+    }
+    queue.results = calloc(queue.count, sizeof(BatchResult));
+
+    const int fft_size = options->fft_size ? options->fft_size : OFFLINE_DEFAULT_FFT_SIZE;
+    const int hop = options->hop ? options->hop : fft_size / 2;
+    const int batch = options->fft_batch ? options->fft_batch : OFFLINE_DEFAULT_BATCH;
+    int jobs = options->jobs ? options->jobs : SDL_GetNumLogicalCPUCores();
+    if (jobs > BATCH_MAX_JOBS) {
+        jobs = BATCH_MAX_JOBS;
+    }
+    if (jobs > queue.count) {
+        jobs = queue.count;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    BatchWorker* workers = calloc(jobs, sizeof(BatchWorker));
+    bool ok = queue.results && workers;
+    for (int w = 0; ok && w < jobs; w++) {
+        workers[w].queue = &queue;
+        ok = offline_stft_init(&workers[w].stft, fft_size, hop, batch);
+        if (ok) {
+            workers[w].power_sum = malloc(sizeof(double) * workers[w].stft.bins);
+            workers[w].hashes = malloc(sizeof(FingerprintHash) * FP_MAX_HASHES);
+            ok = workers[w].power_sum && workers[w].hashes;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to set up the batch workers.\n");
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    int started = 0;
+    if (ok) {
+        for (int w = 0; w < jobs; w++) {
+            workers[w].thread = SDL_CreateThread(batch_worker, "BatchWorker", &workers[w]);
+            if (!workers[w].thread) {
+                fprintf(stderr, "Failed to create batch worker: %s\n", SDL_GetError());
+                break;
+            }
+            started++;
+        }
+        if (started == 0) {
+            ok = false;
+        }
+    }
+    for (int w = 0; w < started; w++) {
+        SDL_WaitThread(workers[w].thread, NULL);
+    }
+    double wall = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    int succeeded = 0;
+    double audio_seconds = 0;
+    if (ok) {
+        for (int i = 0; i < queue.count; i++) {
+            succeeded += queue.results[i].ok;
+            audio_seconds += queue.results[i].seconds;
+        }
+        fprintf(stderr, "Batch: %d of %d files, %.2f h of audio in %.1f s on %d workers: "
+                "%.2f audio-hours per wall-minute\n",
+                succeeded, queue.count, audio_seconds / 3600.0, wall, started,
+                wall > 0 ? (audio_seconds / 3600.0) / (wall / 60.0) : 0.0);
+        if (options->index_path && !batch_write_index(&queue, options->index_path)) {
+            fprintf(stderr, "Failed to write the index %s.\n", options->index_path);
+            ok = false;
+        }
+        if (options->fingerprint_path && !batch_write_fingerprints(&queue, options->fingerprint_path, fft_size, hop)) {
+            fprintf(stderr, "Failed to write the fingerprint index %s.\n", options->fingerprint_path);
+            ok = false;
+        }
+    }
+
+    for (int w = 0; workers && w < jobs; w++) {
+        offline_stft_free(&workers[w].stft);
+        free(workers[w].power_sum);
+        free(workers[w].hashes);
+    }
+    free(workers);
+    for (int i = 0; i < queue.count; i++) {
+        free(queue.paths[i]);
+        if (queue.results) {
+            free(queue.results[i].hashes);
+        }
+    }
+    free(queue.paths);
+    free(queue.results);
+    return (ok && succeeded == queue.count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
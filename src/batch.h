@@ -0,0 +1,12 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "cli.h"
+
+// Upper bound on batch worker threads.
+#define BATCH_MAX_JOBS 64
+
+int batch_read_list(const char* path, char*** out);
+int batch_run(const CliOptions* options);
+
+#endif
@@ -0,0 +1,700 @@
+#include "browser.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// BMP header, info header and palette written by pyramid_write_tile.
+#define BROWSER_BMP_HEADER (14 + 40 + 256 * 4)
+
+// Coarser levels searched for a stand-in while a tile is loading.
+#define BROWSER_FALLBACK_LEVELS 8
+
+// Zoom limits: pixels per level-0 column when zoomed in all the way.
+#define BROWSER_MAX_PIXELS_PER_COLUMN 8.0
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static unsigned char browser_code(float db) {
+    float v = (db - PYRAMID_FLOOR_DB) / PYRAMID_RANGE_DB;
+    return (unsigned char)(fminf(fmaxf(v, 0.0f), 1.0f) * 255.0f);
+}
+
+static int browser_tile_count(const Browser* browser, int level) {
+    return (int)((browser->columns[level] + PYRAMID_TILE - 1) / PYRAMID_TILE);
+}
+
+static bool browser_same(BrowserKey a, BrowserKey b) {
+    return a.level == b.level && a.index == b.index;
+}
+
+/*
+    browser_read_index: Reads the level table of a pyramid directory.
+*/
+static bool browser_read_index(Browser* browser) {
+    char path[1152];
+    snprintf(path, sizeof(path), "%s/pyramid.txt", browser->directory);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        int level;
+        unsigned long long columns;
+        char reduce[16];
+        if (sscanf(line, "level %d columns %llu", &level, &columns) == 2) {
+            if (level >= 0 && level < PYRAMID_MAX_LEVELS) {
+                browser->columns[level] = columns;
+            }
+        } else if (sscanf(line, "reduce %15s", reduce) == 1) {
+            browser->reduce = strcmp(reduce, "mean") == 0 ? PYRAMID_MEAN : PYRAMID_MAX;
+        } else {
+            sscanf(line, "sample_rate %d", &browser->sample_rate);
+            sscanf(line, "hop %d", &browser->hop);
+            sscanf(line, "levels %d", &browser->level_count);
+        }
+    }
+    fclose(file);
+    return browser->level_count > 0 && browser->level_count <= PYRAMID_MAX_LEVELS &&
+           browser->columns[0] > 0 && browser->sample_rate > 0 && browser->hop > 0;
+}
+
+/*
+    browser_load_bmp: Reads a tile written by the pyramid writer into
+    column-major codes. Returns its width, or 0 if it could not be read.
+*/
+static int browser_load_bmp(Browser* browser, BrowserKey key, unsigned char* codes) {
+    char path[1152];
+    snprintf(path, sizeof(path), "%s/z%02d_%06d.bmp", browser->directory, key.level, key.index);
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+    unsigned char header[BROWSER_BMP_HEADER];
+    unsigned char row[PYRAMID_TILE];
+    int width = 0;
+    if (fread(header, 1, sizeof(header), file) == sizeof(header) && header[0] == 'B' && header[1] == 'M') {
+        width = (int)get_u32(header + 18);
+        if (width <= 0 || width > PYRAMID_TILE || get_u32(header + 22) != PYRAMID_ROWS ||
+            fseek(file, (long)get_u32(header + 10), SEEK_SET) != 0) {
+            width = 0;
+        }
+    }
+    const int stride = (width + 3) & ~3;
+    for (int y = 0; width > 0 && y < PYRAMID_ROWS; y++) {
+        if (fread(row, 1, stride, file) != (size_t)stride) {
+            width = 0;
+            break;
+        }
+        for (int x = 0; x < width; x++) {
+            codes[(size_t)x * PYRAMID_ROWS + y] = row[x];
+        }
+    }
+    fclose(file);
+    return width;
+}
+
+/*
+    browser_reduce_row: Max-reduces one recording row onto the tile rows,
+    as pyramid_push does.
+*/
+static void browser_reduce_row(const Browser* browser, const float* row_db, float* column) {
+    const int bins = browser->reader.bins;
+    for (int y = 0; y < PYRAMID_ROWS; y++) {
+        int lo = (int)((long long)y * bins / PYRAMID_ROWS);
+        int hi = (int)((long long)(y + 1) * bins / PYRAMID_ROWS);
+        float peak = row_db[lo];
+        for (int k = lo + 1; k < hi; k++) {
+            peak = fmaxf(peak, row_db[k]);
+        }
+        column[y] = peak;
+    }
+}
+
+/*
+    browser_pair: Folds a later column into an earlier one with the
+    pyramid writer's expression, so both produce the same floats.
+*/
+static void browser_pair(const Browser* browser, float* earlier, const float* later) {
+    for (int y = 0; y < PYRAMID_ROWS; y++) {
+        earlier[y] = (browser->reduce == PYRAMID_MAX) ? fmaxf(earlier[y], later[y])
+                                                      : 0.5f * (earlier[y] + later[y]);
+    }
+}
+
+/*
+    browser_read_columns: Computes `count` consecutive columns of a lower
+    level straight from the recording, each reducing 2^level rows into
+    values. Rows are paired level by level as pyramid_add pairs them, and
+    a short last column promotes its unpaired parts as pyramid_close does,
+    so a mean is the writer's tree of halvings rather than a flat average.
+    stack holds one pending column per level up to BROWSER_SUMMARY_LEVEL.
+*/
+static bool browser_read_columns(Browser* browser, int level, unsigned long long first, int count,
+                                 float* row_db, float* stack, float* values) {
+    RecordingReader* reader = &browser->reader;
+    unsigned long long row = first << level;
+    if (!recording_reader_seek(reader, row)) {
+        return false;
+    }
+    for (int x = 0; x < count; x++) {
+        unsigned long long end = (first + x + 1) << level;
+        if (end > reader->rows) {
+            end = reader->rows;
+        }
+        const int n = (int)(end - row);
+        for (int i = 0; i < n; i++, row++) {
+            if (!recording_reader_read(reader, row_db)) {
+                return false;
+            }
+            // Bit l of i set means stack level l holds a pending column.
+            int l = 0;
+            float* carry = &stack[(size_t)(level + 1) * PYRAMID_ROWS];
+            browser_reduce_row(browser, row_db, carry);
+            for (; i & (1 << l); l++) {
+                float* pending = &stack[(size_t)l * PYRAMID_ROWS];
+                browser_pair(browser, pending, carry);
+                memcpy(carry, pending, sizeof(float) * PYRAMID_ROWS);
+            }
+            memcpy(&stack[(size_t)l * PYRAMID_ROWS], carry, sizeof(float) * PYRAMID_ROWS);
+        }
+        // n is 2^level except at the end, where the pending columns of the
+        // set bits of n fold upwards, the lowest one promoted first.
+        float* column = &values[(size_t)x * PYRAMID_ROWS];
+        bool started = false;
+        for (int l = 0; l <= level; l++) {
+            if (!(n & (1 << l))) {
+                continue;
+            }
+            const float* pending = &stack[(size_t)l * PYRAMID_ROWS];
+            if (!started) {
+                memcpy(column, pending, sizeof(float) * PYRAMID_ROWS);
+                started = true;
+            } else {
+                float later[PYRAMID_ROWS];
+                memcpy(later, column, sizeof(later));
+                memcpy(column, pending, sizeof(float) * PYRAMID_ROWS);
+                browser_pair(browser, column, later);
+            }
+        }
+    }
+    return true;
+}
+
+/*
+    browser_summary_up: Builds the parent of a finished summary column once
+    both children (or a lone last child, which moves up unchanged) exist,
+    and so on up the levels.
+*/
+static void browser_summary_up(Browser* browser, int level, unsigned long long column) {
+    while (level + 1 < browser->level_count &&
+           ((column & 1) || column + 1 == browser->columns[level])) {
+        const float* a = &browser->summary[level][(column & ~1ull) * PYRAMID_ROWS];
+        float* parent = &browser->summary[level + 1][(column >> 1) * PYRAMID_ROWS];
+        memcpy(parent, a, sizeof(float) * PYRAMID_ROWS);
+        if (column & 1) {
+            browser_pair(browser, parent, a + PYRAMID_ROWS);
+        }
+        level++;
+        column >>= 1;
+    }
+}
+
+/*
+    browser_scan: Folds the next stretch of the recording into the summary
+    levels and advances *scanned. Returns false when the file can no
+    longer be read.
+*/
+static bool browser_scan(Browser* browser, unsigned long long* scanned, float* row_db, float* stack,
+                         float* values) {
+    const int level = BROWSER_SUMMARY_LEVEL;
+    const unsigned long long first = *scanned >> level;
+    unsigned long long last = (*scanned + BROWSER_SCAN_ROWS) >> level;
+    if (last > browser->columns[level]) {
+        last = browser->columns[level];
+    }
+    for (unsigned long long column = first; column < last; column += PYRAMID_TILE) {
+        int count = (int)((last - column < PYRAMID_TILE) ? last - column : PYRAMID_TILE);
+        if (!browser_read_columns(browser, level, column, count, row_db, stack, values)) {
+            return false;
+        }
+        memcpy(&browser->summary[level][column * PYRAMID_ROWS], values, sizeof(float) * count * PYRAMID_ROWS);
+        for (int x = 0; x < count; x++) {
+            browser_summary_up(browser, level, column + x);
+        }
+    }
+    *scanned = last << level;
+    if (*scanned > browser->reader.rows) {
+        *scanned = browser->reader.rows;
+    }
+    return true;
+}
+
+/*
+    browser_available: Whether the loader can prepare a tile right now.
+    Summary tiles wait until the scan has passed their last column.
+*/
+static bool browser_available(const Browser* browser, BrowserKey key, unsigned long long scanned) {
+    if (!browser->from_recording || key.level < BROWSER_SUMMARY_LEVEL) {
+        return true;
+    }
+    unsigned long long end = (unsigned long long)(key.index + 1) * PYRAMID_TILE;
+    if (end > browser->columns[key.level]) {
+        end = browser->columns[key.level];
+    }
+    unsigned long long rows = end << key.level;
+    return scanned >= (rows < browser->reader.rows ? rows : browser->reader.rows);
+}
+
+/*
+    browser_prepare: Produces the codes of one tile on the loader thread.
+    Returns its width, or 0 on failure.
+*/
+static int browser_prepare(Browser* browser, BrowserKey key, float* row_db, float* stack, float* values,
+                           unsigned char* codes) {
+    if (!browser->from_recording) {
+        return browser_load_bmp(browser, key, codes);
+    }
+    const unsigned long long first = (unsigned long long)key.index * PYRAMID_TILE;
+    const unsigned long long remaining = browser->columns[key.level] - first;
+    const int width = (int)(remaining < PYRAMID_TILE ? remaining : PYRAMID_TILE);
+    const float* source = values;
+    if (key.level >= BROWSER_SUMMARY_LEVEL) {
+        source = &browser->summary[key.level][first * PYRAMID_ROWS];
+    } else if (!browser_read_columns(browser, key.level, first, width, row_db, stack, values)) {
+        return 0;
+    }
+    // Quantise once, at the end, as the writer does for its tiles.
+    for (size_t i = 0; i < (size_t)width * PYRAMID_ROWS; i++) {
+        codes[i] = browser_code(source[i]);
+    }
+    return width;
+}
+
+/*
+    browser_loader: Serves tile requests in priority order and, while none
+    can be served, advances the summary scan of a recording.
+*/
+static int browser_loader(void* data) {
+    Browser* browser = data;
+    const int bins = browser->from_recording ? browser->reader.bins : 1;
+    float* row_db = malloc(sizeof(float) * bins);
+    float* stack = malloc(sizeof(float) * (BROWSER_SUMMARY_LEVEL + 2) * PYRAMID_ROWS);
+    float* values = malloc(sizeof(float) * PYRAMID_TILE * PYRAMID_ROWS);
+    unsigned char* codes = malloc((size_t)PYRAMID_TILE * PYRAMID_ROWS);
+    if (!row_db || !stack || !values || !codes) {
+        free(row_db);
+        free(stack);
+        free(values);
+        free(codes);
+        return 1;
+    }
+
+    SDL_LockMutex(browser->mutex);
+    while (!browser->stop) {
+        int pick = -1;
+        if (browser->loaded_count < BROWSER_MAX_LOADED) {
+            for (int i = 0; i < browser->request_count && pick < 0; i++) {
+                if (browser_available(browser, browser->requests[i], browser->scanned)) {
+                    pick = i;
+                }
+            }
+        }
+        if (pick < 0) {
+            if (browser->summary_ready) {
+                SDL_WaitCondition(browser->wake, browser->mutex);
+                continue;
+            }
+            unsigned long long scanned = browser->scanned;
+            SDL_UnlockMutex(browser->mutex);
+            if (!browser_scan(browser, &scanned, row_db, stack, values)) {
+                fprintf(stderr, "Browser: could not read the recording past row %llu\n", scanned);
+                scanned = browser->reader.rows;
+            }
+            SDL_LockMutex(browser->mutex);
+            browser->scanned = scanned;
+            browser->summary_ready = (scanned >= browser->reader.rows);
+            continue;
+        }
+
+        BrowserKey key = browser->requests[pick];
+        memmove(&browser->requests[pick], &browser->requests[pick + 1],
+                sizeof(BrowserKey) * (browser->request_count - pick - 1));
+        browser->request_count--;
+        browser->loading = key;
+        browser->is_loading = true;
+        SDL_UnlockMutex(browser->mutex);
+
+        Uint64 start = SDL_GetTicksNS();
+        Uint32* pixels = malloc(sizeof(Uint32) * PYRAMID_TILE * PYRAMID_ROWS);
+        int width = pixels ? browser_prepare(browser, key, row_db, stack, values, codes) : 0;
+        for (int x = 0; x < width; x++) {
+            const unsigned char* column = &codes[(size_t)x * PYRAMID_ROWS];
+            for (int y = 0; y < PYRAMID_ROWS; y++) {
+                pixels[(size_t)(PYRAMID_ROWS - 1 - y) * PYRAMID_TILE + x] = browser->palette[column[y]];
+            }
+        }
+        float ms = (SDL_GetTicksNS() - start) / 1e6f;
+
+        SDL_LockMutex(browser->mutex);
+        browser->is_loading = false;
+        if (width > 0) {
+            BrowserLoaded* done = &browser->loaded[browser->loaded_count++];
+            done->key = key;
+            done->width = width;
+            done->pixels = pixels;
+            browser->load_ms = browser->tiles_loaded ? 0.9f * browser->load_ms + 0.1f * ms : ms;
+            browser->tiles_loaded++;
+        } else {
+            free(pixels);
+        }
+    }
+    SDL_UnlockMutex(browser->mutex);
+
+    free(row_db);
+    free(stack);
+    free(values);
+    free(codes);
+    return 0;
+}
+
+/*
+    browser_open: Opens a pyramid directory (containing pyramid.txt) or a
+    recording file and starts the loader thread. reduce applies to tiles
+    computed from a recording.
+*/
+bool browser_open(Browser* browser, const char* path, PyramidReduce reduce) {
+    memset(browser, 0, sizeof(*browser));
+    snprintf(browser->directory, sizeof(browser->directory), "%s", path);
+    browser->reduce = reduce;
+    browser->summary_ready = true;  // Only recordings have a summary to build.
+
+    if (!browser_read_index(browser)) {
+        memset(browser->columns, 0, sizeof(browser->columns));
+        browser->level_count = 0;
+        if (!recording_reader_open(&browser->reader, path) || browser->reader.rows == 0) {
+            fprintf(stderr, "Browser: %s is neither a pyramid directory nor a recording\n", path);
+            recording_reader_close(&browser->reader);
+            return false;
+        }
+        browser->from_recording = true;
+        browser->sample_rate = browser->reader.sample_rate;
+        browser->hop = browser->reader.hop;
+        browser->columns[0] = browser->reader.rows;
+        browser->level_count = 1;
+        while (browser->columns[browser->level_count - 1] > 1 && browser->level_count < PYRAMID_MAX_LEVELS) {
+            browser->columns[browser->level_count] = (browser->columns[browser->level_count - 1] + 1) / 2;
+            browser->level_count++;
+        }
+        for (int level = BROWSER_SUMMARY_LEVEL; level < browser->level_count; level++) {
+            browser->summary[level] = malloc(sizeof(float) * browser->columns[level] * PYRAMID_ROWS);
+            if (!browser->summary[level]) {
+                browser_close(browser);
+                return false;
+            }
+        }
+        browser->summary_ready = (browser->level_count <= BROWSER_SUMMARY_LEVEL);
+    }
+
+    unsigned char bgr0[256 * 4];
+    pyramid_palette(bgr0);
+    for (int i = 0; i < 256; i++) {
+        browser->palette[i] = ((Uint32)bgr0[4 * i + 2] << 16) | ((Uint32)bgr0[4 * i + 1] << 8) | bgr0[4 * i];
+    }
+    browser->columns_per_pixel = 1.0;
+
+    browser->mutex = SDL_CreateMutex();
+    browser->wake = SDL_CreateCondition();
+    if (!browser->mutex || !browser->wake) {
+        browser_close(browser);
+        return false;
+    }
+    browser->loader = SDL_CreateThread(browser_loader, "BrowserLoader", browser);
+    if (!browser->loader) {
+        fprintf(stderr, "Browser: could not start the loader thread: %s\n", SDL_GetError());
+        browser_close(browser);
+        return false;
+    }
+    return true;
+}
+
+/*
+    browser_clamp: Keeps the zoom within limits and the view over the data.
+*/
+static void browser_clamp(Browser* browser) {
+    const double total = (double)browser->columns[0];
+    const double width = browser->width > 0 ? browser->width : 1;
+    const double most = fmax(total / width, 1.0) * 2.0;
+    browser->columns_per_pixel = fmin(fmax(browser->columns_per_pixel, 1.0 / BROWSER_MAX_PIXELS_PER_COLUMN), most);
+    const double span = width * browser->columns_per_pixel;
+    browser->view_column = fmin(browser->view_column, total - span);
+    browser->view_column = fmax(browser->view_column, 0.0);
+}
+
+/*
+    browser_fit: Shows the whole recording on the next render.
+*/
+void browser_fit(Browser* browser) {
+    browser->fitted = false;
+}
+
+/*
+    browser_pan: Scrolls the view; positive pixels move the content right.
+*/
+void browser_pan(Browser* browser, float pixels) {
+    browser->view_column -= pixels * browser->columns_per_pixel;
+    browser_clamp(browser);
+}
+
+/*
+    browser_zoom: Scales columns per pixel by factor, keeping the time
+    under window x in place.
+*/
+void browser_zoom(Browser* browser, double factor, float x) {
+    const double anchor = browser->view_column + x * browser->columns_per_pixel;
+    browser->columns_per_pixel *= factor;
+    browser_clamp(browser);
+    browser->view_column = anchor - x * browser->columns_per_pixel;
+    browser_clamp(browser);
+}
+
+/*
+    browser_find: Cache slot holding a tile, or NULL.
+*/
+static BrowserTile* browser_find(Browser* browser, BrowserKey key) {
+    for (int i = 0; i < BROWSER_CACHE_TILES; i++) {
+        if (browser->cache[i].valid && browser_same(browser->cache[i].key, key)) {
+            return &browser->cache[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+    browser_upload: Moves up to BROWSER_UPLOADS_PER_FRAME loaded tiles into
+    the cache, evicting the least recently drawn slots.
+*/
+static void browser_upload(Browser* browser, SDL_Renderer* renderer) {
+    BrowserLoaded batch[BROWSER_UPLOADS_PER_FRAME];
+    SDL_LockMutex(browser->mutex);
+    int count = browser->loaded_count < BROWSER_UPLOADS_PER_FRAME ? browser->loaded_count
+                                                                   : BROWSER_UPLOADS_PER_FRAME;
+    memcpy(batch, browser->loaded, sizeof(BrowserLoaded) * count);
+    memmove(browser->loaded, &browser->loaded[count], sizeof(BrowserLoaded) * (browser->loaded_count - count));
+    browser->loaded_count -= count;
+    if (count > 0) {
+        SDL_SignalCondition(browser->wake);
+    }
+    SDL_UnlockMutex(browser->mutex);
+
+    for (int i = 0; i < count; i++) {
+        BrowserTile* slot = browser_find(browser, batch[i].key);
+        for (int s = 0; !slot && s < BROWSER_CACHE_TILES; s++) {
+            if (!browser->cache[s].valid) {
+                slot = &browser->cache[s];
+            }
+        }
+        if (!slot) {
+            slot = &browser->cache[0];
+            for (int s = 1; s < BROWSER_CACHE_TILES; s++) {
+                if (browser->cache[s].last_used < slot->last_used) {
+                    slot = &browser->cache[s];
+                }
+            }
+        }
+        if (!slot->texture) {
+            slot->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STATIC,
+                                              PYRAMID_TILE, PYRAMID_ROWS);
+        }
+        if (slot->texture) {
+            SDL_Rect rect = { 0, 0, batch[i].width, PYRAMID_ROWS };
+            SDL_UpdateTexture(slot->texture, &rect, batch[i].pixels, PYRAMID_TILE * sizeof(Uint32));
+            slot->key = batch[i].key;
+            slot->width = batch[i].width;
+            slot->last_used = browser->frame;
+            slot->valid = true;
+        }
+        free(batch[i].pixels);
+    }
+}
+
+/*
+    browser_request: Appends a tile to the request list unless it is
+    cached, already listed, or out of range.
+*/
+static void browser_request(Browser* browser, BrowserKey* list, int* count, BrowserKey key) {
+    if (key.level < 0 || key.level >= browser->level_count || key.index < 0 ||
+        key.index >= browser_tile_count(browser, key.level) || *count == BROWSER_MAX_REQUESTS ||
+        browser_find(browser, key)) {
+        return;
+    }
+    for (int i = 0; i < *count; i++) {
+        if (browser_same(list[i], key)) {
+            return;
+        }
+    }
+    list[(*count)++] = key;
+}
+
+/*
+    browser_draw_tile: Draws a tile, or the matching part of the nearest
+    cached ancestor while it is not loaded. Returns whether it was cached.
+*/
+static bool browser_draw_tile(Browser* browser, SDL_Renderer* renderer, BrowserKey key, float height) {
+    const double scale = ldexp(1.0, key.level) / browser->columns_per_pixel;  // Pixels per column.
+    const double x = (ldexp((double)key.index * PYRAMID_TILE, key.level) - browser->view_column) /
+                     browser->columns_per_pixel;
+    BrowserTile* tile = browser_find(browser, key);
+    if (tile) {
+        SDL_FRect src = { 0, 0, (float)tile->width, (float)PYRAMID_ROWS };
+        SDL_FRect dst = { (float)x, 0, (float)(tile->width * scale), height };
+        SDL_RenderTexture(renderer, tile->texture, &src, &dst);
+        tile->last_used = browser->frame;
+        return true;
+    }
+    for (int d = 1; d < BROWSER_FALLBACK_LEVELS && key.level + d < browser->level_count; d++) {
+        BrowserKey up = { key.level + d, key.index >> d };
+        BrowserTile* parent = browser_find(browser, up);
+        if (!parent) {
+            continue;
+        }
+        const double offset = ldexp((double)key.index * PYRAMID_TILE, -d) - (double)up.index * PYRAMID_TILE;
+        const double width = fmin(ldexp(PYRAMID_TILE, -d), parent->width - offset);
+        if (width > 0) {
+            SDL_FRect src = { (float)offset, 0, (float)width, (float)PYRAMID_ROWS };
+            SDL_FRect dst = { (float)x, 0, (float)(width * ldexp(scale, d)), height };
+            SDL_RenderTexture(renderer, parent->texture, &src, &dst);
+            parent->last_used = browser->frame;
+        }
+        break;
+    }
+    return false;
+}
+
+/*
+    browser_render: Uploads finished tiles, draws the visible ones at the
+    level matching the zoom and hands the loader a fresh request list:
+    missing visible tiles first, then neighbours and the adjacent levels.
+*/
+void browser_render(Browser* browser, SDL_Renderer* renderer) {
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    browser->width = win_w > 0 ? win_w : 1;
+    browser->frame++;
+    if (!browser->fitted) {
+        browser->columns_per_pixel = (double)browser->columns[0] / browser->width;
+        browser->view_column = 0.0;
+        browser->fitted = true;
+    }
+    browser_clamp(browser);
+    browser_upload(browser, renderer);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int level = (int)floor(log2(browser->columns_per_pixel));
+    level = level < 0 ? 0 : (level >= browser->level_count ? browser->level_count - 1 : level);
+
+    BrowserKey list[BROWSER_MAX_REQUESTS];
+    int count = 0;
+    const double end_column = browser->view_column + browser->width * browser->columns_per_pixel;
+    for (int pass = 0; pass < 3; pass++) {
+        // Pass 0: this level, drawn. Pass 1: the level above. Pass 2: the level below.
+        const int l = (pass == 0) ? level : (pass == 1 ? level + 1 : level - 1);
+        if (l < 0 || l >= browser->level_count) {
+            continue;
+        }
+        const double span = ldexp(PYRAMID_TILE, l);
+        const int first = (int)floor(browser->view_column / span);
+        const int last = (int)floor((end_column - 1e-9) / span);
+        for (int i = first; i <= last && i < browser_tile_count(browser, l); i++) {
+            BrowserKey key = { l, i };
+            if (pass == 0) {
+                browser_draw_tile(browser, renderer, key, (float)(win_h - 16));
+            }
+            browser_request(browser, list, &count, key);
+        }
+        if (pass == 0) {
+            browser_request(browser, list, &count, (BrowserKey){ l, first - 1 });
+            browser_request(browser, list, &count, (BrowserKey){ l, last + 1 });
+        }
+    }
+
+    SDL_LockMutex(browser->mutex);
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        bool pending = browser->is_loading && browser_same(browser->loading, list[i]);
+        for (int j = 0; j < browser->loaded_count && !pending; j++) {
+            pending = browser_same(browser->loaded[j].key, list[i]);
+        }
+        if (!pending) {
+            browser->requests[kept++] = list[i];
+        }
+    }
+    browser->request_count = kept;
+    const int loaded = browser->loaded_count;
+    const double scanned = browser->from_recording ? (double)browser->scanned / browser->reader.rows : 1.0;
+    SDL_SignalCondition(browser->wake);
+    SDL_UnlockMutex(browser->mutex);
+
+    int cached = 0;
+    for (int i = 0; i < BROWSER_CACHE_TILES; i++) {
+        cached += browser->cache[i].valid;
+    }
+    const double seconds_per_column = (double)browser->hop / browser->sample_rate;
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugTextFormat(renderer, 4, win_h - 12.0f,
+                              "Level %d/%d  %.2f-%.2f s  cache %d/%d  queued %d+%d  summary %.0f%% "
+                              "(wheel/Up/Down: zoom, drag/Left/Right: pan, Home: fit)",
+                              level, browser->level_count - 1, browser->view_column * seconds_per_column,
+                              end_column * seconds_per_column, cached, BROWSER_CACHE_TILES, kept, loaded,
+                              scanned * 100.0);
+}
+
+/*
+    browser_stats: Smoothed tile preparation time and tiles prepared so far.
+*/
+void browser_stats(Browser* browser, float* load_ms, unsigned long long* tiles_loaded) {
+    SDL_LockMutex(browser->mutex);
+    *load_ms = browser->load_ms;
+    *tiles_loaded = browser->tiles_loaded;
+    SDL_UnlockMutex(browser->mutex);
+}
+
+/*
+    browser_close: Stops the loader and releases textures and buffers.
+    Must run before the renderer is destroyed.
+*/
+void browser_close(Browser* browser) {
+    if (browser->loader) {
+        SDL_LockMutex(browser->mutex);
+        browser->stop = true;
+        SDL_SignalCondition(browser->wake);
+        SDL_UnlockMutex(browser->mutex);
+        SDL_WaitThread(browser->loader, NULL);
+    }
+    for (int i = 0; i < browser->loaded_count; i++) {
+        free(browser->loaded[i].pixels);
+    }
+    for (int i = 0; i < BROWSER_CACHE_TILES; i++) {
+        if (browser->cache[i].texture) {
+            SDL_DestroyTexture(browser->cache[i].texture);
+        }
+    }
+    for (int level = 0; level < PYRAMID_MAX_LEVELS; level++) {
+        free(browser->summary[level]);
+    }
+    if (browser->wake) {
+        SDL_DestroyCondition(browser->wake);
+    }
+    if (browser->mutex) {
+        SDL_DestroyMutex(browser->mutex);
+    }
+    recording_reader_close(&browser->reader);
+    memset(browser, 0, sizeof(*browser));
+}
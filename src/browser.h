@@ -0,0 +1,112 @@
+#ifndef BROWSER_H
+#define BROWSER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "pyramid.h"
+#include "recording.h"
+
+// Tile textures kept on the GPU (256 KiB each), least recently drawn evicted first.
+#define BROWSER_CACHE_TILES 128
+
+// Tiles the loader may be asked for at once, and loaded tiles waiting for upload.
+#define BROWSER_MAX_REQUESTS 64
+#define BROWSER_MAX_LOADED 8
+
+// Texture uploads per rendered frame, bounding the upload cost while scrolling.
+#define BROWSER_UPLOADS_PER_FRAME 4
+
+// Recordings: levels from here up are served from an in-memory summary.
+#define BROWSER_SUMMARY_LEVEL 6
+
+// Recording rows folded into the summary per idle step of the loader.
+#define BROWSER_SCAN_ROWS 2048
+
+/*
+    BrowserKey: Identifies a tile: its level and position along the level.
+*/
+typedef struct {
+    int level;
+    int index;
+} BrowserKey;
+
+/*
+    BrowserTile: One cache slot. Only the main thread touches the cache.
+*/
+typedef struct {
+    BrowserKey key;
+    int width;                 // Columns in the tile; the last one of a level may be narrower.
+    SDL_Texture* texture;
+    Uint64 last_used;          // Frame the tile was last drawn.
+    bool valid;
+} BrowserTile;
+
+/*
+    BrowserLoaded: A tile the loader has prepared, waiting for the main
+    thread to upload it.
+*/
+typedef struct {
+    BrowserKey key;
+    int width;
+    Uint32* pixels;            // XRGB8888, PYRAMID_TILE wide, highest frequency first.
+} BrowserLoaded;
+
+/*
+    Browser: Zoomable view over a whole recording.
+
+    Tiles come from a pyramid directory written by --pyramid, or are
+    computed on demand from a recording: lower levels straight from the
+    rows, upper levels from a summary the loader builds in the background.
+    A loader thread prepares pixels for the tiles the main thread asks
+    for (visible ones first, then neighbours and the adjacent zoom levels);
+    the main thread uploads a few per frame into an LRU cache of textures
+    and draws a coarser cached tile wherever a tile is not ready yet.
+*/
+typedef struct {
+    // Tile source.
+    bool from_recording;
+    char directory[1024];
+    RecordingReader reader;
+    PyramidReduce reduce;
+    int sample_rate;
+    int hop;
+    int level_count;
+    unsigned long long columns[PYRAMID_MAX_LEVELS];
+    float* summary[PYRAMID_MAX_LEVELS];          // Column-major PYRAMID_ROWS dB levels.
+    unsigned long long scanned;                   // Rows folded into the summary; guarded by mutex.
+    bool summary_ready;                           // Guarded by mutex.
+
+    // Loader thread and its queues, guarded by mutex.
+    SDL_Thread* loader;
+    SDL_Mutex* mutex;
+    SDL_Condition* wake;
+    bool stop;
+    BrowserKey requests[BROWSER_MAX_REQUESTS];
+    int request_count;
+    BrowserKey loading;                           // Tile being prepared, if is_loading.
+    bool is_loading;
+    BrowserLoaded loaded[BROWSER_MAX_LOADED];
+    int loaded_count;
+    float load_ms;                                // Smoothed time to prepare a tile.
+    unsigned long long tiles_loaded;
+
+    // Main thread: texture cache and view.
+    BrowserTile cache[BROWSER_CACHE_TILES];
+    Uint64 frame;
+    Uint32 palette[256];
+    int width;                                    // Window width at the last render.
+    double view_column;                           // Level-0 column at the left edge.
+    double columns_per_pixel;
+    bool fitted;
+} Browser;
+
+bool browser_open(Browser* browser, const char* path, PyramidReduce reduce);
+void browser_fit(Browser* browser);
+void browser_pan(Browser* browser, float pixels);
+void browser_zoom(Browser* browser, double factor, float x);
+void browser_render(Browser* browser, SDL_Renderer* renderer);
+void browser_stats(Browser* browser, float* load_ms, unsigned long long* tiles_loaded);
+void browser_close(Browser* browser);
+
+#endif
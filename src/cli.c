@@ -0,0 +1,322 @@
+#include "cli.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "offline.h"
+#include "preset.h"
+
+// Length of generated input for headless and benchmark runs, in seconds.
+#define CLI_DEFAULT_DURATION 60.0
+
+static const char* cli_modes[] = {
+    "spectrum", "hpss", "features", "rta", "transfer", "psd", "spectrogram"
+};
+
+/*
+    parse_int: Strict positive integer parse for option values.
+*/
+static bool parse_int(const char* text, int* out) {
+    char* end;
+    long v = strtol(text, &end, 10);
+    if (*end != '\0' || v <= 0 || v > (1 << 24)) {
+        return false;
+    }
+    *out = (int)v;
+    return true;
+}
+
+/*
+    cli_parse: Fills options from argv. Prints the problem and returns false
+    on an unknown option, a missing value or a bad value.
+*/
+bool cli_parse(int argc, char* argv[], CliOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->source = SOURCE_DEVICE;
+    options->frequency = 1000.0;
+    options->duration = CLI_DEFAULT_DURATION;
+    options->mode = "spectrum";
+    options->record_format = FRAME_DB8;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool takes_value = true;
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            options->help = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--self-test") == 0) {
+            options->self_test = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--headless") == 0) {
+            options->headless = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--benchmark") == 0) {
+            options->benchmark = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--howl") == 0) {
+            options->howl = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--similar-bench") == 0) {
+            options->similar_bench = true;
+            takes_value = false;
+        } else if (strcmp(arg, "--preset-bench") == 0) {
+            options->preset_bench = true;
+            takes_value = false;
+        } else if (!value) {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            return false;
+        } else if (strcmp(arg, "--source") == 0) {
+            if (!source_parse(value, &options->source, &options->source_path, &options->frequency)) {
+                fprintf(stderr, "Bad --source '%s': use device, file:PATH, sine[:HZ], noise or sweep.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--duration") == 0) {
+            options->duration = strtod(value, NULL);
+            if (options->duration <= 0) {
+                fprintf(stderr, "Bad --duration '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--mode") == 0) {
+            bool known = false;
+            for (size_t m = 0; m < sizeof(cli_modes) / sizeof(cli_modes[0]); m++) {
+                known |= (strcmp(value, cli_modes[m]) == 0);
+            }
+            if (!known) {
+                fprintf(stderr, "Unknown --mode '%s'.\n", value);
+                return false;
+            }
+            options->mode = value;
+        } else if (strcmp(arg, "--fft-size") == 0) {
+            if (!parse_int(value, &options->fft_size) || (options->fft_size & (options->fft_size - 1))) {
+                fprintf(stderr, "--fft-size must be a power of two.\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--hop") == 0) {
+            if (!parse_int(value, &options->hop)) {
+                fprintf(stderr, "Bad --hop '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--fft-batch") == 0) {
+            if (!parse_int(value, &options->fft_batch) || options->fft_batch > OFFLINE_MAX_BATCH) {
+                fprintf(stderr, "--fft-batch must be 1 to %d.\n", OFFLINE_MAX_BATCH);
+                return false;
+            }
+        } else if (strcmp(arg, "--record") == 0) {
+            options->record_path = value;
+        } else if (strcmp(arg, "--record-format") == 0) {
+            if (strcmp(value, "f32") == 0) {
+                options->record_format = FRAME_FLOAT32;
+            } else if (strcmp(value, "f16") == 0) {
+                options->record_format = FRAME_FLOAT16;
+            } else if (strcmp(value, "db8") == 0) {
+                options->record_format = FRAME_DB8;
+            } else {
+                fprintf(stderr, "Bad --record-format '%s': use f32, f16 or db8.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--pyramid") == 0) {
+            options->pyramid_path = value;
+        } else if (strcmp(arg, "--pyramid-reduce") == 0) {
+            if (strcmp(value, "max") == 0) {
+                options->pyramid_reduce = PYRAMID_MAX;
+            } else if (strcmp(value, "mean") == 0) {
+                options->pyramid_reduce = PYRAMID_MEAN;
+            } else {
+                fprintf(stderr, "Bad --pyramid-reduce '%s': use max or mean.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--fingerprint") == 0) {
+            options->fingerprint_path = value;
+        } else if (strcmp(arg, "--triggers") == 0) {
+            options->trigger_path = value;
+        } else if (strcmp(arg, "--similar") == 0) {
+            options->similar_path = value;
+        } else if (strcmp(arg, "--similar-build") == 0) {
+            options->similar_build = value;
+        } else if (strcmp(arg, "--similar-query") == 0) {
+            options->similar_query = value;
+        } else if (strcmp(arg, "--similar-probe") == 0) {
+            if (!parse_int(value, &options->similar_probe)) {
+                fprintf(stderr, "Bad --similar-probe '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--plugin") == 0) {
+            if (options->plugin_count == PLUGIN_MAX) {
+                fprintf(stderr, "At most %d --plugin options.\n", PLUGIN_MAX);
+                return false;
+            }
+            options->plugin_specs[options->plugin_count++] = value;
+        } else if (strcmp(arg, "--preset") == 0) {
+            options->preset_path = value;
+        } else if (strcmp(arg, "--preset-columns") == 0) {
+            if (!parse_int(value, &options->preset_columns) || options->preset_columns > PRESET_MAX_COLUMNS) {
+                fprintf(stderr, "--preset-columns must be 1 to %d.\n", PRESET_MAX_COLUMNS);
+                return false;
+            }
+        } else if (strcmp(arg, "--browse") == 0) {
+            options->browse_path = value;
+        } else if (strcmp(arg, "--shm") == 0) {
+            options->shm_name = value;
+        } else if (strcmp(arg, "--video") == 0) {
+            options->video_path = value;
+        } else if (strcmp(arg, "--batch") == 0) {
+            options->batch_path = value;
+            options->headless = true;
+        } else if (strcmp(arg, "--jobs") == 0) {
+            if (!parse_int(value, &options->jobs)) {
+                fprintf(stderr, "Bad --jobs '%s'.\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--index") == 0) {
+            options->index_path = value;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return false;
+        }
+        if (takes_value) {
+            i++;
+        }
+    }
+
+    if ((options->headless || options->benchmark) && options->source == SOURCE_DEVICE) {
+        options->source = SOURCE_NOISE;  // Offline runs need a finite input.
+    }
+    if ((options->headless || options->benchmark) && options->video_path) {
+        fprintf(stderr, "--video needs the window.\n");
+        return false;
+    }
+    if (options->pyramid_path && (!options->headless || options->batch_path)) {
+        fprintf(stderr, "--pyramid needs --headless and a single input.\n");
+        return false;
+    }
+    if (options->browse_path && (options->headless || options->benchmark)) {
+        fprintf(stderr, "--browse needs the window.\n");
+        return false;
+    }
+    if (options->plugin_count && (options->headless || options->benchmark)) {
+        fprintf(stderr, "--plugin needs the window.\n");
+        return false;
+    }
+    if (!options->preset_path && (options->preset_columns || options->preset_bench)) {
+        fprintf(stderr, "--preset-columns and --preset-bench need --preset.\n");
+        return false;
+    }
+    if (options->preset_path && !options->preset_bench && (options->headless || options->benchmark)) {
+        fprintf(stderr, "--preset needs the window or --preset-bench.\n");
+        return false;
+    }
+    if (options->fingerprint_path && options->benchmark) {
+        fprintf(stderr, "--fingerprint cannot be used with --benchmark.\n");
+        return false;
+    }
+    if (options->howl && (options->benchmark || options->batch_path)) {
+        fprintf(stderr, "--howl cannot be used with --benchmark or --batch.\n");
+        return false;
+    }
+    if (options->trigger_path && (options->benchmark || options->batch_path)) {
+        fprintf(stderr, "--triggers cannot be used with --benchmark or --batch.\n");
+        return false;
+    }
+    const int similar_actions = (options->similar_build != NULL) + (options->similar_query != NULL) +
+                                options->similar_bench;
+    if (options->similar_path && similar_actions != 1) {
+        fprintf(stderr, "--similar needs one of --similar-build, --similar-query or --similar-bench.\n");
+        return false;
+    }
+    if (!options->similar_path && (similar_actions || options->similar_probe)) {
+        fprintf(stderr, "--similar-build, --similar-query, --similar-probe and --similar-bench need --similar.\n");
+        return false;
+    }
+    if (!options->batch_path && options->index_path) {
+        fprintf(stderr, "--index needs --batch.\n");
+        return false;
+    }
+    if (options->jobs && !options->headless && !options->benchmark) {
+        fprintf(stderr, "--jobs needs --batch, --headless or --benchmark.\n");
+        return false;
+    }
+    if (options->hop && options->fft_size && options->hop > options->fft_size) {
+        fprintf(stderr, "--hop cannot exceed --fft-size.\n");
+        return false;
+    }
+    return true;
+}
+
+/*
+    cli_usage: Prints the option summary.
+*/
+void cli_usage(const char* program) {
+    printf("Usage: %s [options]\n"
+           "\n"
+           "Input:\n"
+           "  --source SRC          device (default), file:PATH, sine[:HZ], noise or sweep\n"
+           "  --duration SECONDS    Generator length for headless and benchmark runs (default 60)\n"
+           "\n"
+           "Analysis:\n"
+           "  --mode MODE           spectrum, hpss, features, rta, transfer, psd or spectrogram;\n"
+           "                        the initial view in the window, the output when headless\n"
+           "  --fft-size N          FFT size (power of two)\n"
+           "  --hop N               Samples between frames\n"
+           "  --fft-batch K         Windows per FFT call when headless (default 8); a\n"
+           "                        benchmark without it compares batch sizes\n"
+           "\n"
+           "Output:\n"
+           "  --headless            Analyse without a window, as fast as the input can be read\n"
+           "  --record PATH         Write one spectrogram row per hop to PATH\n"
+           "  --record-format F     f32, f16 or db8 (default db8)\n"
+           "  --pyramid DIR         Write the spectrogram as a tiled zoom pyramid of BMP\n"
+           "                        images into DIR (headless)\n"
+           "  --pyramid-reduce R    max (default) or mean when halving the time axis\n"
+           "  --browse PATH         Open a recording or pyramid directory in the zoomable\n"
+           "                        browser view (Z toggles it)\n"
+           "  --shm NAME            Publish the latest row in a named shared-memory block\n"
+           "  --video PATH          Append every rendered frame to PATH as a PPM stream\n"
+           "  --benchmark           Process the input with no sinks and report throughput\n"
+           "\n"
+           "Batch:\n"
+           "  --batch LIST          Analyse every WAV file listed in LIST (one path per line)\n"
+           "                        in parallel; --record then names an output directory\n"
+           "  --jobs N              Worker threads for a batch, or for splitting one file\n"
+           "                        when headless (default: one per logical core)\n"
+           "  --index PATH          Write a CSV summary of every file to PATH\n"
+           "\n"
+           "Identification:\n"
+           "  --fingerprint PATH    With --batch, build a landmark index of the listed files\n"
+           "                        at PATH; otherwise name the reference track the input\n"
+           "                        plays (CSV on stdout when headless, title in the window)\n"
+           "\n"
+           "Events:\n"
+           "  --triggers PATH       Evaluate the rules in PATH every hop, one per line:\n"
+           "                        NAME FEATURE [LO HI] >|< DB [for SECONDS] ACTION, with\n"
+           "                        FEATURE level, band, peak or prominence and ACTION\n"
+           "                        log [FILE], udp ADDRESS:PORT or exec COMMAND\n"
+           "  --howl                Warn of acoustic feedback: persistent, growing narrowband\n"
+           "                        peaks without harmonics (CSV on stdout when headless;\n"
+           "                        use a short hop there, e.g. --fft-size 1024 --hop 128)\n"
+           "\n"
+           "Similarity:\n"
+           "  --similar PATH        Similarity index of per-second mel summaries, used with:\n"
+           "  --similar-build LIST  Index every recording listed in LIST into PATH\n"
+           "  --similar-query REC[@S]  Print the seconds most like second S of recording REC\n"
+           "  --similar-probe N     Search only the N nearest of the index's lists; without\n"
+           "                        it, every vector is searched exactly\n"
+           "  --similar-bench       Compare exact and approximate search: recall and latency\n"
+           "\n"
+           "Plugins:\n"
+           "  --plugin PATH[@MS]    Load an analysis or render plugin DLL (repeatable); MS\n"
+           "                        overrides its time budget per call (default 1 ms per\n"
+           "                        hop, 2 ms per frame). X shows the plugin view\n"
+           "\n"
+           "Presets:\n"
+           "  --preset PATH         Draw columns whose position, size and colour come from\n"
+           "                        the expressions in PATH (M shows the view and reloads PATH)\n"
+           "  --preset-columns N    Columns drawn per frame, up to 1024 (default 128)\n"
+           "  --preset-bench        Time the compiled preset against a per-column interpreter\n"
+           "\n"
+           "  --self-test           Run the built-in consistency checks and exit\n"
+           "  --help                Show this text\n",
+           program);
+}
@@ -0,0 +1,56 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <stdbool.h>
+
+#include "compact.h"
+#include "plugin.h"
+#include "pyramid.h"
+#include "source.h"
+
+/*
+    CliOptions: Everything selectable on the command line. Zero sizes mean
+    "use the build's defaults".
+*/
+typedef struct {
+    SourceType source;
+    const char* source_path;
+    double frequency;          // Sine generator frequency.
+    double duration;           // Generator length in seconds for headless runs.
+    const char* mode;          // View in the window, analysis in headless runs.
+    int fft_size;
+    int hop;
+    int fft_batch;             // Windows per FFT call offline (0 = default).
+    bool headless;
+    bool benchmark;
+    const char* record_path;
+    FrameFormat record_format;
+    const char* shm_name;
+    const char* pyramid_path;  // Directory for a tiled spectrogram pyramid (headless).
+    PyramidReduce pyramid_reduce;  // Also used for tiles computed by --browse.
+    const char* browse_path;   // Recording or pyramid directory to open in the browser view.
+    const char* video_path;
+    const char* batch_path;    // File list for batch analysis; --record is then a directory.
+    int jobs;                  // Batch workers (0 = one per logical core).
+    const char* index_path;    // Combined per-file summary of a batch.
+    const char* fingerprint_path; // Reference index: built by a batch, queried otherwise.
+    bool howl;                 // Report acoustic feedback as it starts.
+    const char* trigger_path;  // Rules evaluated against every row.
+    const char* similar_path;  // Similarity index used by the --similar-* actions.
+    const char* similar_build; // List of recordings to index.
+    const char* similar_query; // Recording, optionally @SECONDS, to find similar seconds for.
+    int similar_probe;         // Lists searched per query (0 = exact search).
+    bool similar_bench;
+    const char* plugin_specs[PLUGIN_MAX];  // PATH[@MS] of each plugin DLL, in load order.
+    int plugin_count;
+    const char* preset_path;   // Expressions computing each column of the preset view.
+    int preset_columns;        // Columns the preset draws (0 = default).
+    bool preset_bench;
+    bool self_test;
+    bool help;
+} CliOptions;
+
+bool cli_parse(int argc, char* argv[], CliOptions* options);
+void cli_usage(const char* program);
+
+#endif
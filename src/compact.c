@@ -0,0 +1,171 @@
+#include "compact.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#define COMPACT_F16C 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COMPACT_SSE2 1
+#endif
+
+/*
+    half_from_float: Scalar float to IEEE half with round-to-nearest-even,
+    used where F16C is not available.
+*/
+static uint16_t half_from_float(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude >= 0x7F800000u) {
+        // Inf stays Inf; NaN stays a quiet NaN.
+        return (uint16_t)(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0));
+    }
+    if (magnitude >= 0x477FF000u) {
+        return (uint16_t)(sign | 0x7C00u);  // Rounds beyond the largest half.
+    }
+    if (magnitude < 0x38800000u) {
+        // Subnormal half: shift the mantissa with its implicit bit into place.
+        if (magnitude < 0x33000000u) {
+            return (uint16_t)sign;
+        }
+        uint32_t exponent = magnitude >> 23;
+        uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+        uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) {
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+    uint32_t half = (magnitude - 0x38000000u) >> 13;
+    uint32_t rest = magnitude & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return (uint16_t)(sign | half);
+}
+
+/*
+    float_from_half: Scalar IEEE half to float.
+*/
+static float float_from_half(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // Normalise a subnormal half.
+        exponent = 113;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    } else {
+        bits = sign;
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/*
+    compact_frame_bytes: Storage needed for count values in a format.
+*/
+size_t compact_frame_bytes(FrameFormat format, int count) {
+    switch (format) {
+    case FRAME_FLOAT16: return sizeof(uint16_t) * (size_t)count;
+    case FRAME_DB8:     return (size_t)count;
+    default:            return sizeof(float) * (size_t)count;
+    }
+}
+
+/*
+    compact_encode: Packs count dB values into out.
+*/
+void compact_encode(FrameFormat format, const float* values, void* out, int count) {
+    int i = 0;
+    if (format == FRAME_FLOAT16) {
+        uint16_t* dst = out;
+#ifdef COMPACT_F16C
+        for (; i + 4 <= count; i += 4) {
+            __m128i half = _mm_cvtps_ph(_mm_loadu_ps(&values[i]), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storel_epi64((__m128i*)&dst[i], half);
+        }
+#endif
+        for (; i < count; i++) {
+            dst[i] = half_from_float(values[i]);
+        }
+    } else if (format == FRAME_DB8) {
+        uint8_t* dst = out;
+        const float scale = 1.0f / COMPACT_DB8_STEP;
+#ifdef COMPACT_SSE2
+        const __m128 vmin = _mm_set1_ps(COMPACT_DB8_MIN);
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 16 <= count; i += 16) {
+            // Round to nearest; packus saturates to 0..255.
+            __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&values[i]), vmin), vscale));
+            __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&values[i + 4]), vmin), vscale));
+            __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&values[i + 8]), vmin), vscale));
+            __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&values[i + 12]), vmin), vscale));
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128((__m128i*)&dst[i], packed);
+        }
+#endif
+        for (; i < count; i++) {
+            // lrintf rounds half to even, as the SSE2 conversion does.
+            float code = (values[i] - COMPACT_DB8_MIN) * scale;
+            dst[i] = (uint8_t)(code <= 0.0f ? 0 : (code >= 255.0f ? 255 : lrintf(code)));
+        }
+    } else {
+        memcpy(out, values, sizeof(float) * (size_t)count);
+    }
+}
+
+/*
+    compact_decode: Expands count packed values back to dB.
+*/
+void compact_decode(FrameFormat format, const void* in, float* values, int count) {
+    int i = 0;
+    if (format == FRAME_FLOAT16) {
+        const uint16_t* src = in;
+#ifdef COMPACT_F16C
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(&values[i], _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)&src[i])));
+        }
+#endif
+        for (; i < count; i++) {
+            values[i] = float_from_half(src[i]);
+        }
+    } else if (format == FRAME_DB8) {
+        const uint8_t* src = in;
+        for (; i < count; i++) {
+            values[i] = COMPACT_DB8_MIN + src[i] * COMPACT_DB8_STEP;
+        }
+    } else {
+        memcpy(values, in, sizeof(float) * (size_t)count);
+    }
+}
+
+const char* compact_format_name(FrameFormat format) {
+    switch (format) {
+    case FRAME_FLOAT16: return "float16";
+    case FRAME_DB8:     return "8-bit dB";
+    default:            return "float32";
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stddef.h>
+
+// dB range of the 8-bit format: code c stands for COMPACT_DB8_MIN + c * COMPACT_DB8_STEP.
+#define COMPACT_DB8_MIN -100.0f
+#define COMPACT_DB8_STEP 0.5f
+
+/*
+    FrameFormat: Storage format for rows of dB values.
+
+    FRAME_FLOAT16 keeps an IEEE half per value; the rounding error is at
+    most 2^-11 of the value (0.031 dB for levels within +/-100 dB).
+    FRAME_DB8 quantises to 0.5 dB steps from -100 dB to +27.5 dB: values
+    inside that range are off by at most 0.25 dB, values outside clamp.
+*/
+typedef enum {
+    FRAME_FLOAT32,
+    FRAME_FLOAT16,
+    FRAME_DB8
+} FrameFormat;
+
+size_t compact_frame_bytes(FrameFormat format, int count);
+void compact_encode(FrameFormat format, const float* values, void* out, int count);
+void compact_decode(FrameFormat format, const void* in, float* values, int count);
+const char* compact_format_name(FrameFormat format);
+
+#endif
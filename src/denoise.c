@@ -0,0 +1,129 @@
+#include "denoise.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DENOISE_SSE2 1
+#endif
+
+/*
+    denoise_init: Allocates the profile buffers. No gain is applied until a
+    profile has been captured.
+*/
+bool denoise_init(DenoiseState* dn, int bins, float over_subtraction, float floor_gain) {
+    memset(dn, 0, sizeof(*dn));
+    dn->bins = bins;
+    dn->over_subtraction = over_subtraction;
+    dn->floor_gain = floor_gain;
+    dn->capture_sum = calloc(bins, sizeof(double));
+    dn->noise_magnitude = calloc(bins, sizeof(float));
+    dn->noise_power = calloc(2 * (size_t)bins, sizeof(float));
+    if (!dn->capture_sum || !dn->noise_magnitude || !dn->noise_power) {
+        denoise_free(dn);
+        return false;
+    }
+    return true;
+}
+
+/*
+    denoise_start_capture: Begins averaging the next `frames` spectra.
+*/
+void denoise_start_capture(DenoiseState* dn, int frames) {
+    memset(dn->capture_sum, 0, sizeof(double) * dn->bins);
+    dn->capture_frames = 0;
+    dn->capture_target = frames;
+}
+
+/*
+    denoise_capture: Adds a raw (un-denoised) spectrum to the running
+    capture and installs the profile once enough frames were seen.
+*/
+void denoise_capture(DenoiseState* dn, const fftwf_complex* spectrum) {
+    if (dn->capture_target == 0) {
+        return;
+    }
+    for (int k = 0; k < dn->bins; k++) {
+        dn->capture_sum[k] += sqrtf(spectrum[k][0] * spectrum[k][0] + spectrum[k][1] * spectrum[k][1]);
+    }
+    if (++dn->capture_frames < dn->capture_target) {
+        return;
+    }
+
+    for (int k = 0; k < dn->bins; k++) {
+        float mean = (float)(dn->capture_sum[k] / dn->capture_frames);
+        float power = dn->over_subtraction * mean * mean + 1e-20f;
+        dn->noise_magnitude[k] = mean;
+        dn->noise_power[2 * k] = power;
+        dn->noise_power[2 * k + 1] = power;
+    }
+    dn->capture_target = 0;
+    dn->has_profile = true;
+}
+
+/*
+    denoise_gain: Scalar gain rule shared by the tail of the SIMD loop.
+    p is the bin power, n the scaled noise power.
+*/
+static inline float denoise_gain(DenoiseMode mode, float p, float n, float floor_gain) {
+    float gain;
+    if (mode == DENOISE_SUBTRACTION) {
+        gain = sqrtf(fmaxf(1.0f - n / (p + 1e-30f), 0.0f));
+    } else {
+        float snr = fmaxf(p / n - 1.0f, 0.0f);
+        gain = snr / (snr + 1.0f);
+    }
+    return fmaxf(gain, floor_gain);
+}
+
+/*
+    denoise_apply: Scales every bin of the spectrum by its gain in place.
+*/
+void denoise_apply(const DenoiseState* dn, DenoiseMode mode, fftwf_complex* spectrum) {
+    if (mode == DENOISE_OFF || !dn->has_profile) {
+        return;
+    }
+    float* x = (float*)spectrum;
+    const float* noise = dn->noise_power;
+    int k = 0;
+
+#ifdef DENOISE_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 tiny = _mm_set1_ps(1e-30f);
+    const __m128 floor_gain = _mm_set1_ps(dn->floor_gain);
+    for (; k + 2 <= dn->bins; k += 2) {
+        __m128 v = _mm_loadu_ps(&x[2 * k]);            // re0 im0 re1 im1
+        __m128 sq = _mm_mul_ps(v, v);
+        __m128 p = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 n = _mm_loadu_ps(&noise[2 * k]);
+        __m128 gain;
+        if (mode == DENOISE_SUBTRACTION) {
+            gain = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_div_ps(n, _mm_add_ps(p, tiny))), zero));
+        } else {
+            __m128 snr = _mm_max_ps(_mm_sub_ps(_mm_div_ps(p, n), one), zero);
+            gain = _mm_div_ps(snr, _mm_add_ps(snr, one));
+        }
+        gain = _mm_max_ps(gain, floor_gain);
+        _mm_storeu_ps(&x[2 * k], _mm_mul_ps(v, gain));
+    }
+#endif
+    for (; k < dn->bins; k++) {
+        float p = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+        float gain = denoise_gain(mode, p, noise[2 * k], dn->floor_gain);
+        x[2 * k] *= gain;
+        x[2 * k + 1] *= gain;
+    }
+}
+
+/*
+    denoise_free: Releases the profile buffers.
+*/
+void denoise_free(DenoiseState* dn) {
+    free(dn->capture_sum);
+    free(dn->noise_magnitude);
+    free(dn->noise_power);
+    memset(dn, 0, sizeof(*dn));
+}
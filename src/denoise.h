@@ -0,0 +1,44 @@
+#ifndef DENOISE_H
+#define DENOISE_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+/*
+    DenoiseMode selects the gain rule applied to each bin.
+*/
+typedef enum {
+    DENOISE_OFF,
+    DENOISE_SUBTRACTION,   // Power spectral subtraction.
+    DENOISE_WIENER         // Wiener gain from the estimated a-posteriori SNR.
+} DenoiseMode;
+
+/*
+    DenoiseState: Noise profile capture and a spectral gain stage.
+
+    The profile is the average magnitude per bin over a capture period. The
+    gain is evaluated and applied directly to the interleaved complex
+    spectrum, two bins per SSE register, so the stage reads the spectrum
+    once and needs no separate gain buffer.
+*/
+typedef struct {
+    int bins;
+    float over_subtraction;  // Scales the noise estimate (alpha).
+    float floor_gain;        // Lowest gain applied to any bin.
+
+    double* capture_sum;     // Magnitude sums during capture.
+    int capture_frames;
+    int capture_target;      // Frames left to capture; 0 when idle.
+    bool has_profile;
+
+    float* noise_magnitude;  // Averaged noise magnitude per bin.
+    float* noise_power;      // alpha * noise^2, duplicated per re/im lane.
+} DenoiseState;
+
+bool denoise_init(DenoiseState* dn, int bins, float over_subtraction, float floor_gain);
+void denoise_start_capture(DenoiseState* dn, int frames);
+void denoise_capture(DenoiseState* dn, const fftwf_complex* spectrum);
+void denoise_apply(const DenoiseState* dn, DenoiseMode mode, fftwf_complex* spectrum);
+void denoise_free(DenoiseState* dn);
+
+#endif
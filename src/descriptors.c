@@ -0,0 +1,189 @@
+#include "descriptors.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DESCRIPTORS_SSE2 1
+#endif
+
+// Bins per block of the power-sum table used to locate the rolloff.
+#define DESCRIPTOR_BLOCK 64
+
+// Keeps the logarithm finite for silent bins.
+#define DESCRIPTOR_FLOOR 1e-20f
+
+/*
+    log2_approx: Exponent plus a quartic fit of log2 over the mantissa
+    (absolute error below 1e-4), so both terms are in log2 units and a
+    flat spectrum has flatness 1; the SIMD path uses the same polynomial.
+*/
+static inline float log2_approx(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float e = (float)((int)(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    return e + (-2.5128774f + (4.0701350f + (-2.1206994f + (0.64514372f - 0.081614486f * m) * m) * m) * m);
+}
+
+#ifdef DESCRIPTORS_SSE2
+static inline __m128 log2_approx_ps(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                             _mm_set1_epi32(0x3F800000)));
+    __m128 p = _mm_sub_ps(_mm_set1_ps(0.64514372f), _mm_mul_ps(_mm_set1_ps(0.081614486f), m));
+    p = _mm_add_ps(_mm_set1_ps(-2.1206994f), _mm_mul_ps(p, m));
+    p = _mm_add_ps(_mm_set1_ps(4.0701350f), _mm_mul_ps(p, m));
+    p = _mm_add_ps(_mm_set1_ps(-2.5128774f), _mm_mul_ps(p, m));
+    return _mm_add_ps(e, p);
+}
+
+static inline float horizontal_sum(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+static inline float horizontal_max(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+/*
+    descriptors_init: Allocates the flux history and block-sum table.
+*/
+bool descriptors_init(DescriptorState* desc, int bins, float bin_hz, float rolloff_fraction) {
+    memset(desc, 0, sizeof(*desc));
+    desc->bins = bins;
+    desc->bin_hz = bin_hz;
+    desc->rolloff_fraction = rolloff_fraction;
+    desc->block_count = (bins + DESCRIPTOR_BLOCK - 1) / DESCRIPTOR_BLOCK;
+    desc->prev_magnitude = calloc(bins, sizeof(float));
+    desc->block_sums = calloc(desc->block_count, sizeof(double));
+    if (!desc->prev_magnitude || !desc->block_sums) {
+        descriptors_free(desc);
+        return false;
+    }
+    return true;
+}
+
+/*
+    descriptors_compute: Fused single pass over the power spectrum.
+    Each block accumulates sum(P), sum(f*P), sum(f^2*P), sum(log2 P),
+    max(P) and the rectified magnitude flux in SIMD registers, then folds
+    them into double totals so long spectra do not lose precision.
+*/
+void descriptors_compute(DescriptorState* desc, const float* power, SpectralFeatures* out) {
+    const int bins = desc->bins;
+    const float bin_hz = desc->bin_hz;
+    float* prev = desc->prev_magnitude;
+
+    double sum_p = 0, sum_fp = 0, sum_ffp = 0, sum_log = 0, flux = 0;
+    float peak = 0;
+
+    for (int block = 0; block < desc->block_count; block++) {
+        const int begin = block * DESCRIPTOR_BLOCK;
+        const int end = (begin + DESCRIPTOR_BLOCK < bins) ? begin + DESCRIPTOR_BLOCK : bins;
+        int k = begin;
+        float b_p = 0, b_fp = 0, b_ffp = 0, b_log = 0, b_flux = 0, b_peak = 0;
+
+#ifdef DESCRIPTORS_SSE2
+        __m128 v_p = _mm_setzero_ps(), v_fp = _mm_setzero_ps(), v_ffp = _mm_setzero_ps();
+        __m128 v_log = _mm_setzero_ps(), v_flux = _mm_setzero_ps(), v_peak = _mm_setzero_ps();
+        const __m128 v_hz = _mm_set1_ps(bin_hz);
+        const __m128 v_floor = _mm_set1_ps(DESCRIPTOR_FLOOR);
+        const __m128i lane = _mm_set_epi32(3, 2, 1, 0);
+        for (; k + 4 <= end; k += 4) {
+            __m128 p = _mm_loadu_ps(&power[k]);
+            __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(k), lane)), v_hz);
+            __m128 fp = _mm_mul_ps(f, p);
+            v_p = _mm_add_ps(v_p, p);
+            v_fp = _mm_add_ps(v_fp, fp);
+            v_ffp = _mm_add_ps(v_ffp, _mm_mul_ps(f, fp));
+            v_log = _mm_add_ps(v_log, log2_approx_ps(_mm_max_ps(p, v_floor)));
+            v_peak = _mm_max_ps(v_peak, p);
+
+            __m128 mag = _mm_sqrt_ps(p);
+            __m128 rise = _mm_sub_ps(mag, _mm_loadu_ps(&prev[k]));
+            v_flux = _mm_add_ps(v_flux, _mm_max_ps(rise, _mm_setzero_ps()));
+            _mm_storeu_ps(&prev[k], mag);
+        }
+        b_p = horizontal_sum(v_p);
+        b_fp = horizontal_sum(v_fp);
+        b_ffp = horizontal_sum(v_ffp);
+        b_log = horizontal_sum(v_log);
+        b_flux = horizontal_sum(v_flux);
+        b_peak = horizontal_max(v_peak);
+#endif
+        for (; k < end; k++) {
+            float p = power[k];
+            float f = k * bin_hz;
+            b_p += p;
+            b_fp += f * p;
+            b_ffp += f * f * p;
+            b_log += log2_approx(fmaxf(p, DESCRIPTOR_FLOOR));
+            b_peak = fmaxf(b_peak, p);
+
+            float mag = sqrtf(p);
+            b_flux += fmaxf(mag - prev[k], 0.0f);
+            prev[k] = mag;
+        }
+
+        desc->block_sums[block] = b_p;
+        sum_p += b_p;
+        sum_fp += b_fp;
+        sum_ffp += b_ffp;
+        sum_log += b_log;
+        flux += b_flux;
+        peak = fmaxf(peak, b_peak);
+    }
+
+    const double total = sum_p + 1e-30;
+    const double centroid = sum_fp / total;
+    const double variance = sum_ffp / total - centroid * centroid;
+    const double mean_p = total / bins;
+
+    out->centroid = (float)centroid;
+    out->spread = (float)sqrt(variance > 0 ? variance : 0);
+    out->flatness = (float)(exp2(sum_log / bins) / mean_p);
+    out->crest = (float)(peak / mean_p);
+    out->flux = (float)flux;
+
+    // Rolloff: find the block via the sums table, then scan only that block.
+    const double target = desc->rolloff_fraction * sum_p;
+    double cumulative = 0;
+    int rolloff_bin = bins - 1;
+    for (int block = 0; block < desc->block_count; block++) {
+        if (cumulative + desc->block_sums[block] >= target) {
+            const int begin = block * DESCRIPTOR_BLOCK;
+            const int end = (begin + DESCRIPTOR_BLOCK < bins) ? begin + DESCRIPTOR_BLOCK : bins;
+            for (int k = begin; k < end; k++) {
+                cumulative += power[k];
+                if (cumulative >= target) {
+                    rolloff_bin = k;
+                    break;
+                }
+            }
+            break;
+        }
+        cumulative += desc->block_sums[block];
+    }
+    out->rolloff = rolloff_bin * bin_hz;
+}
+
+/*
+    descriptors_free: Releases the buffers allocated by descriptors_init.
+*/
+void descriptors_free(DescriptorState* desc) {
+    free(desc->prev_magnitude);
+    free(desc->block_sums);
+    memset(desc, 0, sizeof(*desc));
+}
@@ -0,0 +1,42 @@
+#ifndef DESCRIPTORS_H
+#define DESCRIPTORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+    SpectralFeatures: Scalar descriptors of one analysis frame.
+    Frequencies are in Hz; flatness is in [0, 1]; crest is peak/mean power.
+*/
+typedef struct {
+    uint64_t timestamp_ns;  // SDL tick time the frame was analysed.
+    float centroid;
+    float spread;           // Spectral bandwidth around the centroid.
+    float rolloff;
+    float flatness;
+    float crest;
+    float flux;             // Positive magnitude change since the last frame.
+} SpectralFeatures;
+
+/*
+    DescriptorState: Scratch for the fused descriptor kernel.
+
+    The power spectrum is walked once in blocks; per-block power sums are
+    kept so the rolloff point can later be located by touching only the
+    block it falls in. The previous frame's magnitudes for the flux are read
+    and overwritten in the same pass.
+*/
+typedef struct {
+    int bins;
+    float bin_hz;
+    float rolloff_fraction;  // Share of total power below the rolloff.
+    float* prev_magnitude;   // Magnitudes of the previous frame.
+    double* block_sums;
+    int block_count;
+} DescriptorState;
+
+bool descriptors_init(DescriptorState* desc, int bins, float bin_hz, float rolloff_fraction);
+void descriptors_compute(DescriptorState* desc, const float* power, SpectralFeatures* out);
+void descriptors_free(DescriptorState* desc);
+
+#endif
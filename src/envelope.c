@@ -0,0 +1,151 @@
+#include "envelope.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    envelope_init: Allocates buffers and creates the cached FFTW plans.
+    Must run before any other thread starts planning, since the FFTW
+    planner is not thread-safe.
+*/
+bool envelope_init(EnvelopeState* env, int fft_size, int lifter, int lpc_order) {
+    memset(env, 0, sizeof(*env));
+    env->fft_size = fft_size;
+    env->bins = fft_size / 2 + 1;
+    env->lifter = lifter;
+    env->lpc_order = lpc_order;
+
+    env->dct_in = fftwf_alloc_real(env->bins);
+    env->dct_out = fftwf_alloc_real(env->bins);
+    env->poly_time = fftwf_alloc_real(fft_size);
+    env->poly_freq = fftwf_alloc_complex(env->bins);
+    env->lpc_coeffs = calloc(lpc_order + 1, sizeof(double));
+    env->lpc_scratch = calloc(lpc_order + 1, sizeof(double));
+    env->envelope = calloc(env->bins, sizeof(float));
+    if (!env->dct_in || !env->dct_out || !env->poly_time || !env->poly_freq ||
+        !env->lpc_coeffs || !env->lpc_scratch || !env->envelope) {
+        envelope_free(env);
+        return false;
+    }
+
+    env->dct_plan = fftwf_plan_r2r_1d(env->bins, env->dct_in, env->dct_out,
+                                      FFTW_REDFT00, FFTW_MEASURE);
+    env->poly_plan = fftwf_plan_dft_r2c_1d(fft_size, env->poly_time,
+                                           env->poly_freq, FFTW_MEASURE);
+    if (!env->dct_plan || !env->poly_plan) {
+        envelope_free(env);
+        return false;
+    }
+    return true;
+}
+
+/*
+    envelope_cepstrum: log|X| -> real cepstrum -> lifter -> smoothed log|X|.
+    Applying the DCT-I twice scales by 2 * (bins - 1) = fft_size.
+*/
+static void envelope_cepstrum(EnvelopeState* env, const float* magnitude) {
+    const int bins = env->bins;
+    for (int k = 0; k < bins; k++) {
+        env->dct_in[k] = logf(magnitude[k] + 1e-9f);
+    }
+    fftwf_execute_r2r(env->dct_plan, env->dct_in, env->dct_out);
+
+    // Keep only the low quefrencies, which describe the slow spectral shape.
+    const float scale = 1.0f / env->fft_size;
+    for (int n = 0; n < bins; n++) {
+        env->dct_out[n] = (n < env->lifter) ? env->dct_out[n] * scale : 0.0f;
+    }
+    fftwf_execute_r2r(env->dct_plan, env->dct_out, env->dct_in);
+
+    for (int k = 0; k < bins; k++) {
+        env->envelope[k] = expf(env->dct_in[k]);
+    }
+}
+
+/*
+    envelope_lpc: Autocorrelation from the power spectrum, Levinson-Durbin
+    for the all-pole coefficients, then sqrt(error) / |A(e^jw)| per bin.
+*/
+static void envelope_lpc(EnvelopeState* env, const float* magnitude) {
+    const int bins = env->bins;
+    const int order = env->lpc_order;
+    for (int k = 0; k < bins; k++) {
+        env->dct_in[k] = magnitude[k] * magnitude[k];
+    }
+    fftwf_execute_r2r(env->dct_plan, env->dct_in, env->dct_out);
+
+    double* a = env->lpc_coeffs;
+    double* prev = env->lpc_scratch;
+    const float* r = env->dct_out;  // Autocorrelation, scaled by fft_size.
+    memset(a, 0, sizeof(double) * (order + 1));
+    a[0] = 1.0;
+    double error = r[0] * (1.0 + 1e-9) + 1e-12;  // Slight lag-0 bias keeps it stable.
+    for (int i = 1; i <= order; i++) {
+        double acc = r[i];
+        for (int j = 1; j < i; j++) {
+            acc += a[j] * r[i - j];
+        }
+        double reflection = -acc / error;
+        memcpy(prev, a, sizeof(double) * (i + 1));
+        for (int j = 1; j < i; j++) {
+            a[j] = prev[j] + reflection * prev[i - j];
+        }
+        a[i] = reflection;
+        error *= 1.0 - reflection * reflection;
+        if (error <= 0.0) {
+            error = 1e-12;
+            break;
+        }
+    }
+
+    memset(env->poly_time, 0, sizeof(float) * env->fft_size);
+    for (int j = 0; j <= order; j++) {
+        env->poly_time[j] = (float)a[j];
+    }
+    fftwf_execute(env->poly_plan);
+
+    // Undo the fft_size scaling picked up by the autocorrelation transform.
+    const float gain = sqrtf((float)(error / env->fft_size));
+    for (int k = 0; k < bins; k++) {
+        float re = env->poly_freq[k][0];
+        float im = env->poly_freq[k][1];
+        env->envelope[k] = gain / (sqrtf(re * re + im * im) + 1e-9f);
+    }
+}
+
+/*
+    envelope_process: Updates env->envelope from one magnitude frame.
+*/
+void envelope_process(EnvelopeState* env, EnvelopeMethod method, const float* magnitude) {
+    switch (method) {
+    case ENVELOPE_CEPSTRUM:
+        envelope_cepstrum(env, magnitude);
+        break;
+    case ENVELOPE_LPC:
+        envelope_lpc(env, magnitude);
+        break;
+    case ENVELOPE_OFF:
+        break;
+    }
+}
+
+/*
+    envelope_free: Destroys the cached plans and releases all buffers.
+*/
+void envelope_free(EnvelopeState* env) {
+    if (env->dct_plan) {
+        fftwf_destroy_plan(env->dct_plan);
+    }
+    if (env->poly_plan) {
+        fftwf_destroy_plan(env->poly_plan);
+    }
+    fftwf_free(env->dct_in);
+    fftwf_free(env->dct_out);
+    fftwf_free(env->poly_time);
+    fftwf_free(env->poly_freq);
+    free(env->lpc_coeffs);
+    free(env->lpc_scratch);
+    free(env->envelope);
+    memset(env, 0, sizeof(*env));
+}
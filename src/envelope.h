@@ -0,0 +1,48 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+/*
+    EnvelopeMethod selects how the spectral envelope overlay is estimated.
+*/
+typedef enum {
+    ENVELOPE_OFF,
+    ENVELOPE_CEPSTRUM,   // Low-quefrency liftering of the real cepstrum.
+    ENVELOPE_LPC         // All-pole fit via Levinson-Durbin.
+} EnvelopeMethod;
+
+/*
+    EnvelopeState: Smooth spectral envelope estimation from a magnitude frame.
+
+    The log-magnitude and power spectra of a real signal are real and even,
+    so their inverse FFTs reduce to a DCT-I over the BINS one-sided values.
+    A single cached DCT-I plan therefore serves both the cepstrum round trip
+    and the autocorrelation needed for LPC; a second cached r2c plan
+    evaluates the prediction polynomial across frequency.
+*/
+typedef struct {
+    int fft_size;
+    int bins;
+    int lifter;            // Cepstral coefficients kept (quefrency cutoff).
+    int lpc_order;
+
+    float* dct_in;
+    float* dct_out;
+    fftwf_plan dct_plan;   // DCT-I of length bins, used in both directions.
+
+    float* poly_time;      // Zero-padded prediction polynomial.
+    fftwf_complex* poly_freq;
+    fftwf_plan poly_plan;  // r2c of length fft_size.
+    double* lpc_coeffs;
+    double* lpc_scratch;
+
+    float* envelope;       // Output: envelope magnitude per bin.
+} EnvelopeState;
+
+bool envelope_init(EnvelopeState* env, int fft_size, int lifter, int lpc_order);
+void envelope_process(EnvelopeState* env, EnvelopeMethod method, const float* magnitude);
+void envelope_free(EnvelopeState* env);
+
+#endif
@@ -0,0 +1,287 @@
+#include "eq.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EQ_SSE2 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+    eq_design: RBJ cookbook coefficients for one band.
+*/
+void eq_design(const EqBand* band, float sample_rate, EqCoeffs* out) {
+    const double w0 = 2.0 * M_PI * band->freq_hz / sample_rate;
+    const double cw = cos(w0);
+    const double alpha = sin(w0) / (2.0 * band->q);
+    const double a = pow(10.0, band->gain_db / 40.0);
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (band->type) {
+    case EQ_PEAKING:
+        b0 = 1 + alpha * a;  b1 = -2 * cw;  b2 = 1 - alpha * a;
+        a0 = 1 + alpha / a;  a1 = -2 * cw;  a2 = 1 - alpha / a;
+        break;
+    case EQ_LOW_SHELF: {
+        double s = 2 * sqrt(a) * alpha;
+        b0 = a * ((a + 1) - (a - 1) * cw + s);
+        b1 = 2 * a * ((a - 1) - (a + 1) * cw);
+        b2 = a * ((a + 1) - (a - 1) * cw - s);
+        a0 = (a + 1) + (a - 1) * cw + s;
+        a1 = -2 * ((a - 1) + (a + 1) * cw);
+        a2 = (a + 1) + (a - 1) * cw - s;
+        break;
+    }
+    case EQ_HIGH_SHELF: {
+        double s = 2 * sqrt(a) * alpha;
+        b0 = a * ((a + 1) + (a - 1) * cw + s);
+        b1 = -2 * a * ((a - 1) + (a + 1) * cw);
+        b2 = a * ((a + 1) + (a - 1) * cw - s);
+        a0 = (a + 1) - (a - 1) * cw + s;
+        a1 = 2 * ((a - 1) - (a + 1) * cw);
+        a2 = (a + 1) - (a - 1) * cw - s;
+        break;
+    }
+    case EQ_HIGHPASS:
+        b0 = (1 + cw) / 2;  b1 = -(1 + cw);  b2 = (1 + cw) / 2;
+        a0 = 1 + alpha;     a1 = -2 * cw;    a2 = 1 - alpha;
+        break;
+    case EQ_LOWPASS:
+    default:
+        b0 = (1 - cw) / 2;  b1 = 1 - cw;     b2 = (1 - cw) / 2;
+        a0 = 1 + alpha;     a1 = -2 * cw;    a2 = 1 - alpha;
+        break;
+    }
+
+    out->b0 = (float)(b0 / a0);
+    out->b1 = (float)(b1 / a0);
+    out->b2 = (float)(b2 / a0);
+    out->a1 = (float)(a1 / a0);
+    out->a2 = (float)(a2 / a0);
+}
+
+/*
+    eq_default_chain: Flat starting point used when no eq.txt is present.
+*/
+void eq_default_chain(EqChain* chain) {
+    static const EqBand defaults[] = {
+        { EQ_HIGHPASS,   30.0f,   0.0f, 0.707f },
+        { EQ_LOW_SHELF,  120.0f,  0.0f, 0.707f },
+        { EQ_PEAKING,    1000.0f, 0.0f, 1.0f   },
+        { EQ_HIGH_SHELF, 8000.0f, 0.0f, 0.707f },
+    };
+    chain->count = sizeof(defaults) / sizeof(defaults[0]);
+    memcpy(chain->bands, defaults, sizeof(defaults));
+    chain->version++;
+}
+
+/*
+    eq_load: Reads a chain from a text file with one band per line:
+        <peak|lowshelf|highshelf|highpass|lowpass> <freq_hz> <gain_db> <q>
+    Blank lines and lines starting with '#' are ignored. Returns false (and
+    leaves the chain untouched) if the file cannot be opened or has no bands.
+*/
+bool eq_load(EqChain* chain, const char* path) {
+    static const struct { const char* name; EqFilterType type; } names[] = {
+        { "peak", EQ_PEAKING }, { "lowshelf", EQ_LOW_SHELF }, { "highshelf", EQ_HIGH_SHELF },
+        { "highpass", EQ_HIGHPASS }, { "lowpass", EQ_LOWPASS },
+    };
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    EqChain loaded = { 0 };
+    char line[256];
+    while (fgets(line, sizeof(line), file) && loaded.count < EQ_MAX_BANDS) {
+        char name[32];
+        EqBand band;
+        if (line[0] == '#' ||
+            sscanf(line, "%31s %f %f %f", name, &band.freq_hz, &band.gain_db, &band.q) != 4) {
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strcmp(name, names[i].name) == 0 && band.freq_hz > 0 && band.q > 0) {
+                band.type = names[i].type;
+                loaded.bands[loaded.count++] = band;
+                break;
+            }
+        }
+    }
+    fclose(file);
+
+    if (loaded.count == 0) {
+        return false;
+    }
+    loaded.version = chain->version + 1;
+    *chain = loaded;
+    return true;
+}
+
+/*
+    eq_response_init: Tabulates cos/sin of w and 2w for each frequency.
+*/
+bool eq_response_init(EqResponse* resp, const float* freqs_hz, int points, float sample_rate) {
+    memset(resp, 0, sizeof(*resp));
+    resp->points = points;
+    resp->cos1 = malloc(sizeof(float) * points);
+    resp->sin1 = malloc(sizeof(float) * points);
+    resp->cos2 = malloc(sizeof(float) * points);
+    resp->sin2 = malloc(sizeof(float) * points);
+    resp->response_db = calloc(points, sizeof(float));
+    if (!resp->cos1 || !resp->sin1 || !resp->cos2 || !resp->sin2 || !resp->response_db) {
+        eq_response_free(resp);
+        return false;
+    }
+    for (int i = 0; i < points; i++) {
+        double w = 2.0 * M_PI * freqs_hz[i] / sample_rate;
+        resp->cos1[i] = (float)cos(w);
+        resp->sin1[i] = (float)sin(w);
+        resp->cos2[i] = (float)cos(2 * w);
+        resp->sin2[i] = (float)sin(2 * w);
+    }
+    return true;
+}
+
+/*
+    eq_response_update: Recomputes the combined response in dB if the chain
+    changed since the last call. Each section contributes
+    |b0 + b1 e^-jw + b2 e^-2jw|^2 / |1 + a1 e^-jw + a2 e^-2jw|^2.
+*/
+void eq_response_update(EqResponse* resp, const EqChain* chain, float sample_rate) {
+    if (resp->valid && resp->version == chain->version) {
+        return;
+    }
+    EqCoeffs coeffs[EQ_MAX_BANDS];
+    for (int s = 0; s < chain->count; s++) {
+        eq_design(&chain->bands[s], sample_rate, &coeffs[s]);
+    }
+
+    int i = 0;
+#ifdef EQ_SSE2
+    for (; i + 4 <= resp->points; i += 4) {
+        const __m128 c1 = _mm_loadu_ps(&resp->cos1[i]);
+        const __m128 s1 = _mm_loadu_ps(&resp->sin1[i]);
+        const __m128 c2 = _mm_loadu_ps(&resp->cos2[i]);
+        const __m128 s2 = _mm_loadu_ps(&resp->sin2[i]);
+        __m128 num = _mm_set1_ps(1.0f);
+        __m128 den = _mm_set1_ps(1.0f);
+        for (int s = 0; s < chain->count; s++) {
+            const EqCoeffs* c = &coeffs[s];
+            __m128 nr = _mm_add_ps(_mm_set1_ps(c->b0), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c->b1), c1),
+                                                                  _mm_mul_ps(_mm_set1_ps(c->b2), c2)));
+            __m128 ni = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c->b1), s1), _mm_mul_ps(_mm_set1_ps(c->b2), s2));
+            __m128 dr = _mm_add_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c->a1), c1),
+                                                                 _mm_mul_ps(_mm_set1_ps(c->a2), c2)));
+            __m128 di = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c->a1), s1), _mm_mul_ps(_mm_set1_ps(c->a2), s2));
+            num = _mm_mul_ps(num, _mm_add_ps(_mm_mul_ps(nr, nr), _mm_mul_ps(ni, ni)));
+            den = _mm_mul_ps(den, _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(di, di)));
+        }
+        float ratio[4];
+        _mm_storeu_ps(ratio, _mm_div_ps(num, _mm_max_ps(den, _mm_set1_ps(1e-30f))));
+        for (int j = 0; j < 4; j++) {
+            resp->response_db[i + j] = 10.0f * log10f(ratio[j] + 1e-30f);
+        }
+    }
+#endif
+    for (; i < resp->points; i++) {
+        float num = 1.0f, den = 1.0f;
+        for (int s = 0; s < chain->count; s++) {
+            const EqCoeffs* c = &coeffs[s];
+            float nr = c->b0 + c->b1 * resp->cos1[i] + c->b2 * resp->cos2[i];
+            float ni = c->b1 * resp->sin1[i] + c->b2 * resp->sin2[i];
+            float dr = 1.0f + c->a1 * resp->cos1[i] + c->a2 * resp->cos2[i];
+            float di = c->a1 * resp->sin1[i] + c->a2 * resp->sin2[i];
+            num *= nr * nr + ni * ni;
+            den *= dr * dr + di * di;
+        }
+        resp->response_db[i] = 10.0f * log10f(num / fmaxf(den, 1e-30f) + 1e-30f);
+    }
+    resp->version = chain->version;
+    resp->valid = true;
+}
+
+void eq_response_free(EqResponse* resp) {
+    free(resp->cos1);
+    free(resp->sin1);
+    free(resp->cos2);
+    free(resp->sin2);
+    free(resp->response_db);
+    memset(resp, 0, sizeof(*resp));
+}
+
+/*
+    eq_cascade_set: Loads new coefficients, keeping filter state so edits
+    made while audio is playing do not click. Unused lanes pass through.
+*/
+void eq_cascade_set(EqCascade* cascade, const EqChain* chain, float sample_rate) {
+    cascade->groups = (chain->count + 3) / 4;
+    for (int g = 0; g < EQ_MAX_BANDS / 4; g++) {
+        for (int lane = 0; lane < 4; lane++) {
+            int s = g * 4 + lane;
+            EqCoeffs c = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            if (s < chain->count) {
+                eq_design(&chain->bands[s], sample_rate, &c);
+            }
+            cascade->coeffs[g][0][lane] = c.b0;
+            cascade->coeffs[g][1][lane] = c.b1;
+            cascade->coeffs[g][2][lane] = c.b2;
+            cascade->coeffs[g][3][lane] = c.a1;
+            cascade->coeffs[g][4][lane] = c.a2;
+        }
+    }
+    cascade->version = chain->version;
+}
+
+/*
+    eq_cascade_process: Filters samples in place through every group.
+*/
+void eq_cascade_process(EqCascade* cascade, float* samples, int count) {
+    for (int g = 0; g < cascade->groups; g++) {
+#ifdef EQ_SSE2
+        const __m128 b0 = _mm_loadu_ps(cascade->coeffs[g][0]);
+        const __m128 b1 = _mm_loadu_ps(cascade->coeffs[g][1]);
+        const __m128 b2 = _mm_loadu_ps(cascade->coeffs[g][2]);
+        const __m128 a1 = _mm_loadu_ps(cascade->coeffs[g][3]);
+        const __m128 a2 = _mm_loadu_ps(cascade->coeffs[g][4]);
+        __m128 z1 = _mm_loadu_ps(cascade->z1[g]);
+        __m128 z2 = _mm_loadu_ps(cascade->z2[g]);
+        __m128 y = _mm_loadu_ps(cascade->pipe[g]);
+        for (int n = 0; n < count; n++) {
+            // Lane 0 takes the new sample; lane i takes lane i-1's last output.
+            __m128 shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4));
+            __m128 in = _mm_move_ss(shifted, _mm_set_ss(samples[n]));
+            y = _mm_add_ps(_mm_mul_ps(b0, in), z1);
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, in), _mm_mul_ps(a1, y)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, in), _mm_mul_ps(a2, y));
+            samples[n] = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+        _mm_storeu_ps(cascade->z1[g], z1);
+        _mm_storeu_ps(cascade->z2[g], z2);
+        _mm_storeu_ps(cascade->pipe[g], y);
+#else
+        for (int lane = 0; lane < 4; lane++) {
+            const float b0 = cascade->coeffs[g][0][lane], b1 = cascade->coeffs[g][1][lane];
+            const float b2 = cascade->coeffs[g][2][lane], a1 = cascade->coeffs[g][3][lane];
+            const float a2 = cascade->coeffs[g][4][lane];
+            float z1 = cascade->z1[g][lane], z2 = cascade->z2[g][lane];
+            for (int n = 0; n < count; n++) {
+                float in = samples[n];
+                float y = b0 * in + z1;
+                z1 = b1 * in - a1 * y + z2;
+                z2 = b2 * in - a2 * y;
+                samples[n] = y;
+            }
+            cascade->z1[g][lane] = z1;
+            cascade->z2[g][lane] = z2;
+        }
+#endif
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef EQ_H
+#define EQ_H
+
+#include <stdbool.h>
+
+#define EQ_MAX_BANDS 16
+
+/*
+    EqFilterType: RBJ audio-EQ-cookbook biquad shapes.
+*/
+typedef enum {
+    EQ_PEAKING,
+    EQ_LOW_SHELF,
+    EQ_HIGH_SHELF,
+    EQ_HIGHPASS,
+    EQ_LOWPASS
+} EqFilterType;
+
+/*
+    EqMode: Off, response overlay only, or overlay plus filtering of the
+    pass-through audio.
+*/
+typedef enum {
+    EQ_OFF,
+    EQ_OVERLAY,
+    EQ_APPLY
+} EqMode;
+
+typedef struct {
+    EqFilterType type;
+    float freq_hz;
+    float gain_db;        // Ignored by the pass filters.
+    float q;
+} EqBand;
+
+typedef struct {
+    float b0, b1, b2, a1, a2;   // Normalised so a0 = 1.
+} EqCoeffs;
+
+/*
+    EqChain: User-editable list of bands. version is bumped on every edit so
+    consumers can tell when to rebuild their derived state.
+*/
+typedef struct {
+    int count;
+    EqBand bands[EQ_MAX_BANDS];
+    unsigned version;
+} EqChain;
+
+/*
+    EqResponse: Combined magnitude response at a fixed set of frequencies.
+    cos/sin of w and 2w are tabulated once, so an update is a few
+    multiply-adds per band and point, four points per SSE register, and it
+    only runs when the chain version changes.
+*/
+typedef struct {
+    int points;
+    float* cos1;
+    float* sin1;
+    float* cos2;
+    float* sin2;
+    float* response_db;
+    unsigned version;     // Chain version response_db was computed for.
+    bool valid;
+} EqResponse;
+
+/*
+    EqCascade: The chain as a running filter for audio. Sections are grouped
+    four to an SSE register and run as a skewed pipeline: lane i filters
+    the sample lane i-1 produced one step earlier, so each group adds three
+    samples of delay but processes all four sections per instruction.
+*/
+typedef struct {
+    int groups;
+    float coeffs[EQ_MAX_BANDS / 4][5][4];  // [group][b0 b1 b2 a1 a2][lane]
+    float z1[EQ_MAX_BANDS / 4][4];
+    float z2[EQ_MAX_BANDS / 4][4];
+    float pipe[EQ_MAX_BANDS / 4][4];       // Last outputs, feeding the next lane.
+    unsigned version;
+} EqCascade;
+
+void eq_design(const EqBand* band, float sample_rate, EqCoeffs* out);
+void eq_default_chain(EqChain* chain);
+bool eq_load(EqChain* chain, const char* path);
+
+bool eq_response_init(EqResponse* resp, const float* freqs_hz, int points, float sample_rate);
+void eq_response_update(EqResponse* resp, const EqChain* chain, float sample_rate);
+void eq_response_free(EqResponse* resp);
+
+void eq_cascade_set(EqCascade* cascade, const EqChain* chain, float sample_rate);
+void eq_cascade_process(EqCascade* cascade, float* samples, int count);
+
+#endif
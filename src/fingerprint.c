@@ -0,0 +1,416 @@
+#include <windows.h>
+#include <SDL3/SDL.h>
+
+#include "fingerprint.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Slots of a new builder table.
+#define FP_INITIAL_SLOTS (1u << 16)
+
+/*
+    fingerprint_mix: Spreads the 24-bit hashes over the table (the
+    MurmurHash3 finaliser); neighbouring hashes would otherwise cluster.
+*/
+static uint32_t fingerprint_mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+    fingerprint_init: Sets up peak picking for rows of bins levels, bin_hz
+    apart, arriving every hop_seconds.
+*/
+bool fingerprint_init(FingerprintExtractor* fp, int bins, float bin_hz, float hop_seconds) {
+    memset(fp, 0, sizeof(*fp));
+    fp->bins = bins;
+    fp->bin_hz = bin_hz;
+    fp->first_bin = (int)ceilf(FP_MIN_HZ / bin_hz);
+    fp->last_bin = (int)((FP_BUCKETS - 1) * FP_BUCKET_HZ / bin_hz);
+    if (fp->first_bin < FP_PEAK_RADIUS) {
+        fp->first_bin = FP_PEAK_RADIUS;
+    }
+    if (fp->last_bin > bins - 1 - FP_PEAK_RADIUS) {
+        fp->last_bin = bins - 1 - FP_PEAK_RADIUS;
+    }
+    fp->decay_db = FP_MASK_DECAY_DB_PER_S * hop_seconds;
+    fp->mask = malloc(sizeof(float) * bins);
+    if (!fp->mask) {
+        return false;
+    }
+    for (int k = 0; k < bins; k++) {
+        fp->mask[k] = FP_MIN_DB;
+    }
+    return true;
+}
+
+/*
+    fingerprint_pick: Finds the frame's strongest local maxima above the
+    mask, strongest first, then raises the mask around each of them.
+*/
+static int fingerprint_pick(FingerprintExtractor* fp, const float* row_db, int* peaks) {
+    float levels[FP_PEAKS_PER_FRAME];
+    int count = 0;
+    for (int k = fp->first_bin; k <= fp->last_bin; k++) {
+        const float v = row_db[k];
+        if (v <= fp->mask[k] || (count == FP_PEAKS_PER_FRAME && v <= levels[count - 1])) {
+            continue;
+        }
+        bool local_max = true;
+        for (int d = 1; d <= FP_PEAK_RADIUS && local_max; d++) {
+            local_max = v > row_db[k - d] && v >= row_db[k + d];
+        }
+        if (!local_max) {
+            continue;
+        }
+        int slot = (count < FP_PEAKS_PER_FRAME) ? count++ : count - 1;
+        while (slot > 0 && levels[slot - 1] < v) {
+            levels[slot] = levels[slot - 1];
+            peaks[slot] = peaks[slot - 1];
+            slot--;
+        }
+        levels[slot] = v;
+        peaks[slot] = k;
+    }
+
+    for (int k = 0; k < fp->bins; k++) {
+        fp->mask[k] = fmaxf(fp->mask[k] - fp->decay_db, FP_MIN_DB);
+    }
+    for (int i = 0; i < count; i++) {
+        int lo = peaks[i] - FP_MASK_RADIUS < 0 ? 0 : peaks[i] - FP_MASK_RADIUS;
+        int hi = peaks[i] + FP_MASK_RADIUS >= fp->bins ? fp->bins - 1 : peaks[i] + FP_MASK_RADIUS;
+        for (int k = lo; k <= hi; k++) {
+            fp->mask[k] = fmaxf(fp->mask[k], levels[i] - FP_MASK_SLOPE_DB * abs(k - peaks[i]));
+        }
+    }
+    return count;
+}
+
+/*
+    fingerprint_push: Adds one row of bar levels and writes the hashes it
+    completes to out (room for FP_MAX_HASHES). Returns their number.
+*/
+int fingerprint_push(FingerprintExtractor* fp, const float* row_db, FingerprintHash* out) {
+    int peaks[FP_PEAKS_PER_FRAME];
+    const int count = fingerprint_pick(fp, row_db, peaks);
+    const uint32_t frame = fp->frame++;
+
+    int buckets[FP_PEAKS_PER_FRAME];
+    for (int i = 0; i < count; i++) {
+        buckets[i] = (int)(peaks[i] * fp->bin_hz / FP_BUCKET_HZ);
+    }
+
+    int emitted = 0;
+    for (int a = 0; a < fp->anchor_count; a++) {
+        FingerprintPeak* anchor = &fp->anchors[(fp->anchor_head - fp->anchor_count + a + FP_ANCHORS) % FP_ANCHORS];
+        const uint32_t dt = frame - anchor->frame;
+        if (dt > FP_ZONE_FRAMES) {
+            continue;
+        }
+        for (int i = 0; i < count && anchor->pairs < FP_FAN_OUT; i++) {
+            const int df = buckets[i] - anchor->bucket;
+            if (df < -FP_ZONE_BUCKETS || df > FP_ZONE_BUCKETS) {
+                continue;
+            }
+            out[emitted].hash = ((uint32_t)anchor->bucket << 14) | ((uint32_t)(df + 128) << 6) | (dt & 0x3F);
+            out[emitted].frame = anchor->frame;
+            emitted++;
+            anchor->pairs++;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        FingerprintPeak* slot = &fp->anchors[fp->anchor_head];
+        slot->frame = frame;
+        slot->bucket = (int16_t)buckets[i];
+        slot->pairs = 0;
+        fp->anchor_head = (fp->anchor_head + 1) % FP_ANCHORS;
+        if (fp->anchor_count < FP_ANCHORS) {
+            fp->anchor_count++;
+        }
+    }
+    return emitted;
+}
+
+/*
+    fingerprint_free: Releases the mask.
+*/
+void fingerprint_free(FingerprintExtractor* fp) {
+    free(fp->mask);
+    memset(fp, 0, sizeof(*fp));
+}
+
+/*
+    fingerprint_builder_init: Starts an empty index for references analysed
+    with the given parameters; queries must use the same sample rate and hop.
+*/
+bool fingerprint_builder_init(FingerprintBuilder* builder, int sample_rate, int fft_size, int hop) {
+    memset(builder, 0, sizeof(*builder));
+    builder->sample_rate = sample_rate;
+    builder->fft_size = fft_size;
+    builder->hop = hop;
+    builder->slot_count = FP_INITIAL_SLOTS;
+    builder->slots = calloc(builder->slot_count, sizeof(FingerprintSlot));
+    return builder->slots != NULL;
+}
+
+/*
+    fingerprint_builder_add_track: Registers a reference track. Returns its
+    id, or -1 if the name table cannot grow.
+*/
+int fingerprint_builder_add_track(FingerprintBuilder* builder, const char* name, double seconds) {
+    if (builder->track_count == builder->track_capacity) {
+        int capacity = builder->track_capacity ? builder->track_capacity * 2 : 64;
+        char (*names)[FP_NAME_BYTES] = realloc(builder->names, (size_t)capacity * FP_NAME_BYTES);
+        if (!names) {
+            return -1;
+        }
+        builder->names = names;
+        builder->track_capacity = capacity;
+    }
+    snprintf(builder->names[builder->track_count], FP_NAME_BYTES, "%s", name);
+    builder->seconds += seconds;
+    return builder->track_count++;
+}
+
+/*
+    fingerprint_builder_insert: Linear-probing insert; the table always has
+    free slots because it is kept at most half full.
+*/
+static void fingerprint_builder_insert(FingerprintSlot* slots, uint64_t mask, FingerprintSlot entry) {
+    uint64_t i = fingerprint_mix(entry.key - 1) & mask;
+    while (slots[i].key) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+}
+
+/*
+    fingerprint_builder_add: Inserts a track's hashes, doubling the table
+    first if they would fill it past half.
+*/
+bool fingerprint_builder_add(FingerprintBuilder* builder, int track, const FingerprintHash* hashes, size_t count) {
+    uint64_t slot_count = builder->slot_count;
+    while ((builder->entries + count) * 2 > slot_count) {
+        slot_count *= 2;
+    }
+    if (slot_count != builder->slot_count) {
+        FingerprintSlot* slots = calloc(slot_count, sizeof(FingerprintSlot));
+        if (!slots) {
+            return false;
+        }
+        for (uint64_t i = 0; i < builder->slot_count; i++) {
+            if (builder->slots[i].key) {
+                fingerprint_builder_insert(slots, slot_count - 1, builder->slots[i]);
+            }
+        }
+        free(builder->slots);
+        builder->slots = slots;
+        builder->slot_count = slot_count;
+    }
+    for (size_t i = 0; i < count; i++) {
+        FingerprintSlot entry = { hashes[i].hash + 1, (uint32_t)track, hashes[i].frame };
+        fingerprint_builder_insert(builder->slots, builder->slot_count - 1, entry);
+    }
+    builder->entries += count;
+    return true;
+}
+
+/*
+    fingerprint_builder_write: Writes header, slot table and names. *bytes
+    receives the file size.
+*/
+bool fingerprint_builder_write(const FingerprintBuilder* builder, const char* path, uint64_t* bytes) {
+    FingerprintFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "AVFPIX01", 8);
+    header.sample_rate = (uint32_t)builder->sample_rate;
+    header.fft_size = (uint32_t)builder->fft_size;
+    header.hop = (uint32_t)builder->hop;
+    header.track_count = (uint32_t)builder->track_count;
+    header.slot_count = builder->slot_count;
+    header.entries = builder->entries;
+    header.seconds = builder->seconds;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(builder->slots, sizeof(FingerprintSlot), builder->slot_count, file) == builder->slot_count &&
+              (builder->track_count == 0 ||
+               fwrite(builder->names, FP_NAME_BYTES, builder->track_count, file) == (size_t)builder->track_count);
+    ok &= (fclose(file) == 0);
+    *bytes = sizeof(header) + builder->slot_count * sizeof(FingerprintSlot) +
+             (uint64_t)builder->track_count * FP_NAME_BYTES;
+    return ok;
+}
+
+/*
+    fingerprint_builder_free: Releases the table and names.
+*/
+void fingerprint_builder_free(FingerprintBuilder* builder) {
+    free(builder->slots);
+    free(builder->names);
+    memset(builder, 0, sizeof(*builder));
+}
+
+/*
+    fingerprint_index_open: Maps an index file read-only and checks that
+    its tables fit inside it and that the slot table is at most half full,
+    as the builder leaves it.
+*/
+bool fingerprint_index_open(FingerprintIndex* index, const char* path) {
+    memset(index, 0, sizeof(*index));
+    index->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (index->file == INVALID_HANDLE_VALUE) {
+        index->file = NULL;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(index->file, &size) || size.QuadPart < (long long)sizeof(FingerprintFileHeader)) {
+        fingerprint_index_close(index);
+        return false;
+    }
+    index->bytes = (uint64_t)size.QuadPart;
+    index->mapping = CreateFileMappingA(index->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    index->view = index->mapping ? MapViewOfFile(index->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!index->view) {
+        fingerprint_index_close(index);
+        return false;
+    }
+
+    const FingerprintFileHeader* header = (const FingerprintFileHeader*)index->view;
+    const uint64_t slots = header->slot_count;
+    if (memcmp(header->magic, "AVFPIX01", 8) != 0 || slots == 0 || (slots & (slots - 1)) != 0 ||
+        header->entries > slots / 2 || slots > (index->bytes - sizeof(*header)) / sizeof(FingerprintSlot) ||
+        header->track_count > (index->bytes - sizeof(*header) - slots * sizeof(FingerprintSlot)) / FP_NAME_BYTES) {
+        fingerprint_index_close(index);
+        return false;
+    }
+    index->header = header;
+    index->slots = (const FingerprintSlot*)(header + 1);
+    index->names = (const char (*)[FP_NAME_BYTES])(index->slots + slots);
+    index->mask = slots - 1;
+    return true;
+}
+
+/*
+    fingerprint_index_lookup: Collects up to max_hits entries stored under
+    hash by walking its probe run. Returns their number. The walk stops
+    after one lap, so a table without an empty slot cannot hang it.
+*/
+int fingerprint_index_lookup(const FingerprintIndex* index, uint32_t hash, FingerprintSlot* hits, int max_hits) {
+    const uint32_t key = hash + 1;
+    uint64_t i = fingerprint_mix(hash) & index->mask;
+    int count = 0;
+    for (uint64_t step = 0; step <= index->mask && index->slots[i].key && count < max_hits; step++) {
+        if (index->slots[i].key == key) {
+            hits[count++] = index->slots[i];
+        }
+        i = (i + 1) & index->mask;
+    }
+    return count;
+}
+
+/*
+    fingerprint_index_name: Path a reference track was built from.
+*/
+const char* fingerprint_index_name(const FingerprintIndex* index, int track) {
+    if (track < 0 || (uint32_t)track >= index->header->track_count) {
+        return "?";
+    }
+    return index->names[track];
+}
+
+/*
+    fingerprint_index_close: Unmaps the view and closes the file.
+*/
+void fingerprint_index_close(FingerprintIndex* index) {
+    if (index->view) {
+        UnmapViewOfFile(index->view);
+    }
+    if (index->mapping) {
+        CloseHandle(index->mapping);
+    }
+    if (index->file) {
+        CloseHandle(index->file);
+    }
+    memset(index, 0, sizeof(*index));
+}
+
+/*
+    fingerprint_matcher_init: Starts matching against an open index, with
+    voting windows of FP_MATCH_SECONDS.
+*/
+void fingerprint_matcher_init(FingerprintMatcher* matcher, const FingerprintIndex* index, float hop_seconds) {
+    memset(matcher, 0, sizeof(*matcher));
+    matcher->index = index;
+    matcher->window_frames = (uint32_t)(FP_MATCH_SECONDS / hop_seconds);
+    if (matcher->window_frames < 1) {
+        matcher->window_frames = 1;
+    }
+    matcher->window_end = matcher->window_frames;
+    matcher->result.track = -1;
+}
+
+/*
+    fingerprint_vote: Counts one hit for (track, offset) and keeps the
+    window's leader up to date. A full table drops new pairs.
+*/
+static void fingerprint_vote(FingerprintMatcher* matcher, uint32_t track, int32_t offset) {
+    uint32_t i = fingerprint_mix(track * 0x9E3779B1u ^ (uint32_t)offset) & (FP_VOTE_SLOTS - 1);
+    for (int probe = 0; probe < FP_VOTE_SLOTS; probe++) {
+        FingerprintVote* v = &matcher->votes[i];
+        if (v->count == 0) {
+            v->track = track;
+            v->offset = offset;
+        }
+        if (v->track == track && v->offset == offset) {
+            v->count++;
+            if (v->count > matcher->best.count) {
+                matcher->best = *v;
+            }
+            return;
+        }
+        i = (i + 1) & (FP_VOTE_SLOTS - 1);
+    }
+}
+
+/*
+    fingerprint_matcher_add: Looks up the hashes of query frame `frame`
+    and votes with every hit. When the frame passes the end of the voting
+    window, the window's result is published and the votes cleared.
+*/
+void fingerprint_matcher_add(FingerprintMatcher* matcher, const FingerprintHash* hashes, int count, uint32_t frame) {
+    if (frame >= matcher->window_end) {
+        const bool found = matcher->best.count >= FP_MIN_VOTES;
+        matcher->result.track = found ? (int)matcher->best.track : -1;
+        matcher->result.votes = (int)matcher->best.count;
+        matcher->result.offset_frames = found ? matcher->best.offset : 0;
+        matcher->result.end_frame = frame;
+        matcher->fresh = true;
+        memset(matcher->votes, 0, sizeof(matcher->votes));
+        memset(&matcher->best, 0, sizeof(matcher->best));
+        matcher->window_end = frame + matcher->window_frames;
+    }
+
+    FingerprintSlot hits[FP_MAX_HITS];
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < count; i++) {
+        int n = fingerprint_index_lookup(matcher->index, hashes[i].hash, hits, FP_MAX_HITS);
+        for (int h = 0; h < n; h++) {
+            fingerprint_vote(matcher, hits[h].track, (int32_t)(hits[h].frame - hashes[i].frame));
+        }
+        matcher->hits += n;
+    }
+    matcher->lookups += count;
+    matcher->lookup_seconds += (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
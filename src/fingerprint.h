@@ -0,0 +1,207 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Strongest spectral peaks kept per frame.
+#define FP_PEAKS_PER_FRAME 5
+
+// A peak must be the largest bin within this many bins on either side.
+#define FP_PEAK_RADIUS 3
+
+// Peaks are searched between these frequencies; the bucket size sets the
+// frequency resolution of the hash (10 bits of buckets).
+#define FP_MIN_HZ 100.0f
+#define FP_BUCKET_HZ 10.0f
+#define FP_BUCKETS 1024
+
+// Quietest bar level that can become a peak.
+#define FP_MIN_DB -60.0f
+
+// Masking threshold: each peak raises it around itself, falling off per
+// bin, and it decays over time so only prominent peaks follow loud ones.
+#define FP_MASK_RADIUS 16
+#define FP_MASK_SLOPE_DB 1.0f
+#define FP_MASK_DECAY_DB_PER_S 30.0f
+
+// Target zone: an anchor pairs with up to FP_FAN_OUT later peaks at most
+// FP_ZONE_FRAMES frames ahead and FP_ZONE_BUCKETS buckets away.
+#define FP_ZONE_FRAMES 32
+#define FP_ZONE_BUCKETS 127
+#define FP_FAN_OUT 5
+
+// Past peaks that can still anchor a pair, and the most hashes one frame yields.
+#define FP_ANCHORS (FP_ZONE_FRAMES * FP_PEAKS_PER_FRAME)
+#define FP_MAX_HASHES (FP_ANCHORS * FP_PEAKS_PER_FRAME)
+
+// Reference tracks are identified by the path they were built from.
+#define FP_NAME_BYTES 256
+
+// Index entries one lookup may return; common hashes are truncated.
+#define FP_MAX_HITS 256
+
+// Matching: votes are counted over windows of this length, and a window
+// names a track when its best (track, offset) has at least this many.
+#define FP_MATCH_SECONDS 5.0f
+#define FP_MIN_VOTES 12
+#define FP_VOTE_SLOTS 8192
+
+/*
+    FingerprintHash: One landmark: anchor bucket, bucket difference and
+    frame distance packed into 24 bits, and the anchor's frame.
+*/
+typedef struct {
+    uint32_t hash;
+    uint32_t frame;
+} FingerprintHash;
+
+/*
+    FingerprintPeak: A past peak waiting for targets.
+*/
+typedef struct {
+    uint32_t frame;
+    int16_t bucket;
+    uint8_t pairs;     // Hashes already anchored here.
+} FingerprintPeak;
+
+/*
+    FingerprintExtractor: Turns bar-level rows into constellation hashes.
+
+    Each frame's strongest local maxima above a decaying masking threshold
+    become peaks. Peaks of the last FP_ZONE_FRAMES frames are kept in a
+    ring; every new peak is paired with the older ones whose target zone
+    it falls in, so hashes stream out one frame at a time with no
+    look-ahead, the same way when building a reference and when listening.
+*/
+typedef struct {
+    int bins;
+    int first_bin;          // Peak search range.
+    int last_bin;
+    float bin_hz;
+    float decay_db;         // Mask decay per frame.
+    float* mask;            // Per-bin masking threshold in dB.
+    FingerprintPeak anchors[FP_ANCHORS];
+    int anchor_head;        // Ring slot the next peak goes to.
+    int anchor_count;
+    uint32_t frame;         // Frames pushed so far.
+} FingerprintExtractor;
+
+/*
+    FingerprintSlot: One entry of the index table; key is hash + 1, so a
+    zero key marks an empty slot.
+*/
+typedef struct {
+    uint32_t key;
+    uint32_t track;
+    uint32_t frame;
+} FingerprintSlot;
+
+/*
+    FingerprintFileHeader: Start of an index file. The slot table follows,
+    then track_count names of FP_NAME_BYTES each. Fields are in the
+    machine's byte order; the file is mapped, not parsed.
+*/
+typedef struct {
+    char magic[8];            // "AVFPIX01".
+    uint32_t sample_rate;
+    uint32_t fft_size;
+    uint32_t hop;
+    uint32_t track_count;
+    uint64_t slot_count;      // Power of two.
+    uint64_t entries;
+    double seconds;           // Reference audio indexed.
+    char reserved[16];
+} FingerprintFileHeader;
+
+/*
+    FingerprintBuilder: Collects reference hashes in an in-memory
+    open-addressing table, doubled whenever it would pass half full, and
+    writes it out in the layout FingerprintIndex maps.
+*/
+typedef struct {
+    FingerprintSlot* slots;
+    uint64_t slot_count;
+    uint64_t entries;
+    char (*names)[FP_NAME_BYTES];
+    int track_count;
+    int track_capacity;
+    int sample_rate;
+    int fft_size;
+    int hop;
+    double seconds;
+} FingerprintBuilder;
+
+/*
+    FingerprintIndex: A reference index mapped read-only. Only the pages a
+    lookup touches are read from disk, so opening is instant and memory
+    use follows the working set rather than the file size.
+*/
+typedef struct {
+    void* file;
+    void* mapping;
+    const unsigned char* view;
+    uint64_t bytes;
+    const FingerprintFileHeader* header;
+    const FingerprintSlot* slots;
+    const char (*names)[FP_NAME_BYTES];
+    uint64_t mask;
+} FingerprintIndex;
+
+/*
+    FingerprintMatch: Best (track, time offset) of one matching window.
+*/
+typedef struct {
+    int track;              // -1 when no track reached FP_MIN_VOTES.
+    int votes;
+    int offset_frames;      // Reference frame minus query frame.
+    uint32_t end_frame;     // Query frame that closed the window.
+} FingerprintMatch;
+
+/*
+    FingerprintVote: One (track, offset) counter of the current window.
+*/
+typedef struct {
+    uint32_t track;
+    int32_t offset;
+    uint32_t count;         // Zero marks an empty slot.
+} FingerprintVote;
+
+/*
+    FingerprintMatcher: Looks query hashes up and lets every hit vote for
+    its track at the time offset it implies. A true match piles its votes
+    on a single offset; chance hits scatter.
+*/
+typedef struct {
+    const FingerprintIndex* index;
+    uint32_t window_frames;
+    uint32_t window_end;
+    FingerprintVote votes[FP_VOTE_SLOTS];
+    FingerprintVote best;
+    FingerprintMatch result;        // Last closed window.
+    bool fresh;                     // result changed since the caller last looked.
+    unsigned long long lookups;
+    unsigned long long hits;
+    double lookup_seconds;          // Time spent probing the index and voting.
+} FingerprintMatcher;
+
+bool fingerprint_init(FingerprintExtractor* fp, int bins, float bin_hz, float hop_seconds);
+int fingerprint_push(FingerprintExtractor* fp, const float* row_db, FingerprintHash* out);
+void fingerprint_free(FingerprintExtractor* fp);
+
+bool fingerprint_builder_init(FingerprintBuilder* builder, int sample_rate, int fft_size, int hop);
+int fingerprint_builder_add_track(FingerprintBuilder* builder, const char* name, double seconds);
+bool fingerprint_builder_add(FingerprintBuilder* builder, int track, const FingerprintHash* hashes, size_t count);
+bool fingerprint_builder_write(const FingerprintBuilder* builder, const char* path, uint64_t* bytes);
+void fingerprint_builder_free(FingerprintBuilder* builder);
+
+bool fingerprint_index_open(FingerprintIndex* index, const char* path);
+int fingerprint_index_lookup(const FingerprintIndex* index, uint32_t hash, FingerprintSlot* hits, int max_hits);
+const char* fingerprint_index_name(const FingerprintIndex* index, int track);
+void fingerprint_index_close(FingerprintIndex* index);
+
+void fingerprint_matcher_init(FingerprintMatcher* matcher, const FingerprintIndex* index, float hop_seconds);
+void fingerprint_matcher_add(FingerprintMatcher* matcher, const FingerprintHash* hashes, int count, uint32_t frame);
+
+#endif
@@ -0,0 +1,204 @@
+#include "fixfft.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// 10 log10(2) in Q8.
+#define FIXFFT_DB_PER_OCTAVE_Q8 771
+
+// Level reported for an empty bin, in Q8 dB.
+#define FIXFFT_FLOOR_DB_Q8 (-120 * 256)
+
+// log2(1 + i / 16) in Q8 for i = 0..16.
+static const int16_t log2_table[17] = {
+    0, 22, 44, 63, 82, 100, 118, 134, 150, 165, 179, 193, 207, 220, 232, 244, 256
+};
+
+/*
+    highest_bit: Index of the most significant set bit of a non-zero value.
+*/
+static int highest_bit(uint32_t x) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(x);
+#else
+    int bit = 0;
+    while (x >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/*
+    log2_q8: Integer log2 in Q8, exact in the octave and interpolated from
+    a 17-entry table within it (error below 0.005 octave).
+*/
+static int32_t log2_q8(uint32_t x) {
+    int msb = highest_bit(x);
+    uint32_t frac = (msb >= 8) ? (x >> (msb - 8)) & 0xFF : (x << (8 - msb)) & 0xFF;
+    int idx = frac >> 4;
+    int rem = frac & 15;
+    return msb * 256 + log2_table[idx] + (((log2_table[idx + 1] - log2_table[idx]) * rem) >> 4);
+}
+
+/*
+    isqrt32: Integer square root, rounded down.
+*/
+static uint16_t isqrt32(uint32_t x) {
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+static int16_t to_q15(double x) {
+    long v = lround(x * 32768.0);
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+/*
+    fixfft_init: Builds the window, twiddle and bit-reversal tables.
+    size must be a power of two.
+*/
+bool fixfft_init(FixFft* fft, int size) {
+    memset(fft, 0, sizeof(*fft));
+    fft->size = size;
+    fft->bins = size / 2 + 1;
+    while ((1 << fft->log2_size) < size) {
+        fft->log2_size++;
+    }
+
+    fft->window = malloc(sizeof(int16_t) * size);
+    fft->cos_table = malloc(sizeof(int16_t) * (size / 2));
+    fft->sin_table = malloc(sizeof(int16_t) * (size / 2));
+    fft->bit_reverse = malloc(sizeof(uint16_t) * size);
+    fft->re = malloc(sizeof(int16_t) * size);
+    fft->im = malloc(sizeof(int16_t) * size);
+    fft->power = calloc(fft->bins, sizeof(uint32_t));
+    fft->magnitude = calloc(fft->bins, sizeof(uint16_t));
+    fft->level_db = calloc(fft->bins, sizeof(int16_t));
+    if ((1 << fft->log2_size) != size || size > 65536 || !fft->window || !fft->cos_table ||
+        !fft->sin_table || !fft->bit_reverse || !fft->re || !fft->im || !fft->power ||
+        !fft->magnitude || !fft->level_db) {
+        fixfft_free(fft);
+        return false;
+    }
+
+    for (int i = 0; i < size; i++) {
+        fft->window[i] = to_q15(0.5 * (1 - cos(2 * M_PI * i / (size - 1))));
+        unsigned r = 0;
+        for (int b = 0; b < fft->log2_size; b++) {
+            r |= ((i >> b) & 1u) << (fft->log2_size - 1 - b);
+        }
+        fft->bit_reverse[i] = (uint16_t)r;
+    }
+    for (int k = 0; k < size / 2; k++) {
+        fft->cos_table[k] = to_q15(cos(2 * M_PI * k / size));
+        fft->sin_table[k] = to_q15(sin(2 * M_PI * k / size));
+    }
+    return true;
+}
+
+/*
+    fixfft_process: Windows and transforms size samples, then fills power,
+    magnitude and level_db for bins 0..size/2.
+*/
+void fixfft_process(FixFft* fft, const int16_t* samples) {
+    const int n = fft->size;
+    int16_t* re = fft->re;
+    int16_t* im = fft->im;
+
+    for (int i = 0; i < n; i++) {
+        re[fft->bit_reverse[i]] = (int16_t)((samples[i] * fft->window[i] + (1 << 14)) >> 15);
+        im[i] = 0;
+    }
+
+    fft->exponent = 0;
+    for (int len = 2; len <= n; len <<= 1) {
+        // |a| + sqrt(2)|b| must stay within int16 after the shift.
+        int peak = 0;
+        for (int i = 0; i < n; i++) {
+            int a = abs(re[i]);
+            int b = abs(im[i]);
+            peak = (a > peak) ? a : peak;
+            peak = (b > peak) ? b : peak;
+        }
+        const int shift = (peak <= 13572) ? 0 : (peak <= 27144) ? 1 : 2;
+        fft->exponent += shift;
+
+        const int half = len >> 1;
+        const int step = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                const int32_t wr = fft->cos_table[k * step];
+                const int32_t wi = -fft->sin_table[k * step];
+                const int i = start + k;
+                const int j = i + half;
+                const int32_t tr = (wr * re[j] - wi * im[j] + (1 << 14)) >> 15;
+                const int32_t ti = (wr * im[j] + wi * re[j] + (1 << 14)) >> 15;
+                const int32_t ar = re[i];
+                const int32_t ai = im[i];
+                re[i] = (int16_t)((ar + tr) >> shift);
+                im[i] = (int16_t)((ai + ti) >> shift);
+                re[j] = (int16_t)((ar - tr) >> shift);
+                im[j] = (int16_t)((ai - ti) >> shift);
+            }
+        }
+    }
+
+    // 10 log10(|X|) = 10 log10(2) * (log2(magnitude) + exponent - 15).
+    const int32_t offset_q8 = (fft->exponent - 15) * 256;
+    for (int k = 0; k < fft->bins; k++) {
+        uint32_t p = (uint32_t)(re[k] * re[k]) + (uint32_t)(im[k] * im[k]);
+        fft->power[k] = p;
+        fft->magnitude[k] = isqrt32(p);
+        if (fft->magnitude[k] == 0) {
+            fft->level_db[k] = FIXFFT_FLOOR_DB_Q8;
+            continue;
+        }
+        int32_t db = (FIXFFT_DB_PER_OCTAVE_Q8 * (log2_q8(fft->magnitude[k]) + offset_q8)) >> 8;
+        fft->level_db[k] = (int16_t)(db < FIXFFT_FLOOR_DB_Q8 ? FIXFFT_FLOOR_DB_Q8 : db);
+    }
+}
+
+/*
+    fixfft_memory: Bytes held by the tables and buffers, for comparing
+    against the float path.
+*/
+size_t fixfft_memory(const FixFft* fft) {
+    return sizeof(int16_t) * (size_t)fft->size * 4 +       // window, bit_reverse, re, im
+           sizeof(int16_t) * (size_t)fft->size +           // cos and sin tables
+           (sizeof(uint32_t) + 2 * sizeof(int16_t)) * (size_t)fft->bins;
+}
+
+/*
+    fixfft_free: Releases all tables and buffers.
+*/
+void fixfft_free(FixFft* fft) {
+    free(fft->window);
+    free(fft->cos_table);
+    free(fft->sin_table);
+    free(fft->bit_reverse);
+    free(fft->re);
+    free(fft->im);
+    free(fft->power);
+    free(fft->magnitude);
+    free(fft->level_db);
+    memset(fft, 0, sizeof(*fft));
+}
@@ -0,0 +1,41 @@
+#ifndef FIXFFT_H
+#define FIXFFT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    FixFft: Q15 fixed-point spectrum analysis for the low-power profile.
+
+    int16 samples are windowed with a Q15 Hann table and transformed by an
+    in-place radix-2 FFT on int16 data. Each stage checks the block peak
+    and shifts right by just enough to rule out overflow (block floating
+    point), so quiet input keeps its precision; the shifts are counted in
+    exponent. Power is formed in 32 bits, magnitude by integer square root
+    and levels by a table-interpolated integer log2.
+*/
+typedef struct {
+    int size;
+    int log2_size;
+    int bins;
+
+    int16_t* window;       // Q15 Hann.
+    int16_t* cos_table;    // Q15 cos(2 pi k / size), size / 2 entries.
+    int16_t* sin_table;
+    uint16_t* bit_reverse;
+    int16_t* re;           // Work buffers; spectrum = (re + j im) * 2^exponent.
+    int16_t* im;
+    int exponent;
+
+    uint32_t* power;       // re^2 + im^2 per bin.
+    uint16_t* magnitude;   // isqrt(power) per bin.
+    int16_t* level_db;     // Q8 of 10 log10(|X|) with samples scaled to [-1, 1).
+} FixFft;
+
+bool fixfft_init(FixFft* fft, int size);
+void fixfft_process(FixFft* fft, const int16_t* samples);
+size_t fixfft_memory(const FixFft* fft);
+void fixfft_free(FixFft* fft);
+
+#endif
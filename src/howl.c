@@ -0,0 +1,291 @@
+#include <SDL3/SDL.h>
+
+#include "howl.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Keeps the logarithm finite for silent bins.
+#define HOWL_FLOOR 1e-20f
+
+/*
+    HowlCandidate: A peak that passed the per-frame tests.
+*/
+typedef struct {
+    float bin;
+    float level_db;
+    float papr_db;
+    float phpr_db;
+} HowlCandidate;
+
+static float howl_db(float power) {
+    return 10.0f * log10f(power + HOWL_FLOOR);
+}
+
+/*
+    howl_init: Sets up a detector for frames of fft_size samples every hop.
+    With own_stft it also plans the transform howl_process_samples uses;
+    the FFTW planner is not thread-safe, so call it where plans are made.
+*/
+bool howl_init(HowlDetector* howl, int sample_rate, int fft_size, int hop, bool own_stft) {
+    memset(howl, 0, sizeof(*howl));
+    howl->fft_size = fft_size;
+    howl->bins = fft_size / 2 + 1;
+    howl->bin_hz = (float)sample_rate / fft_size;
+    howl->hop = hop;
+    howl->hop_seconds = (double)hop / sample_rate;
+    howl->first_bin = SDL_max(HOWL_NEIGHBOUR_FAR, (int)ceilf(HOWL_MIN_HZ / howl->bin_hz));
+    howl->last_bin = SDL_min(howl->bins - HOWL_NEIGHBOUR_FAR - 1, (int)floorf(HOWL_MAX_HZ / howl->bin_hz) + 1);
+    howl->persist_frames = SDL_max(3, (int)ceil(HOWL_PERSIST_S / howl->hop_seconds - 1e-6));
+    howl->settle_frames = (fft_size + hop - 1) / hop;
+    if (howl->last_bin <= howl->first_bin) {
+        return false;
+    }
+    if (!own_stft) {
+        return true;
+    }
+    howl->samples = calloc(fft_size, sizeof(float));
+    howl->window = malloc(sizeof(float) * fft_size);
+    howl->input = fftwf_malloc(sizeof(float) * fft_size);
+    howl->spectrum = fftwf_malloc(sizeof(fftwf_complex) * howl->bins);
+    howl->power = malloc(sizeof(float) * howl->bins);
+    if (!howl->samples || !howl->window || !howl->input || !howl->spectrum || !howl->power) {
+        howl_free(howl);
+        return false;
+    }
+    for (int i = 0; i < fft_size; i++) {
+        howl->window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / fft_size);
+    }
+    howl->plan = fftwf_plan_dft_r2c_1d(fft_size, howl->input, howl->spectrum, FFTW_MEASURE);
+    if (!howl->plan) {
+        howl_free(howl);
+        return false;
+    }
+    return true;
+}
+
+/*
+    howl_peak: Tests bin k as a feedback candidate against the frame mean,
+    its neighbourhood and its harmonics. Fills c and returns true when it
+    passes all three.
+*/
+static bool howl_peak(const HowlDetector* howl, const float* power, int k, float mean, HowlCandidate* c) {
+    const float p = power[k];
+    if (p <= power[k - 1] || p < power[k + 1] || p <= power[k - 2] || p <= power[k + 2]) {
+        return false;
+    }
+    c->papr_db = howl_db(p) - howl_db(mean);
+    if (c->papr_db < HOWL_PAPR_DB) {
+        return false;
+    }
+    float near = 0.0f;
+    for (int d = HOWL_NEIGHBOUR_NEAR; d <= HOWL_NEIGHBOUR_FAR; d++) {
+        near += power[k - d] + power[k + d];
+    }
+    near /= 2 * (HOWL_NEIGHBOUR_FAR - HOWL_NEIGHBOUR_NEAR + 1);
+    if (howl_db(p) - howl_db(near) < HOWL_PNPR_DB) {
+        return false;
+    }
+    float harmonic = 0.0f;
+    for (int h = 2; h <= 3; h++) {
+        const int centre = h * k;
+        for (int j = centre - 1; j <= centre + 1 && j < howl->bins; j++) {
+            harmonic = fmaxf(harmonic, power[j]);
+        }
+    }
+    c->phpr_db = howl_db(p) - howl_db(harmonic);
+    if (c->phpr_db < HOWL_PHPR_DB) {
+        return false;
+    }
+    // Quadratic through the log levels of the peak and its neighbours.
+    const float a = howl_db(power[k - 1]);
+    const float b = howl_db(p);
+    const float g = howl_db(power[k + 1]);
+    const float denom = a - 2.0f * b + g;
+    const float offset = denom < 0.0f ? 0.5f * (a - g) / denom : 0.0f;
+    c->bin = k + offset;
+    c->level_db = b - 0.25f * (a - g) * offset;
+    return true;
+}
+
+/*
+    howl_slope: Least-squares slope of a track's recent levels, in dB/s.
+    The first frame's worth of levels is skipped: while a new tone fills
+    the window its level rises whether or not it is growing.
+*/
+static float howl_slope(const HowlDetector* howl, const HowlTrack* track) {
+    const int n = SDL_min(track->frames - howl->settle_frames, HOWL_HISTORY);
+    if (n < 2) {
+        return 0.0f;
+    }
+    // levels[] is a ring; entry (frames - n + i) % HOWL_HISTORY is i frames after the oldest.
+    double mean_x = 0.5 * (n - 1);
+    double mean_y = 0.0;
+    for (int i = 0; i < n; i++) {
+        mean_y += track->levels[(track->frames - n + i) % HOWL_HISTORY];
+    }
+    mean_y /= n;
+    double sxy = 0.0;
+    double sxx = 0.0;
+    for (int i = 0; i < n; i++) {
+        const double dx = i - mean_x;
+        sxy += dx * (track->levels[(track->frames - n + i) % HOWL_HISTORY] - mean_y);
+        sxx += dx * dx;
+    }
+    return (float)(sxy / sxx / howl->hop_seconds);
+}
+
+/*
+    howl_frame: Picks this frame's candidates, extends or starts tracks
+    with them, and flags the tracks that persist and grow.
+*/
+static void howl_frame(HowlDetector* howl, const float* power) {
+    const double time = (howl->frames + 1) * howl->hop_seconds;
+    double sum = 0.0;
+    for (int k = howl->first_bin; k < howl->last_bin; k++) {
+        sum += power[k];
+    }
+    const float mean = (float)(sum / (howl->last_bin - howl->first_bin));
+
+    // Strongest candidates first.
+    HowlCandidate found[HOWL_CANDIDATES];
+    int count = 0;
+    for (int k = howl->first_bin; k < howl->last_bin; k++) {
+        HowlCandidate c;
+        if (power[k] <= mean || !howl_peak(howl, power, k, mean, &c)) {
+            continue;
+        }
+        if (count == HOWL_CANDIDATES && c.level_db <= found[count - 1].level_db) {
+            continue;
+        }
+        int slot = count < HOWL_CANDIDATES ? count++ : count - 1;
+        while (slot > 0 && found[slot - 1].level_db < c.level_db) {
+            found[slot] = found[slot - 1];
+            slot--;
+        }
+        found[slot] = c;
+    }
+
+    bool matched[HOWL_TRACKS] = {false};
+    for (int i = 0; i < count; i++) {
+        const HowlCandidate* c = &found[i];
+        int best = -1;
+        float best_distance = HOWL_TRACK_BINS;
+        int free_slot = -1;
+        for (int t = 0; t < HOWL_TRACKS; t++) {
+            const HowlTrack* track = &howl->tracks[t];
+            if (!track->active) {
+                free_slot = free_slot < 0 ? t : free_slot;
+                continue;
+            }
+            const float distance = fabsf(track->bin - c->bin);
+            if (!matched[t] && distance <= best_distance) {
+                best = t;
+                best_distance = distance;
+            }
+        }
+        if (best < 0 && free_slot < 0) {
+            continue;  // Every slot busy following a stronger or older peak.
+        }
+        if (best < 0) {
+            best = free_slot;
+            memset(&howl->tracks[best], 0, sizeof(HowlTrack));
+            howl->tracks[best].active = true;
+            howl->tracks[best].state.onset = time;
+        }
+        HowlTrack* track = &howl->tracks[best];
+        matched[best] = true;
+        track->bin = c->bin;
+        track->misses = 0;
+        track->levels[track->frames % HOWL_HISTORY] = c->level_db;
+        track->frames++;
+        track->state.frequency_hz = c->bin * howl->bin_hz;
+        track->state.level_db = c->level_db;
+        track->state.papr_db = c->papr_db;
+        track->state.phpr_db = c->phpr_db;
+        track->state.slope_db_per_s = howl_slope(howl, track);
+        track->state.time = time;
+        if (!track->alerted && track->frames >= howl->settle_frames + howl->persist_frames &&
+            track->state.slope_db_per_s >= HOWL_SLOPE_DB_PER_S) {
+            track->alerted = true;
+            if (howl->alert_count < HOWL_TRACKS) {
+                howl->alerts[howl->alert_count++] = track->state;
+            }
+        }
+    }
+
+    howl->howling = 0;
+    for (int t = 0; t < HOWL_TRACKS; t++) {
+        HowlTrack* track = &howl->tracks[t];
+        if (track->active && !matched[t] && ++track->misses > HOWL_MISS_FRAMES) {
+            track->active = false;
+        }
+        if (track->active && track->alerted) {
+            if (howl->howling == 0 || track->state.level_db > howl->loudest.level_db) {
+                howl->loudest = track->state;
+            }
+            howl->howling++;
+        }
+    }
+    howl->frames++;
+}
+
+/*
+    howl_process_spectrum: Analyses one frame of bin powers from the
+    caller's STFT. Alerts raised by it are left in howl->alerts.
+*/
+void howl_process_spectrum(HowlDetector* howl, const float* power) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    howl->alert_count = 0;
+    howl_frame(howl, power);
+    howl->seconds += (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+/*
+    howl_process_samples: Feeds new samples through the detector's own
+    STFT, analysing every completed hop. Alerts raised by any of those
+    frames are left in howl->alerts.
+*/
+void howl_process_samples(HowlDetector* howl, const float* samples, int count) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    const int n = howl->fft_size;
+    howl->alert_count = 0;
+    while (count > 0) {
+        const int take = SDL_min(count, howl->hop - howl->pending);
+        memmove(howl->samples, howl->samples + take, sizeof(float) * (n - take));
+        memcpy(howl->samples + n - take, samples, sizeof(float) * take);
+        samples += take;
+        count -= take;
+        howl->pending += take;
+        if (howl->pending < howl->hop) {
+            continue;
+        }
+        howl->pending = 0;
+        for (int i = 0; i < n; i++) {
+            howl->input[i] = howl->samples[i] * howl->window[i];
+        }
+        fftwf_execute(howl->plan);
+        for (int k = 0; k < howl->bins; k++) {
+            howl->power[k] = howl->spectrum[k][0] * howl->spectrum[k][0] + howl->spectrum[k][1] * howl->spectrum[k][1];
+        }
+        howl_frame(howl, howl->power);
+    }
+    howl->seconds += (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+void howl_free(HowlDetector* howl) {
+    if (howl->plan) {
+        fftwf_destroy_plan(howl->plan);
+    }
+    fftwf_free(howl->input);
+    fftwf_free(howl->spectrum);
+    free(howl->samples);
+    free(howl->window);
+    free(howl->power);
+    memset(howl, 0, sizeof(*howl));
+}
@@ -0,0 +1,112 @@
+#ifndef HOWL_H
+#define HOWL_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+// Short transform the window path runs on its own: 23 ms frames every
+// 2.9 ms at 44.1 kHz, independent of the display FFT.
+#define HOWL_FFT_SIZE 1024
+#define HOWL_HOP 128
+
+// Frequency range searched for feedback.
+#define HOWL_MIN_HZ 80.0f
+#define HOWL_MAX_HZ 12000.0f
+
+// Strongest narrowband peaks considered per frame, and tracks followed.
+#define HOWL_CANDIDATES 8
+#define HOWL_TRACKS 16
+
+// Candidate tests: peak over the frame's mean power (PAPR), over the
+// bins just outside its main lobe (PNPR) and over its 2nd and 3rd
+// harmonics (PHPR). Feedback is a lone sinusoid; music has harmonics.
+#define HOWL_PAPR_DB 15.0f
+#define HOWL_PNPR_DB 10.0f
+#define HOWL_PHPR_DB 10.0f
+#define HOWL_NEIGHBOUR_NEAR 3
+#define HOWL_NEIGHBOUR_FAR 6
+
+// A peak continues a track when it lies within this many bins of it; a
+// track ends after this many frames without one.
+#define HOWL_TRACK_BINS 1.0f
+#define HOWL_MISS_FRAMES 2
+
+// Alert once a track has lasted this long past its first window and its
+// level, fitted over the last HOWL_HISTORY frames, rises at least this fast.
+#define HOWL_PERSIST_S 0.03f
+#define HOWL_SLOPE_DB_PER_S 10.0f
+#define HOWL_HISTORY 16
+
+/*
+    HowlAlert: A track that passed every test.
+*/
+typedef struct {
+    float frequency_hz;     // Quadratic interpolation between bins.
+    float level_db;
+    float papr_db;
+    float phpr_db;
+    float slope_db_per_s;
+    double onset;           // Seconds of input when the track began.
+    double time;            // Seconds of input when it was flagged.
+} HowlAlert;
+
+/*
+    HowlTrack: One narrowband peak followed from frame to frame.
+*/
+typedef struct {
+    bool active;
+    bool alerted;
+    float bin;              // Interpolated position.
+    HowlAlert state;        // Latest measurements.
+    float levels[HOWL_HISTORY];
+    int frames;             // Frames matched so far.
+    int misses;             // Consecutive frames without a match.
+} HowlTrack;
+
+/*
+    HowlDetector: Early warning of acoustic feedback.
+
+    Every frame the strongest local maxima that stand out from the whole
+    spectrum, from their neighbourhood and from their own harmonics become
+    candidates; candidates continue the track at the same frequency or
+    start a new one. A track that persists for HOWL_PERSIST_S with a
+    rising level is reported once, with its frequency refined between
+    bins. Frames come either from the caller's spectra (any FFT size and
+    hop) or, in the window, from a short STFT the detector runs itself so
+    its hop is not the display's.
+*/
+typedef struct {
+    int fft_size;
+    int bins;
+    float bin_hz;
+    int hop;
+    double hop_seconds;
+    int first_bin;          // Search range.
+    int last_bin;
+    int persist_frames;
+    int settle_frames;      // Frames a new tone takes to fill the window.
+
+    // Own STFT (howl_init with own_stft).
+    float* samples;         // Last fft_size samples.
+    int pending;            // Samples received since the last frame.
+    float* window;
+    float* input;
+    fftwf_complex* spectrum;
+    fftwf_plan plan;
+    float* power;
+
+    HowlTrack tracks[HOWL_TRACKS];
+    unsigned long long frames;
+    HowlAlert alerts[HOWL_TRACKS];  // Raised by the last call.
+    int alert_count;
+    int howling;            // Alerted tracks still alive.
+    HowlAlert loudest;      // Loudest of those, when howling.
+    double seconds;         // Time spent analysing.
+} HowlDetector;
+
+bool howl_init(HowlDetector* howl, int sample_rate, int fft_size, int hop, bool own_stft);
+void howl_process_spectrum(HowlDetector* howl, const float* power);
+void howl_process_samples(HowlDetector* howl, const float* samples, int count);
+void howl_free(HowlDetector* howl);
+
+#endif
@@ -0,0 +1,146 @@
+#include "hpss.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    lower_bound: First index in [lo, hi) whose value is not less than value.
+*/
+static int lower_bound(const float* sorted, int lo, int hi, float value) {
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (sorted[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+    median_window_sort: Restores ordering after the window was filled directly.
+*/
+static void median_window_sort(MedianWindow* window) {
+    float* s = window->sorted;
+    for (int i = 1; i < window->size; i++) {
+        float v = s[i];
+        int j = lower_bound(s, 0, i, v);
+        memmove(&s[j + 1], &s[j], sizeof(float) * (i - j));
+        s[j] = v;
+    }
+}
+
+/*
+    median_window_replace: Swaps a value already in the window for a new one.
+    Both positions are found by binary search, and only the elements lying
+    between them are shifted, so a hop costs O(log n) comparisons.
+*/
+static void median_window_replace(MedianWindow* window, float old_value, float new_value) {
+    float* s = window->sorted;
+    int pos = lower_bound(s, 0, window->size, old_value);
+    if (new_value > old_value) {
+        int j = lower_bound(s, pos + 1, window->size, new_value);
+        memmove(&s[pos], &s[pos + 1], sizeof(float) * (j - pos - 1));
+        s[j - 1] = new_value;
+    } else if (new_value < old_value) {
+        int j = lower_bound(s, 0, pos, new_value);
+        memmove(&s[j + 1], &s[j], sizeof(float) * (pos - j));
+        s[j] = new_value;
+    }
+}
+
+static float median_window_median(const MedianWindow* window) {
+    return window->sorted[window->size / 2];
+}
+
+/*
+    hpss_init: Allocates the per-bin rings and median windows.
+    Window lengths are forced to be odd so the median is a single element.
+*/
+bool hpss_init(HpssState* hpss, int bins, int time_len, int freq_len) {
+    memset(hpss, 0, sizeof(*hpss));
+    hpss->bins = bins;
+    hpss->time_len = time_len | 1;
+    hpss->freq_len = freq_len | 1;
+
+    hpss->history = calloc((size_t)hpss->time_len * bins, sizeof(float));
+    hpss->time_windows = calloc(bins, sizeof(MedianWindow));
+    hpss->time_storage = calloc((size_t)hpss->time_len * bins, sizeof(float));
+    hpss->freq_window.sorted = calloc(hpss->freq_len, sizeof(float));
+    hpss->freq_window.size = hpss->freq_len;
+    hpss->harmonic_median = calloc(bins, sizeof(float));
+    hpss->percussive_median = calloc(bins, sizeof(float));
+    hpss->harmonic = calloc(bins, sizeof(float));
+    hpss->percussive = calloc(bins, sizeof(float));
+    if (!hpss->history || !hpss->time_windows || !hpss->time_storage ||
+        !hpss->freq_window.sorted || !hpss->harmonic_median ||
+        !hpss->percussive_median || !hpss->harmonic || !hpss->percussive) {
+        hpss_free(hpss);
+        return false;
+    }
+
+    // The history starts out silent, which is already a valid sorted window.
+    for (int k = 0; k < bins; k++) {
+        hpss->time_windows[k].sorted = &hpss->time_storage[(size_t)k * hpss->time_len];
+        hpss->time_windows[k].size = hpss->time_len;
+    }
+    return true;
+}
+
+/*
+    hpss_process: Feeds one magnitude frame and updates the harmonic and
+    percussive outputs. Cost per hop is O(bins * log(window)).
+*/
+void hpss_process(HpssState* hpss, const float* magnitude) {
+    const int bins = hpss->bins;
+    const int half = hpss->freq_len / 2;
+    float* oldest = &hpss->history[(size_t)hpss->history_slot * bins];
+
+    // Median across time: retire the oldest frame and admit the new one.
+    for (int k = 0; k < bins; k++) {
+        median_window_replace(&hpss->time_windows[k], oldest[k], magnitude[k]);
+        oldest[k] = magnitude[k];
+        hpss->harmonic_median[k] = median_window_median(&hpss->time_windows[k]);
+    }
+    hpss->history_slot = (hpss->history_slot + 1) % hpss->time_len;
+
+    // Median across frequency, zero-padded past either end of the spectrum.
+    for (int i = 0; i < hpss->freq_len; i++) {
+        int k = i - half;
+        hpss->freq_window.sorted[i] = (k >= 0 && k < bins) ? magnitude[k] : 0.0f;
+    }
+    median_window_sort(&hpss->freq_window);
+    for (int k = 0; k < bins; k++) {
+        hpss->percussive_median[k] = median_window_median(&hpss->freq_window);
+        int leaving = k - half;
+        int entering = k + half + 1;
+        float old_value = (leaving >= 0) ? magnitude[leaving] : 0.0f;
+        float new_value = (entering < bins) ? magnitude[entering] : 0.0f;
+        median_window_replace(&hpss->freq_window, old_value, new_value);
+    }
+
+    // Soft masks: each component keeps the share of power its median claims.
+    for (int k = 0; k < bins; k++) {
+        float h = hpss->harmonic_median[k] * hpss->harmonic_median[k];
+        float p = hpss->percussive_median[k] * hpss->percussive_median[k];
+        float mask = h / (h + p + 1e-12f);
+        hpss->harmonic[k] = magnitude[k] * mask;
+        hpss->percussive[k] = magnitude[k] * (1.0f - mask);
+    }
+}
+
+/*
+    hpss_free: Releases everything allocated by hpss_init.
+*/
+void hpss_free(HpssState* hpss) {
+    free(hpss->history);
+    free(hpss->time_windows);
+    free(hpss->time_storage);
+    free(hpss->freq_window.sorted);
+    free(hpss->harmonic_median);
+    free(hpss->percussive_median);
+    free(hpss->harmonic);
+    free(hpss->percussive);
+    memset(hpss, 0, sizeof(*hpss));
+}
@@ -0,0 +1,47 @@
+#ifndef HPSS_H
+#define HPSS_H
+
+#include <stdbool.h>
+
+/*
+    MedianWindow: Fixed-size sorted window supporting a running median.
+    Replacing the oldest value with the newest one is a binary search for
+    both positions followed by a shift of only the elements between them.
+*/
+typedef struct {
+    float* sorted;   // Window contents kept in ascending order.
+    int size;        // Number of values in the window (odd).
+} MedianWindow;
+
+/*
+    HpssState: Real-time harmonic/percussive separation by median filtering.
+
+    Harmonic energy is smooth across time, so each bin keeps a ring of its
+    recent magnitudes and a running median over them. Percussive energy is
+    smooth across frequency, so the current frame is median-filtered across
+    neighbouring bins. Soft (Wiener) masks derived from both medians split
+    the input magnitude into the two output spectra.
+*/
+typedef struct {
+    int bins;
+    int time_len;          // Frames in the per-bin time median (odd).
+    int freq_len;          // Bins in the frequency median (odd).
+
+    float* history;        // time_len x bins ring of past magnitudes.
+    int history_slot;      // Ring slot holding the oldest frame.
+    MedianWindow* time_windows; // One running median per bin.
+    float* time_storage;   // Backing storage for time_windows.
+    MedianWindow freq_window;   // Slides across bins for each frame.
+
+    float* harmonic_median;
+    float* percussive_median;
+
+    float* harmonic;       // Output: harmonic magnitude spectrum.
+    float* percussive;     // Output: percussive magnitude spectrum.
+} HpssState;
+
+bool hpss_init(HpssState* hpss, int bins, int time_len, int freq_len);
+void hpss_process(HpssState* hpss, const float* magnitude);
+void hpss_free(HpssState* hpss);
+
+#endif
@@ -8,6 +8,34 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "batch.h"
+#include "browser.h"
+#include "cli.h"
+#include "compact.h"
+#include "denoise.h"
+#include "descriptors.h"
+#include "envelope.h"
+#include "eq.h"
+#include "fingerprint.h"
+#include "fixfft.h"
+#include "howl.h"
+#include "hpss.h"
+#include "octave.h"
+#include "offline.h"
+#include "ola.h"
+#include "plugin.h"
+#include "preset.h"
+#include "psd.h"
+#include "recording.h"
+#include "selftest.h"
+#include "shm.h"
+#include "similarity.h"
+#include "source.h"
+#include "transfer.h"
+#include "trigger.h"
+#include "vad.h"
+#include "wav.h"
+
 // Fallback definition if M_PI is not defined.
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -15,36 +43,296 @@
 
 // Audio and FFT parameters.
 #define SAMPLE_RATE 44100
+#define AUDIO_CHANNELS 2   // Left is the reference input, right the measurement input.
+#define OUTPUT_CHANNELS 2  // Pass-through plays the processed mono signal on both channels.
+#ifdef AV_LOW_POWER
+#define FFT_SIZE 1024      // Low-power profile: Q15 fixed-point analysis on a smaller frame.
+#else
 #define FFT_SIZE 4096
+#endif
 #define BINS (FFT_SIZE/2 + 1)
-#define FFT_DELAY_MS (FFT_SIZE * 1000 / SAMPLE_RATE)  // Delay (milliseconds) for processing thread
+#define HOP_SIZE (FFT_SIZE / 2)       // Samples between analysis frames (50% overlap).
+#define RING_SIZE (FFT_SIZE * 4)      // Ring buffer capacity; leaves slack for a late processing thread.
+
+// Harmonic/percussive separation median lengths (frames across time, bins across frequency).
+#define HPSS_TIME_FRAMES 17
+#define HPSS_FREQ_BINS 17
+
+// Spectral envelope overlay: cepstral lifter length and LPC model order.
+#define ENVELOPE_LIFTER 40
+#define ENVELOPE_LPC_ORDER 32
+
+// Spectral descriptors: rolloff power fraction and frames kept for the strip charts.
+#define ROLLOFF_FRACTION 0.85f
+#define FEATURE_HISTORY 512
+
+// Real-time analyzer band resolution at startup (bands per octave).
+#define RTA_DEFAULT_FRACTION 3
+
+// Transfer-function Welch averaging depth at startup, and its upper limit.
+#define TRANSFER_DEFAULT_DEPTH 16
+#define TRANSFER_MAX_DEPTH 256
+
+// Spectrogram history length in hops (about 24 s) and its storage format at startup.
+#define SPECTROGRAM_HISTORY 512
+#define HISTORY_DEFAULT_FORMAT FRAME_DB8
+
+// Time constant of the exponential long-term PSD average, in seconds.
+#define PSD_TAU_SECONDS 10.0
+
+// Denoise: over-subtraction factor, gain floor and noise profile length in frames (about 2 s).
+#define DENOISE_OVER_SUBTRACTION 1.5f
+#define DENOISE_FLOOR_GAIN 0.05f
+#define DENOISE_PROFILE_FRAMES (2 * SAMPLE_RATE / HOP_SIZE)
+#define DENOISE_PREVIEW_PATH "denoise_preview.wav"
+
+// Pass-through output queue bound: one hop plus one device period. This
+// period is assumed when SDL does not report the device buffer size.
+#define OUTPUT_DEFAULT_PERIOD 256
+
+// Parametric EQ: band list read when the EQ is switched on, and the overlay's +/- dB range.
+#define EQ_CONFIG_PATH "eq.txt"
+#define EQ_DISPLAY_RANGE_DB 24.0f
+
+// Silence throttle: hop levels in dBFS, flatness above which quiet input counts as
+// noise, level rise that ends silence, quiet time before throttling (about 1 s),
+// and the redraw interval while silent. White noise measures a flatness of about
+// 0.56 through the Hann window; tonal material stays well below 0.4.
+#define VAD_SILENCE_DB -60.0f
+#define VAD_NOISE_DB -45.0f
+#define VAD_FLATNESS 0.4f
+#define VAD_RESUME_MARGIN_DB 6.0f
+#define VAD_HANGOVER_HOPS (SAMPLE_RATE / HOP_SIZE)
+#define VAD_IDLE_FRAME_MS 500
+
+// FFTW wisdom file: plans measured on one start are reused by the next.
+#define PLAN_WISDOM_PATH "fftw_wisdom.dat"
+
+// Frames a file or generator source hands to audio_callback per step (10 ms).
+#define SOURCE_FEED_FRAMES (SAMPLE_RATE / 100)
 
 // Global FFTW plan so that we only create it once.
 static fftwf_plan g_fft_plan = NULL;
 
+/*
+    ViewMode selects what the main loop draws each frame.
+*/
+typedef enum {
+    VIEW_SPECTRUM,   // Plain magnitude spectrum.
+    VIEW_HPSS,       // Harmonic (top) and percussive (bottom) spectra.
+    VIEW_FEATURES,   // Strip charts of the per-frame spectral descriptors.
+    VIEW_RTA,        // Fractional-octave real-time analyzer.
+    VIEW_TRANSFER,   // Reference/measurement transfer function and coherence.
+    VIEW_PSD,        // Long-term averaged power spectral density.
+    VIEW_SPECTROGRAM,// Scrolling spectrogram of the stored history.
+    VIEW_BROWSER,    // Zoomable tiles of a recording or pyramid (--browse).
+    VIEW_PLUGIN,     // Drawn by the render plugins (--plugin).
+    VIEW_PRESET      // Columns computed by the preset's expressions (--preset).
+} ViewMode;
+
+/*
+    RtaSnapshot: Band levels published by the processing thread for the RTA view.
+*/
+typedef struct {
+    int fraction;
+    bool filterbank;               // Levels come from the IIR filterbank path.
+    int band_count;
+    float center_hz[OCTAVE_MAX_BANDS];
+    float level_db[OCTAVE_MAX_BANDS];
+    float leq_db[OCTAVE_MAX_BANDS];
+    double leq_seconds;
+} RtaSnapshot;
+
 /*
     AppState structure holds shared state for video rendering,
     audio processing, and thread synchronization.
 */
 typedef struct {
-    SDL_AudioDeviceID audio_device;
+    SDL_AudioStream* capture_stream;  // Recording device; feeds the ring buffer.
+    SDL_AudioStream* playback_stream; // Playback device for the pass-through path, may be NULL.
+    int playback_device_frames;       // Device buffer size reported by SDL.
     
     // Ring buffer to store incoming audio samples.
-    float audio_buffer[FFT_SIZE];
+    float audio_buffer[RING_SIZE];               // Mono mix of all channels.
+    float channel_buffer[AUDIO_CHANNELS][RING_SIZE]; // Per-channel copies at the same index.
     int audio_buffer_index;   // Next write position in the ring buffer.
+    Uint64 audio_samples_written; // Total samples ever written to the ring buffer.
     SDL_Mutex* audio_mutex;   // Protects audio_buffer
+#ifdef AV_LOW_POWER
+    int16_t pcm_buffer[RING_SIZE];   // Integer mono mix for the fixed-point path.
+#endif
 
     // FFT processing buffers.
     float* fft_input;         // Contiguous FFT input window.
     fftwf_complex* fft_output; // Result of FFT.
-    SDL_Mutex* fft_mutex;      // Protects fft_output
+    SDL_Mutex* fft_mutex;      // Protects fft_output and the published analysis results
+    float power[BINS];         // Power of fft_output, owned by the processing thread.
+    float magnitude[BINS];     // Magnitude of fft_output, owned by the processing thread.
+#ifdef AV_LOW_POWER
+    FixFft fixfft;             // Fixed-point analysis; fft_output is converted from it.
+    int16_t pcm_window[FFT_SIZE];
+    int16_t level_db_q8[BINS]; // Published integer spectrum levels for the bars.
+#endif
+    float fft_cost_ms;         // Window plus transform, per hop.
+    float hop_samples[FFT_SIZE]; // Samples that arrived since the previous hop, oldest first.
+    int hop_sample_count;
+    Uint64 samples_processed;    // Ring position where the last analysed window ended.
+
+    // Spectral denoise preview, applied to fft_output before any analysis or display.
+    DenoiseState denoise;
+    DenoiseMode denoise_mode;
+    bool denoise_capture_request; // Set by the main thread; applied on the next hop.
+    bool denoise_capturing;
+    float denoise_cost_ms;
+
+    // Overlap-add resynthesis of the (denoised) spectrum, written to a WAV for audition.
+    OlaState resynth;
+    WavWriter preview;
+    bool preview_request;         // Main thread's wish; the processing thread opens/closes the file.
+    bool resynth_active;          // Resynthesis ran on the previous hop.
+    float resynth_cost_ms;
+
+    // Duplex pass-through: resynthesised hops queued for the playback callback.
+    bool passthrough;
+    float output_buffer[RING_SIZE];
+    Uint64 output_written;        // Samples ever queued by the processing thread.
+    Uint64 output_read;           // Samples ever consumed by the playback callback.
+    Uint64 output_underruns;      // Playback requests that found the queue short.
+    SDL_Mutex* output_mutex;      // Protects output_buffer and its counters.
+    float output_queue_ms;        // Smoothed queue depth (ours plus SDL's) after each hop.
+
+    // Parametric EQ, overlaid on the spectrum and optionally applied to the pass-through.
+    EqMode eq_mode;
+    EqChain eq_chain;            // Written by the main thread under fft_mutex.
+    int eq_selected;             // Band edited by the arrow keys.
+    EqResponse eq_response;      // Main thread only; refreshed when the chain changes.
+    float eq_response_cost_ms;   // Time of the last response refresh.
+    EqCascade eq_cascade;        // Processing thread only.
+    float eq_cost_ms;
+
+    // Silence throttle: while silent, hops are consumed without any FFT work
+    // and the main loop redraws rarely.
+    VadState vad;
+    bool vad_enabled;
+    bool vad_silent;             // Published throttle state.
+    Uint32 wake_event;           // Pushed when sound returns, to wake the main loop.
+    float process_busy_ms;       // Processing thread work since the last load report.
+    float render_busy_ms;        // Main thread render work since the last load report.
+    float process_load;          // Busy percentages over the last report interval.
+    float render_load;
+
+    // Spectral descriptors computed every hop and published with timestamps.
+    DescriptorState descriptors;
+    SpectralFeatures feature_history[FEATURE_HISTORY]; // Ring of published frames.
+    int feature_head;            // Next slot to write.
+    int feature_count;           // Valid entries in the ring.
+    float descriptor_cost_ms;
+
+    // Fractional-octave analyzer; both paths run while the RTA view is shown.
+    OctaveAnalyzer rta;
+    float rta_power_scale;       // Bin power sum to mean square for the Hann window.
+    int rta_fraction_request;    // Set by the main thread; applied on the next hop.
+    bool rta_use_filterbank;
+    bool rta_reset_request;
+    RtaSnapshot rta_snapshot;
+    float rta_fft_cost_ms;
+    float rta_filter_cost_ms;
+
+    // Dual-channel transfer function, only run while its view is shown.
+    TransferState transfer;
+    int transfer_depth_request;  // Set by the main thread; applied on the next hop.
+    float transfer_magnitude_db[BINS]; // Published copies of the transfer outputs.
+    float transfer_phase_deg[BINS];
+    float transfer_coherence[BINS];
+    int transfer_filled;
+    float transfer_cost_ms;
+
+    // Spectrogram history: one row of bar levels (dB) per hop, stored packed.
+    FrameFormat history_format;
+    FrameFormat history_format_request; // Set by the main thread; applied on the next hop.
+    unsigned char* history;      // SPECTROGRAM_HISTORY rows, guarded by fft_mutex.
+    int history_head;            // Next row to write.
+    Uint64 history_total;        // Rows written since the last format change.
+    float history_cost_ms;
+    SDL_Texture* spectrogram_texture; // Main thread: one column per history row.
+    Uint64 spectrogram_drawn;    // history_total already uploaded to the texture.
+
+    // Long-term PSD, accumulated on every hop regardless of the view.
+    PsdState psd;
+    PsdAveraging psd_averaging;
+    bool psd_reset_request;      // Set by the main thread; applied on the next hop.
+    float psd_db[BINS];          // Published PSD in dB re FS^2/Hz.
+    double psd_seconds;
+    float psd_cost_ms;
+
+    // Harmonic/percussive separation, only run while its view is shown.
+    HpssState hpss;
+    float hpss_harmonic[BINS];   // Published copies of the HPSS outputs.
+    float hpss_percussive[BINS];
+    float hpss_cost_ms;          // Smoothed processing time per hop.
+
+    // Spectral envelope overlay drawn over the spectrum bars.
+    EnvelopeState envelope;
+    EnvelopeMethod envelope_method;
+    float envelope_curve[BINS];  // Published copy of the envelope.
+    float envelope_cost_ms;
+
+    // Startup: audio devices and FFT plans are prepared on background
+    // threads while the window shows a placeholder.
+    SDL_Thread* device_thread;
+    SDL_Thread* plan_thread;
+    SDL_AtomicInt devices_ready; // Set by each thread once its results are written.
+    SDL_AtomicInt plans_ready;
+    Uint64 startup_counter;      // Performance counter when main started.
+    float device_open_ms;
+    float plan_warmup_ms;
+    Uint64 hops_analysed;        // Spectra published so far, guarded by fft_mutex.
+    bool first_spectrum_reported;
+
+    // Command-line input and outputs.
+    bool use_source;             // A file or generator replaces the recording device.
+    AudioSource source;
+    SDL_Thread* source_thread;   // Feeds the source through audio_callback in real time.
+    Recording recording;         // --record, written by the processing thread.
+    SharedFrame shared;          // --shm, published by the processing thread.
+    FILE* video;                 // --video, written by the main thread.
+    Browser browser;             // --browse, drawn by the main thread.
+    bool browser_ready;
+    FingerprintIndex fp_index;   // --fingerprint, matched by the processing thread.
+    FingerprintExtractor fp;
+    FingerprintMatcher* fp_matcher;
+    FingerprintHash* fp_hashes;
+    FingerprintMatch fp_result;  // Last voting window, published under fft_mutex.
+    double fp_lookup_rate;       // Lookups per second of matching time.
+    float fp_cost_ms;
+    bool howl_enabled;           // --howl, planned at startup and run by the processing thread.
+    HowlDetector howl;
+    HowlAlert howl_loudest;      // Published under fft_mutex.
+    int howling;
+    float howl_cost_ms;
+    TriggerEngine triggers;      // --triggers, evaluated by the processing thread.
+    bool triggers_open;
+    unsigned long long trigger_events;  // Published under fft_mutex.
+    float trigger_cost_ms;
+    PluginHost plugins;          // --plugin: analysis on the processing thread, render on the main thread.
+    Uint64 plugin_hops;          // Hops handed to the plugins, owned by the processing thread.
+    float plugin_column[BINS];   // Latest row for the render plugins, published under fft_mutex.
+    Uint64 plugin_column_index;
+    int plugin_analysis_active;  // Analysis stages still enabled, published under fft_mutex.
+    float plugin_analysis_ms;
+    float plugin_render_ms;      // Main thread only.
+    Preset preset;               // --preset, evaluated and drawn by the main thread.
+    bool preset_ready;
+    Uint64 preset_start;         // Performance counter when the preset was loaded.
+    float preset_cost_ms;
 
     // SDL window and renderer for visualization.
     SDL_Window* window;
     SDL_Renderer* renderer;
     
-    // Application state flag.
+    // Application state flags.
     bool running;
+    ViewMode view_mode;
 } AppState;
 
 /*
@@ -74,6 +362,10 @@ void HSLtoRGB(float h, float s, float l, Uint8* r, Uint8* g, Uint8* b) {
     *b = (Uint8)((b1 + m) * 255);
 }
 
+// SDL stream callbacks, defined below next to the ring buffer code.
+void capture_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount);
+void playback_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount);
+
 /*
     initialize_sdl: Initializes SDL (video, audio, and events), creates a window,
     a hardware-accelerated renderer, and opens an audio device.
@@ -81,7 +373,7 @@ void HSLtoRGB(float h, float s, float l, Uint8* r, Uint8* g, Uint8* b) {
     Returns true if everything initializes correctly; otherwise false.
 */
 bool initialize_sdl(AppState* state) {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) != 0) {
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS)) {
         fprintf(stderr, "SDL init error: %s\n", SDL_GetError());
         return false;
     }
@@ -101,22 +393,11 @@ bool initialize_sdl(AppState* state) {
         return false;
     }
     
-    // Setup the desired audio specification.
-    SDL_AudioSpec desired_spec = {0};
-    desired_spec.freq = SAMPLE_RATE;
-    desired_spec.format = SDL_AUDIO_S16;
-    desired_spec.channels = 1;
-    // Note: In SDL3, the callback will be attached after opening the device.
-    
-    state->audio_device = SDL_OpenAudioDevice(NULL, &desired_spec);
-    if (state->audio_device == 0) {
-        fprintf(stderr, "Audio device open failed: %s\n", SDL_GetError());
-        return false;
-    }
-    
-    // Create a mutex to protect the audio ring buffer.
+    // Create mutexes to protect the audio ring buffer and the pass-through queue.
+    // Both exist before any device is opened, since the callbacks use them.
     state->audio_mutex = SDL_CreateMutex();
-    if (!state->audio_mutex) {
+    state->output_mutex = SDL_CreateMutex();
+    if (!state->audio_mutex || !state->output_mutex) {
         fprintf(stderr, "Audio mutex creation failed: %s\n", SDL_GetError());
         return false;
     }
@@ -129,53 +410,667 @@ bool initialize_sdl(AppState* state) {
     return true;
 }
 
+/*
+    elapsed_ms: Milliseconds between two SDL performance counter readings.
+*/
+static float elapsed_ms(Uint64 start, Uint64 end) {
+    return (float)((double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
 /*
     audio_callback: Registered as the SDL audio callback.
-    Converts 16-bit signed audio data to floats and writes them into a circular buffer.
+    Converts interleaved 16-bit signed audio data to floats and writes the
+    mono mix and each channel into circular buffers.
 */
 void audio_callback(void* userdata, Uint8* stream, int len) {
     AppState* state = (AppState*)userdata;
-    int samples = len / sizeof(int16_t);
+    int frames = len / (sizeof(int16_t) * AUDIO_CHANNELS);
     int16_t* audio_data = (int16_t*)stream;
     
     SDL_LockMutex(state->audio_mutex);
-    for (int i = 0; i < samples; i++) {
-        float sample = audio_data[i] / 32768.0f;
-        state->audio_buffer[state->audio_buffer_index] = sample;
-        state->audio_buffer_index = (state->audio_buffer_index + 1) % FFT_SIZE;
+    for (int i = 0; i < frames; i++) {
+        int idx = state->audio_buffer_index;
+        float mix = 0;
+        for (int c = 0; c < AUDIO_CHANNELS; c++) {
+            float sample = audio_data[i * AUDIO_CHANNELS + c] / 32768.0f;
+            state->channel_buffer[c][idx] = sample;
+            mix += sample;
+        }
+        state->audio_buffer[idx] = mix / AUDIO_CHANNELS;
+#ifdef AV_LOW_POWER
+        int pcm = 0;
+        for (int c = 0; c < AUDIO_CHANNELS; c++) {
+            pcm += audio_data[i * AUDIO_CHANNELS + c];
+        }
+        state->pcm_buffer[idx] = (int16_t)(pcm / AUDIO_CHANNELS);
+#endif
+        state->audio_buffer_index = (idx + 1) % RING_SIZE;
     }
+    state->audio_samples_written += frames;
     SDL_UnlockMutex(state->audio_mutex);
 }
 
 /*
-    process_audio: Constructs a contiguous FFT window from the ring buffer,
-    applies a Hann window to the signal, and executes the FFT.
+    capture_callback: SDL stream callback for the recording device. Pulls
+    whatever SDL has converted to our format and hands it to audio_callback.
 */
-void process_audio(AppState* state) {
-    // Build a contiguous FFT input window from the circular ring buffer.
+void capture_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount) {
+    Uint8 buffer[4096];
+    int got;
+    while ((got = SDL_GetAudioStreamData(stream, buffer, sizeof(buffer))) > 0) {
+        audio_callback(userdata, buffer, got);
+    }
+}
+
+/*
+    source_feed_thread: Stands in for the recording device when a file or
+    generator is analysed in the window. Converts the source to the capture
+    format and hands it to audio_callback at the real-time rate; a mono
+    source feeds both channels. Stops at the end of a file.
+*/
+int source_feed_thread(void* data) {
+    AppState* state = (AppState*)data;
+    AudioSource* src = &state->source;
+    float* samples = malloc(sizeof(float) * SOURCE_FEED_FRAMES * src->channels);
+    if (!samples) {
+        return 0;
+    }
+    int16_t pcm[SOURCE_FEED_FRAMES * AUDIO_CHANNELS];
+    const Uint64 step_ns = SDL_NS_PER_SECOND * SOURCE_FEED_FRAMES / SAMPLE_RATE;
+    Uint64 next = SDL_GetTicksNS();
+    while (state->running) {
+        int got = source_read(src, samples, SOURCE_FEED_FRAMES);
+        if (got <= 0) {
+            break;
+        }
+        for (int i = 0; i < got; i++) {
+            for (int c = 0; c < AUDIO_CHANNELS; c++) {
+                float sample = samples[i * src->channels + (c < src->channels ? c : 0)];
+                sample = sample > 1.0f ? 1.0f : (sample < -1.0f ? -1.0f : sample);
+                pcm[i * AUDIO_CHANNELS + c] = (int16_t)lrintf(sample * 32767.0f);
+            }
+        }
+        audio_callback(state, (Uint8*)pcm, got * (int)sizeof(int16_t) * AUDIO_CHANNELS);
+        next += step_ns;
+        Uint64 now = SDL_GetTicksNS();
+        if (next > now) {
+            SDL_DelayNS(next - now);
+        }
+    }
+    free(samples);
+    return 1;
+}
+
+/*
+    playback_callback: SDL stream callback for the playback device. Drains
+    the pass-through queue, duplicating the mono signal to every output
+    channel, and pads with silence when the queue runs short.
+*/
+void playback_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount) {
+    AppState* state = (AppState*)userdata;
+    float buffer[512 * OUTPUT_CHANNELS];
+    int frames_wanted = additional_amount / (int)(sizeof(float) * OUTPUT_CHANNELS);
+
+    while (frames_wanted > 0) {
+        int frames = (frames_wanted < 512) ? frames_wanted : 512;
+        SDL_LockMutex(state->output_mutex);
+        Uint64 queued = state->output_written - state->output_read;
+        int available = (queued < (Uint64)frames) ? (int)queued : frames;
+        for (int i = 0; i < frames; i++) {
+            float sample = 0;
+            if (i < available) {
+                sample = state->output_buffer[(state->output_read + i) % RING_SIZE];
+            }
+            for (int c = 0; c < OUTPUT_CHANNELS; c++) {
+                buffer[i * OUTPUT_CHANNELS + c] = sample;
+            }
+        }
+        state->output_read += available;
+        if (available < frames && state->passthrough) {
+            state->output_underruns++;
+        }
+        SDL_UnlockMutex(state->output_mutex);
+
+        SDL_PutAudioStreamData(stream, buffer, frames * (int)(sizeof(float) * OUTPUT_CHANNELS));
+        frames_wanted -= frames;
+    }
+}
+
+/*
+    process_rta: Runs both octave analyzer paths on the current hop so their
+    costs can be compared, and publishes the levels of the selected path.
+*/
+void process_rta(AppState* state) {
+    OctaveAnalyzer* rta = &state->rta;
+
+    int fraction = state->rta_fraction_request;
+    if (fraction != rta->fraction) {
+        octave_free(rta);
+        if (!octave_init(rta, fraction, SAMPLE_RATE, FFT_SIZE, state->rta_power_scale)) {
+            // octave_init has already recorded the fraction; clear it so the
+            // stage stays off and the next hop retries.
+            octave_free(rta);
+            rta->fraction = 0;
+            rta->band_count = 0;
+            return;
+        }
+    }
+    if (state->rta_reset_request) {
+        state->rta_reset_request = false;
+        octave_reset_leq(rta);
+    }
+    if (state->hop_sample_count == 0) {
+        return;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    octave_process_spectrum(rta, state->power, (float)state->hop_sample_count / SAMPLE_RATE);
+    Uint64 middle = SDL_GetPerformanceCounter();
+    octave_process_samples(rta, state->hop_samples, state->hop_sample_count);
+    Uint64 end = SDL_GetPerformanceCounter();
+
+    bool filterbank = state->rta_use_filterbank;
+    const OctaveLevels* levels = filterbank ? &rta->filter_levels : &rta->fft_levels;
+
+    SDL_LockMutex(state->fft_mutex);
+    RtaSnapshot* snap = &state->rta_snapshot;
+    snap->fraction = rta->fraction;
+    snap->filterbank = filterbank;
+    snap->band_count = rta->band_count;
+    snap->leq_seconds = levels->leq_seconds;
+    for (int b = 0; b < rta->band_count; b++) {
+        snap->center_hz[b] = rta->center_hz[b];
+        snap->level_db[b] = levels->fast_db[b];
+        snap->leq_db[b] = octave_leq_db(levels, b);
+    }
+    state->rta_fft_cost_ms += 0.1f * (elapsed_ms(start, middle) - state->rta_fft_cost_ms);
+    state->rta_filter_cost_ms += 0.1f * (elapsed_ms(middle, end) - state->rta_filter_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_psd: Folds the current frame into the long-term PSD and, while
+    the PSD view is shown, publishes the scaled spectrum.
+*/
+void process_psd(AppState* state) {
+    if (state->psd_reset_request) {
+        state->psd_reset_request = false;
+        psd_reset(&state->psd);
+    }
+    if (state->hop_sample_count == 0) {
+        return;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    psd_accumulate(&state->psd, state->power, (double)state->hop_sample_count / SAMPLE_RATE);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    if (state->view_mode == VIEW_PSD) {
+        static float psd_db[BINS];
+        psd_read_db(&state->psd, state->psd_averaging, psd_db);
+
+        SDL_LockMutex(state->fft_mutex);
+        memcpy(state->psd_db, psd_db, sizeof(float) * BINS);
+        state->psd_seconds = state->psd.seconds;
+        state->psd_cost_ms += 0.1f * (cost - state->psd_cost_ms);
+        SDL_UnlockMutex(state->fft_mutex);
+    }
+}
+
+/*
+    process_fingerprint: Extracts this hop's landmarks, votes with their
+    index hits and publishes the last closed voting window.
+*/
+void process_fingerprint(AppState* state, const float* row) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    int count = fingerprint_push(&state->fp, row, state->fp_hashes);
+    fingerprint_matcher_add(state->fp_matcher, state->fp_hashes, count, state->fp.frame - 1);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    const FingerprintMatcher* m = state->fp_matcher;
+    SDL_LockMutex(state->fft_mutex);
+    state->fp_result = m->result;
+    state->fp_lookup_rate = m->lookup_seconds > 0 ? m->lookups / m->lookup_seconds : 0.0;
+    state->fp_cost_ms += 0.1f * (cost - state->fp_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_triggers: Evaluates the rules against this hop's row and
+    publishes the event count and evaluation cost.
+*/
+void process_triggers(AppState* state, const float* row) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    trigger_process(&state->triggers, row);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    SDL_LockMutex(state->fft_mutex);
+    state->trigger_events = state->triggers.events;
+    state->trigger_cost_ms += 0.1f * (cost - state->trigger_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_plugins: Hands this hop to the analysis plugins and publishes
+    the row the render plugins draw from.
+*/
+void process_plugins(AppState* state, const float* row) {
+    float cost = 0.0f;
+    if (plugin_host_wants(&state->plugins, AV_PLUGIN_ANALYSIS)) {
+        const AvAnalysisFrame frame = {
+            .struct_size = sizeof(AvAnalysisFrame),
+            .hop_index = state->plugin_hops,
+            .time_seconds = (double)state->plugin_hops * HOP_SIZE / SAMPLE_RATE,
+            .samples = state->hop_samples,
+            .sample_count = state->hop_sample_count,
+            .power = state->power,
+            .row_db = row,
+            .bins = BINS,
+        };
+        cost = plugin_host_analyse(&state->plugins, &frame);
+    }
+    int active = 0;
+    for (int i = 0; i < state->plugins.count; i++) {
+        active += state->plugins.plugins[i].analysis.enabled;
+    }
+
+    SDL_LockMutex(state->fft_mutex);
+    memcpy(state->plugin_column, row, sizeof(float) * BINS);
+    state->plugin_column_index = state->plugin_hops;
+    state->plugin_analysis_active = active;
+    state->plugin_analysis_ms += 0.1f * (cost - state->plugin_analysis_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+    state->plugin_hops++;
+}
+
+/*
+    process_howl: Runs the feedback detector's own short STFT over this
+    hop's samples, prints new alerts and publishes the loudest feedback.
+*/
+void process_howl(AppState* state) {
+    if (state->hop_sample_count == 0) {
+        return;
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    howl_process_samples(&state->howl, state->hop_samples, state->hop_sample_count);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    for (int i = 0; i < state->howl.alert_count; i++) {
+        const HowlAlert* a = &state->howl.alerts[i];
+        printf("Feedback: %.1f Hz rising %.0f dB/s, flagged %.0f ms after it appeared\n",
+               a->frequency_hz, a->slope_db_per_s, (a->time - a->onset) * 1000.0);
+    }
+    SDL_LockMutex(state->fft_mutex);
+    state->howl_loudest = state->howl.loudest;
+    state->howling = state->howl.howling;
+    state->howl_cost_ms += 0.1f * (cost - state->howl_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_history: Appends this hop's bar levels to the spectrogram
+    history in the current storage format, reallocating (and clearing)
+    the history when the main thread asks for another format.
+*/
+void process_history(AppState* state) {
+    FrameFormat format = state->history_format_request;
+    if (format != state->history_format || !state->history) {
+        unsigned char* history = malloc(compact_frame_bytes(format, BINS) * SPECTROGRAM_HISTORY);
+        if (!history) {
+            state->history_format_request = state->history_format;
+            return;
+        }
+        SDL_LockMutex(state->fft_mutex);
+        free(state->history);
+        state->history = history;
+        state->history_format = format;
+        state->history_head = 0;
+        state->history_total = 0;
+        SDL_UnlockMutex(state->fft_mutex);
+    }
+
+    static float row[BINS];
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BINS; i++) {
+        row[i] = 10 * log10f(state->magnitude[i] + 1e-6f);
+    }
+    const size_t row_bytes = compact_frame_bytes(format, BINS);
+
+    SDL_LockMutex(state->fft_mutex);
+    compact_encode(format, row, state->history + row_bytes * state->history_head, BINS);
+    state->history_head = (state->history_head + 1) % SPECTROGRAM_HISTORY;
+    state->history_total++;
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+    state->history_cost_ms += 0.1f * (cost - state->history_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+
+    // The command-line sinks get the same row, outside the lock.
+    if (state->recording.file) {
+        recording_write(&state->recording, row);
+    }
+    if (state->shared.header) {
+        shm_publish(&state->shared, row);
+    }
+    if (state->fp_matcher) {
+        process_fingerprint(state, row);
+    }
+    if (state->triggers_open) {
+        process_triggers(state, row);
+    }
+    if (state->plugins.count) {
+        process_plugins(state, row);
+    }
+}
+
+/*
+    process_transfer: Updates the Welch-averaged transfer function from the
+    channel windows copied this hop and publishes the results.
+*/
+void process_transfer(AppState* state) {
+    TransferState* tf = &state->transfer;
+    if (state->transfer_depth_request != tf->depth &&
+        !transfer_set_depth(tf, state->transfer_depth_request)) {
+        state->transfer_depth_request = tf->depth;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    transfer_process(tf);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    SDL_LockMutex(state->fft_mutex);
+    memcpy(state->transfer_magnitude_db, tf->magnitude_db, sizeof(float) * BINS);
+    memcpy(state->transfer_phase_deg, tf->phase_deg, sizeof(float) * BINS);
+    memcpy(state->transfer_coherence, tf->coherence, sizeof(float) * BINS);
+    state->transfer_filled = tf->filled;
+    state->transfer_cost_ms += 0.1f * (cost - state->transfer_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_denoise: Captures the noise profile on request, applies the gain
+    stage to the spectrum, and feeds the resynthesis while a preview is
+    being recorded.
+*/
+void process_denoise(AppState* state) {
+    if (state->denoise_capture_request) {
+        state->denoise_capture_request = false;
+        denoise_start_capture(&state->denoise, DENOISE_PROFILE_FRAMES);
+    }
+    denoise_capture(&state->denoise, state->fft_output);
+    state->denoise_capturing = (state->denoise.capture_target != 0);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_LockMutex(state->fft_mutex);
+    denoise_apply(&state->denoise, state->denoise_mode, state->fft_output);
+    SDL_UnlockMutex(state->fft_mutex);
+    Uint64 middle = SDL_GetPerformanceCounter();
+
+    SDL_LockMutex(state->fft_mutex);
+    state->denoise_cost_ms += 0.1f * (elapsed_ms(start, middle) - state->denoise_cost_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_resynthesis: Inverse transforms the processed spectrum and
+    overlap-adds it into one hop of audio, which goes to the preview file
+    and/or the pass-through queue. The queue is bounded to one hop plus a
+    little device slack, dropping its oldest samples if playback falls
+    behind, so latency stays near one hop plus the device buffer.
+*/
+void process_resynthesis(AppState* state) {
+    // Open or close the preview file on the thread that writes it.
+    if (state->preview_request && !state->preview.file) {
+        if (!wav_open(&state->preview, DENOISE_PREVIEW_PATH, SAMPLE_RATE, 1)) {
+            fprintf(stderr, "Failed to open %s for writing.\n", DENOISE_PREVIEW_PATH);
+            state->preview_request = false;
+        }
+    } else if (!state->preview_request && state->preview.file) {
+        wav_close(&state->preview);
+    }
+
+    bool active = state->preview.file || (state->passthrough && state->playback_stream);
+    if (!active) {
+        state->resynth_active = false;
+        return;
+    }
+    if (!state->resynth_active) {
+        ola_reset(&state->resynth);
+        state->resynth_active = true;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    const float* samples = ola_process(&state->resynth, state->fft_output);
+    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    float eq_cost = 0;
+    if (state->eq_mode == EQ_APPLY) {
+        static float filtered[HOP_SIZE];
+        static EqChain chain;
+        bool changed = false;
+        SDL_LockMutex(state->fft_mutex);
+        if (state->eq_chain.version != state->eq_cascade.version) {
+            chain = state->eq_chain;
+            changed = true;
+        }
+        SDL_UnlockMutex(state->fft_mutex);
+
+        Uint64 eq_start = SDL_GetPerformanceCounter();
+        if (changed) {
+            eq_cascade_set(&state->eq_cascade, &chain, SAMPLE_RATE);
+        }
+        memcpy(filtered, samples, sizeof(float) * HOP_SIZE);
+        eq_cascade_process(&state->eq_cascade, filtered, HOP_SIZE);
+        eq_cost = elapsed_ms(eq_start, SDL_GetPerformanceCounter());
+        samples = filtered;
+    }
+
+    if (state->preview.file) {
+        wav_write(&state->preview, samples, HOP_SIZE);
+    }
+
+    float queue_ms = 0;
+    if (state->passthrough && state->playback_stream) {
+        SDL_LockMutex(state->output_mutex);
+        for (int i = 0; i < HOP_SIZE; i++) {
+            state->output_buffer[(state->output_written + i) % RING_SIZE] = samples[i];
+        }
+        state->output_written += HOP_SIZE;
+        int period = (state->playback_device_frames > 0) ? state->playback_device_frames : OUTPUT_DEFAULT_PERIOD;
+        Uint64 bound = (Uint64)(HOP_SIZE + period);
+        if (state->output_written - state->output_read > bound) {
+            state->output_read = state->output_written - bound;
+        }
+        Uint64 queued = state->output_written - state->output_read;
+        SDL_UnlockMutex(state->output_mutex);
+
+        int sdl_queued = SDL_GetAudioStreamQueued(state->playback_stream);
+        queued += (sdl_queued > 0) ? sdl_queued / (sizeof(float) * OUTPUT_CHANNELS) : 0;
+        queue_ms = queued * 1000.0f / SAMPLE_RATE;
+    }
+
+    SDL_LockMutex(state->fft_mutex);
+    state->resynth_cost_ms += 0.1f * (cost - state->resynth_cost_ms);
+    state->eq_cost_ms += 0.1f * (eq_cost - state->eq_cost_ms);
+    state->output_queue_ms += 0.1f * (queue_ms - state->output_queue_ms);
+    SDL_UnlockMutex(state->fft_mutex);
+}
+
+/*
+    process_audio: Waits for a full hop of new samples, constructs the FFT
+    window ending exactly there from the ring buffer, applies a Hann window
+    to the signal, and executes the FFT. Returns false if no hop was ready.
+*/
+bool process_audio(AppState* state) {
     SDL_LockMutex(state->audio_mutex);
-    int idx = state->audio_buffer_index;
+    Uint64 written = state->audio_samples_written;
+    if (written - state->samples_processed < HOP_SIZE) {
+        SDL_UnlockMutex(state->audio_mutex);
+        return false;
+    }
+    // If the thread fell behind the ring, skip ahead rather than read overwritten samples.
+    if (written - state->samples_processed > RING_SIZE - FFT_SIZE) {
+        state->samples_processed = written - HOP_SIZE;
+    }
+    Uint64 end = state->samples_processed + HOP_SIZE;
+
+    // Keep the samples that are new in this hop for time-domain stages.
+    int hop_idx = (int)((end + RING_SIZE - HOP_SIZE) % RING_SIZE);
+    for (int i = 0; i < HOP_SIZE; i++) {
+        state->hop_samples[i] = state->audio_buffer[(hop_idx + i) % RING_SIZE];
+    }
+    state->hop_sample_count = HOP_SIZE;
+
+    // Silence check on the raw hop, before any FFT work. Sinks that need a
+    // continuous signal and the level-integrating views keep the pipeline running;
+    // in the PSD view every quiet hop has to reach the long-term average.
+    bool silent = vad_update(&state->vad, state->hop_samples, HOP_SIZE);
+    bool throttle = silent && state->vad_enabled && !state->passthrough && !state->preview_request &&
+                    !state->denoise_capture_request && state->denoise.capture_target == 0 &&
+                    state->view_mode != VIEW_RTA && state->view_mode != VIEW_TRANSFER &&
+                    state->view_mode != VIEW_PSD;
+    if (throttle) {
+        SDL_UnlockMutex(state->audio_mutex);
+        state->samples_processed = end;
+        if (!state->vad_silent) {
+            SDL_LockMutex(state->fft_mutex);
+            state->vad_silent = true;
+            SDL_UnlockMutex(state->fft_mutex);
+        }
+        return true;
+    }
+
+    // Build a contiguous FFT input window from the circular ring buffer.
+    int idx = (int)((end + RING_SIZE - FFT_SIZE) % RING_SIZE);
+#ifdef AV_LOW_POWER
+    for (int i = 0; i < FFT_SIZE; i++) {
+        state->pcm_window[i] = state->pcm_buffer[(idx + i) % RING_SIZE];
+    }
+#else
     for (int i = 0; i < FFT_SIZE; i++) {
-        state->fft_input[i] = state->audio_buffer[(idx + i) % FFT_SIZE];
+        state->fft_input[i] = state->audio_buffer[(idx + i) % RING_SIZE];
+    }
+#endif
+    bool transfer_active = (state->view_mode == VIEW_TRANSFER);
+    if (transfer_active) {
+        float* reference = transfer_input(&state->transfer, 0);
+        float* measurement = transfer_input(&state->transfer, 1);
+        for (int i = 0; i < FFT_SIZE; i++) {
+            reference[i] = state->channel_buffer[0][(idx + i) % RING_SIZE];
+            measurement[i] = state->channel_buffer[1][(idx + i) % RING_SIZE];
+        }
     }
     SDL_UnlockMutex(state->audio_mutex);
-    
+    state->samples_processed = end;
+
+    // Sound is back: wake the main loop from its idle wait right away.
+    // Only this thread writes vad_silent, so it can be read here unlocked.
+    if (state->vad_silent) {
+        SDL_LockMutex(state->fft_mutex);
+        state->vad_silent = false;
+        SDL_UnlockMutex(state->fft_mutex);
+        SDL_Event wake = { .type = state->wake_event };
+        SDL_PushEvent(&wake);
+    }
+
+#ifdef AV_LOW_POWER
+    // Fixed-point transform straight from the int16 samples. The float
+    // spectrum is still filled in for the optional stages downstream.
+    Uint64 fft_start = SDL_GetPerformanceCounter();
+    fixfft_process(&state->fixfft, state->pcm_window);
+    float fft_cost = elapsed_ms(fft_start, SDL_GetPerformanceCounter());
+
+    const float scale = ldexpf(1.0f, state->fixfft.exponent - 15);
+    SDL_LockMutex(state->fft_mutex);
+    for (int i = 0; i < BINS; i++) {
+        state->fft_output[i][0] = state->fixfft.re[i] * scale;
+        state->fft_output[i][1] = state->fixfft.im[i] * scale;
+    }
+    memcpy(state->level_db_q8, state->fixfft.level_db, sizeof(int16_t) * BINS);
+    state->fft_cost_ms += 0.1f * (fft_cost - state->fft_cost_ms);
+    state->hops_analysed++;
+    SDL_UnlockMutex(state->fft_mutex);
+#else
+    Uint64 fft_start = SDL_GetPerformanceCounter();
     // Apply a Hann window to smooth the edges and reduce leakage.
     for (int i = 0; i < FFT_SIZE; i++) {
         float hann = 0.5f * (1 - cosf(2 * M_PI * i / (FFT_SIZE - 1)));
         state->fft_input[i] *= hann;
     }
     
-    // Create the FFTW plan on the first call.
-    if (g_fft_plan == NULL) {
-        g_fft_plan = fftwf_plan_dft_r2c_1d(FFT_SIZE, state->fft_input,
-                                             state->fft_output, FFTW_MEASURE);
-    }
-    
-    // Execute the FFT, and protect the FFT output with a mutex.
+    // Execute the FFT, and protect the FFT output with a mutex. The plan was
+    // made by warm_up_plans before this thread started.
     SDL_LockMutex(state->fft_mutex);
     fftwf_execute(g_fft_plan);
+    float fft_cost = elapsed_ms(fft_start, SDL_GetPerformanceCounter());
+    state->fft_cost_ms += 0.1f * (fft_cost - state->fft_cost_ms);
+    state->hops_analysed++;
+    SDL_UnlockMutex(state->fft_mutex);
+#endif
+
+    process_denoise(state);
+    process_resynthesis(state);
+
+    // Only this thread writes fft_output, so it can be read here unlocked.
+    for (int i = 0; i < BINS; i++) {
+        float real = state->fft_output[i][0];
+        float imag = state->fft_output[i][1];
+        state->power[i] = real * real + imag * imag;
+        state->magnitude[i] = sqrtf(state->power[i]);
+    }
+
+    // Scalar descriptors are cheap enough to extract on every hop.
+    SpectralFeatures features;
+    Uint64 descriptor_start = SDL_GetPerformanceCounter();
+    descriptors_compute(&state->descriptors, state->power, &features);
+    float descriptor_cost = elapsed_ms(descriptor_start, SDL_GetPerformanceCounter());
+    features.timestamp_ns = SDL_GetTicksNS();
+    vad_set_flatness(&state->vad, features.flatness);
+
+    SDL_LockMutex(state->fft_mutex);
+    state->feature_history[state->feature_head] = features;
+    state->feature_head = (state->feature_head + 1) % FEATURE_HISTORY;
+    if (state->feature_count < FEATURE_HISTORY) {
+        state->feature_count++;
+    }
+    state->descriptor_cost_ms += 0.1f * (descriptor_cost - state->descriptor_cost_ms);
     SDL_UnlockMutex(state->fft_mutex);
+
+    if (state->view_mode == VIEW_HPSS) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        hpss_process(&state->hpss, state->magnitude);
+        float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+        SDL_LockMutex(state->fft_mutex);
+        memcpy(state->hpss_harmonic, state->hpss.harmonic, sizeof(float) * BINS);
+        memcpy(state->hpss_percussive, state->hpss.percussive, sizeof(float) * BINS);
+        state->hpss_cost_ms += 0.1f * (cost - state->hpss_cost_ms);
+        SDL_UnlockMutex(state->fft_mutex);
+    }
+
+    process_psd(state);
+    process_history(state);
+    if (state->howl_enabled) {
+        process_howl(state);
+    }
+    if (state->view_mode == VIEW_RTA) {
+        process_rta(state);
+    }
+    if (transfer_active) {
+        process_transfer(state);
+    }
+
+    EnvelopeMethod envelope_method = state->envelope_method;
+    if (envelope_method != ENVELOPE_OFF && state->view_mode == VIEW_SPECTRUM) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        envelope_process(&state->envelope, envelope_method, state->magnitude);
+        float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+        SDL_LockMutex(state->fft_mutex);
+        memcpy(state->envelope_curve, state->envelope.envelope, sizeof(float) * BINS);
+        state->envelope_cost_ms += 0.1f * (cost - state->envelope_cost_ms);
+        SDL_UnlockMutex(state->fft_mutex);
+    }
+    return true;
 }
 
 /*
@@ -214,19 +1109,812 @@ void render_spectrum(SDL_Renderer* renderer, fftwf_complex* fft_data) {
         };
         SDL_RenderFillRect(renderer, &bar);
     }
-    
-    SDL_RenderPresent(renderer);
 }
 
+#ifdef AV_LOW_POWER
 /*
-    audio_processing_thread: Performs continuous FFT processing in a separate thread.
-    This offloads computation from the main rendering loop.
+    render_spectrum_levels: Same bars as render_spectrum, drawn from the
+    fixed-point path's Q8 dB levels.
 */
-int audio_processing_thread(void* data) {
+void render_spectrum_levels(SDL_Renderer* renderer, const int16_t* level_db_q8) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+
+    const float bin_width = (float)win_w / BINS;
+    const float max_bar_height = win_h * 0.8f;
+
+    for (int i = 0; i < BINS; i++) {
+        float db = level_db_q8[i] / 256.0f;
+        float bar_height = fmaxf(0, (db + 80) / 80 * max_bar_height);
+
+        float hue = ((float)i / BINS) * 360;
+        Uint8 r, g, b;
+        HSLtoRGB(hue, 100, 50, &r, &g, &b);
+
+        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+        SDL_Rect bar = {
+            .x = (int)(i * bin_width),
+            .y = win_h - (int)bar_height,
+            .w = (int)(bin_width - 2),
+            .h = (int)bar_height
+        };
+        SDL_RenderFillRect(renderer, &bar);
+    }
+}
+#endif
+
+/*
+    render_magnitude_bars: Draws a magnitude spectrum as rainbow bars whose
+    baseline sits at the bottom of the given band of the window.
+*/
+void render_magnitude_bars(SDL_Renderer* renderer, const float* magnitude,
+                           int win_w, int band_top, int band_height) {
+    const float bin_width = (float)win_w / BINS;
+    const float max_bar_height = band_height * 0.8f;
+    const int baseline = band_top + band_height;
+
+    for (int i = 0; i < BINS; i++) {
+        float db = 10 * log10f(magnitude[i] + 1e-6f);
+        float bar_height = fmaxf(0, (db + 80) / 80 * max_bar_height);
+
+        float hue = ((float)i / BINS) * 360;
+        Uint8 r, g, b;
+        HSLtoRGB(hue, 100, 50, &r, &g, &b);
+
+        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+        SDL_Rect bar = {
+            .x = (int)(i * bin_width),
+            .y = baseline - (int)bar_height,
+            .w = (int)(bin_width - 2),
+            .h = (int)bar_height
+        };
+        SDL_RenderFillRect(renderer, &bar);
+    }
+}
+
+/*
+    render_hpss: Renders the harmonic spectrum in the top half of the window
+    and the percussive spectrum in the bottom half.
+*/
+void render_hpss(SDL_Renderer* renderer, const float* harmonic, const float* percussive) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+
+    render_magnitude_bars(renderer, harmonic, win_w, 0, win_h / 2);
+    render_magnitude_bars(renderer, percussive, win_w, win_h / 2, win_h - win_h / 2);
+}
+
+/*
+    render_envelope: Draws a spectral envelope as a smooth white curve using
+    the same dB scale as the spectrum bars, one vertex per bin centre.
+*/
+void render_envelope(SDL_Renderer* renderer, const float* envelope) {
+    static SDL_FPoint points[BINS];
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+
+    const float bin_width = (float)win_w / BINS;
+    const float max_bar_height = win_h * 0.8f;
+
+    for (int i = 0; i < BINS; i++) {
+        float db = 10 * log10f(envelope[i] + 1e-6f);
+        float height = fmaxf(0, (db + 80) / 80 * max_bar_height);
+        points[i].x = (i + 0.5f) * bin_width;
+        points[i].y = win_h - height;
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderLines(renderer, points, BINS);
+}
+
+/*
+    feature_value: Maps one descriptor to [0, 1] for its strip chart.
+*/
+static float feature_value(const SpectralFeatures* f, int chart, float flux_scale) {
+    const float nyquist = SAMPLE_RATE / 2.0f;
+    switch (chart) {
+    case 0: return f->centroid / nyquist;
+    case 1: return f->spread / nyquist;
+    case 2: return f->rolloff / nyquist;
+    case 3: return f->flatness;
+    case 4: return log10f(fmaxf(f->crest, 1.0f)) / log10f((float)BINS);
+    default: return f->flux / flux_scale;
+    }
+}
+
+/*
+    render_features: Draws one strip chart per spectral descriptor, oldest
+    frame on the left, with the latest value printed in each lane.
+*/
+void render_features(SDL_Renderer* renderer, const SpectralFeatures* history, int count) {
+    static const char* names[] = { "centroid", "spread", "rolloff", "flatness", "crest", "flux" };
+    static SDL_FPoint points[FEATURE_HISTORY];
+    const int charts = sizeof(names) / sizeof(names[0]);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    if (count == 0) {
+        return;
+    }
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float lane_h = (float)win_h / charts;
+    const float step = (float)win_w / (FEATURE_HISTORY - 1);
+
+    // Flux has no natural range, so scale it to the loudest frame on screen.
+    float flux_scale = 1e-6f;
+    for (int i = 0; i < count; i++) {
+        flux_scale = fmaxf(flux_scale, history[i].flux);
+    }
+
+    for (int chart = 0; chart < charts; chart++) {
+        const float top = chart * lane_h;
+        for (int i = 0; i < count; i++) {
+            float v = fminf(fmaxf(feature_value(&history[i], chart, flux_scale), 0.0f), 1.0f);
+            points[i].x = (FEATURE_HISTORY - count + i) * step;
+            points[i].y = top + (1.0f - v) * (lane_h - 4) + 2;
+        }
+
+        Uint8 r, g, b;
+        HSLtoRGB(chart * 360.0f / charts, 100, 50, &r, &g, &b);
+        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+        SDL_RenderLines(renderer, points, count);
+
+        const SpectralFeatures* latest = &history[count - 1];
+        float values[] = { latest->centroid, latest->spread, latest->rolloff,
+                           latest->flatness, latest->crest, latest->flux };
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderDebugTextFormat(renderer, 4, top + 4, "%s %.3f", names[chart], values[chart]);
+
+        SDL_SetRenderDrawColor(renderer, 60, 60, 60, 255);
+        SDL_RenderLine(renderer, 0, top + lane_h - 1, (float)win_w, top + lane_h - 1);
+    }
+}
+
+/*
+    render_rta: Draws one bar per fractional-octave band with its fast level,
+    a white tick at the band's Leq, and a centre-frequency label per octave.
+*/
+void render_rta(SDL_Renderer* renderer, const RtaSnapshot* snap) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    if (snap->band_count == 0) {
+        return;
+    }
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float band_w = (float)win_w / snap->band_count;
+    const float plot_h = win_h - 40.0f;
+    const float range_db = 100.0f;
+
+    for (int b = 0; b < snap->band_count; b++) {
+        float level = fminf(fmaxf((snap->level_db[b] + range_db) / range_db, 0.0f), 1.0f);
+        float leq = fminf(fmaxf((snap->leq_db[b] + range_db) / range_db, 0.0f), 1.0f);
+
+        Uint8 r, g, b8;
+        HSLtoRGB(((float)b / snap->band_count) * 360, 100, 50, &r, &g, &b8);
+        SDL_SetRenderDrawColor(renderer, r, g, b8, 255);
+        SDL_FRect bar = { b * band_w + 1, 20 + plot_h * (1 - level), band_w - 2, plot_h * level };
+        SDL_RenderFillRect(renderer, &bar);
+
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        float y = 20 + plot_h * (1 - leq);
+        SDL_RenderLine(renderer, b * band_w + 1, y, (b + 1) * band_w - 1, y);
+
+        if (b % snap->fraction == 0) {
+            float hz = snap->center_hz[b];
+            SDL_RenderDebugTextFormat(renderer, b * band_w + 1, win_h - 14.0f,
+                                      hz < 1000 ? "%.0f" : "%.0fk", hz < 1000 ? hz : hz / 1000);
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugTextFormat(renderer, 4, 4, "1/%d octave, %s, Leq over %.0f s (B: bands, I: path, R: reset)",
+                              snap->fraction, snap->filterbank ? "IIR filterbank" : "FFT binned",
+                              snap->leq_seconds);
+}
+
+/*
+    render_trace: Draws one value per bin as a polyline inside a horizontal
+    band of the window, mapping [lo, hi] to the band's bottom and top.
+*/
+void render_trace(SDL_Renderer* renderer, const float* values, float lo, float hi,
+                  int win_w, float band_top, float band_height) {
+    static SDL_FPoint points[BINS];
+    const float bin_width = (float)win_w / BINS;
+    for (int i = 0; i < BINS; i++) {
+        float v = fminf(fmaxf((values[i] - lo) / (hi - lo), 0.0f), 1.0f);
+        points[i].x = (i + 0.5f) * bin_width;
+        points[i].y = band_top + (1.0f - v) * band_height;
+    }
+    SDL_RenderLines(renderer, points, BINS);
+}
+
+/*
+    render_transfer: Stacks transfer magnitude (+-40 dB), phase (+-180 deg)
+    and coherence (0..1) plots, each with a grey zero/unity reference line.
+*/
+void render_transfer(SDL_Renderer* renderer, const float* magnitude_db, const float* phase_deg,
+                     const float* coherence, int filled, int depth) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float lane_h = win_h / 3.0f;
+
+    SDL_SetRenderDrawColor(renderer, 60, 60, 60, 255);
+    SDL_RenderLine(renderer, 0, lane_h * 0.5f, (float)win_w, lane_h * 0.5f);
+    SDL_RenderLine(renderer, 0, lane_h * 1.5f, (float)win_w, lane_h * 1.5f);
+    SDL_RenderLine(renderer, 0, lane_h * 2.0f, (float)win_w, lane_h * 2.0f);
+
+    SDL_SetRenderDrawColor(renderer, 255, 80, 80, 255);
+    render_trace(renderer, magnitude_db, -40.0f, 40.0f, win_w, 0, lane_h);
+    SDL_SetRenderDrawColor(renderer, 80, 255, 80, 255);
+    render_trace(renderer, phase_deg, -180.0f, 180.0f, win_w, lane_h, lane_h);
+    SDL_SetRenderDrawColor(renderer, 80, 160, 255, 255);
+    render_trace(renderer, coherence, 0.0f, 1.0f, win_w, 2 * lane_h, lane_h);
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugTextFormat(renderer, 4, 4, "|H| dB  (average %d/%d frames, +/- to change)", filled, depth);
+    SDL_RenderDebugText(renderer, 4, lane_h + 4, "phase deg");
+    SDL_RenderDebugText(renderer, 4, 2 * lane_h + 4, "coherence");
+}
+
+/*
+    render_psd: Draws the long-term PSD between -160 and -40 dB re FS^2/Hz,
+    with grid lines every 20 dB and the survey length and averaging mode.
+*/
+void render_psd(SDL_Renderer* renderer, const float* psd_db, double seconds, PsdAveraging averaging) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+
+    SDL_SetRenderDrawColor(renderer, 60, 60, 60, 255);
+    for (int db = -140; db < -40; db += 20) {
+        float y = win_h * (float)(-40 - db) / 120.0f;
+        SDL_RenderLine(renderer, 0, y, (float)win_w, y);
+        SDL_RenderDebugTextFormat(renderer, 4, y + 2, "%d", db);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 200, 80, 255);
+    render_trace(renderer, psd_db, -160.0f, -40.0f, win_w, 0, (float)win_h);
+
+    int total = (int)seconds;
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugTextFormat(renderer, 4, 4, "PSD dB re FS^2/Hz, %s average over %d:%02d:%02d (L: mode, R: reset)",
+                              averaging == PSD_LINEAR ? "linear" : "exponential",
+                              total / 3600, (total / 60) % 60, total % 60);
+}
+
+/*
+    render_eq: Overlays the EQ magnitude response, centred on 0 dB at half
+    height, with a marker per band and a label for the selected one.
+*/
+void render_eq(SDL_Renderer* renderer, const float* response_db, const EqChain* chain,
+               int selected, EqMode mode) {
+    static const char* type_names[] = { "Peak", "Low shelf", "High shelf", "High-pass", "Low-pass" };
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float bin_width = (float)win_w / BINS;
+    const float bin_hz = (float)SAMPLE_RATE / FFT_SIZE;
+
+    SDL_SetRenderDrawColor(renderer, 80, 80, 80, 255);
+    SDL_RenderLine(renderer, 0, win_h * 0.5f, (float)win_w, win_h * 0.5f);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+    render_trace(renderer, response_db, -EQ_DISPLAY_RANGE_DB, EQ_DISPLAY_RANGE_DB, win_w, 0, (float)win_h);
+
+    for (int i = 0; i < chain->count; i++) {
+        const EqBand* band = &chain->bands[i];
+        float gain = (band->type == EQ_HIGHPASS || band->type == EQ_LOWPASS) ? 0.0f : band->gain_db;
+        float v = fminf(fmaxf(gain / EQ_DISPLAY_RANGE_DB, -1.0f), 1.0f);
+        SDL_FRect marker = {
+            .x = (band->freq_hz / bin_hz + 0.5f) * bin_width - 4,
+            .y = (0.5f - 0.5f * v) * win_h - 4,
+            .w = 8,
+            .h = 8
+        };
+        if (i == selected) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_RenderFillRect(renderer, &marker);
+        } else {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+            SDL_RenderRect(renderer, &marker);
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    if (selected < chain->count) {
+        const EqBand* band = &chain->bands[selected];
+        SDL_RenderDebugTextFormat(renderer, 4, 4,
+                                  "EQ %s: band %d/%d %s %.0f Hz %+.1f dB Q %.2f (Tab, arrows, PgUp/PgDn)",
+                                  mode == EQ_APPLY ? "on pass-through" : "preview",
+                                  selected + 1, chain->count, type_names[band->type],
+                                  band->freq_hz, band->gain_db, band->q);
+    }
+}
+
+/*
+    render_spectrogram: Uploads history rows that arrived since the last
+    frame as texture columns and draws the texture as a ring, newest at the
+    right. Rows are decoded from the packed format as they are uploaded.
+*/
+void render_spectrogram(AppState* state) {
+    static Uint32 palette[256];
+    static Uint32 column[BINS];
+    static float row[BINS];
+    SDL_Renderer* renderer = state->renderer;
+
+    if (!state->spectrogram_texture) {
+        for (int i = 0; i < 256; i++) {
+            float t = i / 255.0f;
+            Uint8 r, g, b;
+            HSLtoRGB(240.0f * (1.0f - t), 100, 50.0f * fminf(1.0f, 2.0f * t), &r, &g, &b);
+            palette[i] = ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+        }
+        state->spectrogram_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_XRGB8888,
+                                                       SDL_TEXTUREACCESS_STREAMING,
+                                                       SPECTROGRAM_HISTORY, BINS);
+        if (!state->spectrogram_texture) {
+            return;
+        }
+        SDL_SetTextureScaleMode(state->spectrogram_texture, SDL_SCALEMODE_LINEAR);
+    }
+
+    SDL_LockMutex(state->fft_mutex);
+    const FrameFormat format = state->history_format;
+    const size_t row_bytes = compact_frame_bytes(format, BINS);
+    const Uint64 total = state->history_total;
+    if (state->spectrogram_drawn > total) {
+        state->spectrogram_drawn = 0;  // The history was reallocated.
+    }
+    Uint64 first = state->spectrogram_drawn;
+    if (total - first > SPECTROGRAM_HISTORY) {
+        first = total - SPECTROGRAM_HISTORY;
+    }
+    for (Uint64 t = first; t < total; t++) {
+        int slot = (int)(t % SPECTROGRAM_HISTORY);
+        compact_decode(format, state->history + row_bytes * slot, row, BINS);
+        for (int k = 0; k < BINS; k++) {
+            float v = fminf(fmaxf((row[k] + 80.0f) / 80.0f, 0.0f), 1.0f);
+            column[BINS - 1 - k] = palette[(int)(v * 255.0f)];
+        }
+        SDL_Rect rect = { slot, 0, 1, BINS };
+        SDL_UpdateTexture(state->spectrogram_texture, &rect, column, sizeof(Uint32));
+    }
+    state->spectrogram_drawn = total;
+    SDL_UnlockMutex(state->fft_mutex);
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float column_width = (float)win_w / SPECTROGRAM_HISTORY;
+
+    // Oldest rows first: the tail of the ring, then its head.
+    int count = (int)(total < SPECTROGRAM_HISTORY ? total : SPECTROGRAM_HISTORY);
+    int oldest = (int)(total < SPECTROGRAM_HISTORY ? 0 : total % SPECTROGRAM_HISTORY);
+    int tail = (oldest + count > SPECTROGRAM_HISTORY) ? SPECTROGRAM_HISTORY - oldest : count;
+    float x = (SPECTROGRAM_HISTORY - count) * column_width;
+    SDL_FRect src = { (float)oldest, 0, (float)tail, (float)BINS };
+    SDL_FRect dst = { x, 0, tail * column_width, (float)win_h };
+    if (tail > 0) {
+        SDL_RenderTexture(renderer, state->spectrogram_texture, &src, &dst);
+    }
+    if (tail < count) {
+        src = (SDL_FRect){ 0, 0, (float)(count - tail), (float)BINS };
+        dst = (SDL_FRect){ x + tail * column_width, 0, (count - tail) * column_width, (float)win_h };
+        SDL_RenderTexture(renderer, state->spectrogram_texture, &src, &dst);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugTextFormat(renderer, 4, 4, "Spectrogram history: %s, %.0f KiB (float32 %.0f KiB) (K: format)",
+                              compact_format_name(format),
+                              row_bytes * SPECTROGRAM_HISTORY / 1024.0,
+                              compact_frame_bytes(FRAME_FLOAT32, BINS) * SPECTROGRAM_HISTORY / 1024.0);
+}
+
+/*
+    render_plugins: Clears the window and lets the render plugins draw the
+    latest row over it.
+*/
+void render_plugins(AppState* state) {
+    static float column[BINS];
+    SDL_LockMutex(state->fft_mutex);
+    memcpy(column, state->plugin_column, sizeof(float) * BINS);
+    const Uint64 index = state->plugin_column_index;
+    SDL_UnlockMutex(state->fft_mutex);
+
+    SDL_Renderer* renderer = state->renderer;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const AvRenderFrame frame = {
+        .struct_size = sizeof(AvRenderFrame),
+        .column_index = index,
+        .column_db = column,
+        .bins = BINS,
+        .width = win_w,
+        .height = win_h,
+        .time_seconds = (double)index * HOP_SIZE / SAMPLE_RATE,
+    };
+    float cost = plugin_host_render(&state->plugins, renderer, &frame);
+    state->plugin_render_ms += 0.1f * (cost - state->plugin_render_ms);
+    if (!plugin_host_wants(&state->plugins, AV_PLUGIN_RENDER)) {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderDebugText(renderer, 4, 4, "No render plugin is active (X: back to the spectrum)");
+    }
+}
+
+/*
+    load_preset: Compiles the preset at path, replacing the current one
+    only if it compiles, so a broken edit leaves the last good preset on
+    screen.
+*/
+bool load_preset(AppState* state, const char* path, int columns) {
+    Preset preset;
+    if (!preset_load(&preset, path, columns, BINS, (float)SAMPLE_RATE / FFT_SIZE)) {
+        return false;
+    }
+    if (state->preset_ready) {
+        preset_free(&state->preset);
+    }
+    state->preset = preset;
+    state->preset_ready = true;
+    state->preset_start = SDL_GetPerformanceCounter();
+    const PresetProgram* program = preset.program;
+    printf("Preset %s: %d columns, %d statements, %d frame ops, %d column ops\n", state->preset.path, preset.columns,
+           program->statement_count, program->frame_length, program->column_length);
+    return true;
+}
+
+/*
+    render_preset: Evaluates the preset over the latest spectrum and draws
+    its columns as one batch of coloured quads.
+*/
+void render_preset(AppState* state) {
+    static fftwf_complex fft_snapshot[BINS];
+    static float row[BINS];
+    static SDL_Vertex vertices[PRESET_MAX_COLUMNS * 4];
+    static int indices[PRESET_MAX_COLUMNS * 6];
+    SDL_LockMutex(state->fft_mutex);
+    memcpy(fft_snapshot, state->fft_output, sizeof(fftwf_complex) * BINS);
+    SDL_UnlockMutex(state->fft_mutex);
+    for (int k = 0; k < BINS; k++) {
+        float magnitude = sqrtf(fft_snapshot[k][0] * fft_snapshot[k][0] + fft_snapshot[k][1] * fft_snapshot[k][1]);
+        row[k] = 10 * log10f(magnitude + 1e-6f);
+    }
+
+    Preset* preset = &state->preset;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    preset_evaluate(preset, row, (double)(now - state->preset_start) / SDL_GetPerformanceFrequency());
+    float cost = elapsed_ms(now, SDL_GetPerformanceCounter());
+    state->preset_cost_ms += 0.1f * (cost - state->preset_cost_ms);
+
+    SDL_Renderer* renderer = state->renderer;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float* x = preset_output(preset, PRESET_X);
+    const float* y = preset_output(preset, PRESET_Y);
+    const float* width = preset_output(preset, PRESET_WIDTH);
+    const float* height = preset_output(preset, PRESET_HEIGHT);
+    const float* hue = preset_output(preset, PRESET_HUE);
+    const float* sat = preset_output(preset, PRESET_SAT);
+    const float* light = preset_output(preset, PRESET_LIGHT);
+    int count = 0;
+    for (int c = 0; c < preset->columns; c++) {
+        const float left = x[c] * win_w;
+        const float right = (x[c] + width[c]) * win_w;
+        const float bottom = win_h - y[c] * win_h;
+        const float top = win_h - (y[c] + height[c]) * win_h;
+        if (!isfinite(left + right + bottom + top) || height[c] == 0.0f) {
+            continue;
+        }
+        float h = fmodf(hue[c], 360.0f);
+        h = isfinite(h) ? (h < 0.0f ? h + 360.0f : h) : 0.0f;
+        Uint8 r, g, b;
+        HSLtoRGB(h, 100 * SDL_clamp(sat[c], 0.0f, 1.0f), 100 * SDL_clamp(light[c], 0.0f, 1.0f), &r, &g, &b);
+        const SDL_FColor color = { r / 255.0f, g / 255.0f, b / 255.0f, 1.0f };
+        SDL_Vertex* v = &vertices[count * 4];
+        v[0] = (SDL_Vertex){ { left, top }, color, { 0, 0 } };
+        v[1] = (SDL_Vertex){ { right, top }, color, { 0, 0 } };
+        v[2] = (SDL_Vertex){ { right, bottom }, color, { 0, 0 } };
+        v[3] = (SDL_Vertex){ { left, bottom }, color, { 0, 0 } };
+        static const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) {
+            indices[count * 6 + i] = count * 4 + quad[i];
+        }
+        count++;
+    }
+    if (count > 0) {
+        SDL_RenderGeometry(renderer, NULL, vertices, count * 4, indices, count * 6);
+    }
+}
+
+/*
+    update_window_title: Reports the per-hop cost of the active analysis
+    stages in the window title.
+*/
+void update_window_title(AppState* state) {
+    char title[512];
+    int len = snprintf(title, sizeof(title), "Audio Visualizer");
+
+    SDL_LockMutex(state->fft_mutex);
+    // Busy time of both threads, to compare active and throttled operation.
+    len += snprintf(title + len, sizeof(title) - len, " - %sload: processing %.1f%%, render %.1f%%",
+                    state->vad_silent ? "Silent, " : "", state->process_load, state->render_load);
+#ifdef AV_LOW_POWER
+    len += snprintf(title + len, sizeof(title) - len, " - Q15 FFT %.3f ms/hop", state->fft_cost_ms);
+#else
+    len += snprintf(title + len, sizeof(title) - len, " - FFT %.3f ms/hop", state->fft_cost_ms);
+#endif
+    if (state->view_mode == VIEW_HPSS) {
+        len += snprintf(title + len, sizeof(title) - len, " - HPSS %.3f ms/hop",
+                        state->hpss_cost_ms);
+    } else if (state->view_mode == VIEW_FEATURES) {
+        len += snprintf(title + len, sizeof(title) - len, " - Descriptors %.3f ms/hop",
+                        state->descriptor_cost_ms);
+    } else if (state->view_mode == VIEW_RTA) {
+        len += snprintf(title + len, sizeof(title) - len,
+                        " - RTA FFT-binned %.3f ms/hop, filterbank %.3f ms/hop",
+                        state->rta_fft_cost_ms, state->rta_filter_cost_ms);
+    } else if (state->view_mode == VIEW_TRANSFER) {
+        len += snprintf(title + len, sizeof(title) - len, " - Transfer function %.3f ms/hop",
+                        state->transfer_cost_ms);
+    } else if (state->view_mode == VIEW_PSD) {
+        len += snprintf(title + len, sizeof(title) - len, " - PSD %.3f ms/hop",
+                        state->psd_cost_ms);
+    } else if (state->view_mode == VIEW_BROWSER) {
+        float load_ms;
+        unsigned long long tiles;
+        browser_stats(&state->browser, &load_ms, &tiles);
+        len += snprintf(title + len, sizeof(title) - len, " - Browser tile %.2f ms, %llu loaded",
+                        load_ms, tiles);
+    } else if (state->view_mode == VIEW_PRESET) {
+        len += snprintf(title + len, sizeof(title) - len, " - Preset %d columns, %d ops, %.3f ms/frame",
+                        state->preset.columns, state->preset.program->frame_length +
+                        state->preset.program->column_length, state->preset_cost_ms);
+    } else if (state->view_mode == VIEW_PLUGIN) {
+        len += snprintf(title + len, sizeof(title) - len, " - Plugin render %.3f ms/frame",
+                        state->plugin_render_ms);
+    } else if (state->view_mode == VIEW_SPECTROGRAM) {
+        len += snprintf(title + len, sizeof(title) - len, " - History %s %.3f ms/hop",
+                        compact_format_name(state->history_format), state->history_cost_ms);
+    } else if (state->envelope_method == ENVELOPE_CEPSTRUM) {
+        len += snprintf(title + len, sizeof(title) - len, " - Cepstral envelope %.3f ms/hop",
+                        state->envelope_cost_ms);
+    } else if (state->envelope_method == ENVELOPE_LPC) {
+        len += snprintf(title + len, sizeof(title) - len, " - LPC envelope %.3f ms/hop",
+                        state->envelope_cost_ms);
+    }
+    if (state->eq_mode != EQ_OFF && state->view_mode == VIEW_SPECTRUM) {
+        len += snprintf(title + len, sizeof(title) - len, " - EQ response %.3f ms/update",
+                        state->eq_response_cost_ms);
+    }
+
+    // The denoise stage sits in front of every view, so report it in all of them.
+    if (state->denoise_capturing) {
+        len += snprintf(title + len, sizeof(title) - len, " - Capturing noise profile...");
+    } else if (state->denoise_mode != DENOISE_OFF) {
+        len += snprintf(title + len, sizeof(title) - len, " - %s %.3f ms/hop",
+                        state->denoise_mode == DENOISE_WIENER ? "Wiener" : "Subtraction",
+                        state->denoise_cost_ms);
+    }
+    if (state->resynth_active) {
+        len += snprintf(title + len, sizeof(title) - len,
+                        " - Resynthesis %.3f ms/hop, +%.1f ms latency",
+                        state->resynth_cost_ms,
+                        ola_latency_samples(&state->resynth) * 1000.0f / SAMPLE_RATE);
+        if (state->eq_mode == EQ_APPLY) {
+            len += snprintf(title + len, sizeof(title) - len, ", EQ %.3f ms/hop",
+                            state->eq_cost_ms);
+        }
+        if (state->passthrough) {
+            len += snprintf(title + len, sizeof(title) - len,
+                            ", queue %.1f ms, device %.1f ms, %llu underruns",
+                            state->output_queue_ms,
+                            state->playback_device_frames * 1000.0f / SAMPLE_RATE,
+                            (unsigned long long)state->output_underruns);
+        }
+    }
+    if (state->fp_matcher) {
+        const FingerprintMatch* m = &state->fp_result;
+        if (m->track >= 0) {
+            const char* name = fingerprint_index_name(&state->fp_index, m->track);
+            for (const char* p = name; *p; p++) {
+                name = (*p == '/' || *p == '\\') ? p + 1 : name;
+            }
+            len += snprintf(title + len, sizeof(title) - len, " - Playing %.40s at %.1f s (%d votes)", name,
+                            ((double)m->end_frame + m->offset_frames) * HOP_SIZE / SAMPLE_RATE, m->votes);
+        } else {
+            len += snprintf(title + len, sizeof(title) - len, " - Not identified");
+        }
+        len += snprintf(title + len, sizeof(title) - len, ", fingerprint %.3f ms/hop, %.1fM lookups/s",
+                        state->fp_cost_ms, state->fp_lookup_rate / 1e6);
+    }
+    if (state->howl_enabled) {
+        if (state->howling) {
+            len += snprintf(title + len, sizeof(title) - len, " - FEEDBACK %.1f Hz (%+.0f dB/s)",
+                            state->howl_loudest.frequency_hz, state->howl_loudest.slope_db_per_s);
+        } else {
+            len += snprintf(title + len, sizeof(title) - len, " - No feedback");
+        }
+        len += snprintf(title + len, sizeof(title) - len, ", howl %.3f ms/hop", state->howl_cost_ms);
+    }
+    if (state->triggers_open) {
+        len += snprintf(title + len, sizeof(title) - len, " - %d rules, %.3f ms/hop, %llu events",
+                        state->triggers.count, state->trigger_cost_ms, state->trigger_events);
+    }
+    if (state->plugins.count) {
+        len += snprintf(title + len, sizeof(title) - len, " - %d plugins, %d analysing, %.3f ms/hop",
+                        state->plugins.count, state->plugin_analysis_active, state->plugin_analysis_ms);
+    }
+    SDL_UnlockMutex(state->fft_mutex);
+
+    SDL_SetWindowTitle(state->window, title);
+}
+
+/*
+    open_audio_devices: Startup thread that opens the recording device and,
+    optionally, the playback device. Both streams stay paused until main
+    resumes them. Returns 0 if the recording device could not be opened.
+    With a file or generator source no recording device is needed.
+*/
+int open_audio_devices(void* data) {
+    AppState* state = (AppState*)data;
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    // Setup the desired audio specification.
+    SDL_AudioSpec desired_spec = {0};
+    desired_spec.freq = SAMPLE_RATE;
+    desired_spec.format = SDL_AUDIO_S16;
+    desired_spec.channels = AUDIO_CHANNELS;
+    
+    // Open the recording device; streams start paused until resumed in main.
+    if (!state->use_source) {
+        state->capture_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_RECORDING,
+                                                          &desired_spec, capture_callback, state);
+        if (!state->capture_stream) {
+            fprintf(stderr, "Audio device open failed: %s\n", SDL_GetError());
+            SDL_SetAtomicInt(&state->devices_ready, 1);
+            return 0;
+        }
+    }
+    
+    // The playback device is optional; without it the pass-through is unavailable.
+    SDL_AudioSpec output_spec = {0};
+    output_spec.freq = SAMPLE_RATE;
+    output_spec.format = SDL_AUDIO_F32;
+    output_spec.channels = OUTPUT_CHANNELS;
+    state->playback_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
+                                                       &output_spec, playback_callback, state);
+    if (!state->playback_stream) {
+        fprintf(stderr, "Playback device open failed, pass-through disabled: %s\n", SDL_GetError());
+    } else {
+        SDL_AudioSpec device_spec;
+        SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(state->playback_stream),
+                                 &device_spec, &state->playback_device_frames);
+    }
+    
+    state->device_open_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+    SDL_SetAtomicInt(&state->devices_ready, 1);
+    return 1;
+}
+
+/*
+    warm_up_plans: Startup thread that creates every FFTW plan. The planner
+    is not thread-safe, so all planning happens here, before the processing
+    thread starts. Wisdom from the previous run is loaded first and saved
+    afterwards, so later starts skip most of the FFTW_MEASURE timing runs.
+*/
+int warm_up_plans(void* data) {
+    AppState* state = (AppState*)data;
+    Uint64 start = SDL_GetPerformanceCounter();
+    int ok = 1;
+
+    fftwf_import_wisdom_from_filename(PLAN_WISDOM_PATH);
+    if (!transfer_init(&state->transfer, FFT_SIZE, TRANSFER_DEFAULT_DEPTH)) {
+        fprintf(stderr, "Failed to set up transfer function measurement.\n");
+        ok = 0;
+    } else if (!ola_init(&state->resynth, FFT_SIZE, HOP_SIZE)) {
+        fprintf(stderr, "Failed to set up overlap-add resynthesis.\n");
+        ok = 0;
+    } else if (!envelope_init(&state->envelope, FFT_SIZE, ENVELOPE_LIFTER, ENVELOPE_LPC_ORDER)) {
+        fprintf(stderr, "Failed to set up spectral envelope.\n");
+        ok = 0;
+    } else if (state->howl_enabled && !howl_init(&state->howl, SAMPLE_RATE, HOWL_FFT_SIZE, HOWL_HOP, true)) {
+        fprintf(stderr, "Failed to set up the feedback detector.\n");
+        ok = 0;
+    }
+#ifndef AV_LOW_POWER
+    if (ok) {
+        g_fft_plan = fftwf_plan_dft_r2c_1d(FFT_SIZE, state->fft_input, state->fft_output, FFTW_MEASURE);
+        if (!g_fft_plan) {
+            fprintf(stderr, "Failed to create the FFT plan.\n");
+            ok = 0;
+        }
+    }
+#endif
+    if (ok) {
+        fftwf_export_wisdom_to_filename(PLAN_WISDOM_PATH);
+    }
+
+    state->plan_warmup_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+    SDL_SetAtomicInt(&state->plans_ready, 1);
+    return ok;
+}
+
+/*
+    write_video_frame: Appends the frame just rendered to the --video file
+    as a binary PPM image. The file is a plain PPM stream that encoders
+    read directly (ffmpeg -f image2pipe -c:v ppm -i FILE).
+*/
+void write_video_frame(AppState* state) {
+    SDL_Surface* frame = SDL_RenderReadPixels(state->renderer, NULL);
+    if (!frame) {
+        return;
+    }
+    SDL_Surface* rgb = SDL_ConvertSurface(frame, SDL_PIXELFORMAT_RGB24);
+    SDL_DestroySurface(frame);
+    if (!rgb) {
+        return;
+    }
+    fprintf(state->video, "P6\n%d %d\n255\n", rgb->w, rgb->h);
+    for (int y = 0; y < rgb->h; y++) {
+        fwrite((const Uint8*)rgb->pixels + (size_t)y * rgb->pitch, 3, rgb->w, state->video);
+    }
+    SDL_DestroySurface(rgb);
+}
+
+/*
+    render_placeholder: Startup screen shown until devices and plans are ready.
+*/
+void render_placeholder(SDL_Renderer* renderer, bool devices_ready, bool plans_ready) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    int win_w, win_h;
+    SDL_GetRendererOutputSize(renderer, &win_w, &win_h);
+    const float x = win_w * 0.5f - 120;
+    const float y = win_h * 0.5f - 16;
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugText(renderer, x, y, "Starting Audio Visualizer...");
+    SDL_RenderDebugTextFormat(renderer, x, y + 16, "Audio devices: %s", devices_ready ? "ready" : "opening");
+    SDL_RenderDebugTextFormat(renderer, x, y + 28, "FFT plans:     %s", plans_ready ? "ready" : "measuring");
+}
+
+/*
+    audio_processing_thread: Performs continuous FFT processing in a separate thread.
+    This offloads computation from the main rendering loop.
+*/
+int audio_processing_thread(void* data) {
     AppState* state = (AppState*)data;
     while (state->running) {
-        process_audio(state);
-        SDL_Delay(FFT_DELAY_MS);
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!process_audio(state)) {
+            SDL_Delay(1);
+            continue;
+        }
+        float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+        SDL_LockMutex(state->fft_mutex);
+        state->process_busy_ms += cost;
+        SDL_UnlockMutex(state->fft_mutex);
     }
     return 0;
 }
@@ -235,6 +1923,29 @@ int audio_processing_thread(void* data) {
     cleanup: Releases all dynamically allocated resources and shuts down SDL.
 */
 void cleanup(AppState* state) {
+    // Let the startup threads finish; they write into the state below.
+    if (state->device_thread) {
+        SDL_WaitThread(state->device_thread, NULL);
+        state->device_thread = NULL;
+    }
+    if (state->plan_thread) {
+        SDL_WaitThread(state->plan_thread, NULL);
+        state->plan_thread = NULL;
+    }
+    if (state->source_thread) {
+        state->running = false;
+        SDL_WaitThread(state->source_thread, NULL);
+        state->source_thread = NULL;
+    }
+    // Close the devices first: their callbacks use the buffers and mutexes below.
+    if (state->capture_stream) {
+        SDL_DestroyAudioStream(state->capture_stream);
+        state->capture_stream = NULL;
+    }
+    if (state->playback_stream) {
+        SDL_DestroyAudioStream(state->playback_stream);
+        state->playback_stream = NULL;
+    }
     if (state->fft_input) {
         free(state->fft_input);
         state->fft_input = NULL;
@@ -251,6 +1962,28 @@ void cleanup(AppState* state) {
         SDL_DestroyMutex(state->audio_mutex);
         state->audio_mutex = NULL;
     }
+    if (state->spectrogram_texture) {
+        SDL_DestroyTexture(state->spectrogram_texture);
+        state->spectrogram_texture = NULL;
+    }
+    fingerprint_free(&state->fp);
+    free(state->fp_matcher);
+    free(state->fp_hashes);
+    state->fp_matcher = NULL;
+    state->fp_hashes = NULL;
+    fingerprint_index_close(&state->fp_index);
+    trigger_close(&state->triggers);
+    state->triggers_open = false;
+    plugin_host_close(&state->plugins);
+    if (state->preset_ready) {
+        preset_free(&state->preset);
+        state->preset_ready = false;
+    }
+    howl_free(&state->howl);
+    if (state->browser_ready) {
+        browser_close(&state->browser);
+        state->browser_ready = false;
+    }
     if (state->renderer) {
         SDL_DestroyRenderer(state->renderer);
         state->renderer = NULL;
@@ -259,41 +1992,159 @@ void cleanup(AppState* state) {
         SDL_DestroyWindow(state->window);
         state->window = NULL;
     }
-    if (state->audio_device) {
-        SDL_CloseAudioDevice(state->audio_device);
-        state->audio_device = 0;
+    if (state->output_mutex) {
+        SDL_DestroyMutex(state->output_mutex);
+        state->output_mutex = NULL;
     }
     if (g_fft_plan) {
         fftwf_destroy_plan(g_fft_plan);
         g_fft_plan = NULL;
     }
+    hpss_free(&state->hpss);
+    descriptors_free(&state->descriptors);
+    octave_free(&state->rta);
+    transfer_free(&state->transfer);
+    psd_free(&state->psd);
+    free(state->history);
+    wav_close(&state->preview);
+    denoise_free(&state->denoise);
+    ola_free(&state->resynth);
+#ifdef AV_LOW_POWER
+    fixfft_free(&state->fixfft);
+#endif
+    eq_response_free(&state->eq_response);
+    envelope_free(&state->envelope);
+    recording_close(&state->recording);
+    shm_close(&state->shared);
+    source_close(&state->source);
+    if (state->video) {
+        fclose(state->video);
+        state->video = NULL;
+    }
     SDL_Quit();
 }
 
+/*
+    view_from_name: Maps a --mode name to the view it selects.
+*/
+static ViewMode view_from_name(const char* name) {
+    static const struct { const char* name; ViewMode view; } views[] = {
+        { "spectrum", VIEW_SPECTRUM }, { "hpss", VIEW_HPSS }, { "features", VIEW_FEATURES },
+        { "rta", VIEW_RTA }, { "transfer", VIEW_TRANSFER }, { "psd", VIEW_PSD },
+        { "spectrogram", VIEW_SPECTROGRAM }
+    };
+    for (size_t i = 0; i < sizeof(views) / sizeof(views[0]); i++) {
+        if (strcmp(name, views[i].name) == 0) {
+            return views[i].view;
+        }
+    }
+    return VIEW_SPECTRUM;
+}
+
 int main(int argc, char* argv[]) {
     AppState state = {0};
+    state.startup_counter = SDL_GetPerformanceCounter();
+    
+    CliOptions options;
+    if (!cli_parse(argc, argv, &options)) {
+        fprintf(stderr, "Run '%s --help' for usage.\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.help) {
+        cli_usage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+    if (options.self_test) {
+        return selftest_run();
+    }
+    if (options.preset_bench) {
+        return preset_bench(&options);
+    }
+    if (options.similar_path) {
+        return similarity_run(&options);
+    }
+    if (options.batch_path) {
+        return batch_run(&options);
+    }
+    if (options.headless || options.benchmark) {
+        return offline_run(&options);
+    }
+    // The window's pipeline is sized at compile time.
+    if ((options.fft_size && options.fft_size != FFT_SIZE) || (options.hop && options.hop != HOP_SIZE)) {
+        fprintf(stderr, "The window analyses with FFT size %d and hop %d; use --headless for others.\n",
+                FFT_SIZE, HOP_SIZE);
+        return EXIT_FAILURE;
+    }
+    state.view_mode = view_from_name(options.mode);
     
     // Initialize SDL and set up video, audio, and related resources.
     if (!initialize_sdl(&state)) {
         return EXIT_FAILURE;
     }
     
-    // Set the audio callback (attach our audio_callback to the opened device).
-    SDL_SetAudioCallback(state.audio_device, audio_callback, &state);
+    // Put the window on screen before anything slow happens.
+    render_placeholder(state.renderer, false, false);
+    SDL_RenderPresent(state.renderer);
+    printf("Startup: window after %.1f ms\n", elapsed_ms(state.startup_counter, SDL_GetPerformanceCounter()));
+    
+    // A file or generator source replaces the recording device; decide before the
+    // device thread starts, since it reads use_source.
+    if (options.source != SOURCE_DEVICE) {
+        if (!source_open(&state.source, options.source, options.source_path, options.frequency,
+                         SAMPLE_RATE, AUDIO_CHANNELS, 0)) {
+            fprintf(stderr, "Failed to open the input source.\n");
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        if (state.source.sample_rate != SAMPLE_RATE) {
+            fprintf(stderr, "The window needs %d Hz input; use --headless for other rates.\n", SAMPLE_RATE);
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        state.use_source = true;
+    }
+    
+    // Open the audio devices in the background while the rest is set up.
+    state.device_thread = SDL_CreateThread(open_audio_devices, "DeviceOpen", &state);
+    if (!state.device_thread) {
+        fprintf(stderr, "Failed to create device startup thread: %s\n", SDL_GetError());
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
     
     // Allocate the FFT buffers.
+#ifdef AV_LOW_POWER
+    if (!fixfft_init(&state.fixfft, FFT_SIZE)) {
+        fprintf(stderr, "Failed to set up fixed-point FFT.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    size_t transform_bytes = fixfft_memory(&state.fixfft);
+#else
     state.fft_input = (float*)malloc(sizeof(float) * FFT_SIZE);
     if (!state.fft_input) {
         fprintf(stderr, "Failed to allocate FFT input buffer.\n");
         cleanup(&state);
         return EXIT_FAILURE;
     }
+    size_t transform_bytes = sizeof(float) * FFT_SIZE;
+#endif
     state.fft_output = fftwf_malloc(sizeof(fftwf_complex) * BINS);
     if (!state.fft_output) {
         fprintf(stderr, "Failed to allocate FFT output buffer.\n");
         cleanup(&state);
         return EXIT_FAILURE;
     }
+    transform_bytes += sizeof(fftwf_complex) * BINS;
+    
+    // Report the footprint so the float and fixed-point profiles can be compared.
+    printf("%s analysis, FFT size %d: transform buffers %.1f KiB, application state %.1f KiB\n",
+#ifdef AV_LOW_POWER
+           "Q15 fixed-point",
+#else
+           "Float",
+#endif
+           FFT_SIZE, transform_bytes / 1024.0, sizeof(AppState) / 1024.0);
     
     // Create a mutex to protect FFT output access.
     state.fft_mutex = SDL_CreateMutex();
@@ -303,8 +2154,186 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
     
-    // Start playback so that the audio callback will be invoked.
-    SDL_PlayAudioDevice(state.audio_device);
+    // Measure the FFT plans in the background too, now that their buffers exist.
+    state.transfer_depth_request = TRANSFER_DEFAULT_DEPTH;
+    state.howl_enabled = options.howl;
+    state.plan_thread = SDL_CreateThread(warm_up_plans, "PlanWarmup", &state);
+    if (!state.plan_thread) {
+        fprintf(stderr, "Failed to create plan startup thread: %s\n", SDL_GetError());
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    if (!hpss_init(&state.hpss, BINS, HPSS_TIME_FRAMES, HPSS_FREQ_BINS)) {
+        fprintf(stderr, "Failed to allocate HPSS buffers.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    if (!descriptors_init(&state.descriptors, BINS, (float)SAMPLE_RATE / FFT_SIZE, ROLLOFF_FRACTION)) {
+        fprintf(stderr, "Failed to allocate descriptor buffers.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    // Sum of squared Hann weights converts one-sided bin power to mean square.
+    float window_power = 0;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        float hann = 0.5f * (1 - cosf(2 * M_PI * i / (FFT_SIZE - 1)));
+        window_power += hann * hann;
+    }
+    state.rta_power_scale = 2.0f / (FFT_SIZE * window_power);
+    state.rta_fraction_request = RTA_DEFAULT_FRACTION;
+    if (!octave_init(&state.rta, RTA_DEFAULT_FRACTION, SAMPLE_RATE, FFT_SIZE, state.rta_power_scale)) {
+        fprintf(stderr, "Failed to set up octave analyzer.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    if (!psd_init(&state.psd, BINS, SAMPLE_RATE, window_power, PSD_TAU_SECONDS)) {
+        fprintf(stderr, "Failed to allocate PSD accumulators.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    state.history_format = HISTORY_DEFAULT_FORMAT;
+    state.history_format_request = HISTORY_DEFAULT_FORMAT;
+    
+    if (!denoise_init(&state.denoise, BINS, DENOISE_OVER_SUBTRACTION, DENOISE_FLOOR_GAIN)) {
+        fprintf(stderr, "Failed to allocate denoise buffers.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    
+    // The EQ response is evaluated at the bin centres the spectrum columns are drawn at.
+    static float bin_frequencies[BINS];
+    for (int i = 0; i < BINS; i++) {
+        bin_frequencies[i] = i * (float)SAMPLE_RATE / FFT_SIZE;
+    }
+    if (!eq_response_init(&state.eq_response, bin_frequencies, BINS, SAMPLE_RATE)) {
+        fprintf(stderr, "Failed to allocate EQ response tables.\n");
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    if (!eq_load(&state.eq_chain, EQ_CONFIG_PATH)) {
+        eq_default_chain(&state.eq_chain);
+    }
+    
+    // Command-line outputs.
+    if (options.record_path && !recording_open(&state.recording, options.record_path, SAMPLE_RATE,
+                                               FFT_SIZE, HOP_SIZE, BINS, options.record_format)) {
+        fprintf(stderr, "Failed to open %s for writing.\n", options.record_path);
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    if (options.shm_name && !shm_open_writer(&state.shared, options.shm_name, SAMPLE_RATE,
+                                             FFT_SIZE, HOP_SIZE, BINS, options.record_format)) {
+        fprintf(stderr, "Failed to create shared memory '%s'.\n", options.shm_name);
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    if (options.browse_path) {
+        if (!browser_open(&state.browser, options.browse_path, options.pyramid_reduce)) {
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        state.browser_ready = true;
+        state.view_mode = VIEW_BROWSER;
+    }
+    if (options.fingerprint_path) {
+        if (!fingerprint_index_open(&state.fp_index, options.fingerprint_path)) {
+            fprintf(stderr, "Failed to open the fingerprint index %s.\n", options.fingerprint_path);
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        const FingerprintFileHeader* header = state.fp_index.header;
+        if (header->sample_rate != SAMPLE_RATE || header->hop != HOP_SIZE) {
+            fprintf(stderr, "The index was built at %u Hz with hop %u; the window analyses %d Hz with hop %d "
+                    "(build it with --fft-size %d).\n",
+                    header->sample_rate, header->hop, SAMPLE_RATE, HOP_SIZE, FFT_SIZE);
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        state.fp_matcher = malloc(sizeof(FingerprintMatcher));
+        state.fp_hashes = malloc(sizeof(FingerprintHash) * FP_MAX_HASHES);
+        if (!state.fp_matcher || !state.fp_hashes ||
+            !fingerprint_init(&state.fp, BINS, (float)SAMPLE_RATE / FFT_SIZE, (float)HOP_SIZE / SAMPLE_RATE)) {
+            fprintf(stderr, "Failed to set up fingerprint matching.\n");
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        fingerprint_matcher_init(state.fp_matcher, &state.fp_index, (float)HOP_SIZE / SAMPLE_RATE);
+        printf("Fingerprint: %u reference tracks, %.2f h, %.1f MiB mapped\n", header->track_count,
+               header->seconds / 3600.0, state.fp_index.bytes / 1048576.0);
+    }
+    if (options.trigger_path) {
+        if (!trigger_open(&state.triggers, options.trigger_path, BINS, (float)SAMPLE_RATE / FFT_SIZE,
+                          (double)HOP_SIZE / SAMPLE_RATE)) {
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+        state.triggers_open = true;
+        printf("Triggers: %d rules\n", state.triggers.count);
+    }
+    if (options.preset_path &&
+        !load_preset(&state, options.preset_path, options.preset_columns ? options.preset_columns : PRESET_DEFAULT_COLUMNS)) {
+        cleanup(&state);
+        return EXIT_FAILURE;
+    }
+    plugin_host_init(&state.plugins, SAMPLE_RATE, FFT_SIZE, HOP_SIZE, BINS);
+    for (int i = 0; i < options.plugin_count; i++) {
+        if (!plugin_load(&state.plugins, options.plugin_specs[i])) {
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.video_path) {
+        state.video = fopen(options.video_path, "wb");
+        if (!state.video) {
+            fprintf(stderr, "Failed to open %s for writing.\n", options.video_path);
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    vad_init(&state.vad, VAD_SILENCE_DB, VAD_NOISE_DB, VAD_FLATNESS, VAD_RESUME_MARGIN_DB, VAD_HANGOVER_HOPS);
+    state.vad_enabled = true;
+    state.wake_event = SDL_RegisterEvents(1);
+    
+    // Keep the placeholder responsive until both startup threads are done.
+    while (!SDL_GetAtomicInt(&state.devices_ready) || !SDL_GetAtomicInt(&state.plans_ready)) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_EVENT_QUIT) {
+                state.running = false;
+            }
+        }
+        render_placeholder(state.renderer, SDL_GetAtomicInt(&state.devices_ready),
+                           SDL_GetAtomicInt(&state.plans_ready));
+        SDL_RenderPresent(state.renderer);
+        SDL_Delay(1000 / 60);
+    }
+    int devices_ok = 0;
+    int plans_ok = 0;
+    SDL_WaitThread(state.device_thread, &devices_ok);
+    SDL_WaitThread(state.plan_thread, &plans_ok);
+    state.device_thread = NULL;
+    state.plan_thread = NULL;
+    if (!devices_ok || !plans_ok || !state.running) {
+        cleanup(&state);
+        return state.running ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    printf("Startup: audio devices opened in %.1f ms, FFT plans ready in %.1f ms (in parallel)\n",
+           state.device_open_ms, state.plan_warmup_ms);
+    
+    // Start recording so that the audio callback will be invoked. Playback
+    // runs all the time and outputs silence until the pass-through is enabled.
+    if (state.capture_stream) {
+        SDL_ResumeAudioStreamDevice(state.capture_stream);
+    }
+    if (state.playback_stream) {
+        SDL_ResumeAudioStreamDevice(state.playback_stream);
+    }
     
     // Create a separate thread for audio processing.
     SDL_Thread* audio_thread = SDL_CreateThread(audio_processing_thread, "AudioProcessor", &state);
@@ -313,24 +2342,288 @@ int main(int argc, char* argv[]) {
         cleanup(&state);
         return EXIT_FAILURE;
     }
+    if (state.use_source) {
+        state.source_thread = SDL_CreateThread(source_feed_thread, "SourceFeed", &state);
+        if (!state.source_thread) {
+            fprintf(stderr, "Failed to create source thread: %s\n", SDL_GetError());
+            state.running = false;
+            SDL_WaitThread(audio_thread, NULL);
+            cleanup(&state);
+            return EXIT_FAILURE;
+        }
+    }
     
     // Main loop: Process SDL events and render the frequency spectrum.
     SDL_Event event;
+    Uint64 last_title_update = 0;
     while (state.running) {
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+        SDL_LockMutex(state.fft_mutex);
+        bool has_spectrum = (state.hops_analysed > 0);
+        SDL_UnlockMutex(state.fft_mutex);
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_EVENT_QUIT) {
                 state.running = false;
+            } else if (state.view_mode == VIEW_BROWSER && event.type == SDL_EVENT_MOUSE_WHEEL) {
+                browser_zoom(&state.browser, pow(0.8, event.wheel.y), event.wheel.mouse_x);
+            } else if (state.view_mode == VIEW_BROWSER && event.type == SDL_EVENT_MOUSE_MOTION &&
+                       (event.motion.state & SDL_BUTTON_LMASK)) {
+                browser_pan(&state.browser, event.motion.xrel);
+            } else if (state.view_mode == VIEW_BROWSER && event.type == SDL_EVENT_KEY_DOWN &&
+                       (event.key.key == SDLK_LEFT || event.key.key == SDLK_RIGHT ||
+                        event.key.key == SDLK_UP || event.key.key == SDLK_DOWN)) {
+                // Arrows pan by a quarter window and zoom around the centre; held keys repeat.
+                int win_w, win_h;
+                SDL_GetRendererOutputSize(state.renderer, &win_w, &win_h);
+                if (event.key.key == SDLK_LEFT || event.key.key == SDLK_RIGHT) {
+                    browser_pan(&state.browser, (event.key.key == SDLK_LEFT ? 0.25f : -0.25f) * win_w);
+                } else {
+                    browser_zoom(&state.browser, event.key.key == SDLK_UP ? 0.5 : 2.0, 0.5f * win_w);
+                }
+            } else if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat) {
+                if (event.key.key == SDLK_Z && state.browser_ready) {
+                    // Z toggles the browser opened with --browse.
+                    state.view_mode = (state.view_mode == VIEW_BROWSER) ? VIEW_SPECTRUM : VIEW_BROWSER;
+                } else if (event.key.key == SDLK_X && state.plugins.count) {
+                    // X toggles the view drawn by the render plugins.
+                    state.view_mode = (state.view_mode == VIEW_PLUGIN) ? VIEW_SPECTRUM : VIEW_PLUGIN;
+                } else if (event.key.key == SDLK_M && state.preset_ready) {
+                    // M toggles the preset view, recompiling the preset on the way in.
+                    if (state.view_mode != VIEW_PRESET) {
+                        load_preset(&state, state.preset.path, state.preset.columns);
+                    }
+                    state.view_mode = (state.view_mode == VIEW_PRESET) ? VIEW_SPECTRUM : VIEW_PRESET;
+                } else if (state.view_mode == VIEW_BROWSER && event.key.key == SDLK_HOME) {
+                    browser_fit(&state.browser);
+                } else if (event.key.key == SDLK_H) {
+                    // H toggles the harmonic/percussive view.
+                    state.view_mode = (state.view_mode == VIEW_HPSS) ? VIEW_SPECTRUM : VIEW_HPSS;
+                } else if (event.key.key == SDLK_F) {
+                    // F toggles the descriptor strip charts.
+                    state.view_mode = (state.view_mode == VIEW_FEATURES) ? VIEW_SPECTRUM : VIEW_FEATURES;
+                } else if (event.key.key == SDLK_O) {
+                    // O toggles the fractional-octave analyzer.
+                    state.view_mode = (state.view_mode == VIEW_RTA) ? VIEW_SPECTRUM : VIEW_RTA;
+                } else if (state.view_mode == VIEW_RTA && event.key.key == SDLK_B) {
+                    // B steps the band resolution: 1/1, 1/3, 1/6, 1/12 octave.
+                    int fraction = state.rta_fraction_request;
+                    state.rta_fraction_request = (fraction == 1) ? 3 : (fraction == 12) ? 1 : fraction * 2;
+                } else if (state.view_mode == VIEW_RTA && event.key.key == SDLK_I) {
+                    state.rta_use_filterbank = !state.rta_use_filterbank;
+                } else if (state.view_mode == VIEW_RTA && event.key.key == SDLK_R) {
+                    state.rta_reset_request = true;
+                } else if (event.key.key == SDLK_T) {
+                    // T toggles the dual-channel transfer function view.
+                    state.view_mode = (state.view_mode == VIEW_TRANSFER) ? VIEW_SPECTRUM : VIEW_TRANSFER;
+                } else if (state.view_mode == VIEW_TRANSFER &&
+                           (event.key.key == SDLK_EQUALS || event.key.key == SDLK_PLUS)) {
+                    if (state.transfer_depth_request < TRANSFER_MAX_DEPTH) {
+                        state.transfer_depth_request *= 2;
+                    }
+                } else if (state.view_mode == VIEW_TRANSFER && event.key.key == SDLK_MINUS) {
+                    if (state.transfer_depth_request > 1) {
+                        state.transfer_depth_request /= 2;
+                    }
+                } else if (event.key.key == SDLK_P) {
+                    // P toggles the long-term PSD view.
+                    state.view_mode = (state.view_mode == VIEW_PSD) ? VIEW_SPECTRUM : VIEW_PSD;
+                } else if (state.view_mode == VIEW_PSD && event.key.key == SDLK_L) {
+                    state.psd_averaging = (state.psd_averaging == PSD_LINEAR) ? PSD_EXPONENTIAL : PSD_LINEAR;
+                } else if (state.view_mode == VIEW_PSD && event.key.key == SDLK_R) {
+                    state.psd_reset_request = true;
+                } else if (event.key.key == SDLK_G) {
+                    // G toggles the spectrogram of the stored history.
+                    state.view_mode = (state.view_mode == VIEW_SPECTROGRAM) ? VIEW_SPECTRUM : VIEW_SPECTROGRAM;
+                } else if (state.view_mode == VIEW_SPECTROGRAM && event.key.key == SDLK_K) {
+                    // K cycles the history storage between 8-bit dB, float16 and float32, clearing it.
+                    state.history_format_request = (FrameFormat)((state.history_format_request + 2) % 3);
+                } else if (event.key.key == SDLK_N) {
+                    // N captures a new noise profile over the next two seconds.
+                    state.denoise_capture_request = true;
+                } else if (event.key.key == SDLK_D) {
+                    // D cycles the denoise gain: off, spectral subtraction, Wiener.
+                    state.denoise_mode = (DenoiseMode)((state.denoise_mode + 1) % 3);
+                } else if (event.key.key == SDLK_W) {
+                    // W starts or stops writing the resynthesised preview to a WAV file.
+                    state.preview_request = !state.preview_request;
+                } else if (event.key.key == SDLK_A) {
+                    // A toggles the duplex pass-through to the playback device.
+                    state.passthrough = !state.passthrough && state.playback_stream;
+                } else if (event.key.key == SDLK_Q) {
+                    // Q cycles the EQ: off, response preview, applied to the pass-through.
+                    // eq.txt is re-read each time it is switched on.
+                    SDL_LockMutex(state.fft_mutex);
+                    if (state.eq_mode == EQ_OFF && eq_load(&state.eq_chain, EQ_CONFIG_PATH) &&
+                        state.eq_selected >= state.eq_chain.count) {
+                        state.eq_selected = 0;
+                    }
+                    state.eq_mode = (EqMode)((state.eq_mode + 1) % 3);
+                    SDL_UnlockMutex(state.fft_mutex);
+                } else if (state.eq_mode != EQ_OFF && state.view_mode == VIEW_SPECTRUM &&
+                           event.key.key == SDLK_TAB) {
+                    state.eq_selected = (state.eq_selected + 1) % state.eq_chain.count;
+                } else if (state.eq_mode != EQ_OFF && state.view_mode == VIEW_SPECTRUM &&
+                           (event.key.key == SDLK_LEFT || event.key.key == SDLK_RIGHT ||
+                            event.key.key == SDLK_UP || event.key.key == SDLK_DOWN ||
+                            event.key.key == SDLK_PAGEUP || event.key.key == SDLK_PAGEDOWN)) {
+                    // Left/Right move the band a semitone, Up/Down change the gain,
+                    // PgUp/PgDn the Q.
+                    SDL_LockMutex(state.fft_mutex);
+                    EqBand* band = &state.eq_chain.bands[state.eq_selected];
+                    const float semitone = 1.0594631f;
+                    if (event.key.key == SDLK_LEFT) {
+                        band->freq_hz = fmaxf(band->freq_hz / semitone, 10.0f);
+                    } else if (event.key.key == SDLK_RIGHT) {
+                        band->freq_hz = fminf(band->freq_hz * semitone, SAMPLE_RATE * 0.45f);
+                    } else if (event.key.key == SDLK_UP) {
+                        band->gain_db = fminf(band->gain_db + 0.5f, EQ_DISPLAY_RANGE_DB);
+                    } else if (event.key.key == SDLK_DOWN) {
+                        band->gain_db = fmaxf(band->gain_db - 0.5f, -EQ_DISPLAY_RANGE_DB);
+                    } else if (event.key.key == SDLK_PAGEUP) {
+                        band->q = fminf(band->q * 1.25f, 20.0f);
+                    } else {
+                        band->q = fmaxf(band->q / 1.25f, 0.1f);
+                    }
+                    state.eq_chain.version++;
+                    SDL_UnlockMutex(state.fft_mutex);
+                } else if (event.key.key == SDLK_V) {
+                    // V toggles the silence throttle.
+                    state.vad_enabled = !state.vad_enabled;
+                } else if (event.key.key == SDLK_E) {
+                    // E cycles the envelope overlay: off, cepstrum, LPC.
+                    state.envelope_method = (EnvelopeMethod)((state.envelope_method + 1) % 3);
+                }
+                update_window_title(&state);
             }
         }
         
-        // Safely copy the FFT output for rendering.
-        fftwf_complex fft_snapshot[BINS];
+        if (state.view_mode == VIEW_HPSS) {
+            static float harmonic_snapshot[BINS];
+            static float percussive_snapshot[BINS];
+            SDL_LockMutex(state.fft_mutex);
+            memcpy(harmonic_snapshot, state.hpss_harmonic, sizeof(float) * BINS);
+            memcpy(percussive_snapshot, state.hpss_percussive, sizeof(float) * BINS);
+            SDL_UnlockMutex(state.fft_mutex);
+
+            render_hpss(state.renderer, harmonic_snapshot, percussive_snapshot);
+        } else if (state.view_mode == VIEW_FEATURES) {
+            // Unroll the ring oldest-first while holding the lock.
+            static SpectralFeatures feature_snapshot[FEATURE_HISTORY];
+            SDL_LockMutex(state.fft_mutex);
+            int count = state.feature_count;
+            int first = (state.feature_head - count + FEATURE_HISTORY) % FEATURE_HISTORY;
+            for (int i = 0; i < count; i++) {
+                feature_snapshot[i] = state.feature_history[(first + i) % FEATURE_HISTORY];
+            }
+            SDL_UnlockMutex(state.fft_mutex);
+
+            render_features(state.renderer, feature_snapshot, count);
+        } else if (state.view_mode == VIEW_RTA) {
+            static RtaSnapshot rta_snapshot;
+            SDL_LockMutex(state.fft_mutex);
+            rta_snapshot = state.rta_snapshot;
+            SDL_UnlockMutex(state.fft_mutex);
+
+            render_rta(state.renderer, &rta_snapshot);
+        } else if (state.view_mode == VIEW_TRANSFER) {
+            static float magnitude_snapshot[BINS];
+            static float phase_snapshot[BINS];
+            static float coherence_snapshot[BINS];
+            SDL_LockMutex(state.fft_mutex);
+            memcpy(magnitude_snapshot, state.transfer_magnitude_db, sizeof(float) * BINS);
+            memcpy(phase_snapshot, state.transfer_phase_deg, sizeof(float) * BINS);
+            memcpy(coherence_snapshot, state.transfer_coherence, sizeof(float) * BINS);
+            int filled = state.transfer_filled;
+            SDL_UnlockMutex(state.fft_mutex);
+
+            render_transfer(state.renderer, magnitude_snapshot, phase_snapshot, coherence_snapshot,
+                            filled, state.transfer_depth_request);
+        } else if (state.view_mode == VIEW_PSD) {
+            static float psd_snapshot[BINS];
+            SDL_LockMutex(state.fft_mutex);
+            memcpy(psd_snapshot, state.psd_db, sizeof(float) * BINS);
+            double seconds = state.psd_seconds;
+            SDL_UnlockMutex(state.fft_mutex);
+
+            render_psd(state.renderer, psd_snapshot, seconds, state.psd_averaging);
+        } else if (state.view_mode == VIEW_SPECTROGRAM) {
+            render_spectrogram(&state);
+        } else if (state.view_mode == VIEW_BROWSER) {
+            browser_render(&state.browser, state.renderer);
+        } else if (state.view_mode == VIEW_PLUGIN) {
+            render_plugins(&state);
+        } else if (state.view_mode == VIEW_PRESET) {
+            render_preset(&state);
+        } else {
+            // Safely copy the FFT output for rendering.
+            fftwf_complex fft_snapshot[BINS];
+            static float envelope_snapshot[BINS];
+            SDL_LockMutex(state.fft_mutex);
+            memcpy(fft_snapshot, state.fft_output, sizeof(fftwf_complex) * BINS);
+            memcpy(envelope_snapshot, state.envelope_curve, sizeof(float) * BINS);
+#ifdef AV_LOW_POWER
+            static int16_t level_snapshot[BINS];
+            memcpy(level_snapshot, state.level_db_q8, sizeof(int16_t) * BINS);
+#endif
+            SDL_UnlockMutex(state.fft_mutex);
+            
+#ifdef AV_LOW_POWER
+            render_spectrum_levels(state.renderer, level_snapshot);
+#else
+            render_spectrum(state.renderer, fft_snapshot);
+#endif
+            if (state.envelope_method != ENVELOPE_OFF) {
+                render_envelope(state.renderer, envelope_snapshot);
+            }
+            if (state.eq_mode != EQ_OFF) {
+                // Only this thread edits the chain, so it can be read here unlocked.
+                if (state.eq_response.version != state.eq_chain.version || !state.eq_response.valid) {
+                    Uint64 start = SDL_GetPerformanceCounter();
+                    eq_response_update(&state.eq_response, &state.eq_chain, SAMPLE_RATE);
+                    float cost = elapsed_ms(start, SDL_GetPerformanceCounter());
+                    SDL_LockMutex(state.fft_mutex);
+                    state.eq_response_cost_ms = cost;
+                    SDL_UnlockMutex(state.fft_mutex);
+                }
+                render_eq(state.renderer, state.eq_response.response_db, &state.eq_chain,
+                          state.eq_selected, state.eq_mode);
+            }
+        }
+        if (state.video) {
+            write_video_frame(&state);
+        }
+        SDL_RenderPresent(state.renderer);
+        state.render_busy_ms += elapsed_ms(frame_start, SDL_GetPerformanceCounter());
+        if (has_spectrum && !state.first_spectrum_reported) {
+            printf("Startup: first spectrum on screen after %.1f ms\n",
+                   elapsed_ms(state.startup_counter, SDL_GetPerformanceCounter()));
+            state.first_spectrum_reported = true;
+        }
+
+        // Refresh the per-hop cost and load report about once a second.
+        Uint64 now = SDL_GetTicks();
+        if (now - last_title_update >= 1000) {
+            float interval = (float)(now - last_title_update);
+            SDL_LockMutex(state.fft_mutex);
+            state.process_load = 100.0f * state.process_busy_ms / interval;
+            state.render_load = 100.0f * state.render_busy_ms / interval;
+            state.process_busy_ms = 0;
+            state.render_busy_ms = 0;
+            SDL_UnlockMutex(state.fft_mutex);
+            update_window_title(&state);
+            last_title_update = now;
+        }
+
+        // While silent, redraw rarely; the processing thread wakes us when sound returns.
+        // The browser keeps its frame rate: it shows a file, not the input.
         SDL_LockMutex(state.fft_mutex);
-        memcpy(fft_snapshot, state.fft_output, sizeof(fftwf_complex) * BINS);
+        bool idle = state.vad_silent && state.view_mode != VIEW_BROWSER;
         SDL_UnlockMutex(state.fft_mutex);
-        
-        render_spectrum(state.renderer, fft_snapshot);
-        SDL_Delay(1000 / 60); // Limit to roughly 60 FPS.
+        if (idle) {
+            SDL_WaitEventTimeout(NULL, VAD_IDLE_FRAME_MS);
+        } else {
+            SDL_Delay(1000 / 60); // Limit to roughly 60 FPS.
+        }
     }
     
     // Wait for the audio processing thread to exit.
@@ -0,0 +1,234 @@
+#include "octave.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Octave ratio of the base-10 series, 10^(3/10).
+#define OCTAVE_RATIO 1.9952623149688795
+
+// Lowest band centre considered, in Hz.
+#define OCTAVE_LOWEST_HZ 20.0
+
+// Time constant of the "fast" exponential level, in seconds.
+#define OCTAVE_FAST_TAU 0.125
+
+// Mean square of a full-scale sine, the 0 dB reference.
+#define OCTAVE_REFERENCE 0.5
+
+// Samples filtered per chunk by octave_process_samples.
+#define OCTAVE_CHUNK 256
+
+/*
+    octave_design_band: Designs a 6th-order Butterworth band-pass between
+    lower and upper Hz. Each 3rd-order low-pass prototype pole maps to a
+    conjugate pair of band-pass poles; each pair becomes one biquad with a
+    zero at DC and at Nyquist, normalised to unit gain at the band centre.
+*/
+static void octave_design_band(OctaveBiquad* sections, double lower, double upper, double fs) {
+    const double k = 2.0 * fs;
+    const double w1 = k * tan(M_PI * lower / fs);
+    const double w2 = k * tan(M_PI * upper / fs);
+    const double w0 = sqrt(w1 * w2);
+    const double bw = w2 - w1;
+    const double center = 2.0 * atan(w0 / k);  // Digital centre frequency.
+
+    for (int i = 0; i < OCTAVE_SECTIONS; i++) {
+        double complex proto = cexp(I * M_PI * (2.0 * (i + 1) + OCTAVE_SECTIONS - 1) /
+                                    (2.0 * OCTAVE_SECTIONS));
+        double complex pb = proto * bw;
+        double complex root = csqrt(pb * pb - 4.0 * w0 * w0);
+        double complex pole = (pb + root) / 2.0;
+        if (cimag(pole) < 0) {
+            pole = (pb - root) / 2.0;
+        }
+
+        // Bilinear transform of s / (s^2 - 2 Re(p) s + |p|^2).
+        const double re = creal(pole);
+        const double mag2 = creal(pole) * creal(pole) + cimag(pole) * cimag(pole);
+        const double a0 = k * k - 2.0 * re * k + mag2;
+        OctaveBiquad* s = &sections[i];
+        s->b0 = k / a0;
+        s->b2 = -k / a0;
+        s->a1 = (2.0 * mag2 - 2.0 * k * k) / a0;
+        s->a2 = (k * k + 2.0 * re * k + mag2) / a0;
+        s->z1 = s->z2 = 0.0;
+
+        double complex z1 = cexp(-I * center);
+        double complex z2 = z1 * z1;
+        double gain = cabs(s->b0 + s->b2 * z2) / cabs(1.0 + s->a1 * z1 + s->a2 * z2);
+        s->b0 /= gain;
+        s->b2 /= gain;
+    }
+}
+
+/*
+    octave_init: Builds band edges, FFT bin weights and filter sections for
+    the requested fraction. power_scale converts a sum of one-sided bin
+    powers to the mean square of the analysed signal.
+*/
+bool octave_init(OctaveAnalyzer* rta, int fraction, float sample_rate, int fft_size, float power_scale) {
+    memset(rta, 0, sizeof(*rta));
+    rta->fraction = fraction;
+    rta->sample_rate = sample_rate;
+    rta->bins = fft_size / 2 + 1;
+    rta->bin_hz = sample_rate / fft_size;
+    rta->power_scale = power_scale;
+
+    // Odd fractions centre on 1 kHz; even ones straddle it (IEC 61260).
+    const double nyquist = sample_rate / 2.0;
+    const double half_band = pow(OCTAVE_RATIO, 1.0 / (2.0 * fraction));
+    int x = (int)floor(fraction * log(OCTAVE_LOWEST_HZ / 1000.0) / log(OCTAVE_RATIO));
+    for (;; x++) {
+        double exponent = (fraction % 2) ? (double)x / fraction : (2.0 * x + 1.0) / (2.0 * fraction);
+        double center = 1000.0 * pow(OCTAVE_RATIO, exponent);
+        if (center * half_band >= nyquist || rta->band_count == OCTAVE_MAX_BANDS) {
+            break;
+        }
+        if (center < OCTAVE_LOWEST_HZ / half_band) {
+            continue;
+        }
+        int b = rta->band_count++;
+        rta->center_hz[b] = (float)center;
+        rta->lower_hz[b] = (float)(center / half_band);
+        rta->upper_hz[b] = (float)(center * half_band);
+    }
+
+    // Each bin covers [k - 1/2, k + 1/2) * bin_hz and is shared between the
+    // bands it overlaps in proportion to the overlap, so no power is lost.
+    int total = 0;
+    for (int b = 0; b < rta->band_count; b++) {
+        int first = (int)floor(rta->lower_hz[b] / rta->bin_hz + 0.5);
+        int last = (int)floor(rta->upper_hz[b] / rta->bin_hz + 0.5);
+        if (last >= rta->bins) {
+            last = rta->bins - 1;
+        }
+        rta->bin_first[b] = first;
+        rta->bin_count[b] = last - first + 1;
+        rta->weight_offset[b] = total;
+        total += rta->bin_count[b];
+    }
+    rta->weights = malloc(sizeof(float) * (total > 0 ? total : 1));
+    if (!rta->weights) {
+        return false;
+    }
+    for (int b = 0; b < rta->band_count; b++) {
+        for (int i = 0; i < rta->bin_count[b]; i++) {
+            int k = rta->bin_first[b] + i;
+            double lo = fmax((k - 0.5) * rta->bin_hz, rta->lower_hz[b]);
+            double hi = fmin((k + 0.5) * rta->bin_hz, rta->upper_hz[b]);
+            rta->weights[rta->weight_offset[b] + i] = (float)fmax(0.0, (hi - lo) / rta->bin_hz);
+        }
+        octave_design_band(rta->sections[b], rta->lower_hz[b], rta->upper_hz[b], sample_rate);
+    }
+    return true;
+}
+
+/*
+    octave_accumulate: Folds one block's mean square per band into the fast
+    level and the Leq integrator.
+*/
+static void octave_accumulate(OctaveLevels* levels, int band_count, const double* mean_square, double seconds) {
+    const double alpha = 1.0 - exp(-seconds / OCTAVE_FAST_TAU);
+    for (int b = 0; b < band_count; b++) {
+        levels->fast_energy[b] += alpha * (mean_square[b] - levels->fast_energy[b]);
+        levels->fast_db[b] = (float)(10.0 * log10(levels->fast_energy[b] / OCTAVE_REFERENCE + 1e-12));
+        levels->leq_energy[b] += mean_square[b] * seconds;
+    }
+    levels->leq_seconds += seconds;
+}
+
+/*
+    octave_process_spectrum: FFT-binned path. seconds is the audio time the
+    frame stands for, used for both the fast level and Leq weighting.
+*/
+void octave_process_spectrum(OctaveAnalyzer* rta, const float* power, float seconds) {
+    double mean_square[OCTAVE_MAX_BANDS];
+    for (int b = 0; b < rta->band_count; b++) {
+        const float* w = &rta->weights[rta->weight_offset[b]];
+        const float* p = &power[rta->bin_first[b]];
+        float sum = 0.0f;
+        for (int i = 0; i < rta->bin_count[b]; i++) {
+            sum += w[i] * p[i];
+        }
+        mean_square[b] = sum * rta->power_scale;
+    }
+    octave_accumulate(&rta->fft_levels, rta->band_count, mean_square, seconds);
+}
+
+/*
+    octave_process_samples: Filterbank path. Runs every band's cascade over
+    the new samples chunk by chunk, keeping each section's state in registers.
+*/
+void octave_process_samples(OctaveAnalyzer* rta, const float* samples, int count) {
+    if (count <= 0) {
+        return;
+    }
+    double mean_square[OCTAVE_MAX_BANDS] = {0};
+    double chunk[OCTAVE_CHUNK];
+
+    for (int start = 0; start < count; start += OCTAVE_CHUNK) {
+        const int n = (count - start < OCTAVE_CHUNK) ? count - start : OCTAVE_CHUNK;
+        for (int b = 0; b < rta->band_count; b++) {
+            for (int i = 0; i < n; i++) {
+                chunk[i] = samples[start + i];
+            }
+            for (int s = 0; s < OCTAVE_SECTIONS; s++) {
+                OctaveBiquad* q = &rta->sections[b][s];
+                double z1 = q->z1, z2 = q->z2;
+                for (int i = 0; i < n; i++) {
+                    double in = chunk[i];
+                    double out = q->b0 * in + z1;
+                    z1 = -q->a1 * out + z2;
+                    z2 = q->b2 * in - q->a2 * out;
+                    chunk[i] = out;
+                }
+                q->z1 = z1;
+                q->z2 = z2;
+            }
+            double energy = 0.0;
+            for (int i = 0; i < n; i++) {
+                energy += chunk[i] * chunk[i];
+            }
+            mean_square[b] += energy;
+        }
+    }
+    for (int b = 0; b < rta->band_count; b++) {
+        mean_square[b] /= count;
+    }
+    octave_accumulate(&rta->filter_levels, rta->band_count, mean_square, count / rta->sample_rate);
+}
+
+/*
+    octave_leq_db: Equivalent continuous level of a band since the last reset.
+*/
+float octave_leq_db(const OctaveLevels* levels, int band) {
+    if (levels->leq_seconds <= 0.0) {
+        return -120.0f;
+    }
+    double mean = levels->leq_energy[band] / levels->leq_seconds;
+    return (float)(10.0 * log10(mean / OCTAVE_REFERENCE + 1e-12));
+}
+
+/*
+    octave_reset_leq: Restarts Leq integration for both paths.
+*/
+void octave_reset_leq(OctaveAnalyzer* rta) {
+    memset(rta->fft_levels.leq_energy, 0, sizeof(rta->fft_levels.leq_energy));
+    memset(rta->filter_levels.leq_energy, 0, sizeof(rta->filter_levels.leq_energy));
+    rta->fft_levels.leq_seconds = 0.0;
+    rta->filter_levels.leq_seconds = 0.0;
+}
+
+/*
+    octave_free: Releases the FFT weight table.
+*/
+void octave_free(OctaveAnalyzer* rta) {
+    free(rta->weights);
+    rta->weights = NULL;
+}
@@ -0,0 +1,73 @@
+#ifndef OCTAVE_H
+#define OCTAVE_H
+
+#include <stdbool.h>
+
+// Enough for 1/12-octave bands from 20 Hz up to a 48 kHz Nyquist.
+#define OCTAVE_MAX_BANDS 140
+
+// Biquad sections per band filter (a 6th-order Butterworth band-pass).
+#define OCTAVE_SECTIONS 3
+
+/*
+    OctaveBiquad: One direct-form II transposed section. Double precision
+    keeps narrow low-frequency bands stable at audio sample rates.
+*/
+typedef struct {
+    double b0, b2, a1, a2;   // b1 is always zero for these band-pass sections.
+    double z1, z2;
+} OctaveBiquad;
+
+/*
+    OctaveLevels: Per-band levels produced by one analysis path.
+    Levels are in dB relative to a full-scale sine mean square.
+*/
+typedef struct {
+    float fast_db[OCTAVE_MAX_BANDS];       // Exponential "fast" (125 ms) level.
+    double fast_energy[OCTAVE_MAX_BANDS];
+    double leq_energy[OCTAVE_MAX_BANDS];   // Integrated mean square * seconds.
+    double leq_seconds;
+} OctaveLevels;
+
+/*
+    OctaveAnalyzer: Fractional-octave real-time analyzer.
+
+    Band centres and edges follow the base-10 series of IEC 61260 / ANSI
+    S1.11. Two paths are offered: summing FFT power over precomputed bin
+    ranges with fractional edge weights, and a band-pass IIR filterbank on
+    the time-domain samples, which stays exact where bands are narrower
+    than an FFT bin.
+*/
+typedef struct {
+    int fraction;          // Bands per octave: 1, 3, 6 or 12.
+    float sample_rate;
+    int bins;
+    float bin_hz;
+    float power_scale;     // Converts summed bin power to mean square.
+
+    int band_count;
+    float center_hz[OCTAVE_MAX_BANDS];
+    float lower_hz[OCTAVE_MAX_BANDS];
+    float upper_hz[OCTAVE_MAX_BANDS];
+
+    // FFT-binned path: band b sums bins [bin_first[b], bin_first[b] + bin_count[b]).
+    int bin_first[OCTAVE_MAX_BANDS];
+    int bin_count[OCTAVE_MAX_BANDS];
+    int weight_offset[OCTAVE_MAX_BANDS];
+    float* weights;
+
+    // Filterbank path.
+    OctaveBiquad sections[OCTAVE_MAX_BANDS][OCTAVE_SECTIONS];
+
+    OctaveLevels fft_levels;
+    OctaveLevels filter_levels;
+} OctaveAnalyzer;
+
+bool octave_init(OctaveAnalyzer* rta, int fraction, float sample_rate, int fft_size, float power_scale);
+void octave_process_spectrum(OctaveAnalyzer* rta, const float* power, float seconds);
+void octave_process_samples(OctaveAnalyzer* rta, const float* samples, int count);
+float octave_leq_db(const OctaveLevels* levels, int band);
+void octave_reset_leq(OctaveAnalyzer* rta);
+void octave_free(OctaveAnalyzer* rta);
+
+#endif
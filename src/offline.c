@@ -0,0 +1,754 @@
+#include <SDL3/SDL.h>
+
+#include "offline.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descriptors.h"
+#include "fingerprint.h"
+#include "howl.h"
+#include "psd.h"
+#include "pyramid.h"
+#include "recording.h"
+#include "shm.h"
+#include "source.h"
+#include "trigger.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OFFLINE_SSE2 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Same rolloff fraction and PSD time constant as the window.
+#define OFFLINE_ROLLOFF_FRACTION 0.85f
+#define OFFLINE_PSD_TAU 10.0
+
+// Output of one chunk of the parallel STFT (power and dB rows), and chunk
+// slots per worker: one being filled, one waiting to be drained.
+#define OFFLINE_CHUNK_BYTES (4u << 20)
+#define OFFLINE_SLOTS_PER_WORKER 2
+
+/*
+    offline_stft_init: Allocates buffers for batch windows and plans one
+    batched transform over all of them.
+*/
+bool offline_stft_init(OfflineStft* stft, int fft_size, int hop, int batch) {
+    memset(stft, 0, sizeof(*stft));
+    stft->fft_size = fft_size;
+    stft->hop = hop;
+    stft->bins = fft_size / 2 + 1;
+    stft->batch = batch;
+    stft->span = fft_size + (batch - 1) * hop;
+    stft->window = malloc(sizeof(float) * fft_size);
+    stft->input = fftwf_alloc_real((size_t)batch * fft_size);
+    stft->spectrum = fftwf_alloc_complex((size_t)batch * stft->bins);
+    stft->power = malloc(sizeof(float) * batch * stft->bins);
+    stft->row_db = malloc(sizeof(float) * batch * stft->bins);
+    stft->frame = malloc(sizeof(float) * stft->span);
+    if (!stft->window || !stft->input || !stft->spectrum || !stft->power || !stft->row_db || !stft->frame) {
+        offline_stft_free(stft);
+        return false;
+    }
+    for (int i = 0; i < fft_size; i++) {
+        stft->window[i] = 0.5f * (1 - cosf(2 * (float)M_PI * i / (fft_size - 1)));
+        stft->window_power += (double)stft->window[i] * stft->window[i];
+    }
+    const int n[] = { fft_size };
+    stft->plan = fftwf_plan_many_dft_r2c(1, n, batch, stft->input, NULL, 1, fft_size,
+                                         stft->spectrum, NULL, 1, stft->bins, FFTW_MEASURE);
+    if (!stft->plan) {
+        offline_stft_free(stft);
+        return false;
+    }
+    return true;
+}
+
+/*
+    offline_stft_levels: Batched power and dB over count contiguous spectra.
+    The power pass de-interleaves two bins per load; the dB pass is the
+    same expression the window uses for its bar levels.
+*/
+static void offline_stft_levels(OfflineStft* stft, int count) {
+    const int total = count * stft->bins;
+    const float* spectrum = &stft->spectrum[0][0];
+    int k = 0;
+#ifdef OFFLINE_SSE2
+    for (; k + 4 <= total; k += 4) {
+        __m128 a = _mm_loadu_ps(&spectrum[2 * k]);
+        __m128 b = _mm_loadu_ps(&spectrum[2 * k + 4]);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(&stft->power[k], _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+#endif
+    for (; k < total; k++) {
+        float re = spectrum[2 * k];
+        float im = spectrum[2 * k + 1];
+        stft->power[k] = re * re + im * im;
+    }
+    for (k = 0; k < total; k++) {
+        stft->row_db[k] = 10 * log10f(sqrtf(stft->power[k]) + 1e-6f);
+    }
+}
+
+/*
+    offline_stft_reset: Forgets the sliding frame before a new source.
+*/
+void offline_stft_reset(OfflineStft* stft) {
+    stft->primed = false;
+}
+
+/*
+    read_mono: Reads up to frames frames from the source, mixed down to
+    mono. Returns the number read; fewer than asked means the source ended.
+*/
+static int read_mono(OfflineStft* stft, AudioSource* src, float* out, int frames) {
+    if (src->channels > stft->scratch_channels) {
+        float* scratch = realloc(stft->scratch, sizeof(float) * (size_t)stft->span * src->channels);
+        if (!scratch) {
+            return 0;
+        }
+        stft->scratch = scratch;
+        stft->scratch_channels = src->channels;
+    }
+    int got = source_read(src, stft->scratch, frames);
+    for (int i = 0; i < got; i++) {
+        float mix = 0;
+        for (int c = 0; c < src->channels; c++) {
+            mix += stft->scratch[i * src->channels + c];
+        }
+        out[i] = mix / src->channels;
+    }
+    return got;
+}
+
+/*
+    offline_stft_next: Reads up to batch hops from the source and analyses
+    the frames ending at each, with one batched FFT call. Frame i of the
+    result is at power/row_db + i * bins. Returns the number of frames,
+    0 at the end of the source; a trailing partial hop is dropped.
+*/
+int offline_stft_next(OfflineStft* stft, AudioSource* src) {
+    const int keep = stft->fft_size - stft->hop;
+    if (!stft->primed) {
+        if (read_mono(stft, src, stft->frame, keep) != keep) {
+            return 0;
+        }
+        stft->primed = true;
+    }
+    const int count = read_mono(stft, src, stft->frame + keep, stft->batch * stft->hop) / stft->hop;
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int f = 0; f < count; f++) {
+        const float* samples = stft->frame + f * stft->hop;
+        float* input = stft->input + (size_t)f * stft->fft_size;
+        for (int i = 0; i < stft->fft_size; i++) {
+            input[i] = samples[i] * stft->window[i];
+        }
+    }
+    fftwf_execute(stft->plan);
+    offline_stft_levels(stft, count);
+
+    // The last keep samples overlap the next call's first frame.
+    memmove(stft->frame, stft->frame + count * stft->hop, sizeof(float) * keep);
+    return count;
+}
+
+/*
+    offline_stft_free: Destroys the plan and releases the buffers.
+*/
+void offline_stft_free(OfflineStft* stft) {
+    if (stft->plan) {
+        fftwf_destroy_plan(stft->plan);
+    }
+    free(stft->window);
+    fftwf_free(stft->input);
+    fftwf_free(stft->spectrum);
+    free(stft->power);
+    free(stft->row_db);
+    free(stft->frame);
+    free(stft->scratch);
+    memset(stft, 0, sizeof(*stft));
+}
+
+/*
+    OfflineSinks: Per-frame outputs of an offline run. Frames reach them
+    strictly in order, whichever thread analysed them.
+*/
+typedef struct {
+    bool benchmark;            // Count frames only.
+    bool features;
+    bool psd_mode;
+    int sample_rate;
+    int fft_size;
+    int hop;
+    DescriptorState desc;
+    PsdState psd;
+    Recording rec;
+    SharedFrame shm;
+    PyramidWriter pyramid;
+    FingerprintIndex fp_index;
+    FingerprintExtractor fp;
+    FingerprintMatcher* matcher;   // Heap: the vote table is large.
+    FingerprintHash* fp_hashes;    // One frame's landmarks.
+    TriggerEngine triggers;
+    bool triggers_open;
+    HowlDetector howl;
+    bool howl_open;
+    unsigned long long frames;
+} OfflineSinks;
+
+/*
+    offline_print_match: Writes the result of a closed voting window as a
+    CSV line: query time, track, position in the track, votes.
+*/
+static void offline_print_match(OfflineSinks* sinks) {
+    const FingerprintMatch* m = &sinks->matcher->result;
+    const double seconds_per_frame = (double)sinks->hop / sinks->sample_rate;
+    if (m->track >= 0) {
+        printf("%.2f,\"%s\",%.2f,%d\n", m->end_frame * seconds_per_frame,
+               fingerprint_index_name(&sinks->fp_index, m->track),
+               ((double)m->end_frame + m->offset_frames) * seconds_per_frame, m->votes);
+    } else {
+        printf("%.2f,,,%d\n", m->end_frame * seconds_per_frame, m->votes);
+    }
+    sinks->matcher->fresh = false;
+}
+
+/*
+    offline_emit: Hands one analysed frame to every open output.
+*/
+static void offline_emit(OfflineSinks* sinks, const float* power, const float* row_db) {
+    if (!sinks->benchmark) {
+        if (sinks->rec.file) {
+            recording_write(&sinks->rec, row_db);
+        }
+        if (sinks->shm.header) {
+            shm_publish(&sinks->shm, row_db);
+        }
+        if (sinks->pyramid.column) {
+            pyramid_push(&sinks->pyramid, row_db);
+        }
+        if (sinks->features) {
+            SpectralFeatures f;
+            descriptors_compute(&sinks->desc, power, &f);
+            printf("%.4f,%.2f,%.2f,%.2f,%.5f,%.3f,%.5f\n",
+                   (double)(sinks->frames * sinks->hop + sinks->fft_size) / sinks->sample_rate,
+                   f.centroid, f.spread, f.rolloff, f.flatness, f.crest, f.flux);
+        }
+        if (sinks->psd_mode) {
+            psd_accumulate(&sinks->psd, power, (double)sinks->hop / sinks->sample_rate);
+        }
+        if (sinks->matcher) {
+            int n = fingerprint_push(&sinks->fp, row_db, sinks->fp_hashes);
+            fingerprint_matcher_add(sinks->matcher, sinks->fp_hashes, n, (uint32_t)sinks->frames);
+            if (sinks->matcher->fresh) {
+                offline_print_match(sinks);
+            }
+        }
+        if (sinks->triggers_open) {
+            trigger_process(&sinks->triggers, row_db);
+        }
+        if (sinks->howl_open) {
+            howl_process_spectrum(&sinks->howl, power);
+            for (int i = 0; i < sinks->howl.alert_count; i++) {
+                const HowlAlert* a = &sinks->howl.alerts[i];
+                printf("%.4f,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f\n", a->time, a->frequency_hz, a->level_db,
+                       a->papr_db, a->phpr_db, a->slope_db_per_s, (a->time - a->onset) * 1000.0);
+            }
+        }
+    }
+    sinks->frames++;
+}
+
+/*
+    OfflineSlot: Output of one chunk of the parallel STFT. Chunk c goes to
+    slot c % slot_count and may only be claimed once chunk c - slot_count
+    has been drained, so the slots form a ring in frame order.
+*/
+typedef struct {
+    unsigned long long first;  // First frame of the chunk.
+    int count;                 // Frames in the chunk.
+    int produced;              // Frames analysed; fewer than count if a read failed.
+    bool ready;                // Written by a worker, not yet drained.
+    float* power;              // chunk_frames x bins.
+    float* row_db;
+} OfflineSlot;
+
+/*
+    OfflineQueue: The chunks of one file, shared by the worker pool. Workers
+    claim chunks in order under the mutex and fill their slots without it;
+    the main thread drains the slots in the same order.
+*/
+typedef struct {
+    SDL_Mutex* mutex;
+    SDL_Condition* filled;     // A slot became ready.
+    SDL_Condition* drained;    // The main thread emptied a slot.
+    OfflineSlot* slots;
+    int slot_count;
+    int chunk_frames;
+    unsigned long long total;  // Frames in the file.
+    int chunks;
+    int next;                  // Next unclaimed chunk.
+    int emitted;               // Chunks drained by the main thread.
+} OfflineQueue;
+
+/*
+    OfflineWorker: One pool thread with its own reader, plan and buffers,
+    alive for the whole pass.
+*/
+typedef struct {
+    OfflineQueue* queue;
+    OfflineStft stft;
+    AudioSource src;
+    SDL_Thread* thread;
+} OfflineWorker;
+
+/*
+    offline_chunk: Analyses one chunk into its slot. The reader seeks to
+    the first sample of the chunk's first frame; the fft_size - hop samples
+    shared with the previous chunk are read again, so every frame sees
+    exactly the samples the serial loop gives it.
+*/
+static void offline_chunk(OfflineWorker* worker, OfflineSlot* slot) {
+    OfflineStft* stft = &worker->stft;
+    const size_t bins = stft->bins;
+    slot->produced = 0;
+    if (!source_seek(&worker->src, slot->first * stft->hop)) {
+        return;
+    }
+    offline_stft_reset(stft);
+    while (slot->produced < slot->count) {
+        int got = offline_stft_next(stft, &worker->src);
+        if (got == 0) {
+            break;
+        }
+        if (got > slot->count - slot->produced) {
+            got = slot->count - slot->produced;  // The batch ran into the next chunk.
+        }
+        const size_t offset = (size_t)slot->produced * bins;
+        memcpy(slot->power + offset, stft->power, sizeof(float) * bins * got);
+        memcpy(slot->row_db + offset, stft->row_db, sizeof(float) * bins * got);
+        slot->produced += got;
+    }
+}
+
+/*
+    offline_worker: Pool thread body; claims chunks until the file is
+    exhausted, waiting while its next slot still holds undrained output.
+*/
+static int offline_worker(void* data) {
+    OfflineWorker* worker = (OfflineWorker*)data;
+    OfflineQueue* queue = worker->queue;
+    SDL_LockMutex(queue->mutex);
+    while (queue->next < queue->chunks) {
+        const int chunk = queue->next;
+        if (chunk - queue->emitted >= queue->slot_count) {
+            SDL_WaitCondition(queue->drained, queue->mutex);
+            continue;
+        }
+        queue->next++;
+        OfflineSlot* slot = &queue->slots[chunk % queue->slot_count];
+        slot->first = (unsigned long long)chunk * queue->chunk_frames;
+        slot->count = (int)SDL_min(queue->total - slot->first, (unsigned long long)queue->chunk_frames);
+        SDL_UnlockMutex(queue->mutex);
+
+        offline_chunk(worker, slot);
+
+        SDL_LockMutex(queue->mutex);
+        slot->ready = true;
+        SDL_SignalCondition(queue->filled);
+    }
+    SDL_UnlockMutex(queue->mutex);
+    return 0;
+}
+
+/*
+    offline_parallel: Runs a seekable source through a pool of jobs
+    workers. The file is cut into chunks of about OFFLINE_CHUNK_BYTES of
+    output, a whole number of batches each, which the workers claim in
+    order while the main thread hands the finished ones to the sinks in
+    the same order. Batches start on the same frames as in a serial run,
+    so the outputs match one with the same batch size bit for bit (other
+    batch sizes agree to float rounding; see OfflineStft). The
+    FFTW planner reuses what it measured for the first plan of this shape,
+    so every worker runs the same algorithm as the serial path. Returns
+    false if set-up failed or a chunk before the last one came back short,
+    which would shift every later frame.
+*/
+static bool offline_parallel(OfflineSinks* sinks, const CliOptions* options, const AudioSource* src,
+                             int fft_size, int hop, int batch, int jobs) {
+    const unsigned long long length = src->wav.frames;
+    const unsigned long long total = (length >= (unsigned long long)fft_size) ?
+                                     (length - fft_size) / hop + 1 : 0;
+    const int bins = fft_size / 2 + 1;
+    int chunk_frames = (int)(OFFLINE_CHUNK_BYTES / (2 * sizeof(float) * bins));
+    chunk_frames = SDL_max(chunk_frames / batch, 1) * batch;
+
+    OfflineQueue queue = {0};
+    queue.chunk_frames = chunk_frames;
+    queue.total = total;
+    queue.chunks = (int)((total + chunk_frames - 1) / chunk_frames);
+    queue.slot_count = OFFLINE_SLOTS_PER_WORKER * jobs;
+    queue.mutex = SDL_CreateMutex();
+    queue.filled = SDL_CreateCondition();
+    queue.drained = SDL_CreateCondition();
+    queue.slots = calloc(queue.slot_count, sizeof(OfflineSlot));
+    OfflineWorker* workers = calloc(jobs, sizeof(OfflineWorker));
+    bool ok = queue.mutex && queue.filled && queue.drained && queue.slots && workers;
+    for (int i = 0; ok && i < queue.slot_count; i++) {
+        queue.slots[i].power = malloc(sizeof(float) * chunk_frames * bins);
+        queue.slots[i].row_db = malloc(sizeof(float) * chunk_frames * bins);
+        ok = queue.slots[i].power && queue.slots[i].row_db;
+    }
+    for (int w = 0; ok && w < jobs; w++) {
+        workers[w].queue = &queue;
+        ok = source_open(&workers[w].src, SOURCE_FILE, options->source_path, 0, 0, 0, 0) &&
+             offline_stft_init(&workers[w].stft, fft_size, hop, batch);
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to set up the offline workers.\n");
+    }
+
+    int started = 0;
+    for (int w = 0; ok && w < jobs; w++) {
+        workers[w].thread = SDL_CreateThread(offline_worker, "OfflineStft", &workers[w]);
+        if (!workers[w].thread) {
+            fprintf(stderr, "Failed to create offline worker: %s\n", SDL_GetError());
+            break;
+        }
+        started++;
+    }
+    ok = ok && started > 0;
+
+    SDL_LockMutex(queue.mutex);
+    while (ok && queue.emitted < queue.chunks) {
+        OfflineSlot* slot = &queue.slots[queue.emitted % queue.slot_count];
+        if (!slot->ready) {
+            SDL_WaitCondition(queue.filled, queue.mutex);
+            continue;
+        }
+        if (slot->produced != slot->count && queue.emitted != queue.chunks - 1) {
+            fprintf(stderr, "Failed to read frames %llu to %llu of %s.\n", slot->first + slot->produced,
+                    slot->first + slot->count - 1, options->source_path);
+            ok = false;
+            queue.next = queue.chunks;  // Workers stop claiming chunks.
+            SDL_BroadcastCondition(queue.drained);
+            break;
+        }
+        SDL_UnlockMutex(queue.mutex);
+        for (int i = 0; i < slot->produced; i++) {
+            const size_t offset = (size_t)i * bins;
+            offline_emit(sinks, slot->power + offset, slot->row_db + offset);
+        }
+        SDL_LockMutex(queue.mutex);
+        slot->ready = false;
+        queue.emitted++;
+        SDL_BroadcastCondition(queue.drained);
+    }
+    SDL_UnlockMutex(queue.mutex);
+    for (int w = 0; w < started; w++) {
+        SDL_WaitThread(workers[w].thread, NULL);
+    }
+
+    for (int w = 0; workers && w < jobs; w++) {
+        offline_stft_free(&workers[w].stft);
+        source_close(&workers[w].src);
+    }
+    for (int i = 0; queue.slots && i < queue.slot_count; i++) {
+        free(queue.slots[i].power);
+        free(queue.slots[i].row_db);
+    }
+    free(queue.slots);
+    free(workers);
+    if (queue.drained) {
+        SDL_DestroyCondition(queue.drained);
+    }
+    if (queue.filled) {
+        SDL_DestroyCondition(queue.filled);
+    }
+    if (queue.mutex) {
+        SDL_DestroyMutex(queue.mutex);
+    }
+    return ok;
+}
+
+/*
+    offline_pass: Runs the whole source through the STFT, on this thread or
+    split across jobs threads, and hands every frame to the sinks.
+*/
+static bool offline_pass(OfflineSinks* sinks, const CliOptions* options, AudioSource* src,
+                         OfflineStft* stft, int jobs) {
+    if (jobs > 1) {
+        return offline_parallel(sinks, options, src, stft->fft_size, stft->hop, stft->batch, jobs);
+    }
+    offline_stft_reset(stft);
+    int count;
+    while ((count = offline_stft_next(stft, src)) > 0) {
+        for (int i = 0; i < count; i++) {
+            const size_t offset = (size_t)i * stft->bins;
+            offline_emit(sinks, stft->power + offset, stft->row_db + offset);
+        }
+    }
+    return true;
+}
+
+/*
+    offline_report: Prints the summary line of one pass to stderr.
+*/
+static void offline_report(const char* label, const OfflineSinks* sinks, int batch, int jobs, double seconds) {
+    const unsigned long long frames = sinks->frames;
+    const int keep = sinks->fft_size - sinks->hop;
+    double audio_seconds = (double)(frames * sinks->hop + (frames ? keep : 0)) / sinks->sample_rate;
+    fprintf(stderr, "%s: %llu frames (FFT %d, hop %d, batch %d) on %d thread%s, %.1f s of audio in %.3f s: "
+            "%.1fx real time, %.4f ms/frame\n",
+            label, frames, sinks->fft_size, sinks->hop, batch, jobs, jobs > 1 ? "s" : "",
+            audio_seconds, seconds, seconds > 0 ? audio_seconds / seconds : 0.0,
+            frames ? seconds * 1000.0 / frames : 0.0);
+}
+
+/*
+    offline_benchmark_batches: --benchmark without --fft-batch. Times the
+    same input at every power-of-two batch size up to half the maximum.
+*/
+static bool offline_benchmark_batches(OfflineSinks* sinks, const CliOptions* options, AudioSource* src, int jobs) {
+    int best_batch = 0;
+    double best_rate = 0;
+    for (int batch = 1; batch <= OFFLINE_MAX_BATCH / 2; batch *= 2) {
+        OfflineStft stft;
+        source_close(src);
+        if (!source_open(src, options->source, options->source_path, options->frequency,
+                         OFFLINE_SAMPLE_RATE, 1, options->duration) ||
+            !offline_stft_init(&stft, sinks->fft_size, sinks->hop, batch)) {
+            fprintf(stderr, "Failed to set up the batch %d benchmark.\n", batch);
+            return false;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "Benchmark batch %2d", batch);
+        sinks->frames = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        bool ok = offline_pass(sinks, options, src, &stft, jobs);
+        double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+        offline_stft_free(&stft);
+        if (!ok) {
+            return false;
+        }
+        offline_report(label, sinks, batch, jobs, seconds);
+        double rate = seconds > 0 ? sinks->frames / seconds : 0;
+        if (rate > best_rate) {
+            best_rate = rate;
+            best_batch = batch;
+        }
+    }
+    fprintf(stderr, "Fastest: batch %d, %.0f frames/s\n", best_batch, best_rate);
+    return true;
+}
+
+/*
+    offline_run: Headless and benchmark entry point. Streams the source
+    through the STFT and feeds the selected outputs: recording and
+    shared-memory rows for spectrum/spectrogram, a descriptor CSV on
+    stdout for features, the long-term PSD as CSV at the end for psd. A
+    benchmark run skips all outputs and, without --fft-batch, compares
+    batch sizes. File sources are split across --jobs threads (default:
+    one per logical core). The summary goes to stderr.
+*/
+int offline_run(const CliOptions* options) {
+    const bool rows = strcmp(options->mode, "spectrum") == 0 || strcmp(options->mode, "spectrogram") == 0;
+    OfflineSinks sinks = {0};
+    sinks.benchmark = options->benchmark;
+    sinks.features = strcmp(options->mode, "features") == 0;
+    sinks.psd_mode = strcmp(options->mode, "psd") == 0;
+    if (!rows && !sinks.features && !sinks.psd_mode) {
+        fprintf(stderr, "Mode '%s' needs the window.\n", options->mode);
+        return EXIT_FAILURE;
+    }
+
+    AudioSource src;
+    if (!source_open(&src, options->source, options->source_path, options->frequency,
+                     OFFLINE_SAMPLE_RATE, 1, options->duration)) {
+        fprintf(stderr, "Failed to open the input.\n");
+        return EXIT_FAILURE;
+    }
+    const int fft_size = options->fft_size ? options->fft_size : OFFLINE_DEFAULT_FFT_SIZE;
+    const int hop = options->hop ? options->hop : fft_size / 2;
+    const int batch = options->fft_batch ? options->fft_batch : OFFLINE_DEFAULT_BATCH;
+    if (hop > fft_size) {
+        fprintf(stderr, "--hop cannot exceed the FFT size.\n");
+        source_close(&src);
+        return EXIT_FAILURE;
+    }
+    int jobs = 1;
+    if (src.type == SOURCE_FILE) {
+        jobs = options->jobs ? options->jobs : SDL_GetNumLogicalCPUCores();
+        jobs = (jobs > OFFLINE_MAX_JOBS) ? OFFLINE_MAX_JOBS : (jobs < 1 ? 1 : jobs);
+    }
+    sinks.sample_rate = src.sample_rate;
+    sinks.fft_size = fft_size;
+    sinks.hop = hop;
+
+    if (options->benchmark && !options->fft_batch) {
+        bool ok = offline_benchmark_batches(&sinks, options, &src, jobs);
+        source_close(&src);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // The serial STFT is planned first even for parallel runs; see offline_parallel.
+    OfflineStft stft;
+    bool ok = offline_stft_init(&stft, fft_size, hop, batch);
+    if (!ok) {
+        fprintf(stderr, "Failed to set up the offline STFT.\n");
+        source_close(&src);
+        return EXIT_FAILURE;
+    }
+    const int bins = stft.bins;
+    const float bin_hz = (float)src.sample_rate / fft_size;
+
+    if (!options->benchmark) {
+        if (sinks.features) {
+            ok = descriptors_init(&sinks.desc, bins, bin_hz, OFFLINE_ROLLOFF_FRACTION);
+            printf("time_s,centroid_hz,spread_hz,rolloff_hz,flatness,crest,flux\n");
+        }
+        if (ok && sinks.psd_mode) {
+            ok = psd_init(&sinks.psd, bins, (float)src.sample_rate, stft.window_power, OFFLINE_PSD_TAU);
+        }
+        if (ok && rows && options->record_path) {
+            ok = recording_open(&sinks.rec, options->record_path, src.sample_rate, fft_size, hop, bins,
+                                options->record_format);
+            if (!ok) {
+                fprintf(stderr, "Failed to open %s for writing.\n", options->record_path);
+            }
+        }
+        if (ok && rows && options->shm_name) {
+            ok = shm_open_writer(&sinks.shm, options->shm_name, src.sample_rate, fft_size, hop, bins,
+                                 options->record_format);
+            if (!ok) {
+                fprintf(stderr, "Failed to create shared memory '%s'.\n", options->shm_name);
+            }
+        }
+        if (ok && options->fingerprint_path) {
+            if (!rows) {
+                fprintf(stderr, "--fingerprint needs --mode spectrum or spectrogram.\n");
+                ok = false;
+            } else if (!fingerprint_index_open(&sinks.fp_index, options->fingerprint_path)) {
+                fprintf(stderr, "Failed to open the fingerprint index %s.\n", options->fingerprint_path);
+                ok = false;
+            } else if ((int)sinks.fp_index.header->sample_rate != src.sample_rate ||
+                       (int)sinks.fp_index.header->hop != hop) {
+                fprintf(stderr, "The index was built at %u Hz with hop %u; this input is %d Hz with hop %d.\n",
+                        sinks.fp_index.header->sample_rate, sinks.fp_index.header->hop, src.sample_rate, hop);
+                ok = false;
+            }
+            if (ok) {
+                sinks.matcher = malloc(sizeof(FingerprintMatcher));
+                sinks.fp_hashes = malloc(sizeof(FingerprintHash) * FP_MAX_HASHES);
+                ok = sinks.matcher && sinks.fp_hashes &&
+                     fingerprint_init(&sinks.fp, bins, bin_hz, (float)hop / src.sample_rate);
+            }
+            if (ok) {
+                fingerprint_matcher_init(sinks.matcher, &sinks.fp_index, (float)hop / src.sample_rate);
+                printf("time_s,track,track_time_s,votes\n");
+            }
+        }
+        if (ok && options->trigger_path) {
+            if (!rows) {
+                fprintf(stderr, "--triggers needs --mode spectrum or spectrogram.\n");
+                ok = false;
+            } else {
+                ok = sinks.triggers_open = trigger_open(&sinks.triggers, options->trigger_path, bins, bin_hz,
+                                                        (double)hop / src.sample_rate);
+            }
+        }
+        if (ok && options->howl) {
+            ok = sinks.howl_open = howl_init(&sinks.howl, src.sample_rate, fft_size, hop, false);
+            if (!ok) {
+                fprintf(stderr, "Failed to set up the feedback detector.\n");
+            } else {
+                printf("time_s,frequency_hz,level_db,papr_db,phpr_db,slope_db_per_s,after_onset_ms\n");
+            }
+        }
+        if (ok && rows && options->pyramid_path) {
+            ok = pyramid_open(&sinks.pyramid, options->pyramid_path, src.sample_rate, fft_size, hop, bins,
+                              options->pyramid_reduce);
+            if (!ok) {
+                fprintf(stderr, "Failed to set up the pyramid in %s.\n", options->pyramid_path);
+            }
+        }
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (ok) {
+        ok = offline_pass(&sinks, options, &src, &stft, jobs);
+        if (!ok) {
+            fprintf(stderr, "The parallel STFT failed.\n");
+        }
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    if (ok && sinks.psd_mode && !options->benchmark) {
+        float* db = malloc(sizeof(float) * bins);
+        if (db) {
+            psd_read_db(&sinks.psd, PSD_LINEAR, db);
+            printf("frequency_hz,psd_db\n");
+            for (int k = 0; k < bins; k++) {
+                printf("%.3f,%.3f\n", k * bin_hz, db[k]);
+            }
+            free(db);
+        }
+    }
+    offline_report(options->benchmark ? "Benchmark" : "Analysed", &sinks, batch, jobs, seconds);
+
+    if (ok && sinks.matcher) {
+        // Close the last, partial voting window.
+        fingerprint_matcher_add(sinks.matcher, NULL, 0, sinks.matcher->window_end);
+        offline_print_match(&sinks);
+        const FingerprintMatcher* m = sinks.matcher;
+        const double hours = sinks.fp_index.header->seconds / 3600.0;
+        fprintf(stderr, "Fingerprint: %llu lookups, %llu hits in %.1f ms: %.0f lookups/s; "
+                "index of %u tracks (%.2f h) maps %.1f MiB, %.1f MiB per hour of reference\n",
+                m->lookups, m->hits, m->lookup_seconds * 1000.0,
+                m->lookup_seconds > 0 ? m->lookups / m->lookup_seconds : 0.0,
+                sinks.fp_index.header->track_count, hours, sinks.fp_index.bytes / 1048576.0,
+                hours > 0 ? sinks.fp_index.bytes / 1048576.0 / hours : 0.0);
+    }
+
+    if (ok && sinks.triggers_open) {
+        const TriggerEngine* t = &sinks.triggers;
+        const double per_hop = t->hops ? t->seconds / t->hops : 0.0;
+        fprintf(stderr, "Triggers: %d rules over %llu hops in %.1f ms: %.2f us/hop, %.1f ns/rule; "
+                "%llu events, %llu dropped\n", t->count, t->hops, t->seconds * 1000.0, per_hop * 1e6,
+                per_hop * 1e9 / t->count, t->events, t->dropped);
+    }
+    if (ok && sinks.howl_open) {
+        const HowlDetector* h = &sinks.howl;
+        fprintf(stderr, "Howl: %llu frames every %.1f ms in %.1f ms: %.2f us/frame, alerts after %d frames\n",
+                h->frames, h->hop_seconds * 1000.0, h->seconds * 1000.0,
+                h->frames ? h->seconds * 1e6 / h->frames : 0.0, h->settle_frames + h->persist_frames);
+    }
+    if (sinks.pyramid.column && !pyramid_close(&sinks.pyramid)) {
+        fprintf(stderr, "Failed to write every pyramid tile to %s.\n", options->pyramid_path);
+        ok = false;
+    }
+    recording_close(&sinks.rec);
+    shm_close(&sinks.shm);
+    fingerprint_free(&sinks.fp);
+    free(sinks.matcher);
+    free(sinks.fp_hashes);
+    fingerprint_index_close(&sinks.fp_index);
+    trigger_close(&sinks.triggers);
+    howl_free(&sinks.howl);
+    psd_free(&sinks.psd);
+    descriptors_free(&sinks.desc);
+    offline_stft_free(&stft);
+    source_close(&src);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
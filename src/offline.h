@@ -0,0 +1,60 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+#include "cli.h"
+#include "source.h"
+
+// Analysis parameters for offline runs that do not set them.
+#define OFFLINE_DEFAULT_FFT_SIZE 4096
+#define OFFLINE_SAMPLE_RATE 44100
+
+// Upper bound on threads splitting one file.
+#define OFFLINE_MAX_JOBS 64
+
+// Windows transformed per FFTW call, and the largest batch accepted.
+#define OFFLINE_DEFAULT_BATCH 8
+#define OFFLINE_MAX_BATCH 64
+
+/*
+    OfflineStft: Hann-windowed real FFT over consecutive frames, producing
+    bin powers and the same dB bar levels the window records. Up to batch
+    consecutive windows are gathered into one contiguous buffer and
+    transformed by a single fftwf_plan_many_dft_r2c call, then levelled in
+    one pass, which amortises the per-call overhead on small FFT sizes.
+    FFTW may plan a batch with other codelets than a single window, so
+    rows agree with batch 1 to float rounding; --self-test measures it. It
+    also keeps the sliding mono input, so offline_stft_next can step
+    through a source. Every instance owns its plan and buffers and can be
+    used by one thread without locking once created.
+*/
+typedef struct {
+    int fft_size;
+    int hop;
+    int bins;
+    int batch;              // Windows per FFT call.
+    int span;               // Samples covered by a full batch.
+    double window_power;    // Sum of squared window weights.
+    float* window;
+    float* input;           // batch x fft_size windowed samples.
+    fftwf_complex* spectrum;// batch x bins.
+    fftwf_plan plan;        // Batched r2c over every window.
+    float* power;           // batch x bins.
+    float* row_db;          // batch x bins.
+
+    float* frame;           // Sliding mono input, span samples.
+    float* scratch;         // Interleaved read buffer, span frames.
+    int scratch_channels;
+    bool primed;            // frame holds fft_size - hop samples from the last step.
+} OfflineStft;
+
+bool offline_stft_init(OfflineStft* stft, int fft_size, int hop, int batch);
+void offline_stft_reset(OfflineStft* stft);
+int offline_stft_next(OfflineStft* stft, AudioSource* src);
+void offline_stft_free(OfflineStft* stft);
+
+int offline_run(const CliOptions* options);
+
+#endif
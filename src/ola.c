@@ -0,0 +1,105 @@
+#include "ola.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+    ola_init: Allocates the buffers and creates the cached c2r plan.
+    fft_size must be a multiple of hop.
+*/
+bool ola_init(OlaState* ola, int fft_size, int hop) {
+    memset(ola, 0, sizeof(*ola));
+    ola->fft_size = fft_size;
+    ola->hop = hop;
+    const int bins = fft_size / 2 + 1;
+
+    ola->spectrum = fftwf_alloc_complex(bins);
+    ola->frame = fftwf_alloc_real(fft_size);
+    ola->window = malloc(sizeof(float) * fft_size);
+    ola->norm = malloc(sizeof(float) * hop);
+    ola->accumulator = calloc(fft_size, sizeof(float));
+    ola->output = calloc(hop, sizeof(float));
+    if (!ola->spectrum || !ola->frame || !ola->window || !ola->norm ||
+        !ola->accumulator || !ola->output) {
+        ola_free(ola);
+        return false;
+    }
+
+    for (int i = 0; i < fft_size; i++) {
+        ola->window[i] = 0.5f * (1 - cosf(2 * (float)M_PI * i / (fft_size - 1)));
+    }
+    for (int i = 0; i < hop; i++) {
+        double sum = 0.0;
+        for (int j = i; j < fft_size; j += hop) {
+            sum += (double)ola->window[j] * ola->window[j];
+        }
+        ola->norm[i] = (float)(1.0 / fmax(sum, 1e-6));
+    }
+
+    ola->plan = fftwf_plan_dft_c2r_1d(fft_size, ola->spectrum, ola->frame, FFTW_MEASURE);
+    if (!ola->plan) {
+        ola_free(ola);
+        return false;
+    }
+    return true;
+}
+
+/*
+    ola_process: Adds one frame and returns the hop samples it completed.
+    The returned buffer stays valid until the next call.
+*/
+const float* ola_process(OlaState* ola, const fftwf_complex* spectrum) {
+    const int n = ola->fft_size;
+    const int hop = ola->hop;
+    memcpy(ola->spectrum, spectrum, sizeof(fftwf_complex) * (n / 2 + 1));
+    fftwf_execute(ola->plan);
+
+    // c2r is unnormalised; fold the 1/n into the synthesis window.
+    const float scale = 1.0f / n;
+    for (int i = 0; i < n; i++) {
+        ola->accumulator[i] += ola->frame[i] * ola->window[i] * scale;
+    }
+    for (int i = 0; i < hop; i++) {
+        ola->output[i] = ola->accumulator[i] * ola->norm[i];
+    }
+    memmove(ola->accumulator, &ola->accumulator[hop], sizeof(float) * (n - hop));
+    memset(&ola->accumulator[n - hop], 0, sizeof(float) * hop);
+    return ola->output;
+}
+
+/*
+    ola_latency_samples: Delay from an input sample entering a frame to its
+    resynthesised copy leaving the accumulator, excluding hop buffering.
+*/
+int ola_latency_samples(const OlaState* ola) {
+    return ola->fft_size - ola->hop;
+}
+
+/*
+    ola_reset: Discards pending overlaps, e.g. when resynthesis restarts
+    after frames were skipped.
+*/
+void ola_reset(OlaState* ola) {
+    memset(ola->accumulator, 0, sizeof(float) * ola->fft_size);
+}
+
+/*
+    ola_free: Destroys the plan and releases all buffers.
+*/
+void ola_free(OlaState* ola) {
+    if (ola->plan) {
+        fftwf_destroy_plan(ola->plan);
+    }
+    fftwf_free(ola->spectrum);
+    fftwf_free(ola->frame);
+    free(ola->window);
+    free(ola->norm);
+    free(ola->accumulator);
+    free(ola->output);
+    memset(ola, 0, sizeof(*ola));
+}
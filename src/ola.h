@@ -0,0 +1,34 @@
+#ifndef OLA_H
+#define OLA_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+/*
+    OlaState: Weighted overlap-add resynthesis of a modified STFT.
+
+    Each spectrum is inverse transformed with a cached c2r plan, multiplied
+    by the synthesis window (the same Hann as the analysis) and added into
+    an accumulator. After every frame the first `hop` samples are final and
+    are divided by the summed squared window at their position, which makes
+    an unmodified spectrum reconstruct the input exactly.
+*/
+typedef struct {
+    int fft_size;
+    int hop;
+    fftwf_complex* spectrum;  // Copy of the input, consumed by the c2r.
+    float* frame;
+    fftwf_plan plan;
+    float* window;
+    float* norm;              // hop entries of 1 / sum(w^2) at each phase.
+    float* accumulator;       // fft_size samples still receiving overlaps.
+    float* output;            // hop finished samples from the last frame.
+} OlaState;
+
+bool ola_init(OlaState* ola, int fft_size, int hop);
+const float* ola_process(OlaState* ola, const fftwf_complex* spectrum);
+int ola_latency_samples(const OlaState* ola);
+void ola_reset(OlaState* ola);
+void ola_free(OlaState* ola);
+
+#endif
@@ -0,0 +1,230 @@
+#include "plugin.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The draw API hands plugin arrays straight to SDL.
+_Static_assert(sizeof(AvRect) == sizeof(SDL_FRect), "AvRect must match SDL_FRect");
+_Static_assert(sizeof(AvPoint) == sizeof(SDL_FPoint), "AvPoint must match SDL_FPoint");
+
+/*
+    plugin_host_init: Records the analysis parameters plugins are told
+    about when they are created.
+*/
+void plugin_host_init(PluginHost* host, int sample_rate, int fft_size, int hop, int bins) {
+    memset(host, 0, sizeof(*host));
+    host->host.struct_size = sizeof(AvHostInfo);
+    host->host.abi_version = AV_PLUGIN_ABI_VERSION;
+    host->host.sample_rate = sample_rate;
+    host->host.fft_size = fft_size;
+    host->host.hop = hop;
+    host->host.bins = bins;
+}
+
+/*
+    plugin_describe_stage: "budget N ms" for an enabled stage, "off" otherwise.
+*/
+static void plugin_describe_stage(char* out, size_t size, const PluginStage* stage) {
+    if (stage->enabled) {
+        snprintf(out, size, "budget %.2f ms", stage->budget_ms);
+    } else {
+        snprintf(out, size, "off");
+    }
+}
+
+/*
+    plugin_load: Loads the DLL named by spec, PATH[@MS] where MS overrides
+    both stage budgets, checks its ABI version and creates its instance.
+*/
+bool plugin_load(PluginHost* host, const char* spec) {
+    if (host->count == PLUGIN_MAX) {
+        fprintf(stderr, "At most %d plugins can be loaded.\n", PLUGIN_MAX);
+        return false;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s", spec);
+    float analysis_budget = PLUGIN_ANALYSIS_BUDGET_MS;
+    float render_budget = PLUGIN_RENDER_BUDGET_MS;
+    char* at = strrchr(path, '@');
+    if (at) {
+        char* end = NULL;
+        float budget = strtof(at + 1, &end);
+        if (end != at + 1 && *end == '\0' && budget > 0.0f) {
+            *at = '\0';
+            analysis_budget = render_budget = budget;
+        }
+    }
+
+    Plugin* plugin = &host->plugins[host->count];
+    memset(plugin, 0, sizeof(*plugin));
+    plugin->object = SDL_LoadObject(path);
+    if (!plugin->object) {
+        fprintf(stderr, "Failed to load the plugin %s: %s\n", path, SDL_GetError());
+        return false;
+    }
+    AvPluginEntry entry = (AvPluginEntry)SDL_LoadFunction(plugin->object, AV_PLUGIN_ENTRY_NAME);
+    const AvPluginDescriptor* desc = entry ? entry() : NULL;
+    const char* problem = NULL;
+    if (!desc) {
+        problem = "no " AV_PLUGIN_ENTRY_NAME " export";
+    } else if (desc->abi_version != AV_PLUGIN_ABI_VERSION) {
+        problem = "built for another plugin ABI version";
+    } else if (desc->struct_size < AV_PLUGIN_DESCRIPTOR_MIN_SIZE || !desc->create || !desc->destroy) {
+        problem = "incomplete descriptor";
+    } else {
+        // Copy only what the plugin declared; later fields stay NULL.
+        memcpy(&plugin->desc, desc, SDL_min((size_t)desc->struct_size, sizeof(AvPluginDescriptor)));
+        plugin->instance = plugin->desc.create(&host->host);
+        problem = plugin->instance ? NULL : "create failed";
+    }
+    if (problem) {
+        fprintf(stderr, "Failed to load the plugin %s: %s.\n", path, problem);
+        SDL_UnloadObject(plugin->object);
+        memset(plugin, 0, sizeof(*plugin));
+        return false;
+    }
+    desc = &plugin->desc;
+    snprintf(plugin->name, sizeof(plugin->name), "%s", desc->name ? desc->name : path);
+    plugin->analysis.enabled = (desc->stages & AV_PLUGIN_ANALYSIS) && desc->analyse;
+    plugin->analysis.budget_ms = analysis_budget;
+    plugin->render.enabled = (desc->stages & AV_PLUGIN_RENDER) && desc->render;
+    plugin->render.budget_ms = render_budget;
+    host->count++;
+    char analysis[32];
+    char render[32];
+    plugin_describe_stage(analysis, sizeof(analysis), &plugin->analysis);
+    plugin_describe_stage(render, sizeof(render), &plugin->render);
+    printf("Plugin %s: analysis %s, render %s\n", plugin->name, analysis, render);
+    return true;
+}
+
+/*
+    plugin_host_wants: Whether any plugin still runs the given stage.
+*/
+bool plugin_host_wants(const PluginHost* host, uint32_t stage) {
+    for (int i = 0; i < host->count; i++) {
+        const Plugin* plugin = &host->plugins[i];
+        if (stage == AV_PLUGIN_ANALYSIS ? plugin->analysis.enabled : plugin->render.enabled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    plugin_charge: Books one call against its stage and disables the stage
+    after PLUGIN_STRIKES overruns in a row or one wildly late call.
+*/
+static void plugin_charge(Plugin* plugin, PluginStage* stage, const char* stage_name, float ms) {
+    stage->calls++;
+    stage->cost_ms += 0.1f * (ms - stage->cost_ms);
+    stage->worst_ms = SDL_max(stage->worst_ms, ms);
+    if (ms <= stage->budget_ms) {
+        stage->strikes = 0;
+        return;
+    }
+    stage->overruns++;
+    stage->strikes++;
+    if (stage->strikes >= PLUGIN_STRIKES || ms > PLUGIN_HARD_FACTOR * stage->budget_ms) {
+        stage->enabled = false;
+        fprintf(stderr, "Plugin %s: %s disabled after taking %.2f ms (budget %.2f ms, %llu of %llu calls over).\n",
+                plugin->name, stage_name, ms, stage->budget_ms, stage->overruns, stage->calls);
+    }
+}
+
+/*
+    plugin_host_analyse: Hands one hop to every enabled analysis stage.
+    Returns the total time spent in plugins, in ms.
+*/
+float plugin_host_analyse(PluginHost* host, const AvAnalysisFrame* frame) {
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    float total = 0.0f;
+    for (int i = 0; i < host->count; i++) {
+        Plugin* plugin = &host->plugins[i];
+        if (!plugin->analysis.enabled) {
+            continue;
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        plugin->desc.analyse(plugin->instance, frame);
+        float ms = (float)((SDL_GetPerformanceCounter() - start) * 1000.0 / frequency);
+        plugin_charge(plugin, &plugin->analysis, "analysis", ms);
+        total += ms;
+    }
+    return total;
+}
+
+static void plugin_color(SDL_Renderer* renderer, uint32_t rgba) {
+    SDL_SetRenderDrawColor(renderer, (Uint8)(rgba >> 24), (Uint8)(rgba >> 16), (Uint8)(rgba >> 8), (Uint8)rgba);
+}
+
+static void plugin_fill_rects(void* context, const AvRect* rects, int32_t count, uint32_t rgba) {
+    if (rects && count > 0) {
+        plugin_color(context, rgba);
+        SDL_RenderFillRects(context, (const SDL_FRect*)rects, count);
+    }
+}
+
+static void plugin_lines(void* context, const AvPoint* points, int32_t count, uint32_t rgba) {
+    if (points && count > 1) {
+        plugin_color(context, rgba);
+        SDL_RenderLines(context, (const SDL_FPoint*)points, count);
+    }
+}
+
+static void plugin_points(void* context, const AvPoint* points, int32_t count, uint32_t rgba) {
+    if (points && count > 0) {
+        plugin_color(context, rgba);
+        SDL_RenderPoints(context, (const SDL_FPoint*)points, count);
+    }
+}
+
+static void plugin_text(void* context, float x, float y, const char* text, uint32_t rgba) {
+    if (text) {
+        plugin_color(context, rgba);
+        SDL_RenderDebugText(context, x, y, text);
+    }
+}
+
+/*
+    plugin_host_render: Lets every enabled render stage draw, in load
+    order, onto the current render target. Returns the total time spent
+    in plugins, in ms.
+*/
+float plugin_host_render(PluginHost* host, SDL_Renderer* renderer, const AvRenderFrame* frame) {
+    const AvDrawApi draw = {
+        .struct_size = sizeof(AvDrawApi),
+        .context = renderer,
+        .fill_rects = plugin_fill_rects,
+        .lines = plugin_lines,
+        .points = plugin_points,
+        .text = plugin_text,
+    };
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    float total = 0.0f;
+    for (int i = 0; i < host->count; i++) {
+        Plugin* plugin = &host->plugins[i];
+        if (!plugin->render.enabled) {
+            continue;
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        plugin->desc.render(plugin->instance, frame, &draw);
+        float ms = (float)((SDL_GetPerformanceCounter() - start) * 1000.0 / frequency);
+        plugin_charge(plugin, &plugin->render, "render", ms);
+        total += ms;
+    }
+    return total;
+}
+
+/*
+    plugin_host_close: Destroys the instances and unloads the DLLs, last
+    loaded first. Both threads that call plugins must have stopped.
+*/
+void plugin_host_close(PluginHost* host) {
+    for (int i = host->count - 1; i >= 0; i--) {
+        Plugin* plugin = &host->plugins[i];
+        plugin->desc.destroy(plugin->instance);
+        SDL_UnloadObject(plugin->object);
+    }
+    memset(host, 0, sizeof(*host));
+}
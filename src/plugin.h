@@ -0,0 +1,71 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "plugin_abi.h"
+
+// Most plugins loaded at once.
+#define PLUGIN_MAX 8
+
+// Default time budgets: per hop for analysis, per frame for rendering.
+#define PLUGIN_ANALYSIS_BUDGET_MS 1.0f
+#define PLUGIN_RENDER_BUDGET_MS 2.0f
+
+// A stage is disabled after this many consecutive overruns, or at once
+// by a single call this many times over its budget.
+#define PLUGIN_STRIKES 3
+#define PLUGIN_HARD_FACTOR 10.0f
+
+#define PLUGIN_NAME_BYTES 64
+
+/*
+    PluginStage: Timing of one stage of one plugin. Only the thread that
+    runs the stage writes it.
+*/
+typedef struct {
+    bool enabled;
+    float budget_ms;
+    float cost_ms;             // Smoothed.
+    float worst_ms;
+    int strikes;               // Consecutive overruns.
+    unsigned long long calls;
+    unsigned long long overruns;
+} PluginStage;
+
+/*
+    Plugin: A loaded DLL and the instance it created.
+*/
+typedef struct {
+    SDL_SharedObject* object;
+    AvPluginDescriptor desc;   // The plugin's descriptor; fields it does not know are NULL.
+    void* instance;
+    char name[PLUGIN_NAME_BYTES];
+    PluginStage analysis;      // Processing thread.
+    PluginStage render;        // Main thread.
+} Plugin;
+
+/*
+    PluginHost: The plugins named on the command line, in load order.
+    Analysis plugins see every hop; render plugins draw the plugin view,
+    layered in load order. Calls are timed against their stage's budget
+    and a stage that keeps overrunning is switched off, so one slow
+    plugin cannot stall the pipeline or the window for long. A call in
+    progress cannot be interrupted: the budget bounds repeat offenders,
+    not a plugin that never returns.
+*/
+typedef struct {
+    Plugin plugins[PLUGIN_MAX];
+    int count;
+    AvHostInfo host;
+} PluginHost;
+
+void plugin_host_init(PluginHost* host, int sample_rate, int fft_size, int hop, int bins);
+bool plugin_load(PluginHost* host, const char* spec);
+bool plugin_host_wants(const PluginHost* host, uint32_t stage);
+float plugin_host_analyse(PluginHost* host, const AvAnalysisFrame* frame);
+float plugin_host_render(PluginHost* host, SDL_Renderer* renderer, const AvRenderFrame* frame);
+void plugin_host_close(PluginHost* host);
+
+#endif
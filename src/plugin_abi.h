@@ -0,0 +1,133 @@
+#ifndef PLUGIN_ABI_H
+#define PLUGIN_ABI_H
+
+/*
+    Plugin ABI: the only header a plugin DLL needs. It uses plain C types
+    so plugins can be built with any compiler against any SDL version.
+
+    A plugin exports one function, av_plugin_entry, returning a static
+    AvPluginDescriptor. The host calls create once at startup, then
+    analyse on the processing thread for every hop and render on the main
+    thread for every frame of the plugin view; the two may run at the
+    same time. Every pointer a call receives is valid only during that
+    call and is read-only. A call that overruns its time budget too often
+    disables that stage of the plugin for the rest of the run.
+
+    Compatibility: AV_PLUGIN_ABI_VERSION changes only when existing fields
+    change meaning. New fields are appended to the structs, whose
+    struct_size tells either side which fields the other knows; the host
+    treats descriptor fields past a plugin's struct_size as NULL. The
+    padding a 64-bit compiler would insert is spelled out as reserved
+    fields, so compilers with the same pointer width agree on every
+    offset; 32- and 64-bit builds differ wherever a pointer comes first.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AV_PLUGIN_ABI_VERSION 1
+#define AV_PLUGIN_ENTRY_NAME "av_plugin_entry"
+
+#ifdef _WIN32
+#define AV_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define AV_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+// Stages a plugin implements (AvPluginDescriptor.stages).
+#define AV_PLUGIN_ANALYSIS 1u
+#define AV_PLUGIN_RENDER 2u
+
+/*
+    AvHostInfo: The analysis the host runs, passed to create.
+*/
+typedef struct {
+    uint32_t struct_size;
+    uint32_t abi_version;
+    int32_t sample_rate;
+    int32_t fft_size;
+    int32_t hop;
+    int32_t bins;
+} AvHostInfo;
+
+/*
+    AvAnalysisFrame: One hop. row_db holds 10 * log10 of each bin's
+    magnitude, the scale the spectrogram and recordings use.
+*/
+typedef struct {
+    uint32_t struct_size;
+    uint32_t reserved0;         // Reserved fields are zero.
+    uint64_t hop_index;
+    double time_seconds;
+    const float* samples;       // Mono samples new in this hop, oldest first.
+    int32_t sample_count;
+    int32_t reserved1;
+    const float* power;         // bins values.
+    const float* row_db;        // bins values.
+    int32_t bins;
+    int32_t reserved2;
+} AvAnalysisFrame;
+
+/*
+    AvRect, AvPoint: Pixel geometry; layout-compatible with SDL_FRect and
+    SDL_FPoint, so the host passes batches through without copying.
+*/
+typedef struct {
+    float x, y, w, h;
+} AvRect;
+
+typedef struct {
+    float x, y;
+} AvPoint;
+
+/*
+    AvDrawApi: Batch drawing. Colours are 0xRRGGBBAA. Each call submits a
+    whole array, so a plugin should gather its shapes and draw them in a
+    few calls rather than one call per shape.
+*/
+typedef struct {
+    uint32_t struct_size;
+    uint32_t reserved;          // Zero.
+    void* context;
+    void (*fill_rects)(void* context, const AvRect* rects, int32_t count, uint32_t rgba);
+    void (*lines)(void* context, const AvPoint* points, int32_t count, uint32_t rgba);  // A polyline.
+    void (*points)(void* context, const AvPoint* points, int32_t count, uint32_t rgba);
+    void (*text)(void* context, float x, float y, const char* text, uint32_t rgba);
+} AvDrawApi;
+
+/*
+    AvRenderFrame: The newest spectrogram column and the view to fill.
+*/
+typedef struct {
+    uint32_t struct_size;
+    uint32_t reserved0;         // Reserved fields are zero.
+    uint64_t column_index;      // Hop the column came from; repeats when no hop arrived.
+    const float* column_db;     // bins values, as AvAnalysisFrame.row_db.
+    int32_t bins;
+    int32_t width;              // Output size in pixels.
+    int32_t height;
+    int32_t reserved1;
+    double time_seconds;
+} AvRenderFrame;
+
+/*
+    AvPluginDescriptor: What the plugin exports. Unused stages may be NULL.
+*/
+typedef struct {
+    uint32_t struct_size;
+    uint32_t abi_version;       // AV_PLUGIN_ABI_VERSION the plugin was built against.
+    const char* name;
+    uint32_t stages;            // AV_PLUGIN_ANALYSIS and/or AV_PLUGIN_RENDER.
+    uint32_t reserved;          // Zero.
+    void* (*create)(const AvHostInfo* host);                // NULL return refuses to load.
+    void (*destroy)(void* instance);
+    void (*analyse)(void* instance, const AvAnalysisFrame* frame);
+    void (*render)(void* instance, const AvRenderFrame* frame, const AvDrawApi* draw);
+} AvPluginDescriptor;
+
+// Smallest descriptor the host accepts: ABI version 1, which ends at render.
+#define AV_PLUGIN_DESCRIPTOR_MIN_SIZE (offsetof(AvPluginDescriptor, render) + sizeof(void (*)(void)))
+
+typedef const AvPluginDescriptor* (*AvPluginEntry)(void);
+
+#endif
@@ -0,0 +1,1104 @@
+#include <SDL3/SDL.h>
+
+#include "preset.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "offline.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PRESET_SSE2 1
+#endif
+
+// Column counts compared by --preset-bench when --preset-columns is not given.
+#define PRESET_BENCH_SIZES 3
+
+enum {
+    PRESET_NODE_NUMBER,
+    PRESET_NODE_INPUT,
+    PRESET_NODE_NAME,
+    PRESET_NODE_OP
+};
+
+typedef enum {
+    PRESET_OP_ADD,
+    PRESET_OP_SUB,
+    PRESET_OP_MUL,
+    PRESET_OP_DIV,
+    PRESET_OP_MOD,
+    PRESET_OP_POW,
+    PRESET_OP_MIN,
+    PRESET_OP_MAX,
+    PRESET_OP_LT,
+    PRESET_OP_GT,
+    PRESET_OP_LE,
+    PRESET_OP_GE,
+    PRESET_OP_EQ,
+    PRESET_OP_NE,
+    PRESET_OP_NEG,
+    PRESET_OP_ABS,
+    PRESET_OP_SQRT,
+    PRESET_OP_FLOOR,
+    PRESET_OP_SIN,
+    PRESET_OP_COS,
+    PRESET_OP_EXP,
+    PRESET_OP_LOG,
+    PRESET_OP_IF,
+    PRESET_OP_CLAMP,
+    PRESET_OP_MIX,
+    PRESET_OPS
+} PresetOpCode;
+
+static const int preset_arity[PRESET_OPS] = {
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3
+};
+
+static const struct {
+    const char* name;
+    PresetOpCode op;
+} preset_functions[] = {
+    {"sin", PRESET_OP_SIN}, {"cos", PRESET_OP_COS}, {"abs", PRESET_OP_ABS}, {"sqrt", PRESET_OP_SQRT},
+    {"floor", PRESET_OP_FLOOR}, {"exp", PRESET_OP_EXP}, {"log", PRESET_OP_LOG}, {"pow", PRESET_OP_POW},
+    {"min", PRESET_OP_MIN}, {"max", PRESET_OP_MAX}, {"if", PRESET_OP_IF}, {"clamp", PRESET_OP_CLAMP},
+    {"mix", PRESET_OP_MIX}
+};
+
+// Names in slot order: scalar inputs, vector inputs, outputs.
+static const char* preset_builtin_names[] = {
+    "time", "frame", "n", "bass", "mid", "treb", "vol",
+    "i", "freq", "db", "level", "prev",
+    "x", "y", "width", "height", "hue", "sat", "light"
+};
+
+#define PRESET_FIRST_OUTPUT (PRESET_SCALAR_INPUTS + PRESET_VECTOR_INPUTS)
+#define PRESET_BUILTINS (PRESET_FIRST_OUTPUT + PRESET_OUTPUTS)
+
+// Compiled ahead of every preset, so an output it leaves alone draws like the spectrum view.
+static const char preset_defaults[] =
+    "x = i / n; width = 1 / n; y = 0; height = level * 0.8\n"
+    "hue = 360 * i / n; sat = 1; light = 0.5\n";
+
+/*
+    preset_apply: The meaning of every operation, shared by constant
+    folding, the frame code, the scalar kernels and the interpreter.
+    Comparisons give 1 or 0; min and max follow the SSE2 instructions
+    when an operand is NaN.
+*/
+static inline float preset_apply(int op, float a, float b, float c) {
+    switch (op) {
+    case PRESET_OP_ADD: return a + b;
+    case PRESET_OP_SUB: return a - b;
+    case PRESET_OP_MUL: return a * b;
+    case PRESET_OP_DIV: return a / b;
+    case PRESET_OP_MOD: return b != 0.0f ? a - b * floorf(a / b) : 0.0f;
+    case PRESET_OP_POW: return powf(a, b);
+    case PRESET_OP_MIN: return a < b ? a : b;
+    case PRESET_OP_MAX: return a > b ? a : b;
+    case PRESET_OP_LT: return a < b ? 1.0f : 0.0f;
+    case PRESET_OP_GT: return a > b ? 1.0f : 0.0f;
+    case PRESET_OP_LE: return a <= b ? 1.0f : 0.0f;
+    case PRESET_OP_GE: return a >= b ? 1.0f : 0.0f;
+    case PRESET_OP_EQ: return a == b ? 1.0f : 0.0f;
+    case PRESET_OP_NE: return a != b ? 1.0f : 0.0f;
+    case PRESET_OP_NEG: return -a;
+    case PRESET_OP_ABS: return fabsf(a);
+    case PRESET_OP_SQRT: return sqrtf(a);
+    case PRESET_OP_FLOOR: return floorf(a);
+    case PRESET_OP_SIN: return sinf(a);
+    case PRESET_OP_COS: return cosf(a);
+    case PRESET_OP_EXP: return expf(a);
+    case PRESET_OP_LOG: return logf(a);
+    case PRESET_OP_IF: return a != 0.0f ? b : c;
+    case PRESET_OP_CLAMP: {
+        const float low = a > b ? a : b;
+        return low < c ? low : c;
+    }
+    case PRESET_OP_MIX: return a + (b - a) * c;
+    }
+    return 0.0f;
+}
+
+/*
+    PresetParser: State of parsing one source text into the program.
+*/
+typedef struct {
+    PresetProgram* program;
+    const char* path;
+    const char* cursor;
+    int line;
+    int16_t bound[PRESET_MAX_NAMES];  // Node last assigned to each name, or -1.
+    int depth;                        // Nesting of the expression being parsed.
+    bool failed;
+} PresetParser;
+
+static int preset_fail(PresetParser* p, const char* format, ...) {
+    if (!p->failed) {
+        va_list args;
+        va_start(args, format);
+        fprintf(stderr, "%s:%d: ", p->path, p->line);
+        vfprintf(stderr, format, args);
+        fprintf(stderr, ".\n");
+        va_end(args);
+    }
+    p->failed = true;
+    return -1;
+}
+
+/*
+    preset_skip: Skips blanks and comments, stopping at a newline, which
+    ends a statement.
+*/
+static void preset_skip(PresetParser* p) {
+    for (;;) {
+        while (*p->cursor == ' ' || *p->cursor == '\t' || *p->cursor == '\r') {
+            p->cursor++;
+        }
+        if (*p->cursor == '#' || (p->cursor[0] == '/' && p->cursor[1] == '/')) {
+            while (*p->cursor && *p->cursor != '\n') {
+                p->cursor++;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+static bool preset_accept(PresetParser* p, const char* token) {
+    preset_skip(p);
+    const size_t length = strlen(token);
+    if (strncmp(p->cursor, token, length) != 0) {
+        return false;
+    }
+    // "<" must not take the first half of "<=", nor "=" of "==".
+    if (length == 1 && strchr("<>=!", token[0]) && p->cursor[1] == '=') {
+        return false;
+    }
+    p->cursor += length;
+    return true;
+}
+
+static bool preset_name(PresetParser* p, char* name) {
+    preset_skip(p);
+    if (!isalpha((unsigned char)*p->cursor) && *p->cursor != '_') {
+        return false;
+    }
+    int length = 0;
+    while (isalnum((unsigned char)*p->cursor) || *p->cursor == '_') {
+        if (length < PRESET_NAME_BYTES - 1) {
+            name[length++] = *p->cursor;
+        }
+        p->cursor++;
+    }
+    name[length] = '\0';
+    return true;
+}
+
+static int preset_find(const PresetProgram* program, const char* name) {
+    for (int i = 0; i < program->name_count; i++) {
+        if (strcmp(program->names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+    preset_resolve: Follows names to the node whose value they hold.
+*/
+static int preset_resolve(const PresetProgram* program, int node) {
+    while (program->nodes[node].kind == PRESET_NODE_NAME) {
+        node = program->nodes[node].target;
+    }
+    return node;
+}
+
+static int preset_node(PresetParser* p, int kind) {
+    if (p->program->node_count == PRESET_MAX_NODES) {
+        return preset_fail(p, "more than %d expression nodes", PRESET_MAX_NODES);
+    }
+    const int index = p->program->node_count++;
+    PresetNode* node = &p->program->nodes[index];
+    memset(node, 0, sizeof(*node));
+    node->kind = (uint8_t)kind;
+    node->slot = node->target = -1;
+    return index;
+}
+
+static int preset_number(PresetParser* p, float value) {
+    const int index = preset_node(p, PRESET_NODE_NUMBER);
+    if (index >= 0) {
+        p->program->nodes[index].number = value;
+        p->program->nodes[index].uniform = true;
+    }
+    return index;
+}
+
+/*
+    preset_operation: Adds op applied to args, folding it to a number when
+    every argument already is one.
+*/
+static int preset_operation(PresetParser* p, int op, const int* args) {
+    PresetProgram* program = p->program;
+    bool uniform = true;
+    bool constant = true;
+    float values[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < preset_arity[op]; i++) {
+        if (args[i] < 0) {
+            return -1;
+        }
+        const PresetNode* arg = &program->nodes[preset_resolve(program, args[i])];
+        uniform &= arg->uniform;
+        constant &= (arg->kind == PRESET_NODE_NUMBER);
+        values[i] = arg->number;
+    }
+    if (constant) {
+        return preset_number(p, preset_apply(op, values[0], values[1], values[2]));
+    }
+    const int index = preset_node(p, PRESET_NODE_OP);
+    if (index >= 0) {
+        PresetNode* node = &program->nodes[index];
+        node->op = (uint8_t)op;
+        node->uniform = uniform;
+        for (int i = 0; i < preset_arity[op]; i++) {
+            node->args[i] = (int16_t)args[i];
+        }
+    }
+    return index;
+}
+
+static int preset_expression(PresetParser* p);
+static int preset_unary(PresetParser* p);
+
+/*
+    preset_primary: A number, a name, a function call or a parenthesised
+    expression.
+*/
+static int preset_primary(PresetParser* p) {
+    preset_skip(p);
+    if (isdigit((unsigned char)*p->cursor) || *p->cursor == '.') {
+        char* end;
+        const float value = strtof(p->cursor, &end);
+        if (end == p->cursor) {
+            return preset_fail(p, "bad number");
+        }
+        p->cursor = end;
+        return preset_number(p, value);
+    }
+    if (preset_accept(p, "(")) {
+        const int node = preset_expression(p);
+        if (node >= 0 && !preset_accept(p, ")")) {
+            return preset_fail(p, "missing ')'");
+        }
+        return node;
+    }
+    char name[PRESET_NAME_BYTES];
+    if (!preset_name(p, name)) {
+        return preset_fail(p, *p->cursor && *p->cursor != '\n' ? "unexpected '%c'" : "missing operand",
+                           *p->cursor);
+    }
+    if (preset_accept(p, "(")) {
+        int op = -1;
+        for (size_t f = 0; f < sizeof(preset_functions) / sizeof(preset_functions[0]); f++) {
+            op = strcmp(name, preset_functions[f].name) == 0 ? (int)preset_functions[f].op : op;
+        }
+        if (op < 0) {
+            return preset_fail(p, "unknown function '%s'", name);
+        }
+        int args[3] = {-1, -1, -1};
+        for (int i = 0; i < preset_arity[op]; i++) {
+            if (i > 0 && !preset_accept(p, ",")) {
+                return preset_fail(p, "%s takes %d arguments", name, preset_arity[op]);
+            }
+            args[i] = preset_expression(p);
+            if (args[i] < 0) {
+                return -1;
+            }
+        }
+        if (!preset_accept(p, ")")) {
+            return preset_fail(p, "%s takes %d arguments", name, preset_arity[op]);
+        }
+        return preset_operation(p, op, args);
+    }
+    const int slot = preset_find(p->program, name);
+    if (slot < 0 || p->bound[slot] < 0) {
+        return preset_fail(p, "'%s' is read before it is assigned", name);
+    }
+    const int index = preset_node(p, PRESET_NODE_NAME);
+    if (index >= 0) {
+        PresetNode* node = &p->program->nodes[index];
+        node->slot = (int16_t)slot;
+        node->target = p->bound[slot];
+        node->uniform = p->program->nodes[preset_resolve(p->program, index)].uniform;
+    }
+    return index;
+}
+
+/*
+    preset_power: primary ^ unary, binding tighter than a leading minus
+    on its right but looser on its left: -a^b is -(a^b).
+*/
+static int preset_power(PresetParser* p) {
+    int node = preset_primary(p);
+    if (node >= 0 && preset_accept(p, "^")) {
+        const int args[2] = {node, preset_unary(p)};
+        node = preset_operation(p, PRESET_OP_POW, args);
+    }
+    return node;
+}
+
+/*
+    preset_unary: Leading signs, then a power. Every nested expression
+    (parentheses, call arguments, signs and exponents) passes through
+    here, so this is where the parser's recursion is bounded.
+*/
+static int preset_unary(PresetParser* p) {
+    if (p->depth == PRESET_MAX_DEPTH) {
+        return preset_fail(p, "expression nested more than %d deep", PRESET_MAX_DEPTH);
+    }
+    p->depth++;
+    int node;
+    if (preset_accept(p, "-")) {
+        const int args[1] = {preset_unary(p)};
+        node = preset_operation(p, PRESET_OP_NEG, args);
+    } else if (preset_accept(p, "+")) {
+        node = preset_unary(p);
+    } else {
+        node = preset_power(p);
+    }
+    p->depth--;
+    return node;
+}
+
+static int preset_term(PresetParser* p) {
+    int node = preset_unary(p);
+    while (node >= 0) {
+        int op;
+        if (preset_accept(p, "*")) {
+            op = PRESET_OP_MUL;
+        } else if (preset_accept(p, "/")) {
+            op = PRESET_OP_DIV;
+        } else if (preset_accept(p, "%")) {
+            op = PRESET_OP_MOD;
+        } else {
+            break;
+        }
+        const int args[2] = {node, preset_unary(p)};
+        node = preset_operation(p, op, args);
+    }
+    return node;
+}
+
+static int preset_sum(PresetParser* p) {
+    int node = preset_term(p);
+    while (node >= 0) {
+        int op;
+        if (preset_accept(p, "+")) {
+            op = PRESET_OP_ADD;
+        } else if (preset_accept(p, "-")) {
+            op = PRESET_OP_SUB;
+        } else {
+            break;
+        }
+        const int args[2] = {node, preset_term(p)};
+        node = preset_operation(p, op, args);
+    }
+    return node;
+}
+
+/*
+    preset_expression: Comparisons, the loosest binding level.
+*/
+static int preset_expression(PresetParser* p) {
+    static const struct {
+        const char* token;
+        PresetOpCode op;
+    } comparisons[] = {
+        {"<=", PRESET_OP_LE}, {">=", PRESET_OP_GE}, {"==", PRESET_OP_EQ}, {"!=", PRESET_OP_NE},
+        {"<", PRESET_OP_LT}, {">", PRESET_OP_GT}
+    };
+    int node = preset_sum(p);
+    while (node >= 0) {
+        int op = -1;
+        for (size_t c = 0; c < sizeof(comparisons) / sizeof(comparisons[0]) && op < 0; c++) {
+            op = preset_accept(p, comparisons[c].token) ? (int)comparisons[c].op : -1;
+        }
+        if (op < 0) {
+            break;
+        }
+        const int args[2] = {node, preset_sum(p)};
+        node = preset_operation(p, op, args);
+    }
+    return node;
+}
+
+/*
+    preset_parse: Appends the statements of text, one NAME = EXPRESSION
+    per line or separated by ';', to the program.
+*/
+static bool preset_parse(PresetParser* p, const char* text, const char* path) {
+    PresetProgram* program = p->program;
+    p->path = path;
+    p->cursor = text;
+    p->line = 1;
+    while (!p->failed) {
+        preset_skip(p);
+        if (*p->cursor == '\n' || *p->cursor == ';') {
+            p->line += (*p->cursor == '\n');
+            p->cursor++;
+            continue;
+        }
+        if (*p->cursor == '\0') {
+            break;
+        }
+        char name[PRESET_NAME_BYTES];
+        if (!preset_name(p, name)) {
+            preset_fail(p, "expected NAME = EXPRESSION");
+            break;
+        }
+        if (!preset_accept(p, "=")) {
+            preset_fail(p, "expected '=' after '%s'", name);
+            break;
+        }
+        int slot = preset_find(program, name);
+        if (slot >= 0 && slot < PRESET_FIRST_OUTPUT) {
+            preset_fail(p, "'%s' is an input", name);
+            break;
+        }
+        if (slot < 0 && program->name_count == PRESET_MAX_NAMES) {
+            preset_fail(p, "more than %d names", PRESET_MAX_NAMES);
+            break;
+        }
+        const int root = preset_expression(p);
+        preset_skip(p);
+        if (root >= 0 && *p->cursor && *p->cursor != '\n' && *p->cursor != ';') {
+            preset_fail(p, "unexpected '%c'", *p->cursor);
+        }
+        if (p->failed) {
+            break;
+        }
+        if (program->statement_count == PRESET_MAX_STATEMENTS) {
+            preset_fail(p, "more than %d statements", PRESET_MAX_STATEMENTS);
+            break;
+        }
+        if (slot < 0) {
+            slot = program->name_count++;
+            snprintf(program->names[slot], PRESET_NAME_BYTES, "%s", name);
+        }
+        program->statements[program->statement_count++] = (PresetStatement){(int16_t)slot, (int16_t)root};
+        p->bound[slot] = (int16_t)root;
+    }
+    return !p->failed;
+}
+
+/*
+    PresetCompiler: Register assignment while the program is compiled.
+*/
+typedef struct {
+    PresetProgram* program;
+    const char* path;
+    int16_t uses[PRESET_MAX_NODES];       // Consumers not yet compiled; outputs never release theirs.
+    int16_t reg[PRESET_MAX_NODES];        // Register holding each node's value, or -1.
+    bool busy[PRESET_MAX_VECTORS];
+    int16_t broadcast_of[PRESET_MAX_SCALARS];
+    bool failed;
+} PresetCompiler;
+
+static int preset_compile_fail(PresetCompiler* c, const char* problem) {
+    if (!c->failed) {
+        fprintf(stderr, "%s: %s.\n", c->path, problem);
+    }
+    c->failed = true;
+    return 0;
+}
+
+static void preset_count(PresetCompiler* c, int node) {
+    node = preset_resolve(c->program, node);
+    if (c->uses[node]++ > 0) {
+        return;
+    }
+    const PresetNode* n = &c->program->nodes[node];
+    if (n->kind == PRESET_NODE_OP) {
+        for (int i = 0; i < preset_arity[n->op]; i++) {
+            preset_count(c, n->args[i]);
+        }
+    }
+}
+
+static int preset_scalar(PresetCompiler* c, float value) {
+    PresetProgram* program = c->program;
+    if (program->scalar_count == PRESET_MAX_SCALARS) {
+        return preset_compile_fail(c, "too many scalar registers");
+    }
+    program->scalars[program->scalar_count] = value;
+    return program->scalar_count++;
+}
+
+static int preset_vector(PresetCompiler* c) {
+    for (int v = PRESET_VECTOR_INPUTS; v < PRESET_MAX_VECTORS; v++) {
+        if (!c->busy[v]) {
+            c->busy[v] = true;
+            c->program->vector_count = SDL_max(c->program->vector_count, v + 1);
+            return v;
+        }
+    }
+    return preset_compile_fail(c, "expression too deep: out of vector registers");
+}
+
+/*
+    preset_broadcast: A vector register holding scalar register s in every
+    lane. It is filled once per frame, before any block runs, so it must
+    be one no temporary has used: a fresh register, never released.
+*/
+static int preset_broadcast(PresetCompiler* c, int s) {
+    if (c->broadcast_of[s] < 0) {
+        const int v = c->program->vector_count;
+        if (v == PRESET_MAX_VECTORS) {
+            return preset_compile_fail(c, "too many constants: out of vector registers");
+        }
+        c->busy[v] = true;
+        c->program->vector_count++;
+        c->program->broadcast[v] = (int16_t)s;
+        c->broadcast_of[s] = (int16_t)v;
+    }
+    return c->broadcast_of[s];
+}
+
+static void preset_emit(PresetCompiler* c, bool frame, int op, int dst, const int* args) {
+    PresetProgram* program = c->program;
+    int* length = frame ? &program->frame_length : &program->column_length;
+    if (*length == PRESET_MAX_CODE) {
+        preset_compile_fail(c, "program too long");
+        return;
+    }
+    PresetOp* code = frame ? &program->frame_code[*length] : &program->column_code[*length];
+    memset(code, 0, sizeof(*code));
+    code->op = (uint8_t)op;
+    code->argc = (uint8_t)preset_arity[op];
+    code->dst = (uint16_t)dst;
+    for (int i = 0; i < code->argc; i++) {
+        code->args[i] = (uint16_t)args[i];
+    }
+    (*length)++;
+}
+
+/*
+    preset_generate: Emits the code for a node once and returns its
+    register: a scalar register for a uniform node, a vector register
+    otherwise. A temporary vector register is released as soon as its
+    last consumer is emitted, so the consumer may reuse it in place.
+*/
+static int preset_generate(PresetCompiler* c, int node) {
+    PresetProgram* program = c->program;
+    node = preset_resolve(program, node);
+    if (c->reg[node] >= 0 || c->failed) {
+        return SDL_max(c->reg[node], 0);
+    }
+    const PresetNode* n = &program->nodes[node];
+    int reg = 0;
+    if (n->kind == PRESET_NODE_NUMBER) {
+        reg = preset_scalar(c, n->number);
+    } else if (n->kind == PRESET_NODE_INPUT) {
+        reg = n->slot < PRESET_SCALAR_INPUTS ? n->slot : n->slot - PRESET_SCALAR_INPUTS;
+    } else {
+        int args[3] = {0, 0, 0};
+        int resolved[3] = {0, 0, 0};
+        const int argc = preset_arity[n->op];
+        for (int i = 0; i < argc; i++) {
+            resolved[i] = preset_resolve(program, n->args[i]);
+            args[i] = preset_generate(c, resolved[i]);
+            if (!n->uniform && program->nodes[resolved[i]].uniform) {
+                args[i] = preset_broadcast(c, args[i]);
+            }
+        }
+        if (n->uniform) {
+            reg = preset_scalar(c, 0.0f);
+            preset_emit(c, true, n->op, reg, args);
+        } else {
+            for (int i = 0; i < argc; i++) {
+                const PresetNode* arg = &program->nodes[resolved[i]];
+                if (--c->uses[resolved[i]] == 0 && !arg->uniform && arg->kind == PRESET_NODE_OP) {
+                    c->busy[c->reg[resolved[i]]] = false;
+                }
+            }
+            reg = preset_vector(c);
+            preset_emit(c, false, n->op, reg, args);
+        }
+    }
+    c->reg[node] = (int16_t)reg;
+    return reg;
+}
+
+/*
+    preset_compile: Compiles the final value of every output, leaving out
+    whatever no output depends on.
+*/
+static bool preset_compile(PresetProgram* program, const int16_t* bound, const char* path) {
+    static PresetCompiler c;
+    memset(&c, 0, sizeof(c));
+    c.program = program;
+    c.path = path;
+    memset(c.reg, -1, sizeof(c.reg));
+    memset(c.broadcast_of, -1, sizeof(c.broadcast_of));
+    memset(program->broadcast, -1, sizeof(program->broadcast));
+    for (int v = 0; v < PRESET_VECTOR_INPUTS; v++) {
+        c.busy[v] = true;
+    }
+    program->scalar_count = PRESET_SCALAR_INPUTS;
+    program->vector_count = PRESET_VECTOR_INPUTS;
+
+    for (int o = 0; o < PRESET_OUTPUTS; o++) {
+        preset_count(&c, bound[PRESET_FIRST_OUTPUT + o]);
+    }
+    for (int o = 0; o < PRESET_OUTPUTS; o++) {
+        const int root = preset_resolve(program, bound[PRESET_FIRST_OUTPUT + o]);
+        program->output_register[o] = (int16_t)preset_generate(&c, root);
+        program->output_scalar[o] = program->nodes[root].uniform;
+    }
+    return !c.failed;
+}
+
+static float* preset_input(const Preset* preset, PresetVectorInput input) {
+    return preset->inputs + (size_t)input * PRESET_MAX_COLUMNS;
+}
+
+/*
+    preset_load: Reads and compiles the preset at path and sets up
+    columns log-spaced columns over rows of bins bins bin_hz apart.
+*/
+bool preset_load(Preset* preset, const char* path, int columns, int bins, float bin_hz) {
+    memset(preset, 0, sizeof(*preset));
+    snprintf(preset->path, sizeof(preset->path), "%s", path);
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open the preset %s.\n", path);
+        return false;
+    }
+    static char text[PRESET_MAX_SOURCE + 1];
+    const size_t length = fread(text, 1, PRESET_MAX_SOURCE + 1, file);
+    fclose(file);
+    if (length > PRESET_MAX_SOURCE) {
+        fprintf(stderr, "%s is larger than %d bytes.\n", path, PRESET_MAX_SOURCE);
+        return false;
+    }
+    text[length] = '\0';
+
+    preset->program = calloc(1, sizeof(PresetProgram));
+    preset->columns = SDL_clamp(columns, 1, PRESET_MAX_COLUMNS);
+    preset->first_bin = malloc(sizeof(int) * (preset->columns + 1));
+    preset->inputs = calloc((size_t)PRESET_VECTOR_INPUTS * PRESET_MAX_COLUMNS, sizeof(float));
+    preset->outputs = calloc((size_t)PRESET_OUTPUTS * PRESET_MAX_COLUMNS, sizeof(float));
+    preset->blocks = calloc((size_t)PRESET_MAX_VECTORS * PRESET_BLOCK, sizeof(float));
+    if (!preset->program || !preset->first_bin || !preset->inputs || !preset->outputs || !preset->blocks) {
+        preset_free(preset);
+        return false;
+    }
+#ifdef PRESET_SSE2
+    preset->sse2 = true;
+#endif
+
+    PresetProgram* program = preset->program;
+    static PresetParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.program = program;
+    memset(parser.bound, -1, sizeof(parser.bound));
+    for (int slot = 0; slot < PRESET_BUILTINS; slot++) {
+        snprintf(program->names[slot], PRESET_NAME_BYTES, "%s", preset_builtin_names[slot]);
+        if (slot < PRESET_FIRST_OUTPUT) {
+            const int node = preset_node(&parser, PRESET_NODE_INPUT);
+            program->nodes[node].slot = (int16_t)slot;
+            program->nodes[node].uniform = slot < PRESET_SCALAR_INPUTS;
+            parser.bound[slot] = (int16_t)node;
+        }
+    }
+    program->name_count = PRESET_BUILTINS;
+    if (!preset_parse(&parser, preset_defaults, "<defaults>") || !preset_parse(&parser, text, path) ||
+        !preset_compile(program, parser.bound, path)) {
+        preset_free(preset);
+        return false;
+    }
+
+    // Column edges spaced evenly in log frequency; each column takes at least one bin.
+    const float nyquist = bin_hz * (bins - 1);
+    const float low = SDL_min(PRESET_MIN_HZ, 0.5f * nyquist);
+    float* freq = preset_input(preset, PRESET_FREQ);
+    float* index = preset_input(preset, PRESET_I);
+    float previous = low;
+    for (int c = 0; c <= preset->columns; c++) {
+        const float edge = low * powf(nyquist / low, (float)c / preset->columns);
+        preset->first_bin[c] = SDL_clamp((int)(edge / bin_hz + 0.5f), 1, bins - 1);
+        if (c > 0) {
+            preset->first_bin[c] = SDL_max(preset->first_bin[c], preset->first_bin[c - 1]);
+            freq[c - 1] = sqrtf(previous * edge);
+            index[c - 1] = (float)(c - 1);
+        }
+        previous = edge;
+    }
+    return true;
+}
+
+/*
+    preset_columns: Reduces a spectrum row to the preset's columns, each
+    the loudest of its bins, and sets this frame's inputs.
+*/
+void preset_columns(Preset* preset, const float* row_db, double time) {
+    const int columns = preset->columns;
+    const float* freq = preset_input(preset, PRESET_FREQ);
+    float* db = preset_input(preset, PRESET_DB);
+    float* level = preset_input(preset, PRESET_LEVEL);
+    double sums[3] = {0.0, 0.0, 0.0};
+    int counts[3] = {0, 0, 0};
+    double total = 0.0;
+    for (int c = 0; c < columns; c++) {
+        const int first = preset->first_bin[c];
+        const int last = SDL_max(first + 1, preset->first_bin[c + 1]);
+        float peak = row_db[first];
+        for (int k = first + 1; k < last; k++) {
+            peak = fmaxf(peak, row_db[k]);
+        }
+        db[c] = peak;
+        level[c] = SDL_clamp((peak + 80.0f) / 80.0f, 0.0f, 1.0f);
+        const int band = freq[c] < PRESET_BASS_HZ ? 0 : (freq[c] < PRESET_TREB_HZ ? 1 : 2);
+        sums[band] += level[c];
+        counts[band]++;
+        total += level[c];
+    }
+    float* s = preset->program->scalars;
+    s[PRESET_TIME] = (float)time;
+    s[PRESET_FRAME] = (float)preset->frames;
+    s[PRESET_N] = (float)columns;
+    s[PRESET_BASS] = counts[0] ? (float)(sums[0] / counts[0]) : 0.0f;
+    s[PRESET_MID] = counts[1] ? (float)(sums[1] / counts[1]) : 0.0f;
+    s[PRESET_TREB] = counts[2] ? (float)(sums[2] / counts[2]) : 0.0f;
+    s[PRESET_VOL] = (float)(total / columns);
+}
+
+#ifdef PRESET_SSE2
+// Applies expr to every group of four lanes; x, y and z are the arguments.
+#define PRESET_SSE2_LOOP(expr)                              \
+    for (int k = 0; k < count; k += 4) {                    \
+        const __m128 x = _mm_loadu_ps(a + k);               \
+        const __m128 y = _mm_loadu_ps(b + k);               \
+        const __m128 z = _mm_loadu_ps(c + k);               \
+        (void)y;                                            \
+        (void)z;                                            \
+        _mm_storeu_ps(dst + k, (expr));                     \
+    }                                                       \
+    return true
+
+/*
+    preset_kernel_sse2: The operations SSE2 has instructions for. Returns
+    false for the others.
+*/
+static bool preset_kernel_sse2(int op, float* dst, const float* a, const float* b, const float* c, int count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    switch (op) {
+    case PRESET_OP_ADD: PRESET_SSE2_LOOP(_mm_add_ps(x, y));
+    case PRESET_OP_SUB: PRESET_SSE2_LOOP(_mm_sub_ps(x, y));
+    case PRESET_OP_MUL: PRESET_SSE2_LOOP(_mm_mul_ps(x, y));
+    case PRESET_OP_DIV: PRESET_SSE2_LOOP(_mm_div_ps(x, y));
+    case PRESET_OP_MIN: PRESET_SSE2_LOOP(_mm_min_ps(x, y));
+    case PRESET_OP_MAX: PRESET_SSE2_LOOP(_mm_max_ps(x, y));
+    case PRESET_OP_LT: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmplt_ps(x, y), one));
+    case PRESET_OP_GT: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmpgt_ps(x, y), one));
+    case PRESET_OP_LE: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmple_ps(x, y), one));
+    case PRESET_OP_GE: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmpge_ps(x, y), one));
+    case PRESET_OP_EQ: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmpeq_ps(x, y), one));
+    case PRESET_OP_NE: PRESET_SSE2_LOOP(_mm_and_ps(_mm_cmpneq_ps(x, y), one));
+    case PRESET_OP_NEG: PRESET_SSE2_LOOP(_mm_xor_ps(x, sign));
+    case PRESET_OP_ABS: PRESET_SSE2_LOOP(_mm_andnot_ps(sign, x));
+    case PRESET_OP_SQRT: PRESET_SSE2_LOOP(_mm_sqrt_ps(x));
+    case PRESET_OP_IF: {
+        PRESET_SSE2_LOOP(_mm_or_ps(_mm_and_ps(_mm_cmpneq_ps(x, zero), y), _mm_andnot_ps(_mm_cmpneq_ps(x, zero), z)));
+    }
+    case PRESET_OP_CLAMP: PRESET_SSE2_LOOP(_mm_min_ps(_mm_max_ps(x, y), z));
+    case PRESET_OP_MIX: PRESET_SSE2_LOOP(_mm_add_ps(x, _mm_mul_ps(_mm_sub_ps(y, x), z)));
+    }
+    return false;
+}
+#endif
+
+// One loop per operation, with preset_apply inlined for that operation.
+#define PRESET_LOOP(OP)                                     \
+    case OP:                                                \
+        for (int k = 0; k < count; k++) {                   \
+            dst[k] = preset_apply(OP, a[k], b[k], c[k]);    \
+        }                                                   \
+        break
+
+/*
+    preset_kernel: Applies one instruction to count lanes, a multiple of 4.
+*/
+static void preset_kernel(int op, float* dst, const float* a, const float* b, const float* c, int count, bool sse2) {
+#ifdef PRESET_SSE2
+    if (sse2 && preset_kernel_sse2(op, dst, a, b, c, count)) {
+        return;
+    }
+#else
+    (void)sse2;
+#endif
+    switch (op) {
+    PRESET_LOOP(PRESET_OP_ADD);
+    PRESET_LOOP(PRESET_OP_SUB);
+    PRESET_LOOP(PRESET_OP_MUL);
+    PRESET_LOOP(PRESET_OP_DIV);
+    PRESET_LOOP(PRESET_OP_MOD);
+    PRESET_LOOP(PRESET_OP_POW);
+    PRESET_LOOP(PRESET_OP_MIN);
+    PRESET_LOOP(PRESET_OP_MAX);
+    PRESET_LOOP(PRESET_OP_LT);
+    PRESET_LOOP(PRESET_OP_GT);
+    PRESET_LOOP(PRESET_OP_LE);
+    PRESET_LOOP(PRESET_OP_GE);
+    PRESET_LOOP(PRESET_OP_EQ);
+    PRESET_LOOP(PRESET_OP_NE);
+    PRESET_LOOP(PRESET_OP_NEG);
+    PRESET_LOOP(PRESET_OP_ABS);
+    PRESET_LOOP(PRESET_OP_SQRT);
+    PRESET_LOOP(PRESET_OP_FLOOR);
+    PRESET_LOOP(PRESET_OP_SIN);
+    PRESET_LOOP(PRESET_OP_COS);
+    PRESET_LOOP(PRESET_OP_EXP);
+    PRESET_LOOP(PRESET_OP_LOG);
+    PRESET_LOOP(PRESET_OP_IF);
+    PRESET_LOOP(PRESET_OP_CLAMP);
+    PRESET_LOOP(PRESET_OP_MIX);
+    }
+}
+
+/*
+    preset_finish: Keeps this frame's heights for the next frame's prev.
+*/
+static void preset_finish(Preset* preset) {
+    memcpy(preset_input(preset, PRESET_PREV), preset->outputs + (size_t)PRESET_HEIGHT * PRESET_MAX_COLUMNS,
+           sizeof(float) * preset->columns);
+    preset->frames++;
+}
+
+/*
+    preset_run: Runs the compiled program: the frame code once, then the
+    column code over each block of PRESET_BLOCK columns.
+*/
+void preset_run(Preset* preset) {
+    const PresetProgram* program = preset->program;
+    float* s = preset->program->scalars;
+    for (int i = 0; i < program->frame_length; i++) {
+        const PresetOp* op = &program->frame_code[i];
+        s[op->dst] = preset_apply(op->op, s[op->args[0]], s[op->args[1]], s[op->args[2]]);
+    }
+    float* regs[PRESET_MAX_VECTORS];
+    for (int v = PRESET_VECTOR_INPUTS; v < program->vector_count; v++) {
+        regs[v] = preset->blocks + (size_t)v * PRESET_BLOCK;
+        if (program->broadcast[v] >= 0) {
+            const float value = s[program->broadcast[v]];
+            for (int k = 0; k < PRESET_BLOCK; k++) {
+                regs[v][k] = value;
+            }
+        }
+    }
+    for (int o = 0; o < PRESET_OUTPUTS; o++) {
+        if (program->output_scalar[o]) {
+            float* out = preset->outputs + (size_t)o * PRESET_MAX_COLUMNS;
+            const float value = s[program->output_register[o]];
+            for (int c = 0; c < preset->columns; c++) {
+                out[c] = value;
+            }
+        }
+    }
+
+    for (int start = 0; start < preset->columns; start += PRESET_BLOCK) {
+        const int count = SDL_min(PRESET_BLOCK, preset->columns - start);
+        const int lanes = (count + 3) & ~3;  // Arrays are padded, so the tail runs whole groups of 4.
+        for (int v = 0; v < PRESET_VECTOR_INPUTS; v++) {
+            regs[v] = preset->inputs + (size_t)v * PRESET_MAX_COLUMNS + start;
+        }
+        for (int i = 0; i < program->column_length; i++) {
+            const PresetOp* op = &program->column_code[i];
+            preset_kernel(op->op, regs[op->dst], regs[op->args[0]], regs[op->args[1]], regs[op->args[2]], lanes,
+                          preset->sse2);
+        }
+        for (int o = 0; o < PRESET_OUTPUTS; o++) {
+            if (!program->output_scalar[o]) {
+                memcpy(preset->outputs + (size_t)o * PRESET_MAX_COLUMNS + start, regs[program->output_register[o]],
+                       sizeof(float) * count);
+            }
+        }
+    }
+    preset_finish(preset);
+}
+
+static float preset_interpret(const PresetProgram* program, const float* vars, int index) {
+    const PresetNode* node = &program->nodes[index];
+    if (node->kind == PRESET_NODE_NUMBER) {
+        return node->number;
+    }
+    if (node->kind != PRESET_NODE_OP) {
+        return vars[node->slot];
+    }
+    float args[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < preset_arity[node->op]; i++) {
+        args[i] = preset_interpret(program, vars, node->args[i]);
+    }
+    return preset_apply(node->op, args[0], args[1], args[2]);
+}
+
+/*
+    preset_run_reference: Evaluates the statements column by column with
+    a tree-walking interpreter and a variable table, the way a preset
+    would run uncompiled. --preset-bench measures preset_run against it
+    and checks that both agree.
+*/
+void preset_run_reference(Preset* preset) {
+    const PresetProgram* program = preset->program;
+    float vars[PRESET_MAX_NAMES] = {0.0f};
+    memcpy(vars, program->scalars, sizeof(float) * PRESET_SCALAR_INPUTS);
+    for (int c = 0; c < preset->columns; c++) {
+        for (int v = 0; v < PRESET_VECTOR_INPUTS; v++) {
+            vars[PRESET_SCALAR_INPUTS + v] = preset->inputs[(size_t)v * PRESET_MAX_COLUMNS + c];
+        }
+        for (int i = 0; i < program->statement_count; i++) {
+            vars[program->statements[i].slot] = preset_interpret(program, vars, program->statements[i].root);
+        }
+        for (int o = 0; o < PRESET_OUTPUTS; o++) {
+            preset->outputs[(size_t)o * PRESET_MAX_COLUMNS + c] = vars[PRESET_FIRST_OUTPUT + o];
+        }
+    }
+    preset_finish(preset);
+}
+
+/*
+    preset_evaluate: Computes one frame of outputs from a spectrum row.
+*/
+void preset_evaluate(Preset* preset, const float* row_db, double time) {
+    preset_columns(preset, row_db, time);
+    preset_run(preset);
+}
+
+const float* preset_output(const Preset* preset, PresetOutput output) {
+    return preset->outputs + (size_t)output * PRESET_MAX_COLUMNS;
+}
+
+void preset_free(Preset* preset) {
+    free(preset->program);
+    free(preset->first_bin);
+    free(preset->inputs);
+    free(preset->outputs);
+    free(preset->blocks);
+    memset(preset, 0, sizeof(*preset));
+}
+
+/*
+    preset_bench_row: A synthetic spectrum frame: a sloped noise floor, a
+    few harmonics of a gliding tone and a kick every half second.
+*/
+static void preset_bench_row(float* row, int bins, int frame, unsigned* seed) {
+    const float tone = 8.0f + 4.0f * sinf(frame * 0.01f);
+    const float kick = (frame % 30) < 3 ? 20.0f : 0.0f;
+    for (int k = 0; k < bins; k++) {
+        *seed = *seed * 1664525u + 1013904223u;
+        row[k] = -50.0f - 20.0f * log10f(1.0f + k) + 10.0f * (*seed >> 8) / 16777216.0f;
+        row[k] += k < 8 ? kick : 0.0f;
+    }
+    for (int h = 1; h <= 6; h++) {
+        const int k = (int)(tone * h * h);
+        if (k < bins) {
+            row[k] = -10.0f - 3.0f * h;
+        }
+    }
+}
+
+/*
+    preset_bench: --preset-bench entry point. Runs the same frames through
+    the interpreter and the compiled program, with scalar and SSE2
+    kernels, and prints the evaluation time per frame of each as CSV with
+    the largest difference from the interpreter's outputs.
+*/
+int preset_bench(const CliOptions* options) {
+    const int fft_size = options->fft_size ? options->fft_size : OFFLINE_DEFAULT_FFT_SIZE;
+    const int bins = fft_size / 2 + 1;
+    const float bin_hz = (float)OFFLINE_SAMPLE_RATE / fft_size;
+    static const int sizes[PRESET_BENCH_SIZES] = {64, 256, 1024};
+    const int size_count = options->preset_columns ? 1 : PRESET_BENCH_SIZES;
+    float* row = malloc(sizeof(float) * bins);
+    float* reference = malloc(sizeof(float) * PRESET_OUTPUTS * PRESET_MAX_COLUMNS);
+    if (!row || !reference) {
+        free(row);
+        free(reference);
+        return EXIT_FAILURE;
+    }
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    printf("method,columns,frames,ms_per_frame,mcolumns_per_s,max_error\n");
+
+    int status = EXIT_SUCCESS;
+    for (int s = 0; s < size_count && status == EXIT_SUCCESS; s++) {
+        const int columns = options->preset_columns ? options->preset_columns : sizes[s];
+        Preset preset;
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!preset_load(&preset, options->preset_path, columns, bins, bin_hz)) {
+            status = EXIT_FAILURE;
+            break;
+        }
+        const double compile_ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+        if (s == 0) {
+            const PresetProgram* program = preset.program;
+            fprintf(stderr, "Compiled %d statements in %.3f ms: %d frame ops, %d column ops, %d vector registers\n",
+                    program->statement_count, compile_ms, program->frame_length, program->column_length,
+                    program->vector_count);
+        }
+
+        static const char* methods[3] = {"interpreter", "compiled_scalar", "compiled_sse2"};
+        for (int method = 0; method < 3; method++) {
+#ifndef PRESET_SSE2
+            if (method == 2) {
+                break;
+            }
+#endif
+            preset.sse2 = (method == 2);
+            preset.frames = 0;
+            memset(preset_input(&preset, PRESET_PREV), 0, sizeof(float) * columns);
+            unsigned seed = 12345u;
+            Uint64 elapsed = 0;
+            for (int f = 0; f < PRESET_BENCH_FRAMES; f++) {
+                preset_bench_row(row, bins, f, &seed);
+                preset_columns(&preset, row, f / 60.0);
+                start = SDL_GetPerformanceCounter();
+                if (method == 0) {
+                    preset_run_reference(&preset);
+                } else {
+                    preset_run(&preset);
+                }
+                elapsed += SDL_GetPerformanceCounter() - start;
+            }
+            // Relative difference from the interpreter, over every output of the last frame.
+            double error = 0.0;
+            for (int o = 0; o < PRESET_OUTPUTS; o++) {
+                for (int c = 0; c < columns; c++) {
+                    const size_t i = (size_t)o * PRESET_MAX_COLUMNS + c;
+                    if (method == 0) {
+                        reference[i] = preset.outputs[i];
+                    } else if (isnan(reference[i]) != isnan(preset.outputs[i])) {
+                        error = INFINITY;  // NaN on one side only; fmax would drop it.
+                    } else if (!isnan(reference[i])) {
+                        error = fmax(error, fabs((double)preset.outputs[i] - reference[i]) /
+                                            fmax(1.0, fabs((double)reference[i])));
+                    }
+                }
+            }
+            const double seconds = elapsed / frequency;
+            printf("%s,%d,%d,%.5f,%.1f,%.2e\n", methods[method], columns, PRESET_BENCH_FRAMES,
+                   1000.0 * seconds / PRESET_BENCH_FRAMES,
+                   seconds > 0 ? (double)columns * PRESET_BENCH_FRAMES / seconds / 1e6 : 0.0, error);
+        }
+        preset_free(&preset);
+    }
+    free(row);
+    free(reference);
+    return status;
+}
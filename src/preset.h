@@ -0,0 +1,155 @@
+#ifndef PRESET_H
+#define PRESET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cli.h"
+
+// Columns a preset can draw, and columns evaluated together: one block of
+// every register the program uses stays in L1 while the block runs.
+#define PRESET_MAX_COLUMNS 1024
+#define PRESET_DEFAULT_COLUMNS 128
+#define PRESET_BLOCK 64
+
+// Columns are spaced logarithmically from here to Nyquist.
+#define PRESET_MIN_HZ 30.0f
+
+// Band edges of the bass, mid and treb inputs.
+#define PRESET_BASS_HZ 250.0f
+#define PRESET_TREB_HZ 4000.0f
+
+// Limits of a compiled preset.
+#define PRESET_MAX_SOURCE 16384
+#define PRESET_MAX_NODES 2048
+#define PRESET_MAX_STATEMENTS 256
+#define PRESET_MAX_NAMES 128
+#define PRESET_NAME_BYTES 32
+#define PRESET_MAX_CODE 1024
+#define PRESET_MAX_SCALARS 1024
+#define PRESET_MAX_VECTORS 64
+#define PRESET_MAX_DEPTH 64     // Nested parentheses, calls and unary operators.
+
+// Frames timed per method and column count by --preset-bench.
+#define PRESET_BENCH_FRAMES 2000
+
+// Inputs a preset reads. Scalars hold one value per frame; vectors one per column.
+typedef enum {
+    PRESET_TIME,            // Seconds since the preset was loaded.
+    PRESET_FRAME,           // Frames evaluated so far.
+    PRESET_N,               // Column count.
+    PRESET_BASS,            // Mean level of the columns in each band, 0 to 1.
+    PRESET_MID,
+    PRESET_TREB,
+    PRESET_VOL,             // Mean level of every column.
+    PRESET_SCALAR_INPUTS
+} PresetScalarInput;
+
+typedef enum {
+    PRESET_I,               // Column index.
+    PRESET_FREQ,            // Centre frequency in Hz.
+    PRESET_DB,              // Loudest bin of the column.
+    PRESET_LEVEL,           // db mapped from -80..0 to 0..1.
+    PRESET_PREV,            // This column's height in the previous frame.
+    PRESET_VECTOR_INPUTS
+} PresetVectorInput;
+
+// What a preset computes for each column. Geometry is a fraction of the
+// window, measured from its bottom left; colour is HSL with hue in degrees.
+typedef enum {
+    PRESET_X,
+    PRESET_Y,
+    PRESET_WIDTH,
+    PRESET_HEIGHT,
+    PRESET_HUE,
+    PRESET_SAT,
+    PRESET_LIGHT,
+    PRESET_OUTPUTS
+} PresetOutput;
+
+/*
+    PresetNode: An expression node. A name refers to the value last
+    assigned to it: slot for the reference interpreter, which keeps a
+    variable table, and target for the compiler, which does not.
+*/
+typedef struct {
+    uint8_t kind;
+    uint8_t op;
+    bool uniform;           // Same value in every column of a frame.
+    int16_t slot;
+    int16_t target;
+    int16_t args[3];
+    float number;
+} PresetNode;
+
+/*
+    PresetStatement: name = expression.
+*/
+typedef struct {
+    int16_t slot;
+    int16_t root;
+} PresetStatement;
+
+/*
+    PresetOp: One instruction. In the frame code every operand is a scalar
+    register; in the column code every operand is a vector register.
+*/
+typedef struct {
+    uint8_t op;
+    uint8_t argc;
+    uint16_t dst;
+    uint16_t args[3];
+} PresetOp;
+
+/*
+    PresetProgram: A preset parsed into statements and compiled into two
+    instruction lists. Subexpressions that are uniform across columns run
+    once per frame on scalars; the rest run column block by column block,
+    each instruction sweeping a whole block before the next one starts.
+*/
+typedef struct {
+    char names[PRESET_MAX_NAMES][PRESET_NAME_BYTES];
+    int name_count;
+    PresetNode nodes[PRESET_MAX_NODES];
+    int node_count;
+    PresetStatement statements[PRESET_MAX_STATEMENTS];
+    int statement_count;
+
+    PresetOp frame_code[PRESET_MAX_CODE];
+    int frame_length;
+    PresetOp column_code[PRESET_MAX_CODE];
+    int column_length;
+    float scalars[PRESET_MAX_SCALARS];  // Inputs, then constants and temporaries.
+    int scalar_count;
+    int vector_count;                   // Inputs, then broadcasts and temporaries.
+    int16_t broadcast[PRESET_MAX_VECTORS];  // Scalar register each block holds, or -1.
+    int16_t output_register[PRESET_OUTPUTS];
+    bool output_scalar[PRESET_OUTPUTS];
+} PresetProgram;
+
+/*
+    Preset: A compiled preset and the per-column arrays it runs over.
+*/
+typedef struct {
+    char path[256];
+    PresetProgram* program;
+    bool sse2;              // Use the SSE2 kernels where they exist.
+    int columns;
+    int* first_bin;         // columns + 1 bin boundaries.
+    float* inputs;          // PRESET_VECTOR_INPUTS x PRESET_MAX_COLUMNS.
+    float* outputs;         // PRESET_OUTPUTS x PRESET_MAX_COLUMNS.
+    float* blocks;          // PRESET_MAX_VECTORS x PRESET_BLOCK.
+    unsigned long long frames;
+} Preset;
+
+bool preset_load(Preset* preset, const char* path, int columns, int bins, float bin_hz);
+void preset_columns(Preset* preset, const float* row_db, double time);
+void preset_run(Preset* preset);
+void preset_run_reference(Preset* preset);
+void preset_evaluate(Preset* preset, const float* row_db, double time);
+const float* preset_output(const Preset* preset, PresetOutput output);
+void preset_free(Preset* preset);
+
+int preset_bench(const CliOptions* options);
+
+#endif
@@ -0,0 +1,69 @@
+#include "psd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    psd_init: Allocates the accumulators. window_power is sum(w[n]^2) of the
+    analysis window, which normalises the estimate to power per Hz.
+*/
+bool psd_init(PsdState* psd, int bins, float sample_rate, double window_power, double tau) {
+    memset(psd, 0, sizeof(*psd));
+    psd->bins = bins;
+    psd->density_scale = 1.0 / (sample_rate * window_power);
+    psd->tau = tau;
+    psd->linear_sum = calloc(bins, sizeof(double));
+    psd->exponential = calloc(bins, sizeof(double));
+    if (!psd->linear_sum || !psd->exponential) {
+        psd_free(psd);
+        return false;
+    }
+    return true;
+}
+
+/*
+    psd_accumulate: Adds one frame of bin powers covering `seconds` of audio.
+    The first frame after a reset seeds the exponential average directly.
+*/
+void psd_accumulate(PsdState* psd, const float* power, double seconds) {
+    const double alpha = (psd->frames == 0) ? 1.0 : 1.0 - exp(-seconds / psd->tau);
+    for (int k = 0; k < psd->bins; k++) {
+        double p = power[k];
+        psd->linear_sum[k] += p;
+        psd->exponential[k] += alpha * (p - psd->exponential[k]);
+    }
+    psd->frames++;
+    psd->seconds += seconds;
+}
+
+/*
+    psd_read_db: Writes the scaled one-sided PSD in dB re full scale^2/Hz.
+*/
+void psd_read_db(const PsdState* psd, PsdAveraging averaging, float* out_db) {
+    const double frames = (psd->frames > 0) ? (double)psd->frames : 1.0;
+    for (int k = 0; k < psd->bins; k++) {
+        double mean = (averaging == PSD_LINEAR) ? psd->linear_sum[k] / frames : psd->exponential[k];
+        double one_sided = (k == 0 || k == psd->bins - 1) ? 1.0 : 2.0;
+        out_db[k] = (float)(10.0 * log10(mean * one_sided * psd->density_scale + 1e-30));
+    }
+}
+
+/*
+    psd_reset: Starts a new survey.
+*/
+void psd_reset(PsdState* psd) {
+    memset(psd->linear_sum, 0, sizeof(double) * psd->bins);
+    memset(psd->exponential, 0, sizeof(double) * psd->bins);
+    psd->frames = 0;
+    psd->seconds = 0.0;
+}
+
+/*
+    psd_free: Releases the accumulators.
+*/
+void psd_free(PsdState* psd) {
+    free(psd->linear_sum);
+    free(psd->exponential);
+    memset(psd, 0, sizeof(*psd));
+}
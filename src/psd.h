@@ -0,0 +1,40 @@
+#ifndef PSD_H
+#define PSD_H
+
+#include <stdbool.h>
+
+/*
+    PsdAveraging selects which long-term average psd_read_db reports.
+*/
+typedef enum {
+    PSD_LINEAR,       // Equal weight for every frame since the last reset.
+    PSD_EXPONENTIAL   // Exponential forgetting with time constant tau.
+} PsdAveraging;
+
+/*
+    PsdState: Long-term Welch power spectral density built from the STFT
+    frames the visualizer already computes, so no extra FFTs are needed.
+
+    Raw bin powers are accumulated in double precision, which keeps hours
+    of frames exact enough; scaling is applied only when reading:
+    PSD = c_k * |X_k|^2 / (fs * sum(w^2)), with c_k = 2 for interior bins
+    (one-sided correction) and 1 at DC and Nyquist.
+*/
+typedef struct {
+    int bins;
+    double density_scale;    // 1 / (fs * sum(w^2)).
+    double tau;              // Exponential time constant in seconds.
+
+    double* linear_sum;      // Sum of |X_k|^2 over all frames.
+    double* exponential;     // Exponentially weighted |X_k|^2.
+    unsigned long long frames;
+    double seconds;          // Audio time covered since the last reset.
+} PsdState;
+
+bool psd_init(PsdState* psd, int bins, float sample_rate, double window_power, double tau);
+void psd_accumulate(PsdState* psd, const float* power, double seconds);
+void psd_read_db(const PsdState* psd, PsdAveraging averaging, float* out_db);
+void psd_reset(PsdState* psd);
+void psd_free(PsdState* psd);
+
+#endif
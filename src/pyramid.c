@@ -0,0 +1,242 @@
+#include "pyramid.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// BMP header, info header and a 256-entry palette precede the pixels.
+#define PYRAMID_BMP_HEADER (14 + 40 + 256 * 4)
+
+static void put_u16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+}
+
+/*
+    pyramid_palette: The spectrogram view's colour map, blue through red
+    with lightness rising from black, as BMP palette entries (B, G, R, 0).
+*/
+void pyramid_palette(unsigned char* palette) {
+    for (int i = 0; i < 256; i++) {
+        float t = i / 255.0f;
+        float h = 240.0f * (1.0f - t);
+        float l = 0.5f * fminf(1.0f, 2.0f * t);
+        float c = 1 - fabsf(2 * l - 1);
+        float x = c * (1 - fabsf(fmodf(h / 60.0f, 2) - 1));
+        float m = l - c / 2;
+        float r = 0, g = 0, b = 0;
+        if (h < 60) {
+            r = c; g = x;
+        } else if (h < 120) {
+            r = x; g = c;
+        } else if (h < 180) {
+            g = c; b = x;
+        } else {
+            g = x; b = c;
+        }
+        palette[4 * i + 0] = (unsigned char)((b + m) * 255);
+        palette[4 * i + 1] = (unsigned char)((g + m) * 255);
+        palette[4 * i + 2] = (unsigned char)((r + m) * 255);
+        palette[4 * i + 3] = 0;
+    }
+}
+
+/*
+    pyramid_write_tile: Writes the current tile of a level as a BMP of its
+    filled width. BMP rows run bottom-up, so row 0 (lowest frequency)
+    comes first.
+*/
+static void pyramid_write_tile(PyramidWriter* pyr, int level) {
+    PyramidLevel* lvl = &pyr->levels[level];
+    const int width = lvl->column;
+    const int stride = (width + 3) & ~3;
+    for (int y = 0; y < PYRAMID_ROWS; y++) {
+        unsigned char* out = &pyr->pixels[(size_t)y * stride];
+        for (int x = 0; x < width; x++) {
+            float v = (lvl->tile[(size_t)x * PYRAMID_ROWS + y] - PYRAMID_FLOOR_DB) / PYRAMID_RANGE_DB;
+            out[x] = (unsigned char)(fminf(fmaxf(v, 0.0f), 1.0f) * 255.0f);
+        }
+        memset(out + width, 0, stride - width);
+    }
+
+    unsigned char header[PYRAMID_BMP_HEADER] = {0};
+    const uint32_t image_bytes = (uint32_t)stride * PYRAMID_ROWS;
+    header[0] = 'B';
+    header[1] = 'M';
+    put_u32(header + 2, PYRAMID_BMP_HEADER + image_bytes);
+    put_u32(header + 10, PYRAMID_BMP_HEADER);
+    put_u32(header + 14, 40);
+    put_u32(header + 18, (uint32_t)width);
+    put_u32(header + 22, PYRAMID_ROWS);
+    put_u16(header + 26, 1);
+    put_u16(header + 28, 8);
+    put_u32(header + 34, image_bytes);
+    put_u32(header + 46, 256);
+    pyramid_palette(header + 54);
+
+    char path[1152];
+    snprintf(path, sizeof(path), "%s/z%02d_%06d.bmp", pyr->directory, level, lvl->tiles);
+    FILE* file = fopen(path, "wb");
+    if (!file || fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+        fwrite(pyr->pixels, 1, image_bytes, file) != image_bytes) {
+        pyr->failed = true;
+    }
+    if (file) {
+        fclose(file);
+    }
+    lvl->tiles++;
+    lvl->column = 0;
+}
+
+/*
+    pyramid_open: Allocates level 0 and the scratch buffers. The output
+    directory must exist.
+*/
+bool pyramid_open(PyramidWriter* pyr, const char* directory, int sample_rate, int fft_size, int hop,
+                  int bins, PyramidReduce reduce) {
+    memset(pyr, 0, sizeof(*pyr));
+    snprintf(pyr->directory, sizeof(pyr->directory), "%s", directory);
+    pyr->sample_rate = sample_rate;
+    pyr->fft_size = fft_size;
+    pyr->hop = hop;
+    pyr->bins = bins;
+    pyr->reduce = reduce;
+    pyr->column = malloc(sizeof(float) * PYRAMID_ROWS);
+    pyr->pixels = malloc((size_t)PYRAMID_TILE * PYRAMID_ROWS);
+    if (!pyr->column || !pyr->pixels) {
+        pyramid_close(pyr);
+        return false;
+    }
+    return true;
+}
+
+/*
+    pyramid_level: Returns a level, allocating it on first use.
+*/
+static PyramidLevel* pyramid_level(PyramidWriter* pyr, int level) {
+    if (level >= PYRAMID_MAX_LEVELS) {
+        return NULL;
+    }
+    PyramidLevel* lvl = &pyr->levels[level];
+    if (!lvl->tile) {
+        lvl->tile = malloc(sizeof(float) * PYRAMID_TILE * PYRAMID_ROWS);
+        lvl->pending = malloc(sizeof(float) * PYRAMID_ROWS);
+        if (!lvl->tile || !lvl->pending) {
+            free(lvl->tile);
+            free(lvl->pending);
+            lvl->tile = lvl->pending = NULL;
+            pyr->failed = true;
+            return NULL;
+        }
+        pyr->level_count = level + 1;
+    }
+    return lvl;
+}
+
+/*
+    pyramid_add: Appends a column to a level, writing the tile when it
+    fills, and pairs it with the pending column to feed the next level.
+*/
+static void pyramid_add(PyramidWriter* pyr, int level, const float* column) {
+    PyramidLevel* lvl = pyramid_level(pyr, level);
+    if (!lvl) {
+        return;
+    }
+    memcpy(&lvl->tile[(size_t)lvl->column * PYRAMID_ROWS], column, sizeof(float) * PYRAMID_ROWS);
+    lvl->column++;
+    lvl->total++;
+    if (lvl->column == PYRAMID_TILE) {
+        pyramid_write_tile(pyr, level);
+    }
+
+    if (!lvl->has_pending) {
+        memcpy(lvl->pending, column, sizeof(float) * PYRAMID_ROWS);
+        lvl->has_pending = true;
+        return;
+    }
+    for (int y = 0; y < PYRAMID_ROWS; y++) {
+        lvl->pending[y] = (pyr->reduce == PYRAMID_MAX) ? fmaxf(lvl->pending[y], column[y])
+                                                       : 0.5f * (lvl->pending[y] + column[y]);
+    }
+    lvl->has_pending = false;
+    pyramid_add(pyr, level + 1, lvl->pending);
+}
+
+/*
+    pyramid_push: Adds one frame. The bins are max-reduced onto the
+    pyramid's frequency rows so narrow peaks survive.
+*/
+void pyramid_push(PyramidWriter* pyr, const float* row_db) {
+    for (int y = 0; y < PYRAMID_ROWS; y++) {
+        int lo = (int)((long long)y * pyr->bins / PYRAMID_ROWS);
+        int hi = (int)((long long)(y + 1) * pyr->bins / PYRAMID_ROWS);
+        float peak = row_db[lo];
+        for (int k = lo + 1; k < hi; k++) {
+            peak = fmaxf(peak, row_db[k]);
+        }
+        pyr->column[y] = peak;
+    }
+    pyramid_add(pyr, 0, pyr->column);
+}
+
+/*
+    pyramid_close: Flushes every level bottom-up (an unpaired last column
+    moves up on its own), writes the partial tiles and pyramid.txt, and
+    releases the buffers. Returns false if any file could not be written.
+*/
+bool pyramid_close(PyramidWriter* pyr) {
+    const bool opened = pyr->column && pyr->pixels;
+    for (int level = 0; opened && level < pyr->level_count; level++) {
+        PyramidLevel* lvl = &pyr->levels[level];
+        if (lvl->has_pending && lvl->total > 1) {
+            lvl->has_pending = false;
+            pyramid_add(pyr, level + 1, lvl->pending);
+        }
+        if (lvl->column > 0) {
+            pyramid_write_tile(pyr, level);
+        }
+        if (lvl->total <= 1) {
+            pyr->level_count = level + 1;  // A single column: this is the top.
+        }
+    }
+
+    if (opened) {
+        char path[1152];
+        snprintf(path, sizeof(path), "%s/pyramid.txt", pyr->directory);
+        FILE* file = fopen(path, "w");
+        if (file) {
+            const double seconds_per_column = (double)pyr->hop / pyr->sample_rate;
+            fprintf(file, "tile %d\nrows %d\nsample_rate %d\nfft_size %d\nhop %d\nreduce %s\n"
+                    "floor_db %.1f\nrange_db %.1f\nlevels %d\n",
+                    PYRAMID_TILE, PYRAMID_ROWS, pyr->sample_rate, pyr->fft_size, pyr->hop,
+                    pyr->reduce == PYRAMID_MAX ? "max" : "mean", PYRAMID_FLOOR_DB, PYRAMID_RANGE_DB,
+                    pyr->level_count);
+            for (int level = 0; level < pyr->level_count; level++) {
+                fprintf(file, "level %d columns %llu tiles %d seconds_per_column %.6f\n", level,
+                        pyr->levels[level].total, pyr->levels[level].tiles,
+                        seconds_per_column * ((unsigned long long)1 << level));
+            }
+            pyr->failed |= (fclose(file) != 0);
+        } else {
+            pyr->failed = true;
+        }
+    }
+
+    bool ok = opened && !pyr->failed;
+    for (int level = 0; level < PYRAMID_MAX_LEVELS; level++) {
+        free(pyr->levels[level].tile);
+        free(pyr->levels[level].pending);
+    }
+    free(pyr->column);
+    free(pyr->pixels);
+    memset(pyr, 0, sizeof(*pyr));
+    return ok;
+}
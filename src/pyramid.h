@@ -0,0 +1,70 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stdbool.h>
+
+// Tile edge in pixels: columns are frames (time), rows are frequency.
+#define PYRAMID_TILE 256
+
+// Frequency rows of every level; bins are max-reduced onto them.
+#define PYRAMID_ROWS 256
+
+// Enough levels to halve 2^40 columns down to one.
+#define PYRAMID_MAX_LEVELS 41
+
+// Level range mapped onto the 256 palette entries, as in the spectrogram view.
+#define PYRAMID_FLOOR_DB -80.0f
+#define PYRAMID_RANGE_DB 80.0f
+
+/*
+    PyramidReduce: How two neighbouring columns merge into one of the next level.
+*/
+typedef enum {
+    PYRAMID_MAX,    // Keeps short events visible when zoomed out.
+    PYRAMID_MEAN    // Mean of the dB levels; smoother overview.
+} PyramidReduce;
+
+/*
+    PyramidLevel: The tile being filled on one level, plus the column
+    waiting for its partner on the way to the next level.
+*/
+typedef struct {
+    float* tile;                // PYRAMID_TILE columns x PYRAMID_ROWS, column-major.
+    int column;                 // Columns in the current tile.
+    int tiles;                  // Tiles written so far.
+    float* pending;
+    bool has_pending;
+    unsigned long long total;   // Columns pushed into this level.
+} PyramidLevel;
+
+/*
+    PyramidWriter: Streams rows of bar levels into a tiled, multi-resolution
+    spectrogram. Level 0 holds one column per frame; each further level
+    halves the time axis. A tile is written as soon as it is full, so only
+    one tile per level is held in memory however long the input runs.
+
+    Tiles are 8-bit palettised BMP files named z<level>_<index>.bmp in the
+    output directory, with low frequencies at the bottom. pyramid.txt
+    describes the levels. The final tile of a level may be narrower.
+*/
+typedef struct {
+    char directory[1024];
+    int bins;
+    PyramidReduce reduce;
+    int sample_rate;
+    int fft_size;
+    int hop;
+    int level_count;
+    PyramidLevel levels[PYRAMID_MAX_LEVELS];
+    float* column;              // Scratch: one row reduced onto PYRAMID_ROWS.
+    unsigned char* pixels;      // Scratch: one tile in BMP row order.
+    bool failed;                // A tile could not be written.
+} PyramidWriter;
+
+bool pyramid_open(PyramidWriter* pyr, const char* directory, int sample_rate, int fft_size, int hop,
+                  int bins, PyramidReduce reduce);
+void pyramid_push(PyramidWriter* pyr, const float* row_db);
+bool pyramid_close(PyramidWriter* pyr);
+void pyramid_palette(unsigned char* palette);
+
+#endif
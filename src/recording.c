@@ -0,0 +1,157 @@
+#include "recording.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+    recording_write_header: Writes the header with the current row count.
+*/
+static void recording_write_header(Recording* rec) {
+    unsigned char h[RECORDING_HEADER_BYTES] = {0};
+    memcpy(h, "AVSPEC01", 8);
+    put_u32(h + 8, (uint32_t)rec->sample_rate);
+    put_u32(h + 12, (uint32_t)rec->fft_size);
+    put_u32(h + 16, (uint32_t)rec->hop);
+    put_u32(h + 20, (uint32_t)rec->bins);
+    put_u32(h + 24, (uint32_t)rec->format);
+    put_u32(h + 28, (uint32_t)(rec->rows & 0xFFFFFFFFu));
+    put_u32(h + 32, (uint32_t)(rec->rows >> 32));
+    fwrite(h, 1, sizeof(h), rec->file);
+}
+
+/*
+    recording_open: Creates the file and writes a placeholder header.
+*/
+bool recording_open(Recording* rec, const char* path, int sample_rate, int fft_size, int hop,
+                    int bins, FrameFormat format) {
+    memset(rec, 0, sizeof(*rec));
+    rec->sample_rate = sample_rate;
+    rec->fft_size = fft_size;
+    rec->hop = hop;
+    rec->bins = bins;
+    rec->format = format;
+    rec->packed = malloc(compact_frame_bytes(format, bins));
+    rec->file = fopen(path, "wb");
+    if (!rec->packed || !rec->file) {
+        recording_close(rec);
+        return false;
+    }
+    recording_write_header(rec);
+    return true;
+}
+
+/*
+    recording_write: Encodes and appends one row of dB values.
+*/
+bool recording_write(Recording* rec, const float* row_db) {
+    compact_encode(rec->format, row_db, rec->packed, rec->bins);
+    return recording_write_packed(rec, rec->packed, 1);
+}
+
+/*
+    recording_write_packed: Appends rows that are already encoded.
+*/
+bool recording_write_packed(Recording* rec, const void* packed, int rows) {
+    size_t bytes = compact_frame_bytes(rec->format, rec->bins);
+    if (fwrite(packed, bytes, rows, rec->file) != (size_t)rows) {
+        return false;
+    }
+    rec->rows += rows;
+    return true;
+}
+
+/*
+    recording_close: Patches the row count into the header and closes the file.
+*/
+void recording_close(Recording* rec) {
+    if (rec->file) {
+        fseek(rec->file, 0, SEEK_SET);
+        recording_write_header(rec);
+        fclose(rec->file);
+        rec->file = NULL;
+    }
+    free(rec->packed);
+    rec->packed = NULL;
+}
+
+/*
+    recording_reader_open: Opens a recording and validates its header.
+*/
+bool recording_reader_open(RecordingReader* reader, const char* path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        return false;
+    }
+    unsigned char h[RECORDING_HEADER_BYTES];
+    if (fread(h, 1, sizeof(h), reader->file) != sizeof(h) || memcmp(h, "AVSPEC01", 8) != 0) {
+        recording_reader_close(reader);
+        return false;
+    }
+    reader->sample_rate = (int)get_u32(h + 8);
+    reader->fft_size = (int)get_u32(h + 12);
+    reader->hop = (int)get_u32(h + 16);
+    reader->bins = (int)get_u32(h + 20);
+    reader->format = (FrameFormat)get_u32(h + 24);
+    reader->rows = get_u32(h + 28) | ((unsigned long long)get_u32(h + 32) << 32);
+    if (reader->bins <= 0 || reader->hop <= 0 || reader->sample_rate <= 0 || reader->format > FRAME_DB8) {
+        recording_reader_close(reader);
+        return false;
+    }
+    reader->row_bytes = compact_frame_bytes(reader->format, reader->bins);
+    reader->packed = malloc(reader->row_bytes);
+    if (!reader->packed) {
+        recording_reader_close(reader);
+        return false;
+    }
+    return true;
+}
+
+/*
+    recording_reader_seek: Positions the reader before a row.
+*/
+bool recording_reader_seek(RecordingReader* reader, unsigned long long row) {
+    if (row > reader->rows) {
+        return false;
+    }
+    long long offset = RECORDING_HEADER_BYTES + (long long)(row * reader->row_bytes);
+#ifdef _WIN32
+    return _fseeki64(reader->file, offset, SEEK_SET) == 0;
+#else
+    return fseek(reader->file, (long)offset, SEEK_SET) == 0;
+#endif
+}
+
+/*
+    recording_reader_read: Reads and decodes the next row.
+*/
+bool recording_reader_read(RecordingReader* reader, float* row_db) {
+    if (fread(reader->packed, reader->row_bytes, 1, reader->file) != 1) {
+        return false;
+    }
+    compact_decode(reader->format, reader->packed, row_db, reader->bins);
+    return true;
+}
+
+/*
+    recording_reader_close: Closes the file and frees the row buffer.
+*/
+void recording_reader_close(RecordingReader* reader) {
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+    free(reader->packed);
+    reader->packed = NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "compact.h"
+
+// Size of the fixed file header that precedes the rows.
+#define RECORDING_HEADER_BYTES 64
+
+/*
+    Recording: A spectrogram written row by row, one row of bar levels (dB)
+    per hop, packed in a FrameFormat.
+
+    Layout (little-endian): "AVSPEC01", then u32 sample_rate, fft_size,
+    hop, bins, format, and a u64 row count patched in on close, padded to
+    RECORDING_HEADER_BYTES; rows of compact_frame_bytes(format, bins)
+    follow back to back.
+*/
+typedef struct {
+    FILE* file;
+    int sample_rate;
+    int fft_size;
+    int hop;
+    int bins;
+    FrameFormat format;
+    unsigned long long rows;
+    void* packed;              // One encoded row.
+} Recording;
+
+/*
+    RecordingReader: Random access to the rows of a recording file.
+*/
+typedef struct {
+    FILE* file;
+    int sample_rate;
+    int fft_size;
+    int hop;
+    int bins;
+    FrameFormat format;
+    unsigned long long rows;
+    size_t row_bytes;
+    void* packed;              // One encoded row.
+} RecordingReader;
+
+bool recording_open(Recording* rec, const char* path, int sample_rate, int fft_size, int hop,
+                    int bins, FrameFormat format);
+bool recording_write(Recording* rec, const float* row_db);
+bool recording_write_packed(Recording* rec, const void* packed, int rows);
+void recording_close(Recording* rec);
+
+bool recording_reader_open(RecordingReader* reader, const char* path);
+bool recording_reader_seek(RecordingReader* reader, unsigned long long row);
+bool recording_reader_read(RecordingReader* reader, float* row_db);
+void recording_reader_close(RecordingReader* reader);
+
+#endif
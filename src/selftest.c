@@ -0,0 +1,219 @@
+#include "selftest.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compact.h"
+#include "descriptors.h"
+#include "offline.h"
+#include "source.h"
+
+// Spectrum size the checks run at: the window's 4096-point FFT.
+#define SELFTEST_BINS 2049
+
+// dB values the compact formats are swept over: -200 to +200 dB in steps
+// of 1/256 dB. The count is odd so the scalar tails run after the SIMD loops.
+#define SELFTEST_COMPACT_VALUES 102401
+#define SELFTEST_COMPACT_STEP (1.0f / 256.0f)
+
+// Seconds of generated noise the batched STFT is compared over, and the
+// largest dB difference from the single-window transform accepted as
+// float rounding.
+#define SELFTEST_STFT_SECONDS 3.0
+#define SELFTEST_STFT_TOLERANCE_DB 1e-3
+
+/*
+    selftest_report: Prints one check's outcome and counts failures.
+*/
+static void selftest_report(int* failures, bool passed, const char* name, const char* detail) {
+    printf("%s %s: %s\n", passed ? "ok  " : "FAIL", name, detail);
+    *failures += !passed;
+}
+
+/*
+    selftest_flatness: A constant power spectrum, whatever its level, has
+    a geometric mean equal to its arithmetic mean, so flatness 1.
+*/
+static void selftest_flatness(int* failures) {
+    static const float levels[] = {1e-12f, 1e-3f, 0.37f, 1.0f, 250.0f};
+    float* power = malloc(sizeof(float) * SELFTEST_BINS);
+    DescriptorState desc;
+    if (!power || !descriptors_init(&desc, SELFTEST_BINS, 44100.0f / 4096, 0.85f)) {
+        free(power);
+        selftest_report(failures, false, "descriptors", "set-up failed");
+        return;
+    }
+    double worst = 0.0;
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        for (int k = 0; k < SELFTEST_BINS; k++) {
+            power[k] = levels[l];
+        }
+        SpectralFeatures f;
+        descriptors_compute(&desc, power, &f);
+        worst = fmax(worst, fabs(f.flatness - 1.0));
+    }
+    descriptors_free(&desc);
+    free(power);
+    char detail[96];
+    snprintf(detail, sizeof(detail), "flatness of constant spectra within %.1e of 1", worst);
+    selftest_report(failures, worst < 1e-3, "descriptors", detail);
+}
+
+/*
+    selftest_compact: Round-trips a sweep of dB values through both packed
+    formats and holds them to the bounds compact.h states. Every value is
+    also packed on its own, which takes the scalar path, and must give the
+    same bytes as the F16C or SSE2 loop that packed it in bulk.
+*/
+static void selftest_compact(int* failures) {
+    const int count = SELFTEST_COMPACT_VALUES;
+    float* values = malloc(sizeof(float) * count);
+    float* decoded = malloc(sizeof(float) * count);
+    uint8_t* packed = malloc(compact_frame_bytes(FRAME_FLOAT16, count));
+    if (!values || !decoded || !packed) {
+        free(values);
+        free(decoded);
+        free(packed);
+        selftest_report(failures, false, "compact", "set-up failed");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        values[i] = -200.0f + i * SELFTEST_COMPACT_STEP;
+    }
+
+    static const FrameFormat formats[] = {FRAME_FLOAT16, FRAME_DB8};
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        FrameFormat format = formats[f];
+        size_t bytes = compact_frame_bytes(format, 1);
+        compact_encode(format, values, packed, count);
+        compact_decode(format, packed, decoded, count);
+
+        double worst = 0.0;
+        int out_of_bound = 0;
+        int mismatched = 0;
+        for (int i = 0; i < count; i++) {
+            float v = values[i];
+            double error = fabs((double)decoded[i] - v);
+            if (format == FRAME_FLOAT16) {
+                // Half spacing is 2^-10 of the value; zero needs no rounding.
+                out_of_bound += (v != 0.0f && error > ldexp(fabs(v), -11));
+                if (fabsf(v) <= 100.0f) {
+                    worst = fmax(worst, error);
+                }
+            } else {
+                float top = COMPACT_DB8_MIN + 255 * COMPACT_DB8_STEP;
+                float expected = v < COMPACT_DB8_MIN ? COMPACT_DB8_MIN : (v > top ? top : v);
+                double clamped = fabs((double)decoded[i] - expected);
+                out_of_bound += clamped > 0.5 * COMPACT_DB8_STEP;
+                worst = fmax(worst, clamped);
+            }
+            uint8_t single[sizeof(uint16_t)];
+            compact_encode(format, &v, single, 1);
+            mismatched += memcmp(single, packed + i * bytes, bytes) != 0;
+        }
+
+        char detail[128];
+        if (format == FRAME_FLOAT16) {
+            snprintf(detail, sizeof(detail), "worst error %.4f dB within +/-100 dB, %d over 2^-11 of the value, "
+                     "%d differ from scalar", worst, out_of_bound, mismatched);
+            selftest_report(failures, !out_of_bound && !mismatched && worst <= 0.03125, "float16", detail);
+        } else {
+            snprintf(detail, sizeof(detail), "worst error %.4f dB after clamping, %d over half a step, "
+                     "%d differ from scalar", worst, out_of_bound, mismatched);
+            selftest_report(failures, !out_of_bound && !mismatched, "8-bit dB", detail);
+        }
+    }
+    free(values);
+    free(decoded);
+    free(packed);
+}
+
+/*
+    selftest_stft_rows: Runs the noise generator through an OfflineStft of
+    the given batch size and returns its dB rows, frames x bins, or NULL.
+*/
+static float* selftest_stft_rows(int batch, int* frames) {
+    const int fft_size = OFFLINE_DEFAULT_FFT_SIZE;
+    const int hop = fft_size / 2;
+    const int bins = fft_size / 2 + 1;
+    const int capacity = (int)(SELFTEST_STFT_SECONDS * OFFLINE_SAMPLE_RATE) / hop;
+    AudioSource src;
+    OfflineStft stft;
+    float* rows = malloc(sizeof(float) * capacity * bins);
+    if (!rows || !source_open(&src, SOURCE_NOISE, NULL, 0, OFFLINE_SAMPLE_RATE, 1, SELFTEST_STFT_SECONDS)) {
+        free(rows);
+        return NULL;
+    }
+    if (!offline_stft_init(&stft, fft_size, hop, batch)) {
+        source_close(&src);
+        free(rows);
+        return NULL;
+    }
+    *frames = 0;
+    int count;
+    while ((count = offline_stft_next(&stft, &src)) > 0 && *frames + count <= capacity) {
+        memcpy(rows + (size_t)*frames * bins, stft.row_db, sizeof(float) * count * bins);
+        *frames += count;
+    }
+    offline_stft_free(&stft);
+    source_close(&src);
+    return rows;
+}
+
+/*
+    selftest_batched_stft: The batched plan must give the rows the
+    one-window plan gives. FFTW may pick a different algorithm for each
+    plan shape, so the rows are held to float rounding, and the check
+    says whether they also came out bit for bit.
+*/
+static void selftest_batched_stft(int* failures) {
+    const int bins = OFFLINE_DEFAULT_FFT_SIZE / 2 + 1;
+    int frames = 0;
+    float* single = selftest_stft_rows(1, &frames);
+    static const int batches[] = {OFFLINE_DEFAULT_BATCH, OFFLINE_MAX_BATCH};
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        char name[32];
+        snprintf(name, sizeof(name), "stft batch %d", batches[b]);
+        int batched_frames = 0;
+        float* batched = single ? selftest_stft_rows(batches[b], &batched_frames) : NULL;
+        if (!batched || batched_frames != frames || frames == 0) {
+            free(batched);
+            selftest_report(failures, false, name, "set-up failed or frame counts differ");
+            continue;
+        }
+        double worst = 0.0;
+        size_t differing = 0;
+        const size_t total = (size_t)frames * bins;
+        for (size_t i = 0; i < total; i++) {
+            differing += memcmp(&single[i], &batched[i], sizeof(float)) != 0;
+            worst = fmax(worst, fabs((double)single[i] - batched[i]));
+        }
+        free(batched);
+        char detail[128];
+        if (differing == 0) {
+            snprintf(detail, sizeof(detail), "%d frames bit-identical to batch 1", frames);
+        } else {
+            snprintf(detail, sizeof(detail), "%zu of %zu values differ from batch 1, worst %.2e dB",
+                     differing, total, worst);
+        }
+        selftest_report(failures, worst <= SELFTEST_STFT_TOLERANCE_DB, name, detail);
+    }
+    free(single);
+}
+
+/*
+    selftest_run: --self-test entry point. Runs every check, prints one
+    line per check and fails if any of them does.
+*/
+int selftest_run(void) {
+    int failures = 0;
+    selftest_flatness(&failures);
+    selftest_compact(&failures);
+    selftest_batched_stft(&failures);
+    printf("%d check%s failed\n", failures, failures == 1 ? "" : "s");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,6 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+int selftest_run(void);
+
+#endif
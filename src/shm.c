@@ -0,0 +1,58 @@
+#include <windows.h>
+
+#include "shm.h"
+
+#include <string.h>
+
+/*
+    shm_open_writer: Creates the named mapping sized for the header and one row.
+*/
+bool shm_open_writer(SharedFrame* shm, const char* name, int sample_rate, int fft_size, int hop,
+                     int bins, FrameFormat format) {
+    memset(shm, 0, sizeof(*shm));
+    const DWORD size = (DWORD)(sizeof(SharedFrameHeader) + compact_frame_bytes(format, bins));
+    shm->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+    if (!shm->mapping) {
+        return false;
+    }
+    shm->header = (SharedFrameHeader*)MapViewOfFile(shm->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!shm->header) {
+        shm_close(shm);
+        return false;
+    }
+    shm->row = (unsigned char*)(shm->header + 1);
+    shm->format = format;
+    shm->bins = bins;
+
+    memset(shm->header, 0, size);
+    memcpy(shm->header->magic, "AVSHM01", 8);
+    shm->header->sample_rate = (unsigned int)sample_rate;
+    shm->header->fft_size = (unsigned int)fft_size;
+    shm->header->hop = (unsigned int)hop;
+    shm->header->bins = (unsigned int)bins;
+    shm->header->format = (unsigned int)format;
+    return true;
+}
+
+/*
+    shm_publish: Replaces the shared row under the seqlock.
+*/
+void shm_publish(SharedFrame* shm, const float* row_db) {
+    InterlockedIncrement64(&shm->header->sequence);
+    compact_encode(shm->format, row_db, shm->row, shm->bins);
+    MemoryBarrier();
+    InterlockedIncrement64(&shm->header->sequence);
+}
+
+/*
+    shm_close: Unmaps the view and releases the mapping.
+*/
+void shm_close(SharedFrame* shm) {
+    if (shm->header) {
+        UnmapViewOfFile(shm->header);
+    }
+    if (shm->mapping) {
+        CloseHandle(shm->mapping);
+    }
+    memset(shm, 0, sizeof(*shm));
+}
@@ -0,0 +1,44 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdbool.h>
+
+#include "compact.h"
+
+/*
+    SharedFrameHeader: Start of the shared-memory block; the latest row of
+    bins packed values follows it.
+
+    sequence is a seqlock: the writer makes it odd before touching the row
+    and even again afterwards. Readers copy the row, then accept it only if
+    sequence was even and unchanged across the copy.
+*/
+typedef struct {
+    char magic[8];                  // "AVSHM01".
+    unsigned int sample_rate;
+    unsigned int fft_size;
+    unsigned int hop;
+    unsigned int bins;
+    unsigned int format;            // FrameFormat of the row.
+    unsigned int reserved;
+    volatile long long sequence;
+} SharedFrameHeader;
+
+/*
+    SharedFrame: Named Windows file mapping (page-file backed) that other
+    processes open with OpenFileMapping to follow the analysis live.
+*/
+typedef struct {
+    void* mapping;
+    SharedFrameHeader* header;
+    unsigned char* row;
+    FrameFormat format;
+    int bins;
+} SharedFrame;
+
+bool shm_open_writer(SharedFrame* shm, const char* name, int sample_rate, int fft_size, int hop,
+                     int bins, FrameFormat format);
+void shm_publish(SharedFrame* shm, const float* row_db);
+void shm_close(SharedFrame* shm);
+
+#endif
@@ -0,0 +1,733 @@
+#include <SDL3/SDL.h>
+
+#include "similarity.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "recording.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMILARITY_SSE2 1
+#endif
+
+// Probe counts compared by --similar-bench.
+#define SIM_BENCH_PROBES 7
+
+// Longest probe list ranked per query.
+#define SIM_MAX_PROBE 256
+
+/*
+    SimilarityMel: Triangular mel filters over the bins of a recording,
+    each normalised to unit weight so a band is a weighted mean of row dB.
+*/
+typedef struct {
+    int first[SIM_BANDS];
+    int count[SIM_BANDS];
+    int offset[SIM_BANDS];      // Into weights.
+    float* weights;
+} SimilarityMel;
+
+/*
+    SimilarityBuild: Vectors collected from the listed recordings before
+    they are clustered and written.
+*/
+typedef struct {
+    float* vectors;
+    SimilarityEntry* entries;
+    int count;
+    int capacity;
+    char (*names)[SIM_NAME_BYTES];
+    SimilarityTrack* tracks;
+    int track_count;
+    double seconds;             // Recorded audio read, silent seconds included.
+} SimilarityBuild;
+
+static double mel_from_hz(double hz) {
+    return 2595.0 * log10(1.0 + hz / 700.0);
+}
+
+static double hz_from_mel(double mel) {
+    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+}
+
+/*
+    similarity_mel_init: Spaces SIM_BANDS filters evenly in mel between
+    SIM_MIN_HZ and SIM_MAX_HZ (or Nyquist). A filter narrower than a bin
+    still takes the bin nearest its centre.
+*/
+static bool similarity_mel_init(SimilarityMel* mel, int bins, float bin_hz) {
+    memset(mel, 0, sizeof(*mel));
+    const double top = fmin(SIM_MAX_HZ, (bins - 1) * bin_hz);
+    const double low = mel_from_hz(SIM_MIN_HZ);
+    const double step = (mel_from_hz(top) - low) / (SIM_BANDS + 1);
+    int total = 0;
+    for (int b = 0; b < SIM_BANDS; b++) {
+        const double hi = hz_from_mel(low + (b + 2) * step);
+        mel->first[b] = (int)ceil(hz_from_mel(low + b * step) / bin_hz);
+        mel->count[b] = SDL_max(1, (int)floor(hi / bin_hz) - mel->first[b] + 1);
+        total += mel->count[b];
+    }
+    mel->weights = malloc(sizeof(float) * total);
+    if (!mel->weights) {
+        return false;
+    }
+    int offset = 0;
+    for (int b = 0; b < SIM_BANDS; b++) {
+        const double lo = hz_from_mel(low + b * step);
+        const double center = hz_from_mel(low + (b + 1) * step);
+        const double hi = hz_from_mel(low + (b + 2) * step);
+        double sum = 0.0;
+        for (int i = 0; i < mel->count[b]; i++) {
+            const double hz = (mel->first[b] + i) * bin_hz;
+            double w = hz < center ? (hz - lo) / (center - lo) : (hi - hz) / (hi - center);
+            w = fmax(w, 0.0);
+            mel->weights[offset + i] = (float)w;
+            sum += w;
+        }
+        if (sum <= 0.0) {
+            // No bin inside the triangle: use the one nearest its centre.
+            mel->first[b] = SDL_min(bins - 1, (int)lround(center / bin_hz));
+            mel->count[b] = 1;
+            mel->weights[offset] = 1.0f;
+            sum = 1.0;
+        }
+        for (int i = 0; i < mel->count[b]; i++) {
+            mel->weights[offset + i] = (float)(mel->weights[offset + i] / sum);
+        }
+        mel->offset[b] = offset;
+        offset += mel->count[b];
+    }
+    return true;
+}
+
+/*
+    similarity_mel_add: Adds one row's band levels to sums.
+*/
+static void similarity_mel_add(const SimilarityMel* mel, const float* row_db, float* sums) {
+    for (int b = 0; b < SIM_BANDS; b++) {
+        const float* w = mel->weights + mel->offset[b];
+        const float* db = row_db + mel->first[b];
+        float level = 0.0f;
+        for (int i = 0; i < mel->count[b]; i++) {
+            level += w[i] * db[i];
+        }
+        sums[b] += level;
+    }
+}
+
+static void similarity_mel_free(SimilarityMel* mel) {
+    free(mel->weights);
+    memset(mel, 0, sizeof(*mel));
+}
+
+/*
+    similarity_vector: Turns the band sums of `frames` rows into a summary
+    vector: mean levels, less their own mean, at unit length. Returns false
+    for silent or spectrally flat seconds, which would match anything.
+*/
+static bool similarity_vector(const float* sums, int frames, float* out) {
+    float mean = 0.0f;
+    for (int b = 0; b < SIM_BANDS; b++) {
+        out[b] = sums[b] / frames;
+        mean += out[b];
+    }
+    mean /= SIM_BANDS;
+    if (mean < SIM_SILENCE_DB) {
+        return false;
+    }
+    float norm = 0.0f;
+    for (int b = 0; b < SIM_BANDS; b++) {
+        out[b] -= mean;
+        norm += out[b] * out[b];
+    }
+    if (norm < 1e-6f) {
+        return false;
+    }
+    norm = 1.0f / sqrtf(norm);
+    for (int b = 0; b < SIM_BANDS; b++) {
+        out[b] *= norm;
+    }
+    return true;
+}
+
+/*
+    similarity_frames_per_vector: Rows of a recording summarised by one vector.
+*/
+static int similarity_frames_per_vector(const RecordingReader* reader) {
+    return SDL_max(1, (int)lround(SIM_SECONDS_PER_VECTOR * reader->sample_rate / reader->hop));
+}
+
+/*
+    similarity_entry_seconds: Start time of an entry's first row.
+*/
+static double similarity_entry_seconds(const SimilarityIndex* index, const SimilarityEntry* entry) {
+    const SimilarityTrack* track = &index->tracks[entry->track];
+    return (double)entry->row * track->hop / track->sample_rate;
+}
+
+static float similarity_dot_scalar(const float* a, const float* b) {
+    float sum = 0.0f;
+    for (int d = 0; d < SIM_BANDS; d++) {
+        sum += a[d] * b[d];
+    }
+    return sum;
+}
+
+/*
+    similarity_keep: Inserts a result into hits, kept sorted by descending
+    score and at most k long.
+*/
+static void similarity_keep(SimilarityHit* hits, int* count, int k, float score, int index) {
+    if (*count == k && score <= hits[k - 1].score) {
+        return;
+    }
+    int slot = *count < k ? (*count)++ : k - 1;
+    while (slot > 0 && hits[slot - 1].score < score) {
+        hits[slot] = hits[slot - 1];
+        slot--;
+    }
+    hits[slot].score = score;
+    hits[slot].index = index;
+}
+
+/*
+    similarity_scan: Scores vectors [first, last) against the query. The
+    SSE2 kernel keeps the query in registers and splits each dot product
+    over two accumulators; the scalar loop is the benchmark's baseline.
+*/
+static void similarity_scan(const float* vectors, int first, int last, const float* query, bool simd,
+                            SimilarityHit* hits, int* count, int k) {
+#ifdef SIMILARITY_SSE2
+    if (simd) {
+        __m128 q[SIM_BANDS / 4];
+        for (int d = 0; d < SIM_BANDS / 4; d++) {
+            q[d] = _mm_loadu_ps(query + 4 * d);
+        }
+        for (int i = first; i < last; i++) {
+            const float* v = vectors + (size_t)i * SIM_BANDS;
+            __m128 s0 = _mm_mul_ps(q[0], _mm_loadu_ps(v));
+            __m128 s1 = _mm_mul_ps(q[1], _mm_loadu_ps(v + 4));
+            for (int d = 2; d < SIM_BANDS / 4; d += 2) {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(q[d], _mm_loadu_ps(v + 4 * d)));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(q[d + 1], _mm_loadu_ps(v + 4 * d + 4)));
+            }
+            s0 = _mm_add_ps(s0, s1);
+            s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+            s0 = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, _MM_SHUFFLE(1, 1, 1, 1)));
+            similarity_keep(hits, count, k, _mm_cvtss_f32(s0), i);
+        }
+        return;
+    }
+#endif
+    (void)simd;
+    for (int i = first; i < last; i++) {
+        similarity_keep(hits, count, k, similarity_dot_scalar(vectors + (size_t)i * SIM_BANDS, query), i);
+    }
+}
+
+/*
+    similarity_search: Finds the k vectors most similar to the query.
+    probe <= 0 (or at least list_count) scans every vector; otherwise only
+    the lists of the `probe` centroids nearest the query are scanned, which
+    can miss neighbours that were clustered elsewhere. Returns the number
+    of hits, best first.
+*/
+int similarity_search(const SimilarityIndex* index, const float* query, int probe, SimilarityHit* hits, int k) {
+    int count = 0;
+    if (probe <= 0 || probe >= index->list_count) {
+        similarity_scan(index->vectors, 0, index->count, query, true, hits, &count, k);
+        return count;
+    }
+    SimilarityHit lists[SIM_MAX_PROBE];
+    int list_count = 0;
+    probe = SDL_min(probe, SIM_MAX_PROBE);
+    similarity_scan(index->centroids, 0, index->list_count, query, true, lists, &list_count, probe);
+    for (int i = 0; i < list_count; i++) {
+        const int list = lists[i].index;
+        similarity_scan(index->vectors, (int)index->list_start[list], (int)index->list_start[list + 1],
+                        query, true, hits, &count, k);
+    }
+    return count;
+}
+
+/*
+    similarity_build_add: Appends one vector of a track.
+*/
+static bool similarity_build_add(SimilarityBuild* build, const float* vector, int track, unsigned long long row) {
+    if (build->count == build->capacity) {
+        int capacity = build->capacity ? build->capacity * 2 : 4096;
+        float* vectors = realloc(build->vectors, sizeof(float) * SIM_BANDS * capacity);
+        build->vectors = vectors ? vectors : build->vectors;
+        SimilarityEntry* entries = realloc(build->entries, sizeof(SimilarityEntry) * capacity);
+        build->entries = entries ? entries : build->entries;
+        if (!vectors || !entries) {
+            return false;
+        }
+        build->capacity = capacity;
+    }
+    memcpy(build->vectors + (size_t)build->count * SIM_BANDS, vector, sizeof(float) * SIM_BANDS);
+    build->entries[build->count].track = (uint32_t)track;
+    build->entries[build->count].row = (uint32_t)row;
+    build->count++;
+    return true;
+}
+
+/*
+    similarity_build_recording: Reads a recording once, summarising every
+    full run of frames_per_vector rows. An unreadable file is reported and
+    skipped; returns false only when memory runs out.
+*/
+static bool similarity_build_recording(SimilarityBuild* build, const char* path) {
+    RecordingReader reader;
+    if (!recording_reader_open(&reader, path)) {
+        fprintf(stderr, "%s: not a readable recording, skipped.\n", path);
+        return true;
+    }
+    SimilarityMel mel;
+    float* row = malloc(sizeof(float) * reader.bins);
+    bool ok = row && similarity_mel_init(&mel, reader.bins, (float)reader.sample_rate / reader.fft_size);
+    char (*names)[SIM_NAME_BYTES] = ok ? realloc(build->names, SIM_NAME_BYTES * (build->track_count + 1)) : NULL;
+    build->names = names ? names : build->names;
+    SimilarityTrack* tracks = names ? realloc(build->tracks, sizeof(SimilarityTrack) * (build->track_count + 1)) : NULL;
+    build->tracks = tracks ? tracks : build->tracks;
+    ok = ok && names && tracks;
+    if (ok) {
+        const int track = build->track_count++;
+        const int frames = similarity_frames_per_vector(&reader);
+        memset(build->names[track], 0, SIM_NAME_BYTES);
+        snprintf(build->names[track], SIM_NAME_BYTES, "%s", path);
+        memset(&build->tracks[track], 0, sizeof(SimilarityTrack));
+        build->tracks[track].sample_rate = (uint32_t)reader.sample_rate;
+        build->tracks[track].hop = (uint32_t)reader.hop;
+        build->tracks[track].rows_per_vector = (uint32_t)frames;
+
+        float sums[SIM_BANDS] = {0};
+        float vector[SIM_BANDS];
+        int filled = 0;
+        for (unsigned long long r = 0; ok && r < reader.rows; r++) {
+            if (!recording_reader_read(&reader, row)) {
+                fprintf(stderr, "%s: read failed at row %llu.\n", path, r);
+                break;
+            }
+            similarity_mel_add(&mel, row, sums);
+            if (++filled == frames) {
+                if (similarity_vector(sums, frames, vector)) {
+                    ok = similarity_build_add(build, vector, track, r + 1 - frames);
+                }
+                memset(sums, 0, sizeof(sums));
+                filled = 0;
+            }
+        }
+        build->seconds += (double)reader.rows * reader.hop / reader.sample_rate;
+        similarity_mel_free(&mel);
+    }
+    free(row);
+    recording_reader_close(&reader);
+    return ok;
+}
+
+/*
+    similarity_sample: The s-th of `samples` vectors spread evenly over the build.
+*/
+static const float* similarity_sample(const SimilarityBuild* build, int s, int samples) {
+    return build->vectors + (size_t)((long long)s * build->count / samples) * SIM_BANDS;
+}
+
+/*
+    similarity_train: Spherical k-means over an evenly strided sample of
+    the vectors. Centroids start on evenly spaced samples; a cluster left
+    empty is reseeded on another sample so every list stays in use.
+*/
+static bool similarity_train(const SimilarityBuild* build, int lists, float* centroids) {
+    const int samples = SDL_min(build->count, SIM_TRAIN_VECTORS);
+    double* sums = malloc(sizeof(double) * SIM_BANDS * lists);
+    int* sizes = malloc(sizeof(int) * lists);
+    if (!sums || !sizes) {
+        free(sums);
+        free(sizes);
+        return false;
+    }
+    for (int c = 0; c < lists; c++) {
+        memcpy(centroids + (size_t)c * SIM_BANDS, similarity_sample(build, (int)((long long)c * samples / lists), samples), sizeof(float) * SIM_BANDS);
+    }
+    for (int iteration = 0; iteration < SIM_KMEANS_ITERATIONS; iteration++) {
+        memset(sums, 0, sizeof(double) * SIM_BANDS * lists);
+        memset(sizes, 0, sizeof(int) * lists);
+        for (int s = 0; s < samples; s++) {
+            const float* v = similarity_sample(build, s, samples);
+            SimilarityHit best;
+            int found = 0;
+            similarity_scan(centroids, 0, lists, v, true, &best, &found, 1);
+            double* sum = sums + (size_t)best.index * SIM_BANDS;
+            for (int d = 0; d < SIM_BANDS; d++) {
+                sum[d] += v[d];
+            }
+            sizes[best.index]++;
+        }
+        for (int c = 0; c < lists; c++) {
+            float* centroid = centroids + (size_t)c * SIM_BANDS;
+            const double* sum = sums + (size_t)c * SIM_BANDS;
+            double norm = 0.0;
+            for (int d = 0; d < SIM_BANDS; d++) {
+                norm += sum[d] * sum[d];
+            }
+            if (sizes[c] == 0 || norm <= 0.0) {
+                const int s = (int)(((long long)c * 7919 + iteration * 104729LL) % samples);
+                memcpy(centroid, similarity_sample(build, s, samples), sizeof(float) * SIM_BANDS);
+                continue;
+            }
+            norm = 1.0 / sqrt(norm);
+            for (int d = 0; d < SIM_BANDS; d++) {
+                centroid[d] = (float)(sum[d] * norm);
+            }
+        }
+    }
+    free(sums);
+    free(sizes);
+    return true;
+}
+
+/*
+    similarity_write: Clusters the collected vectors, groups them by list
+    with a counting sort and writes the index. Returns the file size in
+    *bytes.
+*/
+static bool similarity_write(const SimilarityBuild* build, const char* path, int* list_count, uint64_t* bytes) {
+    const int lists = SDL_max(1, SDL_min(SIM_MAX_LISTS, (int)lround(sqrt((double)build->count))));
+    float* centroids = malloc(sizeof(float) * SIM_BANDS * lists);
+    uint32_t* list_start = calloc(lists + 1, sizeof(uint32_t));
+    int* assigned = malloc(sizeof(int) * build->count);
+    float* vectors = malloc(sizeof(float) * SIM_BANDS * build->count);
+    SimilarityEntry* entries = malloc(sizeof(SimilarityEntry) * build->count);
+    FILE* file = NULL;
+    bool ok = centroids && list_start && assigned && vectors && entries &&
+              similarity_train(build, lists, centroids);
+    if (ok) {
+        for (int i = 0; i < build->count; i++) {
+            SimilarityHit best;
+            int found = 0;
+            similarity_scan(centroids, 0, lists, build->vectors + (size_t)i * SIM_BANDS, true, &best, &found, 1);
+            assigned[i] = best.index;
+            list_start[best.index + 1]++;
+        }
+        for (int c = 0; c < lists; c++) {
+            list_start[c + 1] += list_start[c];
+        }
+        // Reuse the upper offsets as fill cursors, then restore them.
+        for (int i = 0; i < build->count; i++) {
+            const uint32_t slot = list_start[assigned[i]]++;
+            memcpy(vectors + (size_t)slot * SIM_BANDS, build->vectors + (size_t)i * SIM_BANDS,
+                   sizeof(float) * SIM_BANDS);
+            entries[slot] = build->entries[i];
+        }
+        for (int c = lists; c > 0; c--) {
+            list_start[c] = list_start[c - 1];
+        }
+        list_start[0] = 0;
+
+        SimilarityFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "AVSIM002", 8);
+        header.dims = SIM_BANDS;
+        header.vector_count = (uint32_t)build->count;
+        header.list_count = (uint32_t)lists;
+        header.track_count = (uint32_t)build->track_count;
+        file = fopen(path, "wb");
+        ok = file &&
+             fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(centroids, sizeof(float) * SIM_BANDS, lists, file) == (size_t)lists &&
+             fwrite(list_start, sizeof(uint32_t), lists + 1, file) == (size_t)lists + 1 &&
+             fwrite(entries, sizeof(SimilarityEntry), build->count, file) == (size_t)build->count &&
+             fwrite(vectors, sizeof(float) * SIM_BANDS, build->count, file) == (size_t)build->count &&
+             fwrite(build->names, SIM_NAME_BYTES, build->track_count, file) == (size_t)build->track_count &&
+             fwrite(build->tracks, sizeof(SimilarityTrack), build->track_count, file) == (size_t)build->track_count;
+        *list_count = lists;
+        *bytes = sizeof(header) + sizeof(float) * SIM_BANDS * lists + sizeof(uint32_t) * (lists + 1) +
+                 (sizeof(SimilarityEntry) + sizeof(float) * SIM_BANDS) * (uint64_t)build->count +
+                 (uint64_t)(SIM_NAME_BYTES + sizeof(SimilarityTrack)) * build->track_count;
+    }
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+    free(centroids);
+    free(list_start);
+    free(assigned);
+    free(vectors);
+    free(entries);
+    return ok;
+}
+
+/*
+    similarity_load: Reads a whole index into memory and checks that its
+    lists cover exactly its vectors.
+*/
+bool similarity_load(SimilarityIndex* index, const char* path) {
+    memset(index, 0, sizeof(*index));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    SimilarityFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, "AVSIM002", 8) == 0 && header.dims == SIM_BANDS &&
+              header.list_count >= 1 && header.list_count <= SIM_MAX_LISTS &&
+              header.vector_count <= INT32_MAX && header.track_count <= INT32_MAX;
+    if (ok) {
+        index->dims = (int)header.dims;
+        index->count = (int)header.vector_count;
+        index->list_count = (int)header.list_count;
+        index->track_count = (int)header.track_count;
+        index->centroids = malloc(sizeof(float) * SIM_BANDS * index->list_count);
+        index->list_start = malloc(sizeof(uint32_t) * (index->list_count + 1));
+        index->entries = malloc(sizeof(SimilarityEntry) * SDL_max(1, index->count));
+        index->vectors = malloc(sizeof(float) * SIM_BANDS * SDL_max(1, index->count));
+        index->names = malloc((size_t)SIM_NAME_BYTES * SDL_max(1, index->track_count));
+        index->tracks = malloc(sizeof(SimilarityTrack) * SDL_max(1, index->track_count));
+        ok = index->centroids && index->list_start && index->entries && index->vectors && index->names &&
+             index->tracks &&
+             fread(index->centroids, sizeof(float) * SIM_BANDS, index->list_count, file) == (size_t)index->list_count &&
+             fread(index->list_start, sizeof(uint32_t), index->list_count + 1, file) == (size_t)index->list_count + 1 &&
+             fread(index->entries, sizeof(SimilarityEntry), index->count, file) == (size_t)index->count &&
+             fread(index->vectors, sizeof(float) * SIM_BANDS, index->count, file) == (size_t)index->count &&
+             fread(index->names, SIM_NAME_BYTES, index->track_count, file) == (size_t)index->track_count &&
+             fread(index->tracks, sizeof(SimilarityTrack), index->track_count, file) == (size_t)index->track_count;
+    }
+    for (int c = 0; ok && c < index->list_count; c++) {
+        ok = index->list_start[c] <= index->list_start[c + 1];
+    }
+    ok = ok && index->list_start[0] == 0 && index->list_start[index->list_count] == (uint32_t)index->count;
+    for (int i = 0; ok && i < index->count; i++) {
+        ok = index->entries[i].track < (uint32_t)index->track_count;
+    }
+    for (int t = 0; ok && t < index->track_count; t++) {
+        index->names[t][SIM_NAME_BYTES - 1] = '\0';
+        ok = index->tracks[t].sample_rate > 0 && index->tracks[t].hop > 0;
+    }
+    fclose(file);
+    if (!ok) {
+        similarity_free(index);
+    }
+    return ok;
+}
+
+void similarity_free(SimilarityIndex* index) {
+    free(index->centroids);
+    free(index->list_start);
+    free(index->entries);
+    free(index->vectors);
+    free(index->names);
+    free(index->tracks);
+    memset(index, 0, sizeof(*index));
+}
+
+/*
+    similarity_build: --similar-build entry point. Summarises every listed
+    recording, clusters the vectors and writes the index.
+*/
+static int similarity_build(const CliOptions* options) {
+    char** paths = NULL;
+    const int path_count = batch_read_list(options->similar_build, &paths);
+    if (path_count < 0) {
+        fprintf(stderr, "Failed to read the recording list %s.\n", options->similar_build);
+        return EXIT_FAILURE;
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    SimilarityBuild build = {0};
+    bool ok = true;
+    for (int i = 0; ok && i < path_count; i++) {
+        ok = similarity_build_recording(&build, paths[i]);
+    }
+    if (ok && build.count == 0) {
+        fprintf(stderr, "No audible seconds in the listed recordings.\n");
+        ok = false;
+    }
+    int lists = 0;
+    uint64_t bytes = 0;
+    if (ok && !similarity_write(&build, options->similar_path, &lists, &bytes)) {
+        fprintf(stderr, "Failed to write the similarity index %s.\n", options->similar_path);
+        ok = false;
+    }
+    if (ok) {
+        const double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+        fprintf(stderr, "Similarity: %d vectors from %d recordings (%.2f h) in %d lists, %.1f MiB, "
+                "built in %.2f s\n", build.count, build.track_count, build.seconds / 3600.0, lists,
+                bytes / 1048576.0, seconds);
+    }
+    for (int i = 0; i < path_count; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+    free(build.vectors);
+    free(build.entries);
+    free(build.names);
+    free(build.tracks);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+    similarity_query_vector: Summary vector of a recording at `second`,
+    computed as when building: the run of frames_per_vector rows that
+    contains the row nearest it, starting on a multiple of that length,
+    so a time printed for an indexed vector finds that vector again.
+*/
+static bool similarity_query_vector(const char* path, double second, float* vector) {
+    RecordingReader reader;
+    if (!recording_reader_open(&reader, path)) {
+        fprintf(stderr, "%s: not a readable recording.\n", path);
+        return false;
+    }
+    SimilarityMel mel;
+    const int frames = similarity_frames_per_vector(&reader);
+    const unsigned long long row_at = (unsigned long long)llround(SDL_max(0.0, second) * reader.sample_rate / reader.hop);
+    const unsigned long long first = row_at / frames * frames;
+    second = (double)first * reader.hop / reader.sample_rate;
+    float* row = malloc(sizeof(float) * reader.bins);
+    bool ok = row && similarity_mel_init(&mel, reader.bins, (float)reader.sample_rate / reader.fft_size);
+    if (ok) {
+        float sums[SIM_BANDS] = {0};
+        ok = first + frames <= reader.rows && recording_reader_seek(&reader, first);
+        for (int r = 0; ok && r < frames; r++) {
+            ok = recording_reader_read(&reader, row);
+            if (ok) {
+                similarity_mel_add(&mel, row, sums);
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "%s: no full second at %.2f s.\n", path, second);
+        } else if (!similarity_vector(sums, frames, vector)) {
+            fprintf(stderr, "%s: %.2f s is too quiet to search for.\n", path, second);
+            ok = false;
+        }
+        similarity_mel_free(&mel);
+    }
+    free(row);
+    recording_reader_close(&reader);
+    return ok;
+}
+
+/*
+    similarity_query: --similar-query entry point. Prints the nearest
+    seconds as CSV and the search latency to stderr.
+*/
+static int similarity_query(const SimilarityIndex* index, const CliOptions* options) {
+    char path[SIM_NAME_BYTES];
+    snprintf(path, sizeof(path), "%s", options->similar_query);
+    double second = 0.0;
+    char* at = strrchr(path, '@');
+    if (at) {
+        *at = '\0';
+        second = atof(at + 1);
+    }
+    float query[SIM_BANDS];
+    if (!similarity_query_vector(path, second, query)) {
+        return EXIT_FAILURE;
+    }
+    SimilarityHit hits[SIM_TOP_K];
+    Uint64 start = SDL_GetPerformanceCounter();
+    const int count = similarity_search(index, query, options->similar_probe, hits, SIM_TOP_K);
+    const double ms = 1000.0 * (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    printf("rank,score,track,time_s\n");
+    for (int i = 0; i < count; i++) {
+        const SimilarityEntry* e = &index->entries[hits[i].index];
+        printf("%d,%.4f,\"%s\",%.3f\n", i + 1, hits[i].score, index->names[e->track],
+               similarity_entry_seconds(index, e));
+    }
+    if (options->similar_probe > 0 && options->similar_probe < index->list_count) {
+        fprintf(stderr, "Searched %d of %d lists of %d vectors in %.3f ms\n",
+                SDL_min(options->similar_probe, SIM_MAX_PROBE), index->list_count, index->count, ms);
+    } else {
+        fprintf(stderr, "Searched all %d vectors in %.3f ms\n", index->count, ms);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+    similarity_bench: --similar-bench entry point. Queries with vectors
+    sampled evenly from the index itself, times the scalar and SSE2 exact
+    scans, then measures each probe count's recall@k against the exact
+    results and its mean latency.
+*/
+static int similarity_bench(const SimilarityIndex* index) {
+    const int queries = SDL_min(SIM_BENCH_QUERIES, index->count);
+    const int k = SDL_min(SIM_TOP_K, index->count);
+    SimilarityHit* exact = malloc(sizeof(SimilarityHit) * SIM_TOP_K * queries);
+    if (!exact || queries == 0) {
+        free(exact);
+        return EXIT_FAILURE;
+    }
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    printf("method,lists_probed,recall_at_%d,mean_ms,queries_per_s\n", k);
+
+    for (int simd = 0; simd < 2; simd++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < queries; q++) {
+            const float* query = index->vectors + (size_t)((long long)q * index->count / queries) * SIM_BANDS;
+            int count = 0;
+            similarity_scan(index->vectors, 0, index->count, query, simd != 0, exact + q * SIM_TOP_K, &count, k);
+        }
+        const double seconds = (SDL_GetPerformanceCounter() - start) / frequency;
+#ifndef SIMILARITY_SSE2
+        if (simd) {
+            break;
+        }
+#endif
+        printf("%s,%d,1.0000,%.4f,%.0f\n", simd ? "exact_sse2" : "exact_scalar", index->list_count,
+               1000.0 * seconds / queries, queries / seconds);
+    }
+
+    static const int probes[SIM_BENCH_PROBES] = {1, 2, 4, 8, 16, 32, 64};
+    for (int p = 0; p < SIM_BENCH_PROBES && probes[p] < index->list_count; p++) {
+        SimilarityHit hits[SIM_TOP_K];
+        long long found = 0;
+        Uint64 elapsed = 0;
+        for (int q = 0; q < queries; q++) {
+            const float* query = index->vectors + (size_t)((long long)q * index->count / queries) * SIM_BANDS;
+            Uint64 start = SDL_GetPerformanceCounter();
+            const int count = similarity_search(index, query, probes[p], hits, k);
+            elapsed += SDL_GetPerformanceCounter() - start;
+            for (int i = 0; i < count; i++) {
+                for (int j = 0; j < k; j++) {
+                    if (hits[i].index == exact[q * SIM_TOP_K + j].index) {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        const double seconds = elapsed / frequency;
+        printf("ivf,%d,%.4f,%.4f,%.0f\n", probes[p], (double)found / ((long long)queries * k),
+               1000.0 * seconds / queries, seconds > 0 ? queries / seconds : 0.0);
+    }
+    double indexed = 0.0;
+    for (int i = 0; i < index->count; i++) {
+        const SimilarityTrack* track = &index->tracks[index->entries[i].track];
+        indexed += (double)track->rows_per_vector * track->hop / track->sample_rate;
+    }
+    fprintf(stderr, "Benchmarked %d queries over %d vectors (%.2f h indexed) in %d lists\n",
+            queries, index->count, indexed / 3600.0, index->list_count);
+    free(exact);
+    return EXIT_SUCCESS;
+}
+
+/*
+    similarity_run: --similar entry point; builds, queries or benchmarks
+    the index at options->similar_path.
+*/
+int similarity_run(const CliOptions* options) {
+    if (options->similar_build) {
+        return similarity_build(options);
+    }
+    SimilarityIndex index;
+    if (!similarity_load(&index, options->similar_path)) {
+        fprintf(stderr, "Failed to load the similarity index %s.\n", options->similar_path);
+        return EXIT_FAILURE;
+    }
+    int status = options->similar_bench ? similarity_bench(&index) : similarity_query(&index, options);
+    similarity_free(&index);
+    return status;
+}
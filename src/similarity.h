@@ -0,0 +1,107 @@
+#ifndef SIMILARITY_H
+#define SIMILARITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cli.h"
+
+// Mel bands of a summary vector; a multiple of 8 for the SIMD kernels.
+#define SIM_BANDS 32
+
+// Mel filterbank range.
+#define SIM_MIN_HZ 50.0f
+#define SIM_MAX_HZ 8000.0f
+
+// Audio summarised by one vector, rounded to a whole number of rows.
+#define SIM_SECONDS_PER_VECTOR 1.0
+
+// Seconds quieter than this (mean band level; the rows floor at -60) are not indexed.
+#define SIM_SILENCE_DB -55.0f
+
+// Inverted lists: about sqrt(vectors) of them, trained by spherical
+// k-means on at most SIM_TRAIN_VECTORS vectors.
+#define SIM_MAX_LISTS 4096
+#define SIM_TRAIN_VECTORS 65536
+#define SIM_KMEANS_ITERATIONS 10
+
+// Neighbours returned per query, and queries sampled by --similar-bench.
+#define SIM_TOP_K 10
+#define SIM_BENCH_QUERIES 200
+
+// Recordings are identified by the path they were indexed from.
+#define SIM_NAME_BYTES 256
+
+/*
+    SimilarityEntry: Where a vector came from: its track and the first
+    recording row it summarises.
+*/
+typedef struct {
+    uint32_t track;
+    uint32_t row;
+} SimilarityEntry;
+
+/*
+    SimilarityTrack: Timing of an indexed recording, which turns an
+    entry's row back into seconds.
+*/
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t hop;
+    uint32_t rows_per_vector;
+    uint32_t reserved;
+} SimilarityTrack;
+
+/*
+    SimilarityHit: One search result; index is the vector's position.
+*/
+typedef struct {
+    float score;            // Cosine similarity.
+    int index;
+} SimilarityHit;
+
+/*
+    SimilarityFileHeader: Start of an index file, followed by the
+    centroids, list_count + 1 list offsets, the entries, the vectors
+    (grouped by list), the track names and the track timings.
+*/
+typedef struct {
+    char magic[8];          // "AVSIM002".
+    uint32_t dims;
+    uint32_t vector_count;
+    uint32_t list_count;
+    uint32_t track_count;
+    char reserved[40];
+} SimilarityFileHeader;
+
+/*
+    SimilarityIndex: Per-second mel summaries of a set of recordings.
+
+    Every vector is the mean log-mel spectrum of the whole number of rows
+    nearest one second (22 rows or 1.02 s at 44.1 kHz and hop 2048), with
+    its own mean removed and scaled to unit length, so a dot product is the cosine
+    similarity of spectral shape regardless of level. Vectors are stored
+    grouped by their nearest centroid: an exact search scans them all, an
+    approximate (IVF) one only the lists of the centroids closest to the
+    query.
+*/
+typedef struct {
+    int dims;
+    int count;
+    int list_count;
+    int track_count;
+    float* centroids;       // list_count x dims.
+    uint32_t* list_start;   // list_count + 1 offsets into entries/vectors.
+    SimilarityEntry* entries;
+    float* vectors;         // count x dims.
+    char (*names)[SIM_NAME_BYTES];
+    SimilarityTrack* tracks;
+} SimilarityIndex;
+
+bool similarity_load(SimilarityIndex* index, const char* path);
+int similarity_search(const SimilarityIndex* index, const float* query, int probe, SimilarityHit* hits, int k);
+void similarity_free(SimilarityIndex* index);
+
+int similarity_run(const CliOptions* options);
+
+#endif
@@ -0,0 +1,139 @@
+#include "source.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Sweep range in Hz and its period when the generator is endless.
+#define SWEEP_START_HZ 20.0
+#define SWEEP_END_HZ 20000.0
+#define SWEEP_DEFAULT_SECONDS 10.0
+
+// Generator peak level, leaving headroom below full scale.
+#define GENERATOR_AMPLITUDE 0.5
+
+/*
+    source_parse: Splits a --source argument: "device", "file:PATH",
+    "sine[:HZ]", "noise" or "sweep".
+*/
+bool source_parse(const char* spec, SourceType* type, const char** path, double* frequency) {
+    *path = NULL;
+    if (strcmp(spec, "device") == 0) {
+        *type = SOURCE_DEVICE;
+    } else if (strncmp(spec, "file:", 5) == 0 && spec[5] != '\0') {
+        *type = SOURCE_FILE;
+        *path = spec + 5;
+    } else if (strcmp(spec, "sine") == 0) {
+        *type = SOURCE_SINE;
+    } else if (strncmp(spec, "sine:", 5) == 0) {
+        char* end;
+        *type = SOURCE_SINE;
+        *frequency = strtod(spec + 5, &end);
+        return *end == '\0' && *frequency > 0;
+    } else if (strcmp(spec, "noise") == 0) {
+        *type = SOURCE_NOISE;
+    } else if (strcmp(spec, "sweep") == 0) {
+        *type = SOURCE_SWEEP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+    source_open: Opens a file or sets up a generator. A file keeps its own
+    rate and channel count; generators use the given ones.
+*/
+bool source_open(AudioSource* src, SourceType type, const char* path, double frequency,
+                 int sample_rate, int channels, double duration_seconds) {
+    memset(src, 0, sizeof(*src));
+    src->type = type;
+    src->sample_rate = sample_rate;
+    src->channels = channels;
+    src->frequency = frequency;
+    src->noise_state = 0x9E3779B9u;
+    src->duration_frames = (unsigned long long)(duration_seconds * sample_rate);
+
+    if (type == SOURCE_FILE) {
+        if (!wav_reader_open(&src->wav, path)) {
+            return false;
+        }
+        src->sample_rate = src->wav.sample_rate;
+        src->channels = src->wav.channels;
+    }
+    return type != SOURCE_DEVICE;
+}
+
+/*
+    source_read: Reads up to frames interleaved frames; returns the number
+    read, 0 at the end of a file or of a bounded generator.
+*/
+int source_read(AudioSource* src, float* samples, int frames) {
+    if (src->type == SOURCE_FILE) {
+        return wav_read(&src->wav, samples, frames);
+    }
+    if (src->duration_frames) {
+        unsigned long long left = src->duration_frames - src->frames_generated;
+        if ((unsigned long long)frames > left) {
+            frames = (int)left;
+        }
+    }
+
+    const double fs = src->sample_rate;
+    const double sweep_frames = (src->duration_frames ? src->duration_frames : SWEEP_DEFAULT_SECONDS * fs);
+    const double sweep_rate = log(SWEEP_END_HZ / SWEEP_START_HZ) / sweep_frames;
+    for (int i = 0; i < frames; i++) {
+        double value;
+        if (src->type == SOURCE_NOISE) {
+            uint32_t x = src->noise_state;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            src->noise_state = x;
+            value = (x / 4294967296.0) * 2.0 - 1.0;
+        } else {
+            double hz = src->frequency;
+            if (src->type == SOURCE_SWEEP) {
+                double t = fmod((double)src->frames_generated, sweep_frames);
+                hz = SWEEP_START_HZ * exp(sweep_rate * t);
+            }
+            value = sin(2 * M_PI * src->phase);
+            src->phase += hz / fs;
+            src->phase -= floor(src->phase);
+        }
+        for (int c = 0; c < src->channels; c++) {
+            samples[i * src->channels + c] = (float)(GENERATOR_AMPLITUDE * value);
+        }
+        src->frames_generated++;
+    }
+    return frames;
+}
+
+/*
+    source_seek: Moves a file source to a frame. Generators carry phase and
+    noise state from frame to frame and cannot seek.
+*/
+bool source_seek(AudioSource* src, unsigned long long frame) {
+    return src->type == SOURCE_FILE && wav_reader_seek(&src->wav, (unsigned long)frame);
+}
+
+/*
+    source_length_seconds: Length of a file or bounded generator; 0 if endless.
+*/
+double source_length_seconds(const AudioSource* src) {
+    if (src->type == SOURCE_FILE) {
+        return (double)src->wav.frames / src->sample_rate;
+    }
+    return (double)src->duration_frames / src->sample_rate;
+}
+
+/*
+    source_close: Closes a file source.
+*/
+void source_close(AudioSource* src) {
+    wav_reader_close(&src->wav);
+}
@@ -0,0 +1,47 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "wav.h"
+
+/*
+    SourceType: Where analysed audio comes from.
+*/
+typedef enum {
+    SOURCE_DEVICE,     // Default recording device (window mode only).
+    SOURCE_FILE,       // WAV file.
+    SOURCE_SINE,       // Generators: a sine, white noise or a log sweep.
+    SOURCE_NOISE,
+    SOURCE_SWEEP
+} SourceType;
+
+/*
+    AudioSource: File or generator input read as interleaved float frames.
+    Generators produce the same signal on every channel; duration_frames
+    bounds them (0 = endless) and a sweep repeats with that period, or
+    every ten seconds when endless.
+*/
+typedef struct {
+    SourceType type;
+    int sample_rate;
+    int channels;
+    WavReader wav;
+
+    double frequency;          // Sine frequency in Hz.
+    double phase;              // Generator phase in cycles.
+    uint32_t noise_state;      // xorshift32 state.
+    unsigned long long duration_frames;
+    unsigned long long frames_generated;
+} AudioSource;
+
+bool source_parse(const char* spec, SourceType* type, const char** path, double* frequency);
+bool source_open(AudioSource* src, SourceType type, const char* path, double frequency,
+                 int sample_rate, int channels, double duration_seconds);
+int source_read(AudioSource* src, float* samples, int frames);
+bool source_seek(AudioSource* src, unsigned long long frame);
+double source_length_seconds(const AudioSource* src);
+void source_close(AudioSource* src);
+
+#endif
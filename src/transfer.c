@@ -0,0 +1,149 @@
+#include "transfer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+    transfer_init: Allocates the batched FFT buffers and creates the plan.
+    Must run before other threads start planning.
+*/
+bool transfer_init(TransferState* tf, int fft_size, int depth) {
+    memset(tf, 0, sizeof(*tf));
+    tf->fft_size = fft_size;
+    tf->bins = fft_size / 2 + 1;
+
+    tf->input = fftwf_alloc_real(2 * (size_t)fft_size);
+    tf->spectra = fftwf_alloc_complex(2 * (size_t)tf->bins);
+    tf->window = malloc(sizeof(float) * fft_size);
+    tf->magnitude_db = calloc(tf->bins, sizeof(float));
+    tf->phase_deg = calloc(tf->bins, sizeof(float));
+    tf->coherence = calloc(tf->bins, sizeof(float));
+    if (!tf->input || !tf->spectra || !tf->window || !tf->magnitude_db ||
+        !tf->phase_deg || !tf->coherence || !transfer_set_depth(tf, depth)) {
+        transfer_free(tf);
+        return false;
+    }
+
+    for (int i = 0; i < fft_size; i++) {
+        tf->window[i] = 0.5f * (1 - cosf(2 * (float)M_PI * i / (fft_size - 1)));
+    }
+
+    const int n[] = { fft_size };
+    tf->plan = fftwf_plan_many_dft_r2c(1, n, 2, tf->input, NULL, 1, fft_size,
+                                       tf->spectra, NULL, 1, tf->bins, FFTW_MEASURE);
+    if (!tf->plan) {
+        transfer_free(tf);
+        return false;
+    }
+    memset(tf->input, 0, sizeof(float) * 2 * fft_size);
+    return true;
+}
+
+/*
+    transfer_input: Buffer the caller fills with fft_size samples of a channel
+    (0 = reference, 1 = measurement) before calling transfer_process.
+*/
+float* transfer_input(TransferState* tf, int channel) {
+    return &tf->input[(size_t)channel * tf->fft_size];
+}
+
+/*
+    transfer_set_depth: Changes the averaging depth and restarts the average.
+*/
+bool transfer_set_depth(TransferState* tf, int depth) {
+    float* history = malloc(sizeof(float) * 4 * (size_t)tf->bins * depth);
+    double* sums = calloc(4 * (size_t)tf->bins, sizeof(double));
+    if (!history || !sums) {
+        free(history);
+        free(sums);
+        return false;
+    }
+    free(tf->history);
+    free(tf->sums);
+    tf->history = history;
+    tf->sums = sums;
+    tf->depth = depth;
+    tf->filled = 0;
+    tf->slot = 0;
+    return true;
+}
+
+/*
+    transfer_process: Transforms both channels in one batched call, updates
+    the running Welch sums and recomputes |H|, phase and coherence.
+*/
+void transfer_process(TransferState* tf) {
+    const int n = tf->fft_size;
+    const int bins = tf->bins;
+    for (int i = 0; i < n; i++) {
+        tf->input[i] *= tf->window[i];
+        tf->input[n + i] *= tf->window[i];
+    }
+    fftwf_execute(tf->plan);
+
+    const fftwf_complex* x = tf->spectra;
+    const fftwf_complex* y = &tf->spectra[bins];
+    float* frame = &tf->history[(size_t)tf->slot * bins * 4];
+    const bool full = (tf->filled == tf->depth);
+
+    for (int k = 0; k < bins; k++) {
+        float gxx = x[k][0] * x[k][0] + x[k][1] * x[k][1];
+        float gyy = y[k][0] * y[k][0] + y[k][1] * y[k][1];
+        // Gxy = conj(X) * Y
+        float gxy_re = x[k][0] * y[k][0] + x[k][1] * y[k][1];
+        float gxy_im = x[k][0] * y[k][1] - x[k][1] * y[k][0];
+
+        float* slot = &frame[k * 4];
+        double* sum = &tf->sums[k * 4];
+        if (full) {
+            sum[0] -= slot[0];
+            sum[1] -= slot[1];
+            sum[2] -= slot[2];
+            sum[3] -= slot[3];
+        }
+        slot[0] = gxx;
+        slot[1] = gyy;
+        slot[2] = gxy_re;
+        slot[3] = gxy_im;
+        sum[0] += gxx;
+        sum[1] += gyy;
+        sum[2] += gxy_re;
+        sum[3] += gxy_im;
+
+        // The 1/depth scaling cancels in every ratio below.
+        double cross2 = sum[2] * sum[2] + sum[3] * sum[3];
+        double sxx = fmax(sum[0], 1e-30);
+        double syy = fmax(sum[1], 1e-30);
+        tf->magnitude_db[k] = (float)(10.0 * log10(cross2 / (sxx * sxx) + 1e-30));
+        tf->phase_deg[k] = (float)(atan2(sum[3], sum[2]) * 180.0 / M_PI);
+        tf->coherence[k] = (float)fmin(cross2 / (sxx * syy), 1.0);
+    }
+
+    tf->slot = (tf->slot + 1) % tf->depth;
+    if (!full) {
+        tf->filled++;
+    }
+}
+
+/*
+    transfer_free: Destroys the plan and releases all buffers.
+*/
+void transfer_free(TransferState* tf) {
+    if (tf->plan) {
+        fftwf_destroy_plan(tf->plan);
+    }
+    fftwf_free(tf->input);
+    fftwf_free(tf->spectra);
+    free(tf->window);
+    free(tf->history);
+    free(tf->sums);
+    free(tf->magnitude_db);
+    free(tf->phase_deg);
+    free(tf->coherence);
+    memset(tf, 0, sizeof(*tf));
+}
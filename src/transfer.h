@@ -0,0 +1,42 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <stdbool.h>
+#include <fftw3.h>
+
+/*
+    TransferState: Dual-channel transfer function and coherence measurement.
+
+    Both channels are windowed into one contiguous buffer and transformed by
+    a single batched r2c plan. Auto- and cross-spectra are Welch-averaged
+    over the last `depth` frames with a ring of past frames and running
+    double sums: each hop adds the newest frame and subtracts the one that
+    falls out, so a deeper average costs memory but not time.
+*/
+typedef struct {
+    int fft_size;
+    int bins;
+    int depth;             // Frames in the Welch average.
+    int filled;            // Frames currently in the average (<= depth).
+    int slot;              // Ring slot of the oldest frame.
+
+    float* input;          // 2 x fft_size: reference, then measurement.
+    fftwf_complex* spectra;// 2 x bins.
+    fftwf_plan plan;       // Batched r2c over both channels.
+    float* window;
+
+    float* history;        // depth x bins x {Gxx, Gyy, Re Gxy, Im Gxy}.
+    double* sums;          // bins x {Gxx, Gyy, Re Gxy, Im Gxy}.
+
+    float* magnitude_db;   // Output: |H| = |Gxy| / Gxx in dB.
+    float* phase_deg;      // Output: arg(Gxy) in degrees.
+    float* coherence;      // Output: |Gxy|^2 / (Gxx * Gyy).
+} TransferState;
+
+bool transfer_init(TransferState* tf, int fft_size, int depth);
+float* transfer_input(TransferState* tf, int channel);
+void transfer_process(TransferState* tf);
+bool transfer_set_depth(TransferState* tf, int depth);
+void transfer_free(TransferState* tf);
+
+#endif
@@ -0,0 +1,435 @@
+#include <winsock2.h>        // Before anything that pulls in windows.h.
+#include <SDL3/SDL.h>
+
+#include "trigger.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Longest line of a rules file.
+#define TRIGGER_LINE_MAX 1024
+
+// Text of one dispatched event.
+#define TRIGGER_MESSAGE_BYTES 160
+
+/*
+    trigger_token: Returns the next whitespace-separated token of *cursor,
+    terminated in place, or NULL at the end of the line.
+*/
+static char* trigger_token(char** cursor) {
+    char* p = *cursor;
+    while (*p && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (!*p) {
+        *cursor = p;
+        return NULL;
+    }
+    char* token = p;
+    while (*p && !isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (*p) {
+        *p++ = '\0';
+    }
+    *cursor = p;
+    return token;
+}
+
+static bool trigger_number(const char* text, float* value) {
+    char* end = NULL;
+    *value = text ? strtof(text, &end) : 0.0f;
+    return text && end != text && *end == '\0' && isfinite(*value);
+}
+
+/*
+    trigger_bins: Bins whose centres lie between lo and hi Hz; a range
+    narrower than a bin takes the bin nearest its middle.
+*/
+static bool trigger_bins(TriggerRule* rule, float lo, float hi, int bins, float bin_hz) {
+    if (lo < 0.0f || hi <= lo) {
+        return false;
+    }
+    rule->first_bin = SDL_min(bins, (int)ceilf(lo / bin_hz));
+    rule->last_bin = SDL_min(bins, (int)floorf(hi / bin_hz) + 1);
+    if (rule->first_bin >= rule->last_bin) {
+        rule->first_bin = SDL_min(bins - 1, (int)lroundf(0.5f * (lo + hi) / bin_hz));
+        rule->last_bin = rule->first_bin + 1;
+    }
+    return true;
+}
+
+/*
+    trigger_compile: Parses one rule,
+
+        NAME FEATURE [LO HI] (>|<) DB [for SECONDS] ACTION [ARGUMENT]
+
+    where FEATURE is level, band, peak or prominence (all but level take a
+    frequency range in Hz) and ACTION is log [PATH], udp ADDRESS:PORT or
+    exec COMMAND (the rest of the line). Prints the problem and returns
+    false on a malformed rule.
+*/
+static bool trigger_compile(TriggerEngine* engine, TriggerRule* rule, char* line, const char* path, int number) {
+    char* cursor = line;
+    const char* name = trigger_token(&cursor);
+    const char* feature = trigger_token(&cursor);
+    const char* problem = NULL;
+    memset(rule, 0, sizeof(*rule));
+    if (!name || !feature) {
+        problem = "expected a name and a feature";
+    } else {
+        snprintf(rule->name, sizeof(rule->name), "%s", name);
+        if (strcmp(feature, "level") == 0) {
+            rule->feature = TRIGGER_LEVEL;
+            rule->first_bin = 0;
+            rule->last_bin = engine->bins;
+        } else {
+            float lo = 0.0f;
+            float hi = 0.0f;
+            rule->feature = strcmp(feature, "band") == 0 ? TRIGGER_BAND :
+                            strcmp(feature, "peak") == 0 ? TRIGGER_PEAK : TRIGGER_PROMINENCE;
+            if (rule->feature == TRIGGER_PROMINENCE && strcmp(feature, "prominence") != 0) {
+                problem = "unknown feature (use level, band, peak or prominence)";
+            } else if (!trigger_number(trigger_token(&cursor), &lo) ||
+                       !trigger_number(trigger_token(&cursor), &hi) ||
+                       !trigger_bins(rule, lo, hi, engine->bins, engine->bin_hz)) {
+                problem = "expected a frequency range LO HI in Hz";
+            }
+        }
+    }
+    if (!problem) {
+        const char* op = trigger_token(&cursor);
+        if (!op || (strcmp(op, ">") != 0 && strcmp(op, "<") != 0)) {
+            problem = "expected > or <";
+        } else if (!trigger_number(trigger_token(&cursor), &rule->threshold)) {
+            problem = "expected a threshold in dB";
+        }
+        rule->above = op && op[0] == '>';
+        rule->linear_sum = pow(10.0, rule->threshold / 10.0) * (rule->last_bin - rule->first_bin);
+    }
+    const char* action = problem ? NULL : trigger_token(&cursor);
+    rule->hold = 1;
+    if (action && strcmp(action, "for") == 0) {
+        float seconds = 0.0f;
+        if (!trigger_number(trigger_token(&cursor), &seconds) || seconds < 0.0f) {
+            problem = "expected a hold time in seconds after 'for'";
+        }
+        rule->hold = SDL_max(1, (int)ceil(seconds / engine->hop_seconds - 1e-6));
+        action = problem ? NULL : trigger_token(&cursor);
+    }
+    if (!problem) {
+        while (*cursor && isspace((unsigned char)*cursor)) {
+            cursor++;
+        }
+        snprintf(rule->argument, sizeof(rule->argument), "%s", cursor);
+        if (!action) {
+            problem = "expected an action (log, udp or exec)";
+        } else if (strcmp(action, "log") == 0) {
+            rule->action = TRIGGER_LOG;
+            if (rule->argument[0] && !(rule->log = fopen(rule->argument, "a"))) {
+                problem = "cannot open the log file";
+            }
+        } else if (strcmp(action, "udp") == 0) {
+            rule->action = TRIGGER_UDP;
+            char* colon = strrchr(rule->argument, ':');
+            int port = colon ? atoi(colon + 1) : 0;
+            if (colon) {
+                *colon = '\0';
+                unsigned long address = inet_addr(rule->argument);
+                rule->address = (uint32_t)address;
+                *colon = ':';
+                colon = address == INADDR_NONE ? NULL : colon;
+            }
+            if (!colon || port <= 0 || port > 65535) {
+                problem = "expected an IPv4 ADDRESS:PORT after 'udp'";
+            }
+            rule->port = htons((uint16_t)port);
+        } else if (strcmp(action, "exec") == 0) {
+            rule->action = TRIGGER_EXEC;
+            if (!rule->argument[0]) {
+                problem = "expected a command after 'exec'";
+            }
+        } else {
+            problem = "unknown action (use log, udp or exec)";
+        }
+    }
+    if (problem) {
+        fprintf(stderr, "%s:%d: %s.\n", path, number, problem);
+        if (rule->log) {
+            fclose(rule->log);
+            rule->log = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+/*
+    trigger_format: The text an event is logged and sent as.
+*/
+static void trigger_format(const TriggerRule* rule, const TriggerEvent* event, char* out, size_t size) {
+    snprintf(out, size, "%.3f %s %.1f", event->time, rule->name, event->value);
+}
+
+/*
+    trigger_dispatch: Dispatcher thread. Takes one event at a time off the
+    queue and runs its action with the lock released; drains the queue
+    before honouring quit.
+*/
+static int trigger_dispatch(void* data) {
+    TriggerEngine* engine = (TriggerEngine*)data;
+    SDL_LockMutex(engine->mutex);
+    for (;;) {
+        while (engine->queue_count == 0 && !engine->quit) {
+            SDL_WaitCondition(engine->wake, engine->mutex);
+        }
+        if (engine->queue_count == 0) {
+            break;
+        }
+        TriggerEvent event = engine->queue[engine->queue_head];
+        engine->queue_head = (engine->queue_head + 1) % TRIGGER_QUEUE;
+        engine->queue_count--;
+        SDL_UnlockMutex(engine->mutex);
+
+        const TriggerRule* rule = &engine->rules[event.rule];
+        char message[TRIGGER_MESSAGE_BYTES];
+        trigger_format(rule, &event, message, sizeof(message));
+        if (rule->action == TRIGGER_LOG) {
+            FILE* out = rule->log ? rule->log : stderr;
+            fprintf(out, "Trigger: %s\n", message);
+            fflush(out);
+        } else if (rule->action == TRIGGER_UDP) {
+            struct sockaddr_in to;
+            memset(&to, 0, sizeof(to));
+            to.sin_family = AF_INET;
+            to.sin_addr.s_addr = rule->address;
+            to.sin_port = rule->port;
+            sendto((SOCKET)engine->socket, message, (int)strlen(message), 0, (struct sockaddr*)&to, sizeof(to));
+        } else {
+            char command[TRIGGER_ARG_BYTES + TRIGGER_MESSAGE_BYTES];
+            snprintf(command, sizeof(command), "%s %s", rule->argument, message);
+            system(command);
+        }
+        SDL_LockMutex(engine->mutex);
+    }
+    SDL_UnlockMutex(engine->mutex);
+    return 0;
+}
+
+/*
+    trigger_open: Compiles the rules in path for rows of `bins` bins and
+    starts the dispatcher. Blank lines and lines starting with '#' are
+    skipped.
+*/
+bool trigger_open(TriggerEngine* engine, const char* path, int bins, float bin_hz, double hop_seconds) {
+    memset(engine, 0, sizeof(*engine));
+    engine->bins = bins;
+    engine->bin_hz = bin_hz;
+    engine->hop_seconds = hop_seconds;
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open the rules file %s.\n", path);
+        return false;
+    }
+    engine->rules = calloc(TRIGGER_MAX_RULES, sizeof(TriggerRule));
+    bool ok = engine->rules != NULL;
+    bool udp = false;
+    char line[TRIGGER_LINE_MAX];
+    for (int number = 1; ok && fgets(line, sizeof(line), file); number++) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* start = line;
+        while (isspace((unsigned char)*start)) {
+            start++;
+        }
+        if (!*start || *start == '#') {
+            continue;
+        }
+        if (engine->count == TRIGGER_MAX_RULES) {
+            fprintf(stderr, "%s:%d: more than %d rules.\n", path, number, TRIGGER_MAX_RULES);
+            ok = false;
+            break;
+        }
+        TriggerRule* rule = &engine->rules[engine->count];
+        ok = trigger_compile(engine, rule, start, path, number);
+        if (ok) {
+            engine->count++;
+            engine->top_bin = SDL_max(engine->top_bin, rule->last_bin);
+            engine->need_sums |= rule->feature != TRIGGER_PEAK;
+            engine->need_max |= rule->feature == TRIGGER_PEAK || rule->feature == TRIGGER_PROMINENCE;
+            udp |= rule->action == TRIGGER_UDP;
+        }
+    }
+    fclose(file);
+    if (ok && engine->count == 0) {
+        fprintf(stderr, "%s defines no rules.\n", path);
+        ok = false;
+    }
+    if (ok && udp) {
+        WSADATA wsa;
+        engine->sockets_started = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+        engine->socket = engine->sockets_started ? (uintptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)
+                                                 : (uintptr_t)INVALID_SOCKET;
+        ok = (SOCKET)engine->socket != INVALID_SOCKET;
+        if (!ok) {
+            fprintf(stderr, "Failed to create the socket for udp rules.\n");
+        }
+    }
+    if (ok) {
+        engine->sums = malloc(sizeof(double) * (engine->top_bin + 1));
+        engine->block_max = malloc(sizeof(float) * (engine->top_bin / TRIGGER_BLOCK + 1));
+        engine->mutex = SDL_CreateMutex();
+        engine->wake = SDL_CreateCondition();
+        ok = engine->sums && engine->block_max && engine->mutex && engine->wake;
+    }
+    if (ok) {
+        engine->thread = SDL_CreateThread(trigger_dispatch, "triggers", engine);
+        ok = engine->thread != NULL;
+    }
+    if (!ok) {
+        trigger_close(engine);
+    }
+    return ok;
+}
+
+/*
+    trigger_max: Strongest bin of row_db in [first, last), reading whole
+    blocks from the block maxima.
+*/
+static float trigger_max(const TriggerEngine* engine, const float* row_db, int first, int last) {
+    const int block_first = (first + TRIGGER_BLOCK - 1) / TRIGGER_BLOCK;
+    const int block_last = last / TRIGGER_BLOCK;
+    float peak = -INFINITY;
+    if (block_first >= block_last) {
+        for (int k = first; k < last; k++) {
+            peak = fmaxf(peak, row_db[k]);
+        }
+        return peak;
+    }
+    for (int k = first; k < block_first * TRIGGER_BLOCK; k++) {
+        peak = fmaxf(peak, row_db[k]);
+    }
+    for (int b = block_first; b < block_last; b++) {
+        peak = fmaxf(peak, engine->block_max[b]);
+    }
+    for (int k = block_last * TRIGGER_BLOCK; k < last; k++) {
+        peak = fmaxf(peak, row_db[k]);
+    }
+    return peak;
+}
+
+/*
+    trigger_process: Evaluates every rule against one row (10 * log10 of
+    the bin magnitudes, as recorded) and queues the events that fire.
+*/
+void trigger_process(TriggerEngine* engine, const float* row_db) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    const int top = engine->top_bin;
+    if (engine->need_sums) {
+        double sum = 0.0;
+        engine->sums[0] = 0.0;
+        for (int k = 0; k < top; k++) {
+            sum += expf(row_db[k] * 0.23025851f);  // 10^(dB / 10).
+            engine->sums[k + 1] = sum;
+        }
+    }
+    if (engine->need_max) {
+        for (int b = 0; b < top / TRIGGER_BLOCK; b++) {
+            const float* block = row_db + b * TRIGGER_BLOCK;
+            float peak = block[0];
+            for (int k = 1; k < TRIGGER_BLOCK; k++) {
+                peak = fmaxf(peak, block[k]);
+            }
+            engine->block_max[b] = peak;
+        }
+    }
+
+    const double time = (engine->hops + 1) * engine->hop_seconds;
+    int fired = 0;
+    for (int r = 0; r < engine->count; r++) {
+        TriggerRule* rule = &engine->rules[r];
+        float value = 0.0f;
+        bool holds;
+        if (rule->feature == TRIGGER_PEAK) {
+            value = trigger_max(engine, row_db, rule->first_bin, rule->last_bin);
+            holds = rule->above ? value > rule->threshold : value < rule->threshold;
+        } else {
+            const double sum = engine->sums[rule->last_bin] - engine->sums[rule->first_bin];
+            if (rule->feature == TRIGGER_PROMINENCE) {
+                const double mean = sum / (rule->last_bin - rule->first_bin);
+                value = trigger_max(engine, row_db, rule->first_bin, rule->last_bin) -
+                        10.0f * log10f((float)fmax(mean, 1e-30));
+                holds = rule->above ? value > rule->threshold : value < rule->threshold;
+            } else {
+                // Band levels compare in the linear domain; dB only when firing.
+                holds = rule->above ? sum > rule->linear_sum : sum < rule->linear_sum;
+                value = holds && rule->run == rule->hold - 1 ?
+                        10.0f * log10f((float)fmax(sum / (rule->last_bin - rule->first_bin), 1e-30)) : 0.0f;
+            }
+        }
+        if (!holds) {
+            rule->run = 0;
+            continue;
+        }
+        if (rule->run < rule->hold && ++rule->run == rule->hold) {
+            // The dispatcher holds the lock only to pop events, never while running a hook.
+            if (fired == 0) {
+                SDL_LockMutex(engine->mutex);
+            }
+            fired++;
+            rule->events++;
+            engine->events++;
+            if (engine->queue_count == TRIGGER_QUEUE) {
+                engine->dropped++;
+                continue;
+            }
+            TriggerEvent* event = &engine->queue[(engine->queue_head + engine->queue_count) % TRIGGER_QUEUE];
+            event->rule = r;
+            event->time = time;
+            event->value = value;
+            engine->queue_count++;
+        }
+    }
+    if (fired) {
+        SDL_SignalCondition(engine->wake);
+        SDL_UnlockMutex(engine->mutex);
+    }
+    engine->hops++;
+    engine->seconds += (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+/*
+    trigger_close: Lets the dispatcher finish the queued events, then
+    releases everything.
+*/
+void trigger_close(TriggerEngine* engine) {
+    if (engine->thread) {
+        SDL_LockMutex(engine->mutex);
+        engine->quit = true;
+        SDL_SignalCondition(engine->wake);
+        SDL_UnlockMutex(engine->mutex);
+        SDL_WaitThread(engine->thread, NULL);
+    }
+    for (int r = 0; engine->rules && r < TRIGGER_MAX_RULES; r++) {
+        if (engine->rules[r].log) {
+            fclose(engine->rules[r].log);
+        }
+    }
+    if (engine->sockets_started) {
+        if ((SOCKET)engine->socket != INVALID_SOCKET) {
+            closesocket((SOCKET)engine->socket);
+        }
+        WSACleanup();
+    }
+    if (engine->wake) {
+        SDL_DestroyCondition(engine->wake);
+    }
+    if (engine->mutex) {
+        SDL_DestroyMutex(engine->mutex);
+    }
+    free(engine->rules);
+    free(engine->sums);
+    free(engine->block_max);
+    memset(engine, 0, sizeof(*engine));
+}
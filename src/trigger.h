@@ -0,0 +1,110 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Most rules one file may define.
+#define TRIGGER_MAX_RULES 1024
+
+// Longest rule name and action argument (log path, address or command).
+#define TRIGGER_NAME_BYTES 64
+#define TRIGGER_ARG_BYTES 256
+
+// Events waiting for the dispatcher thread; more are dropped and counted.
+#define TRIGGER_QUEUE 256
+
+// Bins per block of the per-hop maximum table used by peak rules.
+#define TRIGGER_BLOCK 16
+
+typedef enum {
+    TRIGGER_LEVEL,        // Mean level of the whole spectrum.
+    TRIGGER_BAND,         // Mean level between two frequencies.
+    TRIGGER_PEAK,         // Strongest bin between two frequencies.
+    TRIGGER_PROMINENCE    // Strongest bin less the band's mean level.
+} TriggerFeature;
+
+typedef enum {
+    TRIGGER_LOG,          // Line on stderr, or appended to a file.
+    TRIGGER_UDP,          // Datagram with the same line.
+    TRIGGER_EXEC          // Shell command, with name, time and value appended.
+} TriggerAction;
+
+/*
+    TriggerRule: One compiled rule. The text is parsed once when the file
+    is loaded; per hop only the bin range, comparison and hold counter are
+    touched.
+*/
+typedef struct {
+    char name[TRIGGER_NAME_BYTES];
+    TriggerFeature feature;
+    int first_bin;          // Bins [first_bin, last_bin).
+    int last_bin;
+    bool above;             // Fires on value > threshold, else value < threshold.
+    float threshold;        // dB, in the scale of the spectrogram rows.
+    double linear_sum;      // Band rules: the threshold as a sum of linear levels.
+    int hold;               // Consecutive hops the condition must hold.
+    int run;                // Consecutive hops it has held so far.
+    TriggerAction action;
+    char argument[TRIGGER_ARG_BYTES];
+    FILE* log;              // TRIGGER_LOG with a path.
+    uint32_t address;       // TRIGGER_UDP, network byte order.
+    uint16_t port;
+    unsigned long long events;
+} TriggerRule;
+
+/*
+    TriggerEvent: A rule that fired, queued for the dispatcher.
+*/
+typedef struct {
+    int rule;
+    double time;            // Seconds of input analysed when it fired.
+    float value;
+} TriggerEvent;
+
+/*
+    TriggerEngine: Evaluates every rule against each spectrogram row.
+
+    Rules share two per-hop tables built only up to the highest bin any
+    rule reads: a prefix sum of linear levels, which makes every band
+    mean O(1), and block maxima, which bound a peak search to the partial
+    blocks at its edges. A rule fires once when its condition has held
+    for its hold time and re-arms when the condition fails. Firing only
+    queues an event: logging, sending and running commands happen on a
+    dispatcher thread, so a slow hook never stalls analysis.
+*/
+typedef struct {
+    TriggerRule* rules;
+    int count;
+    int bins;
+    float bin_hz;
+    double hop_seconds;
+    int top_bin;            // Tables are built for bins [0, top_bin).
+    bool need_sums;
+    bool need_max;
+    double* sums;           // top_bin + 1 prefix sums of 10^(dB / 10).
+    float* block_max;
+
+    uintptr_t socket;       // Shared by the UDP rules, valid once sockets_started.
+    bool sockets_started;
+    TriggerEvent queue[TRIGGER_QUEUE];
+    int queue_head;         // Next event to dispatch.
+    int queue_count;
+    bool quit;
+    SDL_Mutex* mutex;
+    SDL_Condition* wake;
+    SDL_Thread* thread;
+
+    unsigned long long hops;
+    unsigned long long events;
+    unsigned long long dropped;
+    double seconds;         // Time spent evaluating.
+} TriggerEngine;
+
+bool trigger_open(TriggerEngine* engine, const char* path, int bins, float bin_hz, double hop_seconds);
+void trigger_process(TriggerEngine* engine, const float* row_db);
+void trigger_close(TriggerEngine* engine);
+
+#endif
@@ -0,0 +1,58 @@
+#include "vad.h"
+
+#include <math.h>
+#include <string.h>
+
+/*
+    vad_init: Sets the thresholds and starts in the active state.
+*/
+void vad_init(VadState* vad, float silence_db, float noise_db, float flatness_threshold,
+              float resume_margin_db, int hangover_hops) {
+    memset(vad, 0, sizeof(*vad));
+    vad->silence_db = silence_db;
+    vad->noise_db = noise_db;
+    vad->flatness_threshold = flatness_threshold;
+    vad->resume_margin_db = resume_margin_db;
+    vad->hangover_hops = hangover_hops;
+    vad->level_db = -120.0f;
+}
+
+/*
+    vad_update: Measures one hop of samples and returns true while the
+    input is silent.
+*/
+bool vad_update(VadState* vad, const float* samples, int count) {
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i] * samples[i];
+    }
+    vad->level_db = 10.0f * log10f(sum / (count > 0 ? count : 1) + 1e-12f);
+
+    if (vad->silent) {
+        if (vad->level_db >= vad->noise_db ||
+            vad->level_db > vad->floor_db + vad->resume_margin_db) {
+            vad->silent = false;
+            vad->quiet_hops = 0;
+        }
+        return vad->silent;
+    }
+
+    bool quiet = vad->level_db < vad->silence_db ||
+                 (vad->level_db < vad->noise_db && vad->flatness >= vad->flatness_threshold);
+    if (!quiet) {
+        vad->quiet_hops = 0;
+        return false;
+    }
+    vad->floor_db = (vad->quiet_hops == 0) ? vad->level_db : fmaxf(vad->floor_db, vad->level_db);
+    if (++vad->quiet_hops >= vad->hangover_hops) {
+        vad->silent = true;
+    }
+    return vad->silent;
+}
+
+/*
+    vad_set_flatness: Records the spectral flatness of the latest analysed frame.
+*/
+void vad_set_flatness(VadState* vad, float flatness) {
+    vad->flatness = flatness;
+}
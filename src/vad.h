@@ -0,0 +1,36 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdbool.h>
+
+/*
+    VadState: Energy and spectral-flatness silence detector.
+
+    Each hop's RMS level is measured straight from the ring-buffer samples,
+    before any FFT. A hop counts as quiet if it is below silence_db, or
+    below noise_db while the last analysed frame was noise-like (flat).
+    After hangover_hops quiet hops the input is declared silent. Flatness
+    is not refreshed while silent, so resumption is decided on level alone:
+    the first hop above noise_db, or resume_margin_db above the loudest
+    quiet hop seen on the way in, ends the silence.
+*/
+typedef struct {
+    float silence_db;
+    float noise_db;
+    float flatness_threshold;
+    float resume_margin_db;
+    int hangover_hops;
+
+    float level_db;          // RMS level of the last hop in dBFS.
+    float flatness;          // Flatness of the last analysed frame.
+    float floor_db;          // Loudest quiet hop since the quiet run began.
+    int quiet_hops;
+    bool silent;
+} VadState;
+
+void vad_init(VadState* vad, float silence_db, float noise_db, float flatness_threshold,
+              float resume_margin_db, int hangover_hops);
+bool vad_update(VadState* vad, const float* samples, int count);
+void vad_set_flatness(VadState* vad, float flatness);
+
+#endif
@@ -0,0 +1,224 @@
+#include "wav.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+static void put_u16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint16_t get_u16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+    wav_write_header: Writes a canonical 44-byte PCM header for data_bytes.
+*/
+static void wav_write_header(WavWriter* wav, uint32_t data_bytes) {
+    unsigned char h[44];
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, 1);  // PCM
+    put_u16(h + 22, (uint16_t)wav->channels);
+    put_u32(h + 24, (uint32_t)wav->sample_rate);
+    put_u32(h + 28, (uint32_t)(wav->sample_rate * wav->channels * 2));
+    put_u16(h + 32, (uint16_t)(wav->channels * 2));
+    put_u16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put_u32(h + 40, data_bytes);
+    fwrite(h, 1, sizeof(h), wav->file);
+}
+
+/*
+    wav_open: Creates the file and writes a placeholder header.
+*/
+bool wav_open(WavWriter* wav, const char* path, int sample_rate, int channels) {
+    memset(wav, 0, sizeof(*wav));
+    wav->file = fopen(path, "wb");
+    if (!wav->file) {
+        return false;
+    }
+    wav->sample_rate = sample_rate;
+    wav->channels = channels;
+    wav_write_header(wav, 0);
+    return true;
+}
+
+/*
+    wav_write: Appends interleaved float frames, clipped to 16 bits.
+*/
+void wav_write(WavWriter* wav, const float* samples, int frames) {
+    unsigned char buffer[512];
+    const int count = frames * wav->channels;
+    int used = 0;
+    for (int i = 0; i < count; i++) {
+        float s = fminf(fmaxf(samples[i], -1.0f), 1.0f);
+        put_u16(buffer + used, (uint16_t)(int16_t)lrintf(s * 32767.0f));
+        used += 2;
+        if (used == sizeof(buffer)) {
+            fwrite(buffer, 1, used, wav->file);
+            used = 0;
+        }
+    }
+    fwrite(buffer, 1, used, wav->file);
+    wav->frames += frames;
+}
+
+/*
+    wav_close: Patches the header with the final sizes and closes the file.
+*/
+void wav_close(WavWriter* wav) {
+    if (!wav->file) {
+        return;
+    }
+    fseek(wav->file, 0, SEEK_SET);
+    wav_write_header(wav, (uint32_t)(wav->frames * wav->channels * 2));
+    fclose(wav->file);
+    wav->file = NULL;
+}
+
+/*
+    wav_reader_open: Walks the RIFF chunks up to "data", taking the format
+    from "fmt ". Returns false for anything other than PCM or float data
+    with 1 to WAV_MAX_CHANNELS channels.
+*/
+bool wav_reader_open(WavReader* wav, const char* path) {
+    memset(wav, 0, sizeof(*wav));
+    wav->file = fopen(path, "rb");
+    if (!wav->file) {
+        return false;
+    }
+
+    unsigned char h[12];
+    if (fread(h, 1, 12, wav->file) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        wav_reader_close(wav);
+        return false;
+    }
+
+    bool have_format = false;
+    for (;;) {
+        unsigned char chunk[8];
+        if (fread(chunk, 1, 8, wav->file) != 8) {
+            wav_reader_close(wav);
+            return false;
+        }
+        uint32_t size = get_u32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size <= 64) {
+            unsigned char f[64];
+            if (fread(f, 1, size, wav->file) != size) {
+                wav_reader_close(wav);
+                return false;
+            }
+            uint16_t tag = get_u16(f);
+            if (tag == 0xFFFE && size >= 26) {
+                tag = get_u16(f + 24);  // Sub-format GUID starts with the format tag.
+            }
+            wav->channels = get_u16(f + 2);
+            wav->sample_rate = (int)get_u32(f + 4);
+            wav->bytes_per_sample = get_u16(f + 14) / 8;
+            wav->is_float = (tag == 3);
+            have_format = (tag == 1 && wav->bytes_per_sample >= 2 && wav->bytes_per_sample <= 4) ||
+                          (tag == 3 && wav->bytes_per_sample == 4);
+            if (size & 1) {
+                fseek(wav->file, 1, SEEK_CUR);  // Chunks are padded to even sizes.
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_format || wav->channels <= 0 || wav->channels > WAV_MAX_CHANNELS) {
+                wav_reader_close(wav);
+                return false;
+            }
+            wav->frames = size / (unsigned long)(wav->channels * wav->bytes_per_sample);
+            wav->data_offset = ftell(wav->file);
+            return true;
+        } else {
+            fseek(wav->file, size + (size & 1), SEEK_CUR);
+        }
+    }
+}
+
+/*
+    wav_read: Reads up to frames interleaved frames; returns the number read.
+*/
+int wav_read(WavReader* wav, float* samples, int frames) {
+    unsigned char buffer[4096];
+    const int frame_bytes = wav->channels * wav->bytes_per_sample;
+    unsigned long left = wav->frames - wav->frames_read;
+    if ((unsigned long)frames > left) {
+        frames = (int)left;
+    }
+
+    int done = 0;
+    while (done < frames) {
+        int chunk = (int)(sizeof(buffer) / frame_bytes);
+        if (chunk > frames - done) {
+            chunk = frames - done;
+        }
+        int got = (int)(fread(buffer, frame_bytes, chunk, wav->file));
+        const int count = got * wav->channels;
+        float* out = &samples[(size_t)done * wav->channels];
+        for (int i = 0; i < count; i++) {
+            const unsigned char* p = &buffer[i * wav->bytes_per_sample];
+            if (wav->is_float) {
+                uint32_t bits = get_u32(p);
+                memcpy(&out[i], &bits, sizeof(float));
+            } else if (wav->bytes_per_sample == 2) {
+                out[i] = (int16_t)get_u16(p) / 32768.0f;
+            } else if (wav->bytes_per_sample == 3) {
+                int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+                out[i] = v / 2147483648.0f;
+            } else {
+                out[i] = (int32_t)get_u32(p) / 2147483648.0f;
+            }
+        }
+        done += got;
+        if (got < chunk) {
+            break;
+        }
+    }
+    wav->frames_read += done;
+    return done;
+}
+
+/*
+    wav_reader_seek: Positions the reader at a frame of the data chunk.
+    The data chunk can approach 4 GiB, past the reach of a 32-bit long.
+*/
+bool wav_reader_seek(WavReader* wav, unsigned long frame) {
+    if (frame > wav->frames) {
+        return false;
+    }
+    long long offset = wav->data_offset + (long long)frame * wav->channels * wav->bytes_per_sample;
+#ifdef _WIN32
+    if (_fseeki64(wav->file, offset, SEEK_SET) != 0) {
+#else
+    if (fseek(wav->file, (long)offset, SEEK_SET) != 0) {
+#endif
+        return false;
+    }
+    wav->frames_read = frame;
+    return true;
+}
+
+/*
+    wav_reader_close: Closes the file.
+*/
+void wav_reader_close(WavReader* wav) {
+    if (wav->file) {
+        fclose(wav->file);
+        wav->file = NULL;
+    }
+}
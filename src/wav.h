@@ -0,0 +1,45 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Channels a reader accepts; a frame always fits the read buffer many times over.
+#define WAV_MAX_CHANNELS 64
+
+/*
+    WavWriter: Streams 16-bit PCM to a RIFF/WAVE file. The header sizes are
+    patched in when the writer is closed.
+*/
+typedef struct {
+    FILE* file;
+    int sample_rate;
+    int channels;
+    unsigned long frames;
+} WavWriter;
+
+/*
+    WavReader: Streams 16/24/32-bit PCM or 32-bit float RIFF/WAVE data
+    (plain or WAVE_FORMAT_EXTENSIBLE) as interleaved floats in [-1, 1).
+*/
+typedef struct {
+    FILE* file;
+    int sample_rate;
+    int channels;
+    int bytes_per_sample;
+    bool is_float;
+    unsigned long frames;       // Frames in the data chunk.
+    unsigned long frames_read;
+    long data_offset;           // File offset of the first sample.
+} WavReader;
+
+bool wav_open(WavWriter* wav, const char* path, int sample_rate, int channels);
+void wav_write(WavWriter* wav, const float* samples, int frames);
+void wav_close(WavWriter* wav);
+
+bool wav_reader_open(WavReader* wav, const char* path);
+int wav_read(WavReader* wav, float* samples, int frames);
+bool wav_reader_seek(WavReader* wav, unsigned long frame);
+void wav_reader_close(WavReader* wav);
+
+#endif